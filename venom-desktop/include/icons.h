@@ -35,6 +35,7 @@ gboolean get_item_position(const char *filename, int *x, int *y);
 GtkWidget* create_desktop_item(GFileInfo *info, const char *full_path);
 gint sort_file_info(gconstpointer a, gconstpointer b);
 void refresh_icons(void);
+void icons_watch_app_catalog(void);
 
 /* Drag and Drop Functions */
 void on_drag_begin(GtkWidget *widget, GdkDragContext *context, gpointer data);
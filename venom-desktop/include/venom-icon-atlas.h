@@ -0,0 +1,391 @@
+/*
+ * venom-icon-atlas.h
+ * Icon tiles shared by every shell process of a user session.
+ *
+ * The launcher, dock, panel and desktop all draw the same application
+ * icons.  Instead of each decoding (and rasterizing SVGs) on its own,
+ * the first process to need an icon file at a pixel size decodes it into
+ * /dev/shm/venom-icon-atlas-<uid>; every other process maps that file and
+ * paints the tile directly.  Tiles are premultiplied ARGB32 (cairo's
+ * native layout), so a hit is a cairo surface over the shared pages: no
+ * decode, no copy, and the pixels are resident once for the session.
+ *
+ * Layout (one sparse file, only touched pages use memory):
+ *
+ *   VenomIconAtlasHeader | VenomIconAtlasSlot[n_slots] | tile pixels
+ *
+ * The index is an append-only open-addressing hash table keyed by
+ * (file path, mtime, size) and updated without locks:
+ *   - a writer claims an empty slot with compare-and-swap (EMPTY -> BUSY),
+ *     takes tile space with an atomic add on pixels_used, fills both in and
+ *     only then publishes the slot (-> READY);
+ *   - readers only trust READY slots and stop probing at the first EMPTY.
+ * Nothing is ever removed or rewritten: an icon whose file changes gets
+ * a new key (new mtime) and the old tile is simply never hit again.  When
+ * the table or the tile area is full, icons are decoded privately.
+ *
+ * Surfaces returned here point into a mapping that stays for the life of
+ * the process.  They are shared: never draw into them.
+ *
+ * Header-only; the same file is used by the launcher, dock, panel and
+ * desktop.  Bump VENOM_ICON_ATLAS_VERSION on any layout change.  Under a
+ * strict -std=c11, define _DEFAULT_SOURCE before including it.
+ */
+
+#ifndef VENOM_ICON_ATLAS_H
+#define VENOM_ICON_ATLAS_H
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <cairo.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define VENOM_ICON_ATLAS_MAGIC      0x41495356u   /* "VSIA" */
+#define VENOM_ICON_ATLAS_VERSION    1
+#define VENOM_ICON_ATLAS_SLOTS      4096          /* power of two */
+#define VENOM_ICON_ATLAS_PIXELS     (64u << 20)   /* tile area, bytes */
+#define VENOM_ICON_ATLAS_MAX_SIZE   256           /* larger icons are not shared */
+#define VENOM_ICON_ATLAS_MAX_PROBE  64
+#define VENOM_ICON_ATLAS_PATH_LEN   224
+
+enum {
+    VENOM_ICON_SLOT_EMPTY = 0,
+    VENOM_ICON_SLOT_BUSY,       /* claimed, being decoded */
+    VENOM_ICON_SLOT_READY,
+    VENOM_ICON_SLOT_FAILED      /* no room for the tile; skipped */
+};
+
+typedef struct {
+    gint    magic;              /* set last by the creator */
+    guint32 version;
+    guint32 n_slots;
+    guint32 slots_offset;
+    guint32 pixels_offset;
+    guint32 pixels_size;
+    gint    pixels_used;        /* atomic bump allocator */
+    gint    n_icons;            /* READY slots, for stats */
+} VenomIconAtlasHeader;
+
+typedef struct {
+    gint    state;              /* VENOM_ICON_SLOT_*, atomic */
+    guint32 size;               /* tile is size x size */
+    guint64 hash;
+    gint64  mtime;
+    guint32 offset;             /* into the tile area */
+    guint32 reserved;
+    char    path[VENOM_ICON_ATLAS_PATH_LEN];
+} VenomIconAtlasSlot;
+
+typedef struct {
+    guint8               *base;
+    gsize                 length;
+    VenomIconAtlasHeader *header;
+    VenomIconAtlasSlot   *slots;
+    guint8               *pixels;
+} VenomIconAtlas;
+
+static inline gsize venom_icon_atlas_length(void) {
+    return 4096 + (gsize)VENOM_ICON_ATLAS_SLOTS * sizeof(VenomIconAtlasSlot) + VENOM_ICON_ATLAS_PIXELS;
+}
+
+static inline gboolean venom_icon_atlas_geometry_ok(const VenomIconAtlasHeader *h) {
+    return h->version == VENOM_ICON_ATLAS_VERSION &&
+           h->n_slots == VENOM_ICON_ATLAS_SLOTS &&
+           h->slots_offset == 4096 &&
+           h->pixels_offset == 4096 + VENOM_ICON_ATLAS_SLOTS * sizeof(VenomIconAtlasSlot) &&
+           h->pixels_size == VENOM_ICON_ATLAS_PIXELS;
+}
+
+/* Opens (or creates) the session atlas; NULL if /dev/shm is unusable */
+static inline VenomIconAtlas *venom_icon_atlas_map(void) {
+    char *path = g_strdup_printf("/dev/shm/venom-icon-atlas-%u", (guint)getuid());
+    gsize length = venom_icon_atlas_length();
+    gboolean created = FALSE;
+    struct stat st;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd >= 0) {
+        created = TRUE;
+        if (ftruncate(fd, length) != 0) {
+            close(fd);
+            g_unlink(path);
+            g_free(path);
+            return NULL;
+        }
+    } else if (errno == EEXIST) {
+        fd = open(path, O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        g_free(path);
+        return NULL;
+    }
+
+    /* /dev/shm is shared by all users: only trust our own private file */
+    if (fstat(fd, &st) != 0 || st.st_uid != getuid() || (st.st_mode & 077) != 0) {
+        close(fd);
+        g_free(path);
+        return NULL;
+    }
+
+    /* Several components start together at login: give the creator a moment */
+    for (int i = 0; i < 100 && st.st_size == 0; i++) {
+        g_usleep(1000);
+        if (fstat(fd, &st) != 0) break;
+    }
+    if ((gsize)st.st_size != length) {
+        /* Left by an older layout: the next start creates a fresh one */
+        if (st.st_size != 0) g_unlink(path);
+        close(fd);
+        g_free(path);
+        return NULL;
+    }
+
+    guint8 *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        g_free(path);
+        return NULL;
+    }
+
+    VenomIconAtlasHeader *h = (VenomIconAtlasHeader *)base;
+    if (created) {
+        h->version = VENOM_ICON_ATLAS_VERSION;
+        h->n_slots = VENOM_ICON_ATLAS_SLOTS;
+        h->slots_offset = 4096;
+        h->pixels_offset = 4096 + VENOM_ICON_ATLAS_SLOTS * sizeof(VenomIconAtlasSlot);
+        h->pixels_size = VENOM_ICON_ATLAS_PIXELS;
+        g_atomic_int_set(&h->magic, (gint)VENOM_ICON_ATLAS_MAGIC);
+    } else {
+        for (int i = 0; i < 100 && g_atomic_int_get(&h->magic) == 0; i++)
+            g_usleep(1000);
+    }
+
+    if ((guint32)g_atomic_int_get(&h->magic) != VENOM_ICON_ATLAS_MAGIC || !venom_icon_atlas_geometry_ok(h)) {
+        if ((guint32)g_atomic_int_get(&h->magic) == VENOM_ICON_ATLAS_MAGIC) g_unlink(path);
+        munmap(base, length);
+        g_free(path);
+        return NULL;
+    }
+    g_free(path);
+
+    VenomIconAtlas *atlas = g_new0(VenomIconAtlas, 1);
+    atlas->base = base;
+    atlas->length = length;
+    atlas->header = h;
+    atlas->slots = (VenomIconAtlasSlot *)(base + h->slots_offset);
+    atlas->pixels = base + h->pixels_offset;
+    return atlas;
+}
+
+/* The process-wide atlas, mapped on first use; NULL if unavailable */
+static inline VenomIconAtlas *venom_icon_atlas_get(void) {
+    static VenomIconAtlas *atlas = NULL;
+    static gsize once = 0;
+    if (g_once_init_enter(&once)) {
+        atlas = venom_icon_atlas_map();
+        g_once_init_leave(&once, 1);
+    }
+    return atlas;
+}
+
+static inline guint64 venom_icon_atlas_hash(const char *path, gint64 mtime, int size) {
+    guint64 h = 14695981039346656037ull;               /* FNV-1a */
+    for (const char *p = path; *p; p++) {
+        h ^= (guchar)*p;
+        h *= 1099511628211ull;
+    }
+    h ^= (guint64)mtime * 0x9E3779B97F4A7C15ull;
+    h ^= (guint64)size << 48;
+    return h ? h : 1;
+}
+
+static inline gboolean venom_icon_atlas_slot_matches(const VenomIconAtlasSlot *s, guint64 hash,
+                                                     const char *path, gint64 mtime, int size) {
+    return s->hash == hash && s->mtime == mtime && s->size == (guint32)size && strcmp(s->path, path) == 0;
+}
+
+/* Wraps @size x @size premultiplied pixels; @data must outlive the surface */
+static inline cairo_surface_t *venom_icon_atlas_wrap(guint8 *data, int size) {
+    return cairo_image_surface_create_for_data(data, CAIRO_FORMAT_ARGB32, size, size, size * 4);
+}
+
+/* TRUE if @surface is a tile in the shared atlas rather than private memory */
+static inline gboolean venom_icon_atlas_owns(cairo_surface_t *surface) {
+    VenomIconAtlas *atlas = venom_icon_atlas_get();
+    if (!atlas || !surface || cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE) return FALSE;
+    const guint8 *data = cairo_image_surface_get_data(surface);
+    return data >= atlas->pixels && data < atlas->pixels + atlas->header->pixels_size;
+}
+
+/* Shared tile for the key, or NULL */
+static inline cairo_surface_t *venom_icon_atlas_lookup(VenomIconAtlas *atlas, const char *path,
+                                                       gint64 mtime, int size) {
+    guint64 hash = venom_icon_atlas_hash(path, mtime, size);
+    guint32 mask = atlas->header->n_slots - 1;
+    gsize bytes = (gsize)size * size * 4;
+
+    for (guint32 i = 0; i < VENOM_ICON_ATLAS_MAX_PROBE; i++) {
+        VenomIconAtlasSlot *s = &atlas->slots[(hash + i) & mask];
+        gint state = g_atomic_int_get(&s->state);
+        if (state == VENOM_ICON_SLOT_EMPTY) return NULL;
+        if (state != VENOM_ICON_SLOT_READY || !venom_icon_atlas_slot_matches(s, hash, path, mtime, size))
+            continue;
+        if ((gsize)s->offset + bytes > atlas->header->pixels_size) return NULL;
+        return venom_icon_atlas_wrap(atlas->pixels + s->offset, size);
+    }
+    return NULL;
+}
+
+/* Centres @pb (at most @size square) into @dst, premultiplying */
+static inline void venom_icon_atlas_fill(guint8 *dst, int size, GdkPixbuf *pb) {
+    int w = MIN(gdk_pixbuf_get_width(pb), size);
+    int h = MIN(gdk_pixbuf_get_height(pb), size);
+    int nc = gdk_pixbuf_get_n_channels(pb);
+    int ss = gdk_pixbuf_get_rowstride(pb);
+    const guint8 *src = gdk_pixbuf_read_pixels(pb);
+    int ox = (size - w) / 2;
+    int oy = (size - h) / 2;
+
+    memset(dst, 0, (gsize)size * size * 4);
+    for (int y = 0; y < h; y++) {
+        const guint8 *s = src + (gsize)y * ss;
+        guint32 *d = (guint32 *)(dst + (gsize)(y + oy) * size * 4) + ox;
+        for (int x = 0; x < w; x++, s += nc) {
+            guint a = nc == 4 ? s[3] : 255;
+            guint r = (s[0] * a + 127) / 255;
+            guint g = (s[1] * a + 127) / 255;
+            guint b = (s[2] * a + 127) / 255;
+            d[x] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+/*
+ * Claims a slot and tile space for the key.  Returns the tile pixels to
+ * fill and *@slot_out to publish, or NULL when the atlas is full (or the
+ * key cannot be stored); the caller then decodes privately.
+ */
+static inline guint8 *venom_icon_atlas_reserve(VenomIconAtlas *atlas, const char *path, gint64 mtime,
+                                               int size, VenomIconAtlasSlot **slot_out) {
+    VenomIconAtlasHeader *h = atlas->header;
+    gsize len = strlen(path);
+    if (len >= VENOM_ICON_ATLAS_PATH_LEN || size > VENOM_ICON_ATLAS_MAX_SIZE) return NULL;
+
+    /* Tiles stay 64-byte aligned */
+    gint bytes = ((size * size * 4) + 63) & ~63;
+    if ((guint32)g_atomic_int_get(&h->pixels_used) + (guint32)bytes > h->pixels_size) return NULL;
+
+    guint64 hash = venom_icon_atlas_hash(path, mtime, size);
+    guint32 mask = h->n_slots - 1;
+    for (guint32 i = 0; i < VENOM_ICON_ATLAS_MAX_PROBE; i++) {
+        VenomIconAtlasSlot *s = &atlas->slots[(hash + i) & mask];
+        if (!g_atomic_int_compare_and_exchange(&s->state, VENOM_ICON_SLOT_EMPTY, VENOM_ICON_SLOT_BUSY))
+            continue;
+
+        guint32 offset = (guint32)g_atomic_int_add(&h->pixels_used, bytes);
+        if ((guint64)offset + (guint32)bytes > h->pixels_size) {
+            g_atomic_int_set(&s->state, VENOM_ICON_SLOT_FAILED);
+            return NULL;
+        }
+        s->hash = hash;
+        s->mtime = mtime;
+        s->size = (guint32)size;
+        s->offset = offset;
+        memcpy(s->path, path, len + 1);
+        *slot_out = s;
+        return atlas->pixels + offset;
+    }
+    return NULL;
+}
+
+/*
+ * @size x @size premultiplied tile of the image file at @path (PNG, SVG,
+ * ...), scaled to fit and centred.  Shared through the atlas when
+ * possible, decoded privately otherwise.  Returns a new surface
+ * reference, or NULL if the file cannot be decoded.  Thread-safe.
+ */
+static inline cairo_surface_t *venom_icon_atlas_load(const char *path, int size) {
+    VenomIconAtlas *atlas = venom_icon_atlas_get();
+    GStatBuf st;
+    if (!path || size <= 0 || g_stat(path, &st) != 0) return NULL;
+    gint64 mtime = (gint64)st.st_mtime;
+
+    if (atlas) {
+        cairo_surface_t *hit = venom_icon_atlas_lookup(atlas, path, mtime, size);
+        if (hit) return hit;
+    }
+
+    GdkPixbuf *pb = gdk_pixbuf_new_from_file_at_scale(path, size, size, TRUE, NULL);
+    if (!pb) return NULL;
+
+    VenomIconAtlasSlot *slot = NULL;
+    guint8 *tile = atlas ? venom_icon_atlas_reserve(atlas, path, mtime, size, &slot) : NULL;
+    cairo_surface_t *surface;
+    if (tile) {
+        venom_icon_atlas_fill(tile, size, pb);
+        g_atomic_int_set(&slot->state, VENOM_ICON_SLOT_READY);
+        g_atomic_int_inc(&atlas->header->n_icons);
+        surface = venom_icon_atlas_wrap(tile, size);
+    } else {
+        surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size, size);
+        cairo_surface_flush(surface);
+        venom_icon_atlas_fill(cairo_image_surface_get_data(surface), size, pb);
+        cairo_surface_mark_dirty(surface);
+    }
+    g_object_unref(pb);
+    return surface;
+}
+
+#ifdef GTK_MAJOR_VERSION
+static inline cairo_surface_t *venom_icon_atlas_load_info(GtkIconInfo *info, int size, int scale) {
+    if (!info) return NULL;
+    cairo_surface_t *surface = venom_icon_atlas_load(gtk_icon_info_get_filename(info), size * scale);
+    g_object_unref(info);
+    if (surface) cairo_surface_set_device_scale(surface, scale, scale);
+    return surface;
+}
+
+/*
+ * Theme icon @icon (icon name, absolute path or serialized GIcon) for
+ * @size logical pixels at @scale, e.g. for gtk_image_new_from_surface().
+ * NULL if it is not in the theme or not backed by a file.
+ */
+static inline cairo_surface_t *venom_icon_atlas_load_icon(GtkIconTheme *theme, const char *icon,
+                                                          int size, int scale) {
+    if (!icon || !*icon) return NULL;
+    if (g_path_is_absolute(icon)) {
+        cairo_surface_t *surface = venom_icon_atlas_load(icon, size * scale);
+        if (surface) cairo_surface_set_device_scale(surface, scale, scale);
+        return surface;
+    }
+    if (!strchr(icon, ' ') && !strchr(icon, '.'))
+        return venom_icon_atlas_load_info(gtk_icon_theme_lookup_icon_for_scale(theme, icon, size, scale,
+                                                                               GTK_ICON_LOOKUP_FORCE_SIZE),
+                                          size, scale);
+
+    GIcon *gicon = g_icon_new_for_string(icon, NULL);
+    if (!gicon) return NULL;
+    cairo_surface_t *surface = venom_icon_atlas_load_info(
+        gtk_icon_theme_lookup_by_gicon_for_scale(theme, gicon, size, scale, GTK_ICON_LOOKUP_FORCE_SIZE),
+        size, scale);
+    g_object_unref(gicon);
+    return surface;
+}
+
+/* Same for a GIcon (themed or file icon) */
+static inline cairo_surface_t *venom_icon_atlas_load_gicon(GtkIconTheme *theme, GIcon *gicon,
+                                                           int size, int scale) {
+    if (!gicon) return NULL;
+    return venom_icon_atlas_load_info(
+        gtk_icon_theme_lookup_by_gicon_for_scale(theme, gicon, size, scale, GTK_ICON_LOOKUP_FORCE_SIZE),
+        size, scale);
+}
+#endif /* GTK_MAJOR_VERSION */
+
+#endif /* VENOM_ICON_ATLAS_H */
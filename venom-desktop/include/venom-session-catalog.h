@@ -0,0 +1,223 @@
+/*
+ * venom-session-catalog.h
+ * Read-only client for the session application catalog.
+ *
+ * venom-catalogd (shipped with venom-launcher) scans and watches the
+ * application directories once per session and publishes an immutable
+ * snapshot at $XDG_RUNTIME_DIR/venom/apps.catalog.  Clients map it
+ * read-only instead of enumerating apps themselves, and re-open it when
+ * the service emits Changed.  A new version is renamed into place, so an
+ * open mapping never changes under its reader.
+ *
+ * Layout (must match venom-launcher/src/core/session_catalog.h):
+ *
+ *   VenomCatalogHeader | VenomCatalogRecord[n_apps] |
+ *   guint32 by_id[n_apps] | string table
+ *
+ * Records are sorted by collated name; by_id holds record indices sorted
+ * by desktop id.  String fields are string-table offsets (0 = NULL).
+ * Only shown apps (Type=Application, no NoDisplay) are listed.
+ *
+ * Names and sort keys are localized for the service's locale, recorded
+ * in the header; a client running under another locale gets no catalog
+ * from venom_catalog_open() and falls back to its own scan.
+ *
+ * Header-only; the same file is used by the dock, panel and desktop.
+ */
+
+#ifndef VENOM_SESSION_CATALOG_H
+#define VENOM_SESSION_CATALOG_H
+
+#include <gio/gio.h>
+#include <locale.h>
+#include <string.h>
+
+#define VENOM_CATALOG_MAGIC     0x43415356u   /* "VSAC" */
+#define VENOM_CATALOG_FORMAT    3
+
+#define VENOM_CATALOG_BUS_NAME  "org.venom.AppCatalog"
+#define VENOM_CATALOG_PATH      "/org/venom/AppCatalog"
+#define VENOM_CATALOG_IFACE     "org.venom.AppCatalog"
+
+typedef struct {
+    guint32 magic;
+    guint32 format;
+    guint32 version;
+    guint32 n_apps;
+    guint32 records_offset;
+    guint32 by_id_offset;
+    guint32 strtab_offset;
+    guint32 strtab_size;
+    guint32 locale;         /* string-table offset of the locale key */
+    guint32 reserved;
+} VenomCatalogHeader;
+
+typedef struct {
+    guint32 id;             /* desktop id, e.g. "firefox.desktop" */
+    guint32 path;           /* absolute .desktop path */
+    guint32 name;
+    guint32 exec;           /* field codes already stripped */
+    guint32 icon_name;      /* icon name or absolute path */
+    guint32 categories;
+    guint32 comment;
+    guint32 generic_name;
+    guint32 keywords;
+    guint32 sort_key;
+    guint32 startup_wm_class;
+    guint32 reserved;
+} VenomCatalogRecord;
+
+typedef struct {
+    GMappedFile              *mapped;
+    const VenomCatalogHeader *header;
+    const VenomCatalogRecord *records;
+    const guint32            *by_id;
+    const char               *strtab;
+} VenomCatalog;
+
+typedef void (*VenomCatalogChangedFunc)(guint32 version, gpointer user_data);
+
+static inline gboolean venom_catalog_validate(const char *data, gsize len) {
+    if (len < sizeof(VenomCatalogHeader)) return FALSE;
+
+    const VenomCatalogHeader *h = (const VenomCatalogHeader *)data;
+    if (h->magic != VENOM_CATALOG_MAGIC || h->format != VENOM_CATALOG_FORMAT) return FALSE;
+
+    guint64 rec_end = (guint64)h->records_offset + (guint64)h->n_apps * sizeof(VenomCatalogRecord);
+    guint64 ids_end = (guint64)h->by_id_offset + (guint64)h->n_apps * sizeof(guint32);
+    guint64 str_end = (guint64)h->strtab_offset + h->strtab_size;
+    if (h->records_offset % 8 != 0 || rec_end > len) return FALSE;
+    if (h->by_id_offset % 4 != 0 || ids_end > len) return FALSE;
+    if (h->strtab_size == 0 || str_end > len) return FALSE;
+    if (data[h->strtab_offset + h->strtab_size - 1] != '\0') return FALSE;
+    if (h->locale == 0 || h->locale >= h->strtab_size) return FALSE;
+
+    const VenomCatalogRecord *recs = (const VenomCatalogRecord *)(data + h->records_offset);
+    const guint32 *by_id = (const guint32 *)(data + h->by_id_offset);
+    for (guint32 i = 0; i < h->n_apps; i++) {
+        const guint32 *fields = (const guint32 *)&recs[i];
+        if (by_id[i] >= h->n_apps || recs[i].id == 0 || recs[i].path == 0) return FALSE;
+        for (guint f = 0; f < sizeof(VenomCatalogRecord) / sizeof(guint32); f++)
+            if (fields[f] >= h->strtab_size) return FALSE;
+    }
+    return TRUE;
+}
+
+/* Languages for Name/Comment plus the collation of the sort keys (g_free) */
+static inline char *venom_catalog_locale_key(void) {
+    char *languages = g_strjoinv(":", (char **)g_get_language_names());
+    const char *collate = setlocale(LC_COLLATE, NULL);
+    char *key = g_strconcat(languages, "|", collate ? collate : "C", NULL);
+    g_free(languages);
+    return key;
+}
+
+/*
+ * Maps the current snapshot; NULL if none is published or it was built
+ * for another locale (use a local scan then)
+ */
+static inline VenomCatalog *venom_catalog_open(void) {
+    char *path = g_build_filename(g_get_user_runtime_dir(), "venom", "apps.catalog", NULL);
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    g_free(path);
+    if (!mapped) return NULL;
+
+    const char *data = g_mapped_file_get_contents(mapped);
+    gsize len = g_mapped_file_get_length(mapped);
+    if (!data || !venom_catalog_validate(data, len)) {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    const VenomCatalogHeader *h = (const VenomCatalogHeader *)data;
+    char *locale = venom_catalog_locale_key();
+    gboolean same_locale = strcmp(locale, data + h->strtab_offset + h->locale) == 0;
+    g_free(locale);
+    if (!same_locale) {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    VenomCatalog *c = g_new0(VenomCatalog, 1);
+    c->mapped = mapped;
+    c->header = h;
+    c->records = (const VenomCatalogRecord *)(data + h->records_offset);
+    c->by_id = (const guint32 *)(data + h->by_id_offset);
+    c->strtab = data + h->strtab_offset;
+    return c;
+}
+
+static inline void venom_catalog_free(VenomCatalog *c) {
+    if (!c) return;
+    g_mapped_file_unref(c->mapped);
+    g_free(c);
+}
+
+static inline guint venom_catalog_n_apps(const VenomCatalog *c) {
+    return c->header->n_apps;
+}
+
+static inline const VenomCatalogRecord *venom_catalog_record(const VenomCatalog *c, guint index) {
+    return index < c->header->n_apps ? &c->records[index] : NULL;
+}
+
+/* String field of a record, e.g. venom_catalog_str(c, rec->name); NULL if unset */
+static inline const char *venom_catalog_str(const VenomCatalog *c, guint32 offset) {
+    return offset ? c->strtab + offset : NULL;
+}
+
+/* Record for a desktop id ("firefox.desktop"), or NULL */
+static inline const VenomCatalogRecord *venom_catalog_lookup(const VenomCatalog *c, const char *desktop_id) {
+    guint lo = 0, hi = c->header->n_apps;
+    while (lo < hi) {
+        guint mid = (lo + hi) / 2;
+        const VenomCatalogRecord *rec = &c->records[c->by_id[mid]];
+        int r = strcmp(c->strtab + rec->id, desktop_id);
+        if (r == 0) return rec;
+        if (r < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+typedef struct {
+    VenomCatalogChangedFunc func;
+    gpointer user_data;
+} VenomCatalogWatch;
+
+static inline void venom_catalog_on_signal(GDBusConnection *bus, const char *sender, const char *path,
+                                           const char *iface, const char *signal, GVariant *params,
+                                           gpointer user_data) {
+    (void)bus; (void)sender; (void)path; (void)iface; (void)signal;
+    VenomCatalogWatch *w = user_data;
+    guint32 version = 0;
+    if (g_variant_is_of_type(params, G_VARIANT_TYPE("(u)")))
+        g_variant_get(params, "(u)", &version);
+    w->func(version, w->user_data);
+}
+
+/*
+ * Calls @func whenever a new snapshot is published, and makes sure the
+ * service is running (D-Bus activation), so a missing snapshot shows up
+ * shortly after.  Returns FALSE without a session bus.
+ */
+static inline gboolean venom_catalog_subscribe(VenomCatalogChangedFunc func, gpointer user_data) {
+    GDBusConnection *bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+    if (!bus) return FALSE;
+
+    VenomCatalogWatch *w = g_new0(VenomCatalogWatch, 1);
+    w->func = func;
+    w->user_data = user_data;
+    g_dbus_connection_signal_subscribe(bus, VENOM_CATALOG_BUS_NAME, VENOM_CATALOG_IFACE, "Changed",
+                                       VENOM_CATALOG_PATH, NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+                                       venom_catalog_on_signal, w, g_free);
+
+    /* Reply is not needed; the call only activates the service */
+    g_dbus_connection_call(bus, VENOM_CATALOG_BUS_NAME, VENOM_CATALOG_PATH, VENOM_CATALOG_IFACE,
+                           "GetSnapshot", NULL, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+
+    /* The reference on @bus is kept: the subscription lives as long as the process */
+    return TRUE;
+}
+
+#endif /* VENOM_SESSION_CATALOG_H */
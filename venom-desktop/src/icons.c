@@ -8,6 +8,8 @@
 #include "selection.h"
 #include "menu.h"
 #include "filesystem.h"
+#include "venom-session-catalog.h"
+#include "venom-icon-atlas.h"
 #include <gio/gdesktopappinfo.h>
 #include <glib/gstdio.h>
 #include <string.h>
@@ -266,6 +268,55 @@ void on_bg_drag_data_received(GtkWidget *widget, GdkDragContext *context, gint x
     gtk_drag_finish(context, TRUE, FALSE, time);
 }
 
+/* --- Session App Catalog --- */
+
+static VenomCatalog *app_catalog = NULL;
+static gboolean app_catalog_loaded = FALSE;
+
+/*
+ * Name and icon for a launcher on the desktop, taken from the session
+ * catalog by desktop id instead of parsing the file.  Only used when the
+ * file is the same size as the installed entry (a copy or a symlink);
+ * edited launchers go through GDesktopAppInfo as before.
+ */
+static gboolean lookup_catalog_app(GFileInfo *info, char **display_name, GIcon **gicon) {
+    if (!app_catalog_loaded) {
+        app_catalog = venom_catalog_open();
+        app_catalog_loaded = TRUE;
+    }
+    if (!app_catalog) return FALSE;
+
+    const VenomCatalogRecord *rec = venom_catalog_lookup(app_catalog, g_file_info_get_name(info));
+    if (!rec || !rec->name) return FALSE;
+
+    GStatBuf st;
+    if (g_stat(venom_catalog_str(app_catalog, rec->path), &st) != 0 ||
+        (goffset)st.st_size != g_file_info_get_size(info)) return FALSE;
+
+    const char *icon_name = venom_catalog_str(app_catalog, rec->icon_name);
+    GIcon *icon = icon_name ? g_icon_new_for_string(icon_name, NULL) : NULL;
+    if (!icon) return FALSE;
+
+    g_free(*display_name);
+    *display_name = g_strdup(venom_catalog_str(app_catalog, rec->name));
+    if (*gicon) g_object_unref(*gicon);
+    *gicon = icon;
+    return TRUE;
+}
+
+/* A new snapshot was published: re-open it on the next lookup and redraw */
+static void on_app_catalog_changed(guint32 version, gpointer data) {
+    (void)version; (void)data;
+    venom_catalog_free(app_catalog);
+    app_catalog = NULL;
+    app_catalog_loaded = FALSE;
+    refresh_icons();
+}
+
+void icons_watch_app_catalog(void) {
+    venom_catalog_subscribe(on_app_catalog_changed, NULL);
+}
+
 /* --- Icon Loading & Placement --- */
 
 GtkWidget* create_desktop_item(GFileInfo *info, const char *full_path) {
@@ -274,7 +325,7 @@ GtkWidget* create_desktop_item(GFileInfo *info, const char *full_path) {
     GIcon *gicon = g_object_ref(g_file_info_get_icon(info));
     gboolean is_dir = (g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY);
     
-    if (g_str_has_suffix(filename, ".desktop")) {
+    if (g_str_has_suffix(filename, ".desktop") && !lookup_catalog_app(info, &display_name, &gicon)) {
         GDesktopAppInfo *app_info = g_desktop_app_info_new_from_filename(full_path);
         if (app_info) {
             g_free(display_name);
@@ -294,8 +345,17 @@ GtkWidget* create_desktop_item(GFileInfo *info, const char *full_path) {
     GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 2);
     gtk_container_add(GTK_CONTAINER(btn), box);
 
-    GtkWidget *image = gtk_image_new_from_gicon(gicon, GTK_ICON_SIZE_DIALOG);
-    gtk_image_set_pixel_size(GTK_IMAGE(image), ICON_SIZE);
+    /* Shared with the dock/panel/launcher through the icon atlas when file-backed */
+    GtkWidget *image;
+    cairo_surface_t *surface = venom_icon_atlas_load_gicon(gtk_icon_theme_get_default(), gicon, ICON_SIZE,
+                                                           gtk_widget_get_scale_factor(icon_layout));
+    if (surface) {
+        image = gtk_image_new_from_surface(surface);
+        cairo_surface_destroy(surface);
+    } else {
+        image = gtk_image_new_from_gicon(gicon, GTK_ICON_SIZE_DIALOG);
+        gtk_image_set_pixel_size(GTK_IMAGE(image), ICON_SIZE);
+    }
     gtk_box_pack_start(GTK_BOX(box), image, FALSE, FALSE, 0);
 
     GtkWidget *label = gtk_label_new(display_name);
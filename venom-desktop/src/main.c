@@ -45,6 +45,7 @@ int main(int argc, char *argv[]) {
     gtk_style_context_add_provider_for_screen(screen, GTK_STYLE_PROVIDER(css), 800);
 
     /* Load desktop icons */
+    icons_watch_app_catalog();
     refresh_icons();
 
     /* Show window and start main loop */
@@ -0,0 +1,247 @@
+/*
+ * xprop_bench - Window property reads: one Xlib round trip each against
+ * one pipelined XBatch (src/logic/x_batch.c).
+ *
+ *   make bench
+ *   Xvfb :99 -ac &
+ *   DISPLAY=:99 ./build/xprop-bench [-n windows] [-d delay_ms]
+ *
+ * Creates @windows test clients with the properties the dock and pager
+ * read (WM_CLASS, _NET_WM_NAME, _NET_WM_STATE, _NET_WM_WINDOW_TYPE,
+ * _NET_WM_DESKTOP) and reads all of them plus the geometry both ways,
+ * printing the median time.  With -d the reads go through a local proxy
+ * that holds every client->server write for @delay_ms, standing in for
+ * ssh-forwarded X or a loaded server: the serial column grows with
+ * windows x delay, the batched one with the delay only.
+ */
+
+#define _GNU_SOURCE
+
+#include "logic/x_batch.h"
+
+#include <X11/Xatom.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ROUNDS       9
+#define PROXY_OFFSET 100    /* Proxy display = real display + this */
+
+static const char *prop_names[] = {
+    "WM_CLASS", "_NET_WM_NAME", "_NET_WM_STATE", "_NET_WM_WINDOW_TYPE", "_NET_WM_DESKTOP"
+};
+#define N_PROPS G_N_ELEMENTS(prop_names)
+
+/* -------------------------------------------------------------------------
+ * Delay proxy
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    int client, upstream, delay_ms;
+} ProxyConn;
+
+static char upstream_path[108];
+
+static void *proxy_conn(void *data) {
+    ProxyConn *c = data;
+    struct pollfd fds[2] = { { c->client, POLLIN, 0 }, { c->upstream, POLLIN, 0 } };
+    char buf[65536];
+
+    while (poll(fds, 2, -1) > 0) {
+        for (int i = 0; i < 2; i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP))) continue;
+            ssize_t n = read(fds[i].fd, buf, sizeof buf);
+            if (n <= 0) goto done;
+            if (i == 0) {
+                /* Requests wait out the delay: one per round trip */
+                struct timespec ts = { c->delay_ms / 1000, (c->delay_ms % 1000) * 1000000L };
+                nanosleep(&ts, NULL);
+            }
+            for (ssize_t off = 0; off < n; ) {
+                ssize_t w = write(fds[!i].fd, buf + off, n - off);
+                if (w <= 0) goto done;
+                off += w;
+            }
+        }
+    }
+done:
+    close(c->client);
+    close(c->upstream);
+    g_free(c);
+    return NULL;
+}
+
+static void *proxy_accept(void *data) {
+    int listener = GPOINTER_TO_INT(((gpointer *)data)[0]);
+    int delay_ms = GPOINTER_TO_INT(((gpointer *)data)[1]);
+
+    for (;;) {
+        int client = accept(listener, NULL, NULL);
+        if (client < 0) continue;
+
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        strcpy(addr.sun_path, upstream_path);
+        int upstream = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(upstream, (struct sockaddr *)&addr, sizeof addr) != 0) {
+            perror("xprop-bench: upstream");
+            close(client);
+            close(upstream);
+            continue;
+        }
+
+        ProxyConn *c = g_new(ProxyConn, 1);
+        *c = (ProxyConn){ client, upstream, delay_ms };
+        pthread_t thread;
+        pthread_create(&thread, NULL, proxy_conn, c);
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+/* Starts the proxy for display @number; returns the display name to open */
+static char *start_proxy(int number, int delay_ms) {
+    static gpointer args[2];
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+    snprintf(upstream_path, sizeof upstream_path, "/tmp/.X11-unix/X%d", number);
+    snprintf(addr.sun_path, sizeof addr.sun_path, "/tmp/.X11-unix/X%d", number + PROXY_OFFSET);
+    unlink(addr.sun_path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (bind(listener, (struct sockaddr *)&addr, sizeof addr) != 0 || listen(listener, 4) != 0) {
+        perror("xprop-bench: proxy");
+        exit(1);
+    }
+
+    args[0] = GINT_TO_POINTER(listener);
+    args[1] = GINT_TO_POINTER(delay_ms);
+    pthread_t thread;
+    pthread_create(&thread, NULL, proxy_accept, args);
+    pthread_detach(thread);
+    return g_strdup_printf(":%d", number + PROXY_OFFSET);
+}
+
+/* -------------------------------------------------------------------------
+ * Readers
+ * ------------------------------------------------------------------------- */
+
+/* What the dock and pager did: a blocking request per property */
+static void read_serial(Display *dpy, const Window *windows, int n, const Atom *props) {
+    for (int w = 0; w < n; w++) {
+        for (guint p = 0; p < N_PROPS; p++) {
+            Atom type;
+            int format;
+            unsigned long nitems, after;
+            unsigned char *data = NULL;
+            XGetWindowProperty(dpy, windows[w], props[p], 0, 1024, False, AnyPropertyType,
+                               &type, &format, &nitems, &after, &data);
+            if (data) XFree(data);
+        }
+        XWindowAttributes attrs;
+        XGetWindowAttributes(dpy, windows[w], &attrs);
+    }
+}
+
+static void read_batched(Display *dpy, const Window *windows, int n, const Atom *props) {
+    XBatch *batch = xbatch_new(dpy);
+    for (int w = 0; w < n; w++) {
+        for (guint p = 0; p < N_PROPS; p++) {
+            xbatch_get_property(batch, windows[w], props[p], AnyPropertyType, 1024);
+        }
+        xbatch_get_geometry(batch, windows[w]);
+    }
+    xbatch_run(batch);
+    xbatch_free(batch);
+}
+
+static gint compare_time(gconstpointer a, gconstpointer b) {
+    gint64 x = *(const gint64 *)a, y = *(const gint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static double median_ms(void (*reader)(Display *, const Window *, int, const Atom *),
+                        Display *dpy, const Window *windows, int n, const Atom *props) {
+    gint64 t[ROUNDS];
+    for (int r = 0; r < ROUNDS; r++) {
+        gint64 start = g_get_monotonic_time();
+        reader(dpy, windows, n, props);
+        t[r] = g_get_monotonic_time() - start;
+    }
+    qsort(t, ROUNDS, sizeof *t, (int (*)(const void *, const void *))compare_time);
+    return t[ROUNDS / 2] / 1000.0;
+}
+
+int main(int argc, char *argv[]) {
+    int n_windows = 30, delay_ms = 0, opt;
+    while ((opt = getopt(argc, argv, "n:d:")) != -1) {
+        if (opt == 'n') n_windows = atoi(optarg);
+        else if (opt == 'd') delay_ms = atoi(optarg);
+        else {
+            fprintf(stderr, "usage: %s [-n windows] [-d delay_ms]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const char *display_name = getenv("DISPLAY");
+    Display *setup = XOpenDisplay(NULL);
+    if (!setup || !display_name || display_name[0] != ':') {
+        fprintf(stderr, "xprop-bench: needs a local DISPLAY (e.g. Xvfb :99 -ac)\n");
+        return 1;
+    }
+
+    /* Test clients, created over the direct connection */
+    Atom props[N_PROPS];
+    for (guint p = 0; p < N_PROPS; p++) props[p] = XInternAtom(setup, prop_names[p], False);
+    Atom utf8 = XInternAtom(setup, "UTF8_STRING", False);
+    Atom normal = XInternAtom(setup, "_NET_WM_WINDOW_TYPE_NORMAL", False);
+    Atom above = XInternAtom(setup, "_NET_WM_STATE_ABOVE", False);
+
+    Window *windows = g_new(Window, n_windows);
+    for (int w = 0; w < n_windows; w++) {
+        windows[w] = XCreateSimpleWindow(setup, DefaultRootWindow(setup), 0, 0, 200, 100, 0, 0, 0);
+        char name[64];
+        int len = snprintf(name, sizeof name, "Bench Window %d", w);
+        static const char wm_class[] = "bench\0Bench";
+        long desktop = w % 4;
+        XChangeProperty(setup, windows[w], props[0], XA_STRING, 8, PropModeReplace,
+                        (const unsigned char *)wm_class, sizeof wm_class);
+        XChangeProperty(setup, windows[w], props[1], utf8, 8, PropModeReplace,
+                        (const unsigned char *)name, len);
+        XChangeProperty(setup, windows[w], props[2], XA_ATOM, 32, PropModeReplace,
+                        (const unsigned char *)&above, 1);
+        XChangeProperty(setup, windows[w], props[3], XA_ATOM, 32, PropModeReplace,
+                        (const unsigned char *)&normal, 1);
+        XChangeProperty(setup, windows[w], props[4], XA_CARDINAL, 32, PropModeReplace,
+                        (const unsigned char *)&desktop, 1);
+    }
+    XSync(setup, False);
+
+    /* The measured connection, through the delay proxy if asked */
+    char *measured_name = delay_ms > 0 ? start_proxy(atoi(display_name + 1), delay_ms)
+                                       : g_strdup(display_name);
+    Display *dpy = XOpenDisplay(measured_name);
+    if (!dpy) {
+        fprintf(stderr, "xprop-bench: cannot open %s\n", measured_name);
+        return 1;
+    }
+
+    printf("%d windows, %d requests each, %d ms added latency\n",
+           n_windows, (int)N_PROPS + 1, delay_ms);
+    printf("%14s  %14s\n", "serial (ms)", "batched (ms)");
+    printf("%14.3f  %14.3f\n",
+           median_ms(read_serial, dpy, windows, n_windows, props),
+           median_ms(read_batched, dpy, windows, n_windows, props));
+
+    XCloseDisplay(dpy);
+    XCloseDisplay(setup);
+    g_free(measured_name);
+    g_free(windows);
+    return 0;
+}
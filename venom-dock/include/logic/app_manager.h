@@ -7,24 +7,38 @@
 /* Helper struct for app info */
 typedef struct {
     char *name;
-    char *icon;
+    char *icon;        /* Icon name, path or serialized GIcon; see app_mgr_load_icon() */
     char *desktop_file_path;
-    GdkPixbuf *pixbuf; /* Cached icon for performance */
     /* Add more fields if needed */
 } AppInfo;
 
-/* Scans /usr/share/applications and returns valid apps */
+/* Lists shown apps from the session catalog (venom-catalogd), or scans
+ * the application dirs itself when no snapshot is published */
 /* Returns: GList of AppInfo* */
 GList *app_mgr_scan_apps(void);
 
 /* Free the list returned by scan */
 void app_mgr_free_list(GList *apps);
 
-/* Launch an app by desktop file path */
+/* Icon at @size logical px for @scale, shared with the other shell
+ * processes through the icon atlas; NULL if the theme has no such icon.
+ * Never draw into it. */
+cairo_surface_t *app_mgr_load_icon(const char *icon, int size, int scale);
+
+/* Desktop entry of a window's WM_CLASS class / instance, matched against
+ * StartupWMClass, then desktop ids, then executable names (case-insensitive).
+ * A single lookup in an index built once from the session catalog (or,
+ * without one, a scan of the installed apps) and rebuilt when it changes.
+ * Outputs may be NULL; free with g_free. */
+gboolean app_mgr_find_app_for_class(const char *wm_class, const char *instance,
+                                    char **desktop_file_path, char **icon);
+
+/* Launch an app by desktop file path, through the session spawn helper
+ * (venom-spawn.h) so the dock is not forked */
 /* Returns TRUE on success */
 gboolean app_mgr_launch(const char *desktop_file_path, GError **error);
 
-/* Launch app wrapper detached */
+/* Launch a command line detached, through the spawn helper */
 gboolean app_mgr_launch_detached(const char *cmd_line, GError **error);
 
 #endif
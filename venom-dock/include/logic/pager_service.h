@@ -10,6 +10,18 @@ int pager_svc_get_current_desktop(void);
 int pager_svc_get_num_desktops(void);
 void pager_svc_set_desktop(int index);
 
+/* A client window with its desktop and geometry */
+typedef struct {
+    Window win;
+    long desktop;           /* _NET_WM_DESKTOP; 0xFFFFFFFF = all desktops, -1 = unset */
+    gboolean has_geometry;  /* FALSE if the window vanished */
+    int x, y, width, height;
+} PagerWindowInfo;
+
+/* All client windows (stacking order) with desktop and geometry, read in
+ * one pipelined round trip.  Returns: GArray of PagerWindowInfo (g_array_unref) */
+GArray *pager_svc_get_window_infos(void);
+
 /* Get all windows on a specific desktop */
 /* Returns: GList of Window IDs (GINT_TO_POINTER) */
 GList *pager_svc_get_windows(int desktop_index);
@@ -0,0 +1,62 @@
+#ifndef WINDOW_CACHE_H
+#define WINDOW_CACHE_H
+
+#include <gtk/gtk.h>
+#include <X11/Xlib.h>
+
+/*
+ * Per-window property cache, keyed by XID.
+ *
+ * A client window's properties are read once, when it is first seen, and
+ * PropertyChangeMask is selected on it; after that only the property
+ * named in a PropertyNotify is read again.  A _NET_CLIENT_LIST change
+ * therefore costs no round trips for windows already known, and a single
+ * pipelined one for all the new windows together (x_batch.h).
+ */
+typedef struct {
+    Window xid;
+    char *res_name;             /* WM_CLASS instance, or NULL */
+    char *res_class;            /* WM_CLASS class, or NULL */
+    char *name;                 /* _NET_WM_NAME, else WM_NAME, or NULL */
+    gboolean skip_taskbar;      /* _NET_WM_STATE has _NET_WM_STATE_SKIP_TASKBAR */
+    gboolean dock_or_desktop;   /* _NET_WM_WINDOW_TYPE is DOCK or DESKTOP */
+
+    /* _NET_WM_ICON, decoded on first use (win_cache_get_icon) */
+    cairo_surface_t *icon;
+    int icon_size, icon_scale;  /* What icon was decoded for; 0 = not yet */
+} WinCacheEntry;
+
+/* What a PropertyNotify changed */
+typedef enum {
+    WIN_CACHE_CLASS = 1 << 0,   /* WM_CLASS (the group) */
+    WIN_CACHE_NAME  = 1 << 1,
+    WIN_CACHE_STATE = 1 << 2,   /* _NET_WM_STATE / type: shown in the dock or not */
+    WIN_CACHE_ICON  = 1 << 3,
+} WinCacheChange;
+
+void win_cache_init(Display *dpy);
+
+/* Reads (and subscribes to) every window not cached yet, in one round trip */
+void win_cache_prefetch(const Window *windows, unsigned long n_windows);
+
+/* Entry for @xid, read from the server (and subscribed) the first time */
+const WinCacheEntry *win_cache_get(Window xid);
+
+/* Drops the windows no longer in the client list */
+void win_cache_retain(const Window *clients, unsigned long n_clients);
+
+/* Refreshes the property a PropertyNotify names; 0 if not a cached window */
+WinCacheChange win_cache_handle_property(const XPropertyEvent *event);
+
+/* Grouping key: WM_CLASS class, else instance, else name, else "Unknown" */
+const char *win_cache_class(const WinCacheEntry *entry);
+
+/* Whether the window belongs in the dock (not a dock/desktop, not skip-taskbar) */
+gboolean win_cache_is_dock_window(const WinCacheEntry *entry);
+
+/* _NET_WM_ICON (the image closest to @size x @scale device px) scaled to
+ * @size logical px at @scale, owned by the cache until the property
+ * changes; NULL if the window has none */
+cairo_surface_t *win_cache_get_icon(Window xid, int size, int scale);
+
+#endif
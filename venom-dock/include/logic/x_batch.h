@@ -0,0 +1,37 @@
+#ifndef X_BATCH_H
+#define X_BATCH_H
+
+#include <glib.h>
+#include <X11/Xlib.h>
+#include <xcb/xcb.h>
+
+/*
+ * Pipelined reads over the Xlib display's XCB connection.
+ *
+ * Requests added to a batch are only written out by xbatch_run(), which
+ * then collects every reply: N properties/geometries cost one round trip
+ * instead of N.  Errors (e.g. a window destroyed meanwhile) come back as
+ * a NULL reply instead of going to the Xlib error handler.
+ */
+typedef struct XBatch XBatch;
+
+XBatch *xbatch_new(Display *dpy);
+void xbatch_free(XBatch *batch);
+
+/* Queue a request; returns the slot to read its reply from */
+guint xbatch_get_property(XBatch *batch, Window win, Atom property, Atom type, guint32 max_length);
+guint xbatch_get_geometry(XBatch *batch, Window win);
+
+/* Send everything queued and wait for all the replies */
+void xbatch_run(XBatch *batch);
+
+/* Replies, owned by the batch; NULL if the request failed */
+const xcb_get_property_reply_t *xbatch_property(XBatch *batch, guint slot);
+const xcb_get_geometry_reply_t *xbatch_geometry(XBatch *batch, guint slot);
+
+/* Property value helpers: unset, empty or of the wrong type -> NULL / FALSE */
+char *xbatch_string(XBatch *batch, guint slot);                         /* g_free; up to the first NUL */
+gboolean xbatch_cardinal(XBatch *batch, guint slot, long *value);       /* first item */
+const guint32 *xbatch_cardinals(XBatch *batch, guint slot, guint *n);   /* format 32 */
+
+#endif
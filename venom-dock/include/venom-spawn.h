@@ -0,0 +1,448 @@
+/*
+ * venom-spawn.h
+ * Starts applications through the session spawn helper.
+ *
+ * The launcher, dock and panel are large GTK processes.  Forking one of
+ * them to start an app copies its page tables (and runs atfork handlers)
+ * before the exec, so the time from click to exec grows with the shell's
+ * memory size.  venom-spawnd (shipped with venom-launcher) is a tiny
+ * process started with the session; clients send it argv, environment
+ * and working directory over a Unix socket and it posix_spawn()s the app
+ * in a new session, so the cost no longer depends on the caller.
+ *
+ * Protocol ($XDG_RUNTIME_DIR/venom/spawn.sock, SOCK_SEQPACKET, one
+ * request and one reply per connection):
+ *
+ *   request  VenomSpawnRequest | cwd \0 | argv[argc] \0... | envp[envc] \0...
+ *   reply    VenomSpawnReply
+ *
+ * posix_spawn() only returns once the child has exec'd, so the reply
+ * marks the moment the app starts running.  If the request cannot be
+ * delivered, the app is spawned locally as before and the helper is
+ * (re)started for next time.  Once it has been delivered the helper may
+ * spawn the app at any moment, so a missing reply is never a reason to
+ * spawn it again locally.  Callers block for at most
+ * VENOM_SPAWN_REPLY_WAIT_MS; a later reply is picked up from the main
+ * loop and only logged.
+ *
+ * Header-only; the same file is used by the launcher, dock and panel.
+ * Define VENOM_SPAWN_PROTOCOL_ONLY to get just the wire format (the
+ * helper itself does not link GLib).  Code built with strict -std=c11
+ * must define _DEFAULT_SOURCE before including it.
+ */
+
+#ifndef VENOM_SPAWN_H
+#define VENOM_SPAWN_H
+
+#include <stdint.h>
+
+#define VENOM_SPAWN_MAGIC       0x4e505356u   /* "VSPN" */
+#define VENOM_SPAWN_SOCKET      "venom/spawn.sock"   /* under $XDG_RUNTIME_DIR */
+#define VENOM_SPAWN_MAX_REQUEST (256 * 1024)
+#define VENOM_SPAWN_HELPER      "venom-spawnd"
+#define VENOM_SPAWN_REPLY_WAIT_MS 250  /* blocking wait for the reply, on the caller's thread */
+#define VENOM_SPAWN_REPLY_TIMEOUT 10   /* s; then the main loop stops waiting for it */
+#define VENOM_SPAWN_RESTART_DELAY 5    /* s between attempts to (re)start the helper */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t flags;             /* reserved, 0 */
+    uint32_t argc;
+    uint32_t envc;
+} VenomSpawnRequest;
+
+typedef struct {
+    int32_t  pid;               /* > 0 on success */
+    int32_t  error;             /* errno on failure */
+    int64_t  spawn_us;          /* time the helper spent in posix_spawn */
+} VenomSpawnReply;
+
+#ifndef VENOM_SPAWN_PROTOCOL_ONLY
+
+#include <glib.h>
+#include <glib-unix.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static inline void venom_spawn_child_setup(gpointer user_data) {
+    (void)user_data;
+    setsid();
+}
+
+/*
+ * Starts the helper after a failed connect, at most once per
+ * VENOM_SPAWN_RESTART_DELAY, so one that crashed comes back; the launch
+ * in progress runs locally.
+ */
+static inline void venom_spawn_start_helper(void) {
+    static GMutex lock;
+    static gint64 last_start = 0;
+    gint64 now = g_get_monotonic_time();
+
+    g_mutex_lock(&lock);
+    gboolean due = last_start == 0 || now - last_start >= VENOM_SPAWN_RESTART_DELAY * G_USEC_PER_SEC;
+    if (due) last_start = now;
+    g_mutex_unlock(&lock);
+    if (!due) return;
+
+    gchar *argv[] = { VENOM_SPAWN_HELPER, NULL };
+    g_spawn_async(NULL, argv, NULL, G_SPAWN_SEARCH_PATH, venom_spawn_child_setup, NULL, NULL, NULL);
+}
+
+/* Connected socket to the helper, or -1 */
+static inline int venom_spawn_connect(void) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    char *path = g_build_filename(g_get_user_runtime_dir(), VENOM_SPAWN_SOCKET, NULL);
+    gboolean fits = strlen(path) < sizeof(addr.sun_path);
+    if (fits) strcpy(addr.sun_path, path);
+    g_free(path);
+    if (!fits) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    /* A wedged helper must not freeze the shell: fall back after a second */
+    struct timeval timeout = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Sends the request for @argv.  Returns the socket to read the reply
+ * from, or -1 if the request could not be delivered, so spawning
+ * locally is safe.
+ */
+static inline int venom_spawn_send(const char *cwd, char **argv, char **envp) {
+    int fd = venom_spawn_connect();
+    if (fd < 0) return -1;
+
+    VenomSpawnRequest req = { VENOM_SPAWN_MAGIC, 0, g_strv_length(argv), g_strv_length(envp) };
+    GByteArray *msg = g_byte_array_sized_new(4096);
+    g_byte_array_append(msg, (const guint8 *)&req, sizeof(req));
+    g_byte_array_append(msg, (const guint8 *)cwd, strlen(cwd) + 1);
+    for (char **a = argv; *a; a++) g_byte_array_append(msg, (const guint8 *)*a, strlen(*a) + 1);
+    for (char **e = envp; *e; e++) g_byte_array_append(msg, (const guint8 *)*e, strlen(*e) + 1);
+
+    /* SOCK_SEQPACKET: the request is delivered whole or not at all */
+    gboolean sent = msg->len <= VENOM_SPAWN_MAX_REQUEST &&
+                    send(fd, msg->data, msg->len, MSG_NOSIGNAL) == (ssize_t)msg->len;
+    g_byte_array_unref(msg);
+    if (!sent) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Waits up to @timeout_ms for the reply on @fd.  FALSE if it has not
+ * come yet (@fd stays open); otherwise closes @fd and sets *@error_out
+ * to 0 on success, the child's errno, or EPROTO for a broken reply.
+ */
+static inline gboolean venom_spawn_read_reply(int fd, int timeout_ms,
+                                              VenomSpawnReply *reply, int *error_out) {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int ready;
+    do ready = poll(&pfd, 1, timeout_ms); while (ready < 0 && errno == EINTR);
+    if (ready == 0) return FALSE;
+
+    ssize_t n = recv(fd, reply, sizeof(*reply), MSG_DONTWAIT);
+    close(fd);
+
+    if (n != (ssize_t)sizeof(*reply)) *error_out = EPROTO;
+    else if (reply->pid <= 0)         *error_out = reply->error ? reply->error : EINVAL;
+    else                              *error_out = 0;
+    return TRUE;
+}
+
+/*
+ * Asks the helper to spawn @argv and waits for the reply (up to
+ * VENOM_SPAWN_REPLY_TIMEOUT; for tools, not the UI thread).  Returns
+ * FALSE with *@error_out = 0 if the request could not be delivered,
+ * otherwise FALSE with an errno: the child's, or ETIMEDOUT / EPROTO if
+ * the helper did not answer properly (the app may have started anyway).
+ */
+static inline gboolean venom_spawn_request(const char *cwd, char **argv, char **envp,
+                                           VenomSpawnReply *reply, int *error_out) {
+    *error_out = 0;
+    int fd = venom_spawn_send(cwd, argv, envp);
+    if (fd < 0) return FALSE;
+
+    if (!venom_spawn_read_reply(fd, VENOM_SPAWN_REPLY_TIMEOUT * 1000, reply, error_out)) {
+        close(fd);
+        *error_out = ETIMEDOUT;
+    }
+    return *error_out == 0;
+}
+
+static inline void venom_spawn_set_error(GError **error, const char *program, int err) {
+    if (err == ETIMEDOUT || err == EPROTO) {
+        g_set_error(error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED,
+                    "No answer from %s for \"%s\" (%s); it may still be starting",
+                    VENOM_SPAWN_HELPER, program, g_strerror(err));
+        return;
+    }
+    GSpawnError code = err == ENOENT ? G_SPAWN_ERROR_NOENT :
+                       err == EACCES ? G_SPAWN_ERROR_ACCES :
+                       err == ENOEXEC ? G_SPAWN_ERROR_NOEXEC : G_SPAWN_ERROR_FAILED;
+    g_set_error(error, G_SPAWN_ERROR, code, "Failed to execute child process \"%s\" (%s)",
+                program, g_strerror(err));
+}
+
+/* Called if a launch failed (from the main loop for a late reply) */
+typedef void (*VenomSpawnFailedFunc)(gpointer user_data);
+
+/* A reply that did not come within VENOM_SPAWN_REPLY_WAIT_MS */
+typedef struct {
+    int fd;
+    guint fd_source, timeout_source;
+    char *program;
+    gint64 start;
+    VenomSpawnFailedFunc failed;
+    gpointer user_data;
+    GDestroyNotify destroy;
+} VenomSpawnPending;
+
+static inline void venom_spawn_pending_finish(VenomSpawnPending *pending, int err) {
+    if (err) {
+        GError *error = NULL;
+        venom_spawn_set_error(&error, pending->program, err);
+        g_warning("Spawn: %s", error->message);
+        g_error_free(error);
+        if (pending->failed) pending->failed(pending->user_data);
+    } else {
+        g_debug("Spawn: %s exec'd in %.2f ms via %s (late reply)", pending->program,
+                (g_get_monotonic_time() - pending->start) / 1000.0, VENOM_SPAWN_HELPER);
+    }
+
+    if (pending->fd_source) g_source_remove(pending->fd_source);
+    if (pending->timeout_source) g_source_remove(pending->timeout_source);
+    if (pending->destroy) pending->destroy(pending->user_data);
+    g_free(pending->program);
+    g_free(pending);
+}
+
+static inline gboolean venom_spawn_pending_ready(gint fd, GIOCondition condition, gpointer data) {
+    (void)fd; (void)condition;
+    VenomSpawnPending *pending = data;
+    VenomSpawnReply reply;
+    int err = 0;
+
+    if (!venom_spawn_read_reply(pending->fd, 0, &reply, &err)) return G_SOURCE_CONTINUE;
+    pending->fd_source = 0;
+    venom_spawn_pending_finish(pending, err);
+    return G_SOURCE_REMOVE;
+}
+
+static inline gboolean venom_spawn_pending_timeout(gpointer data) {
+    VenomSpawnPending *pending = data;
+    pending->timeout_source = 0;
+    g_source_remove(pending->fd_source);
+    pending->fd_source = 0;
+    close(pending->fd);
+    venom_spawn_pending_finish(pending, ETIMEDOUT);
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * venom_spawn_async() with a callback for a failed launch — when FALSE
+ * is returned, and for a late error reply after TRUE was; @destroy
+ * frees @user_data once the outcome is known.
+ */
+static inline gboolean venom_spawn_async_full(const char *cwd, char **argv, char **envp,
+                                              VenomSpawnFailedFunc failed, gpointer user_data,
+                                              GDestroyNotify destroy, GError **error) {
+    g_return_val_if_fail(argv != NULL && argv[0] != NULL, FALSE);
+
+    gint64 start = g_get_monotonic_time();
+    char *own_cwd = cwd ? NULL : g_get_current_dir();
+    char **own_env = envp ? NULL : g_get_environ();
+    VenomSpawnReply reply = { 0 };
+    int err = 0;
+    gboolean ok = TRUE;
+    gboolean pending = FALSE;
+
+    int fd = venom_spawn_send(cwd ? cwd : own_cwd, argv, envp ? envp : own_env);
+    if (fd < 0) {
+        venom_spawn_start_helper();
+        ok = g_spawn_async(cwd, argv, envp, G_SPAWN_SEARCH_PATH, venom_spawn_child_setup, NULL, NULL, error);
+        if (ok)
+            g_debug("Spawn: %s exec'd in %.2f ms locally", argv[0], (g_get_monotonic_time() - start) / 1000.0);
+    } else if (!venom_spawn_read_reply(fd, VENOM_SPAWN_REPLY_WAIT_MS, &reply, &err)) {
+        /* Delivered but slow (a long exec, clients queued ahead): never spawn
+         * again locally, and do not hold up the UI — collect it later */
+        VenomSpawnPending *p = g_new0(VenomSpawnPending, 1);
+        p->fd = fd;
+        p->program = g_strdup(argv[0]);
+        p->start = start;
+        p->failed = failed;
+        p->user_data = user_data;
+        p->destroy = destroy;
+        p->fd_source = g_unix_fd_add(fd, G_IO_IN | G_IO_HUP | G_IO_ERR, venom_spawn_pending_ready, p);
+        p->timeout_source = g_timeout_add_seconds(VENOM_SPAWN_REPLY_TIMEOUT, venom_spawn_pending_timeout, p);
+        pending = TRUE;
+    } else if (err) {
+        venom_spawn_set_error(error, argv[0], err);
+        ok = FALSE;
+    } else {
+        g_debug("Spawn: %s exec'd in %.2f ms via %s (posix_spawn %.2f ms)", argv[0],
+                (g_get_monotonic_time() - start) / 1000.0, VENOM_SPAWN_HELPER, reply.spawn_us / 1000.0);
+    }
+
+    if (!ok && failed) failed(user_data);
+    if (!pending && destroy) destroy(user_data);
+    g_free(own_cwd);
+    g_strfreev(own_env);
+    return ok;
+}
+
+/*
+ * Spawns @argv (searched in PATH) detached in its own session, in @cwd
+ * (NULL: ours) with @envp (NULL: ours).  Through the helper when it is
+ * running, locally otherwise.  The click-to-exec time is logged with
+ * g_debug (G_MESSAGES_DEBUG=all to see it).
+ */
+static inline gboolean venom_spawn_async(const char *cwd, char **argv, char **envp, GError **error) {
+    return venom_spawn_async_full(cwd, argv, envp, NULL, NULL, NULL, error);
+}
+
+/* Same for a shell-quoted command line (no shell is involved) */
+static inline gboolean venom_spawn_command_line(const char *command_line, GError **error) {
+    char **argv = NULL;
+    if (!g_shell_parse_argv(command_line, NULL, &argv, error)) return FALSE;
+    gboolean ok = venom_spawn_async(NULL, argv, NULL, error);
+    g_strfreev(argv);
+    return ok;
+}
+
+#ifdef G_TYPE_DESKTOP_APP_INFO
+/*
+ * Argv for a desktop entry's Exec with no files or URIs: %f %F %u %U are
+ * dropped, %i becomes --icon <Icon>, %c the name, %k the file, %% a '%'.
+ */
+static inline char **venom_spawn_desktop_argv(GDesktopAppInfo *info, GError **error) {
+    const char *exec = g_app_info_get_commandline(G_APP_INFO(info));
+    char **raw = NULL;
+    if (!exec || !g_shell_parse_argv(exec, NULL, &raw, error)) {
+        if (!exec) g_set_error(error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED, "Desktop entry has no Exec");
+        return NULL;
+    }
+
+    GPtrArray *argv = g_ptr_array_new();
+    for (char **a = raw; *a; a++) {
+        if (strcmp(*a, "%i") == 0) {
+            char *icon = g_desktop_app_info_get_string(info, "Icon");
+            if (icon) {
+                g_ptr_array_add(argv, g_strdup("--icon"));
+                g_ptr_array_add(argv, icon);
+            }
+            continue;
+        }
+        if (strlen(*a) == 2 && (*a)[0] == '%' && strchr("fFuUdDnNvm", (*a)[1])) continue;
+
+        GString *arg = g_string_new(NULL);
+        for (const char *p = *a; *p; p++) {
+            if (*p != '%' || !p[1]) {
+                g_string_append_c(arg, *p);
+                continue;
+            }
+            p++;
+            if (*p == '%') g_string_append_c(arg, '%');
+            else if (*p == 'c') g_string_append(arg, g_app_info_get_name(G_APP_INFO(info)));
+            else if (*p == 'k' && g_desktop_app_info_get_filename(info))
+                g_string_append(arg, g_desktop_app_info_get_filename(info));
+        }
+        g_ptr_array_add(argv, g_string_free(arg, FALSE));
+    }
+    g_ptr_array_add(argv, NULL);
+    g_strfreev(raw);
+    return (char **)g_ptr_array_free(argv, FALSE);
+}
+
+/* Startup notification of a launch through the helper, for a late failure */
+typedef struct {
+    GAppLaunchContext *context;
+    char *startup_id;
+} VenomSpawnLaunch;
+
+static inline void venom_spawn_launch_failed(gpointer data) {
+    VenomSpawnLaunch *launch = data;
+    g_app_launch_context_launch_failed(launch->context, launch->startup_id);
+}
+
+static inline void venom_spawn_launch_free(gpointer data) {
+    VenomSpawnLaunch *launch = data;
+    g_object_unref(launch->context);
+    g_free(launch->startup_id);
+    g_free(launch);
+}
+
+/*
+ * Launches a desktop entry through the helper (Exec in Path).  Entries
+ * that need more than an exec — Terminal=true, D-Bus activation — go
+ * through g_app_info_launch() as before.  With a @context, its
+ * environment is passed on and, for StartupNotify=true entries, a
+ * startup notification started (DESKTOP_STARTUP_ID), as GIO does.
+ */
+static inline gboolean venom_spawn_desktop_app(GDesktopAppInfo *info, GAppLaunchContext *context,
+                                               GError **error) {
+    if (g_desktop_app_info_get_boolean(info, "Terminal") ||
+        g_desktop_app_info_get_boolean(info, "DBusActivatable"))
+        return g_app_info_launch(G_APP_INFO(info), NULL, context, error);
+
+    char **argv = venom_spawn_desktop_argv(info, error);
+    if (!argv) return FALSE;
+    if (!argv[0]) {
+        g_set_error(error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED, "Desktop entry has an empty Exec");
+        g_strfreev(argv);
+        return FALSE;
+    }
+
+    char **envp = NULL;
+    VenomSpawnLaunch *launch = NULL;
+    if (context) {
+        envp = g_get_environ();
+        char **extra = g_app_launch_context_get_environment(context);
+        for (char **e = extra; e && *e; e++) {
+            char *eq = strchr(*e, '=');
+            if (!eq) continue;
+            *eq = '\0';
+            envp = g_environ_setenv(envp, *e, eq + 1, TRUE);
+        }
+        g_strfreev(extra);
+
+        if (g_desktop_app_info_get_boolean(info, "StartupNotify")) {
+            char *startup_id = g_app_launch_context_get_startup_notify_id(context, G_APP_INFO(info), NULL);
+            if (startup_id) {
+                envp = g_environ_setenv(envp, "DESKTOP_STARTUP_ID", startup_id, TRUE);
+                launch = g_new0(VenomSpawnLaunch, 1);
+                launch->context = g_object_ref(context);
+                launch->startup_id = startup_id;
+            }
+        }
+    }
+
+    char *path = g_desktop_app_info_get_string(info, "Path");
+    gboolean ok = venom_spawn_async_full(path && *path ? path : NULL, argv, envp,
+                                         launch ? venom_spawn_launch_failed : NULL,
+                                         launch, launch ? venom_spawn_launch_free : NULL, error);
+    g_free(path);
+    g_strfreev(envp);
+    g_strfreev(argv);
+    return ok;
+}
+#endif /* G_TYPE_DESKTOP_APP_INFO */
+
+#endif /* VENOM_SPAWN_PROTOCOL_ONLY */
+
+#endif /* VENOM_SPAWN_H */
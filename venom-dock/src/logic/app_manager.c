@@ -1,61 +1,65 @@
 #include "logic/app_manager.h"
+#include "venom-session-catalog.h"
+#include "venom-icon-atlas.h"
+#include "venom-spawn.h"
 #include <string.h>
 #include <stdlib.h>
-#include <unistd.h>
-
-static void child_setup(gpointer user_data) {
-    (void)user_data;
-    setsid();
-}
 
 /* Static cache */
 static GList *cached_apps = NULL;
 static gboolean cache_initialized = FALSE;
 
-/* Programmatic Fallback */
-static GdkPixbuf *create_fallback_pixbuf(void) {
-    GdkPixbuf *pix = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, 48, 48);
-    if (pix) gdk_pixbuf_fill(pix, 0x777777FF); /* Neutral Grey */
-    return pix;
+/* Session catalog snapshot (venom-catalogd); NULL = scan ourselves */
+static VenomCatalog *catalog = NULL;
+static gboolean catalog_subscribed = FALSE;
+
+/* WM_CLASS -> desktop entry index (below), built from the catalog if any */
+static GHashTable *class_index = NULL;    /* lowercased key -> AppMatch */
+
+static void free_app_info(gpointer data) {
+    AppInfo *info = (AppInfo *)data;
+    g_free(info->name);
+    g_free(info->icon);
+    g_free(info->desktop_file_path);
+    g_free(info);
 }
 
-/* Helper to load icon */
-static GdkPixbuf *load_app_icon(GAppInfo *info) {
-    GIcon *icon = g_app_info_get_icon(info);
-    GError *error = NULL;
-    GdkPixbuf *pix = NULL;
-    
-    GtkIconTheme *theme = gtk_icon_theme_get_default();
-    
-    if (icon) {
-        GtkIconInfo *icon_info = gtk_icon_theme_lookup_by_gicon(theme, icon, 64, GTK_ICON_LOOKUP_FORCE_SIZE);
-        if (icon_info) {
-            pix = gtk_icon_info_load_icon(icon_info, &error);
-            g_object_unref(icon_info);
-            
-            if (!pix) {
-                if (error) g_error_free(error);
-                error = NULL;
-            }
-        }
-    }
-    
-    /* Fallback 1: Generic Icon (Only if it exists) */
-    if (!pix) {
-        if (gtk_icon_theme_has_icon(theme, "application-x-executable")) {
-             pix = gtk_icon_theme_load_icon(theme, "application-x-executable", 64, GTK_ICON_LOOKUP_FORCE_SIZE, NULL);
-        }
-    }
-    
-    /* Fallback 2: Generated Pixbuf (Guaranteed) */
-    if (!pix) {
-        pix = create_fallback_pixbuf();
+/* A new snapshot was published: drop ours, the local scan and the class index */
+static void on_catalog_changed(guint32 version, gpointer user_data) {
+    (void)version; (void)user_data;
+    venom_catalog_free(catalog);
+    catalog = NULL;
+    g_clear_pointer(&class_index, g_hash_table_destroy);
+    g_list_free_full(cached_apps, free_app_info);
+    cached_apps = NULL;
+    cache_initialized = FALSE;
+}
+
+/*
+ * Apps from the snapshot, already sorted by name.  Icons are not decoded
+ * here: callers load the icon name lazily, only for what they show.
+ */
+static GList *scan_catalog(void) {
+    GList *apps = NULL;
+    for (guint i = venom_catalog_n_apps(catalog); i-- > 0; ) {
+        const VenomCatalogRecord *rec = venom_catalog_record(catalog, i);
+        AppInfo *info = g_malloc0(sizeof(AppInfo));
+        info->name = g_strdup(venom_catalog_str(catalog, rec->name));
+        info->icon = g_strdup(venom_catalog_str(catalog, rec->icon_name));
+        info->desktop_file_path = g_strdup(venom_catalog_str(catalog, rec->path));
+        apps = g_list_prepend(apps, info);
     }
-    
-    return pix;
+    return apps;
 }
 
 GList *app_mgr_scan_apps(void) {
+    if (!catalog_subscribed) {
+        catalog_subscribed = venom_catalog_subscribe(on_catalog_changed, NULL);
+    }
+    if (!catalog) catalog = venom_catalog_open();
+    if (catalog) return scan_catalog();
+
+    /* No session catalog yet: enumerate apps ourselves */
     if (cache_initialized) {
         GList *copy = NULL;
         for (GList *l = cached_apps; l != NULL; l = l->next) {
@@ -64,7 +68,6 @@ GList *app_mgr_scan_apps(void) {
             dst->name = g_strdup(src->name);
             dst->icon = g_strdup(src->icon);
             dst->desktop_file_path = g_strdup(src->desktop_file_path);
-            if (src->pixbuf) dst->pixbuf = g_object_ref(src->pixbuf);
             copy = g_list_append(copy, dst);
         }
         return copy;
@@ -92,9 +95,6 @@ GList *app_mgr_scan_apps(void) {
             info->desktop_file_path = g_strdup(fname);
         }
         
-        /* Pre-load Pixbuf */
-        info->pixbuf = load_app_icon(app_info);
-        
         cached_apps = g_list_append(cached_apps, info);
     }
     
@@ -105,29 +105,167 @@ GList *app_mgr_scan_apps(void) {
     return app_mgr_scan_apps();
 }
 
-void app_mgr_free_list(GList *apps) {
-    for (GList *l = apps; l != NULL; l = l->next) {
-        AppInfo *info = (AppInfo *)l->data;
-        g_free(info->name);
-        g_free(info->icon);
-        g_free(info->desktop_file_path);
-        if (info->pixbuf) g_object_unref(info->pixbuf);
-        g_free(info);
+/* -------------------------------------------------------------------------
+ * WM_CLASS -> desktop entry index
+ * ------------------------------------------------------------------------- */
+
+/* Match strength; a key keeps the strongest entry that claims it */
+typedef enum {
+    MATCH_WM_CLASS,     /* StartupWMClass */
+    MATCH_ID,           /* desktop id without ".desktop" */
+    MATCH_EXEC          /* basename of the executable */
+} MatchKind;
+
+typedef struct {
+    char *desktop_file_path;
+    char *icon;
+    MatchKind kind;
+    gboolean shown;     /* Not NoDisplay: preferred on equal strength */
+} AppMatch;
+
+static gboolean index_from_catalog = FALSE;
+static gboolean index_monitored = FALSE;
+
+static void free_match(gpointer data) {
+    AppMatch *match = (AppMatch *)data;
+    g_free(match->desktop_file_path);
+    g_free(match->icon);
+    g_free(match);
+}
+
+/* Installed apps changed (GIO watches the application dirs): rebuild lazily */
+static void on_installed_apps_changed(GAppInfoMonitor *monitor, gpointer user_data) {
+    (void)monitor; (void)user_data;
+    if (!index_from_catalog) g_clear_pointer(&class_index, g_hash_table_destroy);
+}
+
+static void index_add(const char *key, const char *path, const char *icon, MatchKind kind, gboolean shown) {
+    if (!key || !*key) return;
+    gchar *lower = g_ascii_strdown(key, -1);
+
+    AppMatch *old = g_hash_table_lookup(class_index, lower);
+    if (old && (old->kind < kind || (old->kind == kind && (old->shown || !shown)))) {
+        g_free(lower);
+        return;
     }
-    g_list_free(apps);
+
+    AppMatch *match = g_malloc0(sizeof(AppMatch));
+    match->desktop_file_path = g_strdup(path);
+    match->icon = g_strdup(icon);
+    match->kind = kind;
+    match->shown = shown;
+    g_hash_table_replace(class_index, lower, match);
 }
 
-gboolean app_mgr_launch_detached(const char *cmd_line, GError **error) {
-    if (!cmd_line) return FALSE;
-    
-    int argc;
-    char **argv;
-    if (g_shell_parse_argv(cmd_line, &argc, &argv, error)) {
-        gboolean success = g_spawn_async(NULL, argv, NULL, G_SPAWN_SEARCH_PATH, child_setup, NULL, NULL, error);
+/* The desktop id and executable keys of one entry */
+static void index_add_id_exec(const char *id, const char *exec, const char *path, const char *icon, gboolean shown) {
+    if (id) {
+        gchar *stem = g_strndup(id, g_str_has_suffix(id, ".desktop") ? strlen(id) - 8 : strlen(id));
+        index_add(stem, path, icon, MATCH_ID, shown);
+        g_free(stem);
+    }
+
+    /* Launch wrappers say nothing about the app */
+    if (exec) {
+        gchar *base = g_path_get_basename(exec);
+        if (!g_str_equal(base, "env") && !g_str_equal(base, "sh") &&
+            !g_str_equal(base, "bash") && !g_str_equal(base, "flatpak")) {
+            index_add(base, path, icon, MATCH_EXEC, shown);
+        }
+        g_free(base);
+    }
+}
+
+/* From the session catalog: its records only list shown apps */
+static void build_index_from_catalog(void) {
+    for (guint i = 0; i < venom_catalog_n_apps(catalog); i++) {
+        const VenomCatalogRecord *rec = venom_catalog_record(catalog, i);
+        const char *path = venom_catalog_str(catalog, rec->path);
+        const char *icon = venom_catalog_str(catalog, rec->icon_name);
+
+        index_add(venom_catalog_str(catalog, rec->startup_wm_class), path, icon, MATCH_WM_CLASS, TRUE);
+
+        /* Exec is stored without field codes; its first word is the executable */
+        gchar **argv = NULL;
+        const char *exec = venom_catalog_str(catalog, rec->exec);
+        if (exec && !g_shell_parse_argv(exec, NULL, &argv, NULL)) argv = NULL;
+        index_add_id_exec(venom_catalog_str(catalog, rec->id), argv ? argv[0] : NULL, path, icon, TRUE);
         g_strfreev(argv);
-        return success;
     }
-    return FALSE;
+}
+
+/* No session catalog: one pass over every installed desktop entry */
+static void build_index_from_gio(void) {
+    GList *all_apps = g_app_info_get_all();
+    for (GList *l = all_apps; l != NULL; l = l->next) {
+        if (!G_IS_DESKTOP_APP_INFO(l->data)) continue;
+        GDesktopAppInfo *info = G_DESKTOP_APP_INFO(l->data);
+        const char *path = g_desktop_app_info_get_filename(info);
+        gchar *icon = g_desktop_app_info_get_string(info, "Icon");
+        gboolean shown = g_app_info_should_show(G_APP_INFO(info));
+
+        index_add(g_desktop_app_info_get_startup_wm_class(info), path, icon, MATCH_WM_CLASS, shown);
+        index_add_id_exec(g_app_info_get_id(G_APP_INFO(info)),
+                          g_app_info_get_executable(G_APP_INFO(info)), path, icon, shown);
+        g_free(icon);
+    }
+    g_list_free_full(all_apps, g_object_unref);
+}
+
+static void build_class_index(void) {
+    class_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_match);
+
+    if (!catalog) catalog = venom_catalog_open();
+    index_from_catalog = catalog != NULL;
+    if (index_from_catalog) {
+        build_index_from_catalog();
+        return;
+    }
+
+    if (!index_monitored) {
+        g_signal_connect(g_app_info_monitor_get(), "changed",
+                         G_CALLBACK(on_installed_apps_changed), NULL);
+        index_monitored = TRUE;
+    }
+    build_index_from_gio();
+}
+
+static const AppMatch *lookup_class(const char *key) {
+    if (!key || !*key) return NULL;
+    gchar *lower = g_ascii_strdown(key, -1);
+    const AppMatch *match = g_hash_table_lookup(class_index, lower);
+    g_free(lower);
+    return match;
+}
+
+gboolean app_mgr_find_app_for_class(const char *wm_class, const char *instance,
+                                    char **desktop_file_path, char **icon) {
+    if (!catalog_subscribed) {
+        catalog_subscribed = venom_catalog_subscribe(on_catalog_changed, NULL);
+    }
+    if (!class_index) build_class_index();
+
+    const AppMatch *match = lookup_class(wm_class);
+    const AppMatch *by_instance = lookup_class(instance);
+    if (!match || (by_instance && by_instance->kind < match->kind)) match = by_instance;
+    if (!match) return FALSE;
+
+    if (desktop_file_path) *desktop_file_path = g_strdup(match->desktop_file_path);
+    if (icon) *icon = g_strdup(match->icon);
+    return TRUE;
+}
+
+cairo_surface_t *app_mgr_load_icon(const char *icon, int size, int scale) {
+    return venom_icon_atlas_load_icon(gtk_icon_theme_get_default(), icon, size, scale);
+}
+
+void app_mgr_free_list(GList *apps) {
+    g_list_free_full(apps, free_app_info);
+}
+
+gboolean app_mgr_launch_detached(const char *cmd_line, GError **error) {
+    if (!cmd_line) return FALSE;
+    return venom_spawn_command_line(cmd_line, error);
 }
 
 gboolean app_mgr_launch(const char *desktop_file_path, GError **error) {
@@ -136,38 +274,11 @@ gboolean app_mgr_launch(const char *desktop_file_path, GError **error) {
     
     GdkAppLaunchContext *context = gdk_display_get_app_launch_context(gdk_display_get_default());
     
-    /* Logic: Try detached if command line available */
-    const gchar *raw_cmd = g_app_info_get_commandline(G_APP_INFO(app_info));
-    gboolean success = FALSE;
-
-    if (raw_cmd) {
-        gchar *cmd_line = g_strdup(raw_cmd);
-        /* Strip codes */
-        const char *codes[] = {"%f", "%u", "%F", "%U", "%i", "%c", "%k", NULL};
-        for (int i = 0; codes[i] != NULL; i++) {
-            gchar *found;
-            while ((found = strstr(cmd_line, codes[i])) != NULL) {
-                found[0] = ' ';
-                found[1] = ' ';
-            }
-        }
-        
-        success = app_mgr_launch_detached(cmd_line, error);
-        if (!success && *error) {
-             /* Reset error for fallback? */
-             g_clear_error(error);
-        }
-        g_free(cmd_line);
-    }
-    
-    if (!success) {
-        /* Fallback */
-        success = g_app_info_launch(G_APP_INFO(app_info), NULL, G_APP_LAUNCH_CONTEXT(context), error);
-    }
+    /* Through the spawn helper; Terminal / D-Bus apps via GIO */
+    gboolean success = venom_spawn_desktop_app(app_info, G_APP_LAUNCH_CONTEXT(context), error);
     
     g_object_unref(context);
     g_object_unref(app_info);
     
     return success;
 }
-
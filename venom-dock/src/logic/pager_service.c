@@ -1,4 +1,5 @@
 #include "logic/pager_service.h"
+#include "logic/x_batch.h"
 #include <X11/Xatom.h>
 #include <X11/extensions/Xcomposite.h>
 #include <gdk/gdkx.h>
@@ -62,33 +63,82 @@ void pager_svc_set_desktop(int index) {
     XFlush(x_display);
 }
 
-GList *pager_svc_get_windows(int desktop_index) {
-    GList *windows = NULL;
+/* Client list in stacking order (falls back to _NET_CLIENT_LIST); free with XFree */
+static Window *get_client_list(unsigned long *n_windows) {
     Atom actual_type;
     int actual_format;
-    unsigned long nitems, bytes_after;
+    unsigned long nitems = 0, bytes_after;
     unsigned char *prop = NULL;
 
-    Atom list_atom = _net_client_list_stacking;
-    if (XGetWindowProperty(x_display, root_window, list_atom, 0, 1024, False,
+    if (XGetWindowProperty(x_display, root_window, _net_client_list_stacking, 0, 1024, False,
                            XA_WINDOW, &actual_type, &actual_format, &nitems, &bytes_after, &prop) != Success) {
-        list_atom = _net_client_list;
-        XGetWindowProperty(x_display, root_window, list_atom, 0, 1024, False,
+        XGetWindowProperty(x_display, root_window, _net_client_list, 0, 1024, False,
                            XA_WINDOW, &actual_type, &actual_format, &nitems, &bytes_after, &prop);
     }
-    
-    if (prop) {
-        Window *list = (Window *)prop;
-        for (unsigned long i = 0; i < nitems; i++) {
-            Window win = list[i];
-            long win_desktop = get_x11_property(win, _net_wm_desktop);
-            if (win_desktop == desktop_index || win_desktop == 0xFFFFFFFF) {
-                windows = g_list_append(windows, GINT_TO_POINTER(win));
-            }
+    *n_windows = prop ? nitems : 0;
+    return (Window *)prop;
+}
+
+GArray *pager_svc_get_window_infos(void) {
+    GArray *infos = g_array_new(FALSE, TRUE, sizeof(PagerWindowInfo));
+    unsigned long n_windows;
+    Window *list = get_client_list(&n_windows);
+    if (!list) return infos;
+
+    /* Every _NET_WM_DESKTOP and geometry request first, then the replies */
+    XBatch *batch = xbatch_new(x_display);
+    guint *slots = g_new(guint, n_windows * 2);
+    for (unsigned long i = 0; i < n_windows; i++) {
+        slots[i * 2] = xbatch_get_property(batch, list[i], _net_wm_desktop, XA_CARDINAL, 1);
+        slots[i * 2 + 1] = xbatch_get_geometry(batch, list[i]);
+    }
+    xbatch_run(batch);
+
+    for (unsigned long i = 0; i < n_windows; i++) {
+        PagerWindowInfo info = { .win = list[i], .desktop = -1 };
+        xbatch_cardinal(batch, slots[i * 2], &info.desktop);
+
+        const xcb_get_geometry_reply_t *geometry = xbatch_geometry(batch, slots[i * 2 + 1]);
+        if (geometry) {
+            info.has_geometry = TRUE;
+            info.x = geometry->x;
+            info.y = geometry->y;
+            info.width = geometry->width;
+            info.height = geometry->height;
+        }
+        g_array_append_val(infos, info);
+    }
+
+    g_free(slots);
+    xbatch_free(batch);
+    XFree(list);
+    return infos;
+}
+
+GList *pager_svc_get_windows(int desktop_index) {
+    GList *windows = NULL;
+    unsigned long n_windows;
+    Window *list = get_client_list(&n_windows);
+    if (!list) return NULL;
+
+    /* One round trip for every window's _NET_WM_DESKTOP (slot i = window i) */
+    XBatch *batch = xbatch_new(x_display);
+    for (unsigned long i = 0; i < n_windows; i++) {
+        xbatch_get_property(batch, list[i], _net_wm_desktop, XA_CARDINAL, 1);
+    }
+    xbatch_run(batch);
+
+    for (unsigned long i = 0; i < n_windows; i++) {
+        long win_desktop = -1;
+        xbatch_cardinal(batch, i, &win_desktop);
+        if (win_desktop == desktop_index || win_desktop == 0xFFFFFFFF) {
+            windows = g_list_prepend(windows, GINT_TO_POINTER(list[i]));
         }
-        XFree(prop);
     }
-    return windows;
+
+    xbatch_free(batch);
+    XFree(list);
+    return g_list_reverse(windows);
 }
 
 Pixmap pager_svc_get_pixmap(Window win) {
@@ -162,13 +212,18 @@ GdkPixbuf *pager_svc_get_snapshot_pixbuf(Window win, int width, int height) {
 }
 
 gboolean pager_svc_get_window_geometry(Window win, int *x, int *y, int *width, int *height) {
-    XWindowAttributes attrs;
-    if (XGetWindowAttributes(x_display, win, &attrs)) {
-        if (x) *x = attrs.x;
-        if (y) *y = attrs.y;
-        if (width) *width = attrs.width;
-        if (height) *height = attrs.height;
-        return TRUE;
+    /* GetGeometry alone (XGetWindowAttributes costs a second round trip) */
+    XBatch *batch = xbatch_new(x_display);
+    guint slot = xbatch_get_geometry(batch, win);
+    xbatch_run(batch);
+
+    const xcb_get_geometry_reply_t *geometry = xbatch_geometry(batch, slot);
+    if (geometry) {
+        if (x) *x = geometry->x;
+        if (y) *y = geometry->y;
+        if (width) *width = geometry->width;
+        if (height) *height = geometry->height;
     }
-    return FALSE;
+    xbatch_free(batch);
+    return geometry != NULL;
 }
@@ -0,0 +1,347 @@
+#include "logic/window_cache.h"
+#include "logic/x_batch.h"
+#include <gdk/gdkx.h>
+#include <X11/Xatom.h>
+#include <string.h>
+
+static Display *x_display = NULL;
+static GHashTable *entries = NULL; /* XID -> WinCacheEntry */
+
+static Atom wm_class_atom;
+static Atom wm_name_atom;
+static Atom net_wm_name_atom;
+static Atom utf8_string_atom;
+static Atom net_wm_state_atom;
+static Atom net_wm_state_skip_taskbar_atom;
+static Atom net_wm_window_type_atom;
+static Atom net_wm_window_type_dock_atom;
+static Atom net_wm_window_type_desktop_atom;
+static Atom net_wm_icon_atom;
+
+static void free_entry(gpointer data) {
+    WinCacheEntry *entry = (WinCacheEntry *)data;
+    g_free(entry->res_name);
+    g_free(entry->res_class);
+    g_free(entry->name);
+    if (entry->icon) cairo_surface_destroy(entry->icon);
+    g_free(entry);
+}
+
+void win_cache_init(Display *dpy) {
+    x_display = dpy;
+    wm_class_atom = XInternAtom(dpy, "WM_CLASS", False);
+    wm_name_atom = XInternAtom(dpy, "WM_NAME", False);
+    net_wm_name_atom = XInternAtom(dpy, "_NET_WM_NAME", False);
+    utf8_string_atom = XInternAtom(dpy, "UTF8_STRING", False);
+    net_wm_state_atom = XInternAtom(dpy, "_NET_WM_STATE", False);
+    net_wm_state_skip_taskbar_atom = XInternAtom(dpy, "_NET_WM_STATE_SKIP_TASKBAR", False);
+    net_wm_window_type_atom = XInternAtom(dpy, "_NET_WM_WINDOW_TYPE", False);
+    net_wm_window_type_dock_atom = XInternAtom(dpy, "_NET_WM_WINDOW_TYPE_DOCK", False);
+    net_wm_window_type_desktop_atom = XInternAtom(dpy, "_NET_WM_WINDOW_TYPE_DESKTOP", False);
+    net_wm_icon_atom = XInternAtom(dpy, "_NET_WM_ICON", False);
+
+    entries = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free_entry);
+}
+
+/*
+ * Property reads go through an XBatch: everything a batch of windows
+ * needs is requested at once and costs a single round trip.
+ */
+typedef struct {
+    guint wm_class, net_wm_name, wm_name, state, type;
+} PropSlots;
+
+static void queue_class(XBatch *batch, Window xid, PropSlots *slots) {
+    slots->wm_class = xbatch_get_property(batch, xid, wm_class_atom, XA_STRING, 1024);
+}
+
+static void queue_name(XBatch *batch, Window xid, PropSlots *slots) {
+    /* _NET_WM_NAME (UTF-8) and the WM_NAME fallback together */
+    slots->net_wm_name = xbatch_get_property(batch, xid, net_wm_name_atom, utf8_string_atom, 1024);
+    slots->wm_name = xbatch_get_property(batch, xid, wm_name_atom, XA_STRING, 1024);
+}
+
+static void queue_state(XBatch *batch, Window xid, PropSlots *slots) {
+    slots->state = xbatch_get_property(batch, xid, net_wm_state_atom, XA_ATOM, 1024);
+}
+
+static void queue_type(XBatch *batch, Window xid, PropSlots *slots) {
+    slots->type = xbatch_get_property(batch, xid, net_wm_window_type_atom, XA_ATOM, 1024);
+}
+
+static void apply_class(WinCacheEntry *entry, XBatch *batch, guint slot) {
+    g_clear_pointer(&entry->res_name, g_free);
+    g_clear_pointer(&entry->res_class, g_free);
+
+    const xcb_get_property_reply_t *reply = xbatch_property(batch, slot);
+    if (!reply || reply->format != 8) return;
+    int len = xcb_get_property_value_length(reply);
+    if (len <= 0) return;
+
+    /* WM_CLASS contains instance\0class\0 */
+    const char *instance = xcb_get_property_value(reply);
+    size_t instance_len = strnlen(instance, len);
+    entry->res_name = g_strndup(instance, instance_len);
+    if (instance_len + 1 < (size_t)len) {
+        entry->res_class = g_strndup(instance + instance_len + 1, len - instance_len - 1);
+    }
+}
+
+static void apply_name(WinCacheEntry *entry, XBatch *batch, const PropSlots *slots) {
+    g_free(entry->name);
+    entry->name = xbatch_string(batch, slots->net_wm_name);
+    if (entry->name == NULL) {
+        entry->name = xbatch_string(batch, slots->wm_name);
+    }
+}
+
+/* TRUE if the atom list in @slot contains @a or @b */
+static gboolean atom_list_has(XBatch *batch, guint slot, Atom a, Atom b) {
+    guint n;
+    const guint32 *atoms = xbatch_cardinals(batch, slot, &n);
+    for (guint i = 0; i < n; i++) {
+        if (atoms[i] == a || atoms[i] == b) return TRUE;
+    }
+    return FALSE;
+}
+
+static void apply_state(WinCacheEntry *entry, XBatch *batch, guint slot) {
+    entry->skip_taskbar = atom_list_has(batch, slot, net_wm_state_skip_taskbar_atom, None);
+}
+
+static void apply_type(WinCacheEntry *entry, XBatch *batch, guint slot) {
+    entry->dock_or_desktop = atom_list_has(batch, slot, net_wm_window_type_dock_atom,
+                                           net_wm_window_type_desktop_atom);
+}
+
+static void forget_icon(WinCacheEntry *entry) {
+    g_clear_pointer(&entry->icon, cairo_surface_destroy);
+    entry->icon_size = entry->icon_scale = 0;
+}
+
+void win_cache_prefetch(const Window *windows, unsigned long n_windows) {
+    GdkDisplay *display = gdk_display_get_default();
+    GPtrArray *fresh = g_ptr_array_new();
+    GArray *slots = g_array_new(FALSE, FALSE, sizeof(PropSlots));
+    XBatch *batch = xbatch_new(x_display);
+
+    /* The windows may be gone already: their properties just read as unset */
+    gdk_x11_display_error_trap_push(display);
+    for (unsigned long i = 0; i < n_windows; i++) {
+        Window xid = windows[i];
+        if (g_hash_table_contains(entries, GSIZE_TO_POINTER(xid))) continue;
+
+        WinCacheEntry *entry = g_malloc0(sizeof(WinCacheEntry));
+        entry->xid = xid;
+        g_hash_table_insert(entries, GSIZE_TO_POINTER(xid), entry);
+        g_ptr_array_add(fresh, entry);
+
+        /* Subscribe first, so a change racing the reads below is not lost.
+         * Our own windows (dock, launcher) keep the event mask GDK gave them. */
+        if (gdk_x11_window_lookup_for_display(display, xid) == NULL) {
+            XSelectInput(x_display, xid, PropertyChangeMask);
+        }
+
+        PropSlots s;
+        queue_class(batch, xid, &s);
+        queue_name(batch, xid, &s);
+        queue_state(batch, xid, &s);
+        queue_type(batch, xid, &s);
+        g_array_append_val(slots, s);
+    }
+    gdk_x11_display_error_trap_pop_ignored(display);
+
+    if (fresh->len > 0) {
+        xbatch_run(batch);
+        for (guint i = 0; i < fresh->len; i++) {
+            WinCacheEntry *entry = g_ptr_array_index(fresh, i);
+            const PropSlots *s = &g_array_index(slots, PropSlots, i);
+            apply_class(entry, batch, s->wm_class);
+            apply_name(entry, batch, s);
+            apply_state(entry, batch, s->state);
+            apply_type(entry, batch, s->type);
+        }
+    }
+
+    xbatch_free(batch);
+    g_array_free(slots, TRUE);
+    g_ptr_array_free(fresh, TRUE);
+}
+
+const WinCacheEntry *win_cache_get(Window xid) {
+    WinCacheEntry *entry = g_hash_table_lookup(entries, GSIZE_TO_POINTER(xid));
+    if (entry) return entry;
+
+    win_cache_prefetch(&xid, 1);
+    return g_hash_table_lookup(entries, GSIZE_TO_POINTER(xid));
+}
+
+void win_cache_retain(const Window *clients, unsigned long n_clients) {
+    GHashTable *alive = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (unsigned long i = 0; i < n_clients; i++) {
+        g_hash_table_add(alive, GSIZE_TO_POINTER(clients[i]));
+    }
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, entries);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        if (!g_hash_table_contains(alive, key)) {
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+    g_hash_table_destroy(alive);
+}
+
+WinCacheChange win_cache_handle_property(const XPropertyEvent *event) {
+    WinCacheEntry *entry = g_hash_table_lookup(entries, GSIZE_TO_POINTER(event->window));
+    if (entry == NULL) return 0;
+
+    Atom atom = event->atom;
+    WinCacheChange change = 0;
+    XBatch *batch = xbatch_new(x_display);
+    PropSlots s;
+
+    if (atom == wm_class_atom) {
+        queue_class(batch, entry->xid, &s);
+        xbatch_run(batch);
+        apply_class(entry, batch, s.wm_class);
+        change = WIN_CACHE_CLASS;
+    } else if (atom == net_wm_name_atom || atom == wm_name_atom) {
+        queue_name(batch, entry->xid, &s);
+        xbatch_run(batch);
+        apply_name(entry, batch, &s);
+        change = WIN_CACHE_NAME;
+        /* The name is the grouping key of windows without WM_CLASS */
+        if (win_cache_class(entry) == entry->name) change |= WIN_CACHE_CLASS;
+    } else if (atom == net_wm_state_atom) {
+        gboolean was = entry->skip_taskbar;
+        queue_state(batch, entry->xid, &s);
+        xbatch_run(batch);
+        apply_state(entry, batch, s.state);
+        /* _NET_WM_STATE also flips on every maximize/fullscreen/focus change */
+        if (entry->skip_taskbar != was) change = WIN_CACHE_STATE;
+    } else if (atom == net_wm_window_type_atom) {
+        queue_type(batch, entry->xid, &s);
+        xbatch_run(batch);
+        apply_type(entry, batch, s.type);
+        change = WIN_CACHE_STATE;
+    } else if (atom == net_wm_icon_atom) {
+        /* Decoded again on next use */
+        forget_icon(entry);
+        change = WIN_CACHE_ICON;
+    }
+
+    xbatch_free(batch);
+    return change;
+}
+
+const char *win_cache_class(const WinCacheEntry *entry) {
+    if (entry->res_class && *entry->res_class) return entry->res_class;
+    if (entry->res_name && *entry->res_name) return entry->res_name;
+    return entry->name ? entry->name : "Unknown";
+}
+
+gboolean win_cache_is_dock_window(const WinCacheEntry *entry) {
+    return !entry->dock_or_desktop && !entry->skip_taskbar;
+}
+
+/*
+ * Picks the image of _NET_WM_ICON (width, height, pixels... repeated)
+ * best for @target device pixels: the smallest one at least that large,
+ * else the largest.  Returns its offset in @data, or -1.
+ */
+static long pick_icon_image(const unsigned long *data, unsigned long nitems, int target) {
+    long best = -1;
+    unsigned long best_size = 0;
+
+    for (unsigned long i = 0; i + 2 <= nitems; ) {
+        unsigned long width = data[i], height = data[i + 1];
+        if (width == 0 || height == 0 || width > 4096 || height > 4096 ||
+            width * height > nitems - i - 2) {
+            break; /* Truncated or garbage: keep what was found so far */
+        }
+
+        unsigned long size = MAX(width, height);
+        gboolean better = best < 0 ||
+            (size >= (unsigned long)target ? best_size < (unsigned long)target || size < best_size
+                                           : size > best_size);
+        if (better) {
+            best = (long)i;
+            best_size = size;
+        }
+        i += 2 + width * height;
+    }
+    return best;
+}
+
+/* Decodes the best-sized image of _NET_WM_ICON into a @size x @scale surface */
+static cairo_surface_t *read_icon(Window xid, int size, int scale) {
+    Atom actual_type;
+    int actual_format;
+    unsigned long nitems, bytes_after;
+    unsigned char *prop = NULL;
+    cairo_surface_t *icon = NULL;
+    int target = size * scale;
+
+    /* All the sizes at once (long_length is in 32-bit units) */
+    if (XGetWindowProperty(x_display, xid, net_wm_icon_atom, 0, 1 << 22, False,
+                           XA_CARDINAL, &actual_type, &actual_format, &nitems, &bytes_after, &prop) != Success) {
+        return NULL;
+    }
+    long offset = (prop && actual_format == 32) ? pick_icon_image((unsigned long *)prop, nitems, target) : -1;
+    if (offset >= 0) {
+        const unsigned long *data = (unsigned long *)prop + offset;
+        int width = data[0];
+        int height = data[1];
+
+        /* ARGB32 as cairo wants it: premultiplied, native endian */
+        cairo_surface_t *image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+        unsigned char *pixels = cairo_image_surface_get_data(image);
+        int stride = cairo_image_surface_get_stride(image);
+
+        for (int y = 0; y < height; y++) {
+            guint32 *row = (guint32 *)(pixels + y * stride);
+            for (int x = 0; x < width; x++) {
+                unsigned long argb = data[2 + y * width + x];
+                guint32 a = (argb >> 24) & 0xFF;
+                guint32 r = (((argb >> 16) & 0xFF) * a + 127) / 255;
+                guint32 g = (((argb >> 8) & 0xFF) * a + 127) / 255;
+                guint32 b = ((argb & 0xFF) * a + 127) / 255;
+                row[x] = (a << 24) | (r << 16) | (g << 8) | b;
+            }
+        }
+        cairo_surface_mark_dirty(image);
+
+        if (width == target && height == target) {
+            icon = image;
+        } else {
+            /* Per-window pixels: scaled once here, not shared */
+            icon = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, target, target);
+            cairo_t *cr = cairo_create(icon);
+            cairo_scale(cr, (double)target / width, (double)target / height);
+            cairo_set_source_surface(cr, image, 0, 0);
+            cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
+            cairo_paint(cr);
+            cairo_destroy(cr);
+            cairo_surface_destroy(image);
+        }
+        cairo_surface_set_device_scale(icon, scale, scale);
+    }
+    if (prop) XFree(prop);
+    return icon;
+}
+
+cairo_surface_t *win_cache_get_icon(Window xid, int size, int scale) {
+    WinCacheEntry *entry = (WinCacheEntry *)win_cache_get(xid);
+    if (entry->icon_size == size && entry->icon_scale == scale) return entry->icon;
+
+    forget_icon(entry);
+    GdkDisplay *display = gdk_display_get_default();
+    gdk_x11_display_error_trap_push(display);
+    entry->icon = read_icon(xid, size, scale);
+    gdk_x11_display_error_trap_pop_ignored(display);
+    entry->icon_size = size;
+    entry->icon_scale = scale;
+    return entry->icon;
+}
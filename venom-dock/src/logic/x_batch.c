@@ -0,0 +1,107 @@
+#include "logic/x_batch.h"
+#include <X11/Xlib-xcb.h>
+#include <stdlib.h>
+
+typedef enum {
+    SLOT_PROPERTY,
+    SLOT_GEOMETRY
+} SlotKind;
+
+typedef struct {
+    SlotKind kind;
+    unsigned int sequence;      /* The request's cookie */
+    void *reply;                /* malloc'd by XCB */
+} Slot;
+
+struct XBatch {
+    xcb_connection_t *conn;
+    GArray *slots;
+    gboolean done;
+};
+
+XBatch *xbatch_new(Display *dpy) {
+    XBatch *batch = g_new0(XBatch, 1);
+    batch->conn = XGetXCBConnection(dpy);
+    batch->slots = g_array_new(FALSE, TRUE, sizeof(Slot));
+    return batch;
+}
+
+void xbatch_free(XBatch *batch) {
+    if (!batch) return;
+    /* Replies never collected must still be discarded */
+    if (!batch->done) xbatch_run(batch);
+    for (guint i = 0; i < batch->slots->len; i++) {
+        free(g_array_index(batch->slots, Slot, i).reply);
+    }
+    g_array_free(batch->slots, TRUE);
+    g_free(batch);
+}
+
+guint xbatch_get_property(XBatch *batch, Window win, Atom property, Atom type, guint32 max_length) {
+    xcb_get_property_cookie_t cookie = xcb_get_property(batch->conn, 0, (xcb_window_t)win,
+                                                        (xcb_atom_t)property, (xcb_atom_t)type,
+                                                        0, max_length);
+    Slot slot = { SLOT_PROPERTY, cookie.sequence, NULL };
+    g_array_append_val(batch->slots, slot);
+    batch->done = FALSE;
+    return batch->slots->len - 1;
+}
+
+guint xbatch_get_geometry(XBatch *batch, Window win) {
+    xcb_get_geometry_cookie_t cookie = xcb_get_geometry(batch->conn, (xcb_drawable_t)win);
+    Slot slot = { SLOT_GEOMETRY, cookie.sequence, NULL };
+    g_array_append_val(batch->slots, slot);
+    batch->done = FALSE;
+    return batch->slots->len - 1;
+}
+
+void xbatch_run(XBatch *batch) {
+    /* One write for all the requests, then the replies in order */
+    xcb_flush(batch->conn);
+    for (guint i = 0; i < batch->slots->len; i++) {
+        Slot *slot = &g_array_index(batch->slots, Slot, i);
+        if (slot->reply) continue;
+        /* Checked requests: an error is handed back here (and dropped), not to Xlib */
+        if (slot->kind == SLOT_PROPERTY) {
+            xcb_get_property_cookie_t cookie = { slot->sequence };
+            slot->reply = xcb_get_property_reply(batch->conn, cookie, NULL);
+        } else {
+            xcb_get_geometry_cookie_t cookie = { slot->sequence };
+            slot->reply = xcb_get_geometry_reply(batch->conn, cookie, NULL);
+        }
+    }
+    batch->done = TRUE;
+}
+
+const xcb_get_property_reply_t *xbatch_property(XBatch *batch, guint slot) {
+    Slot *s = &g_array_index(batch->slots, Slot, slot);
+    return s->kind == SLOT_PROPERTY ? s->reply : NULL;
+}
+
+const xcb_get_geometry_reply_t *xbatch_geometry(XBatch *batch, guint slot) {
+    Slot *s = &g_array_index(batch->slots, Slot, slot);
+    return s->kind == SLOT_GEOMETRY ? s->reply : NULL;
+}
+
+char *xbatch_string(XBatch *batch, guint slot) {
+    const xcb_get_property_reply_t *reply = xbatch_property(batch, slot);
+    if (!reply || reply->type == XCB_NONE || reply->format != 8) return NULL;
+    if (xcb_get_property_value_length(reply) <= 0) return NULL;
+    return g_strndup(xcb_get_property_value(reply), xcb_get_property_value_length(reply));
+}
+
+const guint32 *xbatch_cardinals(XBatch *batch, guint slot, guint *n) {
+    const xcb_get_property_reply_t *reply = xbatch_property(batch, slot);
+    *n = 0;
+    if (!reply || reply->type == XCB_NONE || reply->format != 32) return NULL;
+    *n = xcb_get_property_value_length(reply) / 4;
+    return *n > 0 ? xcb_get_property_value(reply) : NULL;
+}
+
+gboolean xbatch_cardinal(XBatch *batch, guint slot, long *value) {
+    guint n;
+    const guint32 *values = xbatch_cardinals(batch, slot, &n);
+    if (!values) return FALSE;
+    *value = values[0];
+    return TRUE;
+}
@@ -3,6 +3,7 @@
 #include "pager.h"
 #include "logic/app_manager.h"
 #include "logic/pager_service.h"
+#include "venom-spawn.h"
 #include <gio/gdesktopappinfo.h>
 #include <gdk/gdkx.h>
 #include <stdlib.h>
@@ -162,7 +163,7 @@ void on_launcher_clicked(GtkWidget *widget, gpointer data) {
     if (!is_standalone) {
         GError *error = NULL;
         gchar *argv[] = {"/home/x/Desktop/venom-launcher/build/venom-launcher", NULL};
-        if (!g_spawn_async(NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, NULL, &error)) {
+        if (!venom_spawn_async(NULL, argv, NULL, &error)) {
              g_warning("Failed to spawn launcher: %s", error->message);
              g_error_free(error);
         }
@@ -374,12 +375,13 @@ void populate_applications_grid(GtkWidget *stack) {
         GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
         
         GtkWidget *image;
-        if (info->pixbuf) {
-            /* Use cached pixbuf (ref it) */
-            image = gtk_image_new_from_pixbuf(info->pixbuf);
+        cairo_surface_t *icon = app_mgr_load_icon(info->icon, 64, gtk_widget_get_scale_factor(stack));
+        if (icon) {
+            image = gtk_image_new_from_surface(icon);
+            cairo_surface_destroy(icon);
         } else {
-            /* Should be unreachable with new app_manager hardening */
-            image = gtk_image_new_from_icon_name("image-missing", GTK_ICON_SIZE_DND);
+            image = gtk_image_new_from_icon_name("application-x-executable", GTK_ICON_SIZE_DIALOG);
+            gtk_image_set_pixel_size(GTK_IMAGE(image), 64);
         }
         gtk_box_pack_start(GTK_BOX(box), image, TRUE, TRUE, 0);
         
@@ -45,6 +45,9 @@ static gboolean on_pager_draw(GtkWidget *widget, cairo_t *cr, gpointer data) {
     float scale_x = (float)desk_width / screen_w;
     float scale_y = (float)desk_height / screen_h;
     
+    /* Desktop and geometry of every window, in one round trip */
+    GArray *windows = pager_svc_get_window_infos();
+    
     for (int i = 0; i < num_desktops; i++) {
         int x_offset = i * desk_width;
         int y_offset = 0;
@@ -69,18 +72,20 @@ static gboolean on_pager_draw(GtkWidget *widget, cairo_t *cr, gpointer data) {
         }
         
         /* Draw Window Previews */
-        GList *windows = pager_svc_get_windows(i);
         
         cairo_save(cr);
         /* Clip to desktop area */
         cairo_rectangle(cr, x_offset + 1, y_offset + 1, desk_width - 2, desk_height - 2);
         cairo_clip(cr);
         
-        for (GList *l = windows; l != NULL; l = l->next) {
-             Window win = GPOINTER_TO_INT(l->data);
-             int wx, wy, ww, wh;
+        for (guint w = 0; w < windows->len; w++) {
+             const PagerWindowInfo *client = &g_array_index(windows, PagerWindowInfo, w);
+             if (client->desktop != i && client->desktop != 0xFFFFFFFF) continue;
+             
+             Window win = client->win;
+             int wx = client->x, wy = client->y, ww = client->width, wh = client->height;
              
-             if (pager_svc_get_window_geometry(win, &wx, &wy, &ww, &wh)) {
+             if (client->has_geometry) {
                  /* Scale to Pager Coordinates */
                  int px = x_offset + (int)(wx * scale_x);
                  int py = y_offset + (int)(wy * scale_y);
@@ -201,10 +206,10 @@ static gboolean on_pager_draw(GtkWidget *widget, cairo_t *cr, gpointer data) {
                  cairo_stroke(cr);
              }
         }
-        g_list_free(windows);
         
         cairo_restore(cr);
     }
+    g_array_unref(windows);
     
     return FALSE;
 }
@@ -154,7 +154,7 @@ void execute_ai_chat(const char *query, GtkWidget *parent) {
 
 void execute_vater(const char *cmd, GtkWidget *parent) {
     (void)parent;
-    g_spawn_command_line_async(cmd, NULL);
+    app_mgr_launch_detached(cmd, NULL);
 }
 
 /* Stub for password dialog if needed or removed */
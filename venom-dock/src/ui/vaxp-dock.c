@@ -10,6 +10,7 @@
 #include "launcher.h"
 #include "pager.h"
 #include "logic/app_manager.h"
+#include "logic/window_cache.h"
 
 /* Global X11 variables */
 Display *xdisplay;
@@ -33,16 +34,21 @@ Atom net_wm_window_type_desktop_atom;
 typedef struct {
     char *wm_class;
     GList *windows;  /* List of Window IDs */
-    GdkPixbuf *icon;
-    GtkWidget *button;
+    cairo_surface_t *icon;    /* DOCK_ICON_SIZE at the dock's scale factor */
+    Window icon_window;       /* Window the icon came from; None = desktop entry */
+    GtkWidget *button;        /* Persistent; destroyed with the group */
+    GtkWidget *image;         /* Button's icon (or "?" label) */
     int active_index;
     char *desktop_file_path;  /* Path to .desktop file */
     gboolean is_pinned;       /* Whether app is pinned */
 } WindowGroup;
 
+/* Logical size of the icons in the dock */
+#define DOCK_ICON_SIZE 34
+
 GtkWidget *main_window;
 GtkWidget *box;
-GHashTable *window_groups; /* wm_class -> WindowGroup */
+GHashTable *window_groups; /* wm_class -> WindowGroup (owned, with its button) */
 GList *pinned_apps = NULL; /* List of pinned wm_class strings */
 
 
@@ -83,15 +89,11 @@ static void on_dock_realize(GtkWidget *widget, gpointer data) {
 /* Function prototypes */
 static void on_dock_realize(GtkWidget *widget, gpointer data);
 static void on_window_size_allocate(GtkWidget *widget, GtkAllocation *allocation, gpointer data);
-/* Helper for process detachment */
-static void child_setup(gpointer user_data) {
-    (void)user_data;
-    setsid();
-}
 void update_window_list();
-GdkPixbuf *get_window_icon(Window xwindow);
-char *get_window_name(Window xwindow);
-char *get_window_class(Window xwindow);
+static void window_group_free(gpointer data);
+cairo_surface_t *get_window_icon(Window xwindow);
+static void on_icon_theme_changed(GtkIconTheme *theme, gpointer data);
+static void on_scale_factor_changed(GObject *object, GParamSpec *pspec, gpointer data);
 void on_button_clicked(GtkWidget *widget, gpointer data);
 gboolean on_button_press(GtkWidget *widget, GdkEventButton *event, gpointer data);
 void create_context_menu(WindowGroup *group, GdkEventButton *event);
@@ -217,6 +219,7 @@ int main(int argc, char *argv[]) {
     net_wm_window_type_atom = XInternAtom(xdisplay, "_NET_WM_WINDOW_TYPE", False);
     net_wm_window_type_dock_atom = XInternAtom(xdisplay, "_NET_WM_WINDOW_TYPE_DOCK", False);
     net_wm_window_type_desktop_atom = XInternAtom(xdisplay, "_NET_WM_WINDOW_TYPE_DESKTOP", False);
+    win_cache_init(xdisplay);
 
     /* Load CSS */
     GtkCssProvider *provider = gtk_css_provider_new();
@@ -273,9 +276,11 @@ int main(int argc, char *argv[]) {
     g_signal_connect(main_window, "realize", G_CALLBACK(on_dock_realize), NULL);
     g_signal_connect(main_window, "size-allocate", G_CALLBACK(on_window_size_allocate), NULL);
     g_signal_connect(main_window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
+    g_signal_connect(main_window, "notify::scale-factor", G_CALLBACK(on_scale_factor_changed), NULL);
+    g_signal_connect(gtk_icon_theme_get_default(), "changed", G_CALLBACK(on_icon_theme_changed), NULL);
 
     /* Initialize window groups hash table */
-    window_groups = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    window_groups = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, window_group_free);
 
     /* Load pinned apps */
     load_pinned_apps();
@@ -301,554 +306,280 @@ int main(int argc, char *argv[]) {
     return 0;
 }
 
-/* Helper to check if a window should be shown in the dock */
-gboolean is_window_valid_for_dock(Window xwindow) {
-    Atom actual_type;
-    int actual_format;
-    unsigned long nitems, bytes_after;
-    unsigned char *prop = NULL;
+/* Value destructor of window_groups; also removes the group's button */
+static void window_group_free(gpointer data) {
+    WindowGroup *group = (WindowGroup *)data;
+    if (group->button) gtk_widget_destroy(group->button);
+    if (group->icon) cairo_surface_destroy(group->icon);
+    g_list_free(group->windows);
+    g_free(group->desktop_file_path);
+    g_free(group->wm_class);
+    g_free(group);
+}
 
-    /* Check _NET_WM_WINDOW_TYPE */
-    if (XGetWindowProperty(xdisplay, xwindow, net_wm_window_type_atom, 0, 1024, False,
-                           XA_ATOM, &actual_type, &actual_format, &nitems, &bytes_after, &prop) == Success) {
-        if (prop) {
-            Atom *types = (Atom *)prop;
-            for (unsigned long i = 0; i < nitems; i++) {
-                if (types[i] == net_wm_window_type_dock_atom ||
-                    types[i] == net_wm_window_type_desktop_atom) {
-                    XFree(prop);
-                    return FALSE;
-                }
-            }
-            XFree(prop);
-        }
-    }
+static GtkWidget *create_group_image(WindowGroup *group) {
+    GtkWidget *image = group->icon ? gtk_image_new_from_surface(group->icon) : gtk_label_new("?");
+    gtk_widget_set_valign(image, GTK_ALIGN_CENTER);
+    gtk_widget_set_halign(image, GTK_ALIGN_CENTER);
+    return image;
+}
 
-    /* Check _NET_WM_STATE */
-    prop = NULL;
-    if (XGetWindowProperty(xdisplay, xwindow, net_wm_state_atom, 0, 1024, False,
-                           XA_ATOM, &actual_type, &actual_format, &nitems, &bytes_after, &prop) == Success) {
-        if (prop) {
-            Atom *states = (Atom *)prop;
-            for (unsigned long i = 0; i < nitems; i++) {
-                if (states[i] == net_wm_state_skip_taskbar_atom) {
-                    XFree(prop);
-                    return FALSE;
-                }
-            }
-            XFree(prop);
+/*
+ * (Re)loads the group's icon: from its icon window, else from its desktop
+ * entry.  Only called for a new group, an icon change or a theme / scale
+ * change; the surface is reused by every other update.
+ */
+static void load_group_icon(WindowGroup *group) {
+    cairo_surface_t *icon = NULL;
+    
+    if (group->icon_window != None) {
+        icon = get_window_icon(group->icon_window);
+    } else {
+        gchar *icon_name = NULL;
+        if (app_mgr_find_app_for_class(group->wm_class, NULL, NULL, &icon_name)) {
+            icon = app_mgr_load_icon(icon_name, DOCK_ICON_SIZE,
+                                     gtk_widget_get_scale_factor(main_window));
+            g_free(icon_name);
         }
     }
+    
+    if (group->icon) cairo_surface_destroy(group->icon);
+    group->icon = icon;
+    
+    /* Swap the button's image in place */
+    if (group->image != NULL) {
+        GtkWidget *overlay = gtk_widget_get_parent(group->image);
+        gtk_widget_destroy(group->image);
+        group->image = create_group_image(group);
+        gtk_container_add(GTK_CONTAINER(overlay), group->image);
+        gtk_widget_show(group->image);
+    }
+}
 
-    return TRUE;
+/* Builds the group's button once; it lives as long as the group */
+static GtkWidget *create_group_button(WindowGroup *group) {
+    GtkWidget *button = gtk_button_new();
+    gtk_button_set_relief(GTK_BUTTON(button), GTK_RELIEF_NONE);
+    
+    /* Create Overlay to isolate dot from layout flow */
+    GtkWidget *overlay = gtk_overlay_new();
+    
+    /* Icon as main child (centered) */
+    group->image = create_group_image(group);
+    gtk_container_add(GTK_CONTAINER(overlay), group->image);
+    
+    /* Indicator Dot as Overlay Child (Bottom) */
+    GtkWidget *dot = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+    gtk_widget_set_name(dot, "indicator-dot");
+    gtk_widget_set_size_request(dot, 6, 6);
+    gtk_widget_set_halign(dot, GTK_ALIGN_CENTER);
+    gtk_widget_set_valign(dot, GTK_ALIGN_END);
+    gtk_widget_set_margin_bottom(dot, 2); /* Slight offset from very bottom */
+    
+    gtk_overlay_add_overlay(GTK_OVERLAY(overlay), dot);
+    
+    gtk_container_add(GTK_CONTAINER(button), overlay);
+    
+    /* Store group pointer in button */
+    g_object_set_data(G_OBJECT(button), "group", group);
+    g_signal_connect(button, "clicked", G_CALLBACK(on_button_clicked), NULL);
+    g_signal_connect(button, "button-press-event", G_CALLBACK(on_button_press), NULL);
+    
+    gtk_box_pack_start(GTK_BOX(box), button, FALSE, FALSE, 0);
+    gtk_widget_show_all(button);
+    return button;
 }
 
-/* Update the list of windows in the panel */
-void update_window_list() {
-    /* Clear existing buttons (except launcher) */
-    GList *children, *iter;
-    children = gtk_container_get_children(GTK_CONTAINER(box));
-    for (iter = children; iter != NULL; iter = g_list_next(iter)) {
-        GtkWidget *child = GTK_WIDGET(iter->data);
-        /* Don't destroy the launcher button */
-        if (child != launcher_button) {
-            gtk_widget_destroy(child);
-        }
+/* Refreshes the tooltip and running/pinned classes after the windows changed */
+static void update_group_button(WindowGroup *group) {
+    GtkWidget *button = group->button;
+    int window_count = g_list_length(group->windows);
+    
+    if (window_count > 1) {
+        char tooltip[256];
+        snprintf(tooltip, sizeof(tooltip), "%s (%d windows)", group->wm_class, window_count);
+        gtk_widget_set_tooltip_text(button, tooltip);
+    } else if (window_count == 1) {
+        /* Single window - use window name */
+        Window win = GPOINTER_TO_INT(g_list_first(group->windows)->data);
+        const char *name = win_cache_get(win)->name;
+        gtk_widget_set_tooltip_text(button, name ? name : group->wm_class);
+    } else {
+        /* No windows - pinned app */
+        gtk_widget_set_tooltip_text(button, group->wm_class);
     }
-    g_list_free(children);
-
-    /* Clear window lists from groups, but keep pinned apps */
-    if (window_groups != NULL) {
-        GHashTableIter hash_iter;
-        gpointer key, value;
-        g_hash_table_iter_init(&hash_iter, window_groups);
-        while (g_hash_table_iter_next(&hash_iter, &key, &value)) {
-            WindowGroup *group = (WindowGroup *)value;
-            
-            /* Clear windows list */
-            if (group->windows) {
-                g_list_free(group->windows);
-                group->windows = NULL;
-            }
-            
-            /* Remove unpinned groups */
-            if (!group->is_pinned) {
-                if (group->icon) {
-                    g_object_unref(group->icon);
-                }
-                if (group->desktop_file_path) {
-                    g_free(group->desktop_file_path);
-                }
-                g_free(group->wm_class);
-                g_free(group);
-                g_hash_table_iter_remove(&hash_iter);
-            }
-        }
+    
+    GtkStyleContext *context = gtk_widget_get_style_context(button);
+    if (window_count > 0) {
+        gtk_style_context_remove_class(context, "pinned-app");
+        gtk_style_context_add_class(context, "running-app");
+    } else {
+        gtk_style_context_remove_class(context, "running-app");
+        gtk_style_context_add_class(context, "pinned-app");
     }
+}
 
-    /* Get client list */
-    Atom actual_type;
-    int actual_format;
-    unsigned long nitems, bytes_after;
-    unsigned char *prop = NULL;
+/*
+ * New group (and button) for @wm_class.  The icon comes from
+ * @first_window, or from the desktop entry for a pinned app (None).
+ */
+static WindowGroup *window_group_new(const char *wm_class, Window first_window) {
+    WindowGroup *group = g_malloc0(sizeof(WindowGroup));
+    group->wm_class = g_strdup(wm_class);
+    group->is_pinned = (g_list_find_custom(pinned_apps, wm_class, (GCompareFunc)g_strcmp0) != NULL);
+    
+    /* Instance name helps apps whose class matches no desktop entry */
+    const char *instance = first_window != None ? win_cache_get(first_window)->res_name : NULL;
+    app_mgr_find_app_for_class(wm_class, instance, &group->desktop_file_path, NULL);
+    
+    group->icon_window = first_window;
+    load_group_icon(group);
+    
+    group->button = create_group_button(group);
+    g_hash_table_insert(window_groups, group->wm_class, group);
+    return group;
+}
 
-    if (XGetWindowProperty(xdisplay, root_window, net_client_list_atom, 0, 1024, False,
-                           XA_WINDOW, &actual_type, &actual_format, &nitems, &bytes_after, &prop) == Success) {
-        if (prop) {
-            Window *list = (Window *)prop;
-            
-            /* First pass: Group windows by WM_CLASS */
-            for (unsigned long i = 0; i < nitems; i++) {
-                Window win = list[i];
-                
-                /* Skip hidden windows */
-                if (!is_window_valid_for_dock(win)) {
-                    continue;
-                }
-                
-                char *wm_class = get_window_class(win);
-                
-                if (wm_class) {
-                    WindowGroup *group = g_hash_table_lookup(window_groups, wm_class);
-                    
-                    if (group == NULL) {
-                        /* Create new group */
-                        group = g_malloc0(sizeof(WindowGroup));
-                        group->wm_class = strdup(wm_class);
-                        group->windows = NULL;
-                        group->icon = get_window_icon(win);
-                        group->active_index = 0;
-                        
-                        /* Try to find .desktop file */
-                        gchar *desktop_id = g_strdup_printf("%s.desktop", wm_class);
-                        GDesktopAppInfo *app_info = g_desktop_app_info_new(desktop_id);
-                        if (app_info == NULL) {
-                            gchar *lowercase = g_ascii_strdown(wm_class, -1);
-                            g_free(desktop_id);
-                            desktop_id = g_strdup_printf("%s.desktop", lowercase);
-                            app_info = g_desktop_app_info_new(desktop_id);
-                            g_free(lowercase);
-                        }
-                        
-                        if (app_info != NULL) {
-                            group->desktop_file_path = g_strdup(g_desktop_app_info_get_filename(app_info));
-                            g_object_unref(app_info);
-                        } else {
-                            group->desktop_file_path = NULL;
-                        }
-                        g_free(desktop_id);
-                        
-                        /* Check if pinned */
-                        group->is_pinned = (g_list_find_custom(pinned_apps, wm_class, (GCompareFunc)g_strcmp0) != NULL);
-                        
-                        g_hash_table_insert(window_groups, strdup(wm_class), group);
-                    }
-                    
-                    /* Add window to group */
-                    group->windows = g_list_append(group->windows, GINT_TO_POINTER(win));
-                    free(wm_class);
-                }
-            }
-            
-            /* Third pass: Add pinned apps that don't have windows */
-            for (GList *l = pinned_apps; l != NULL; l = l->next) {
-                const gchar *pinned_class = (const gchar *)l->data;
-                
-                /* Check if this pinned app already has a group */
-                if (g_hash_table_lookup(window_groups, pinned_class) == NULL) {
-                    /* Create group for pinned app without windows */
-                    WindowGroup *group = g_malloc0(sizeof(WindowGroup));
-                    group->wm_class = strdup(pinned_class);
-                    group->windows = NULL;
-                    group->active_index = 0;
-                    group->is_pinned = TRUE;
-                    
-                    /* Try to find .desktop file and icon */
-                    gchar *desktop_id = g_strdup_printf("%s.desktop", pinned_class);
-                    GDesktopAppInfo *app_info = g_desktop_app_info_new(desktop_id);
-                    if (app_info == NULL) {
-                        gchar *lowercase = g_ascii_strdown(pinned_class, -1);
-                        g_free(desktop_id);
-                        desktop_id = g_strdup_printf("%s.desktop", lowercase);
-                        app_info = g_desktop_app_info_new(desktop_id);
-                        g_free(lowercase);
-                    }
-                    
-                    if (app_info != NULL) {
-                        group->desktop_file_path = g_strdup(g_desktop_app_info_get_filename(app_info));
-                        
-                        /* Get icon from desktop file */
-                        gchar *icon_name = g_desktop_app_info_get_string(app_info, "Icon");
-                        if (icon_name != NULL) {
-                            GtkIconTheme *icon_theme = gtk_icon_theme_get_default();
-                            GError *error = NULL;
-                            
-                            if (g_path_is_absolute(icon_name)) {
-                                group->icon = gdk_pixbuf_new_from_file_at_scale(icon_name, 48, 48, TRUE, &error);
-                            } else {
-                                group->icon = gtk_icon_theme_load_icon(icon_theme, icon_name, 48,
-                                                                       GTK_ICON_LOOKUP_FORCE_SIZE, &error);
-                            }
-                            
-                            if (error) {
-                                g_error_free(error);
-                            }
-                            g_free(icon_name);
-                        }
-                        
-                        g_object_unref(app_info);
-                    } else {
-                        group->desktop_file_path = NULL;
-                        group->icon = NULL;
-                    }
-                    g_free(desktop_id);
-                    
-                    g_hash_table_insert(window_groups, strdup(pinned_class), group);
-                }
-            }
-            
-            /* Fourth pass: Create buttons for each group */
-            GHashTableIter hash_iter;
-            gpointer key, value;
-            g_hash_table_iter_init(&hash_iter, window_groups);
-            
-            while (g_hash_table_iter_next(&hash_iter, &key, &value)) {
-                WindowGroup *group = (WindowGroup *)value;
-                
-                /* Create button for this group */
-                GtkWidget *button = gtk_button_new();
-                gtk_button_set_relief(GTK_BUTTON(button), GTK_RELIEF_NONE);
-                group->button = button;
-                
-                /* Set tooltip */
-                int window_count = g_list_length(group->windows);
-                if (window_count > 1) {
-                    char tooltip[256];
-                    snprintf(tooltip, sizeof(tooltip), "%s (%d windows)", group->wm_class, window_count);
-                    gtk_widget_set_tooltip_text(button, tooltip);
-                } else if (window_count == 1) {
-                    /* Single window - use window name */
-                    Window win = GPOINTER_TO_INT(g_list_first(group->windows)->data);
-                    char *name = get_window_name(win);
-                    gtk_widget_set_tooltip_text(button, name ? name : group->wm_class);
-                    if (name) free(name);
-                } else {
-                    /* No windows - pinned app */
-                    gtk_widget_set_tooltip_text(button, group->wm_class);
-                }
-                
-                /* Create Overlay to isolate dot from layout flow */
-                GtkWidget *overlay = gtk_overlay_new();
-                
-                /* Icon as main child (centered) */
-                if (group->icon) {
-                    GdkPixbuf *scaled = gdk_pixbuf_scale_simple(group->icon, 34, 34, GDK_INTERP_BILINEAR);
-                    GtkWidget *image = gtk_image_new_from_pixbuf(scaled);
-                    gtk_widget_set_valign(image, GTK_ALIGN_CENTER);
-                    gtk_widget_set_halign(image, GTK_ALIGN_CENTER);
-                    gtk_container_add(GTK_CONTAINER(overlay), image);
-                    g_object_unref(scaled);
-                } else {
-                    GtkWidget *label = gtk_label_new("?");
-                    gtk_widget_set_valign(label, GTK_ALIGN_CENTER);
-                    gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
-                    gtk_container_add(GTK_CONTAINER(overlay), label);
-                }
-                
-                /* Indicator Dot as Overlay Child (Bottom) */
-                GtkWidget *dot = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
-                gtk_widget_set_name(dot, "indicator-dot");
-                gtk_widget_set_size_request(dot, 6, 6);
-                gtk_widget_set_halign(dot, GTK_ALIGN_CENTER);
-                gtk_widget_set_valign(dot, GTK_ALIGN_END);
-                gtk_widget_set_margin_bottom(dot, 2); /* Slight offset from very bottom */
-                
-                gtk_overlay_add_overlay(GTK_OVERLAY(overlay), dot);
-                
-                gtk_container_add(GTK_CONTAINER(button), overlay);
-                
-                /* Store group pointer in button */
-                g_object_set_data(G_OBJECT(button), "group", group);
-                g_signal_connect(button, "clicked", G_CALLBACK(on_button_clicked), NULL);
-                g_signal_connect(button, "button-press-event", G_CALLBACK(on_button_press), NULL);
-                
-                /* Add CSS class for styling */
-                GtkStyleContext *context = gtk_widget_get_style_context(button);
-                if (window_count > 0) {
-                    gtk_style_context_add_class(context, "running-app");
-                } else {
-                    gtk_style_context_add_class(context, "pinned-app");
-                }
-                
-                gtk_box_pack_start(GTK_BOX(box), button, FALSE, FALSE, 0);
-            }
-            
-            XFree(prop);
-        }
+static gboolean same_windows(GList *a, GList *b) {
+    for (; a != NULL && b != NULL; a = a->next, b = b->next) {
+        if (a->data != b->data) return FALSE;
     }
-    gtk_widget_show_all(box);
-    
-    /* Force main window to recalculate size and shrink if needed */
-    gtk_window_resize(GTK_WINDOW(main_window), 1, 1);
+    return a == b;
 }
 
-/* Get window name */
-char *get_window_name(Window xwindow) {
+/*
+ * Update the list of windows in the dock.  Groups and their buttons
+ * persist across updates; only the differences are applied: buttons of
+ * new groups are added, those of closed unpinned groups removed, and a
+ * group whose windows changed gets its tooltip and classes refreshed.
+ * Everything else is left untouched.
+ */
+void update_window_list() {
     Atom actual_type;
     int actual_format;
     unsigned long nitems, bytes_after;
     unsigned char *prop = NULL;
-    char *name = NULL;
 
-    /* Try _NET_WM_NAME first (UTF-8) */
-    if (XGetWindowProperty(xdisplay, xwindow, net_wm_name_atom, 0, 1024, False,
-                           utf8_string_atom, &actual_type, &actual_format, &nitems, &bytes_after, &prop) == Success) {
-        if (prop) {
-            name = strdup((char *)prop);
-            XFree(prop);
-            return name;
-        }
+    if (XGetWindowProperty(xdisplay, root_window, net_client_list_atom, 0, 1024, False,
+                           XA_WINDOW, &actual_type, &actual_format, &nitems, &bytes_after, &prop) != Success) {
+        return; /* Keep what is shown */
     }
 
-    /* Fallback to WM_NAME */
-    if (XGetWindowProperty(xdisplay, xwindow, wm_name_atom, 0, 1024, False,
-                           XA_STRING, &actual_type, &actual_format, &nitems, &bytes_after, &prop) == Success) {
-        if (prop) {
-            name = strdup((char *)prop);
-            XFree(prop);
-            return name;
+    gboolean layout_changed = FALSE;
+    
+    /* First pass: group the client list by WM_CLASS (group -> windows, reversed) */
+    GHashTable *current = g_hash_table_new(g_direct_hash, g_direct_equal);
+    Window *list = (Window *)prop;
+    unsigned long n_clients = prop ? nitems : 0;
+    win_cache_retain(list, n_clients);
+    win_cache_prefetch(list, n_clients); /* New windows: one round trip for all */
+    for (unsigned long i = 0; i < n_clients; i++) {
+        Window win = list[i];
+        const WinCacheEntry *entry = win_cache_get(win); /* No round trip once known */
+        
+        /* Skip hidden windows */
+        if (!win_cache_is_dock_window(entry)) {
+            continue;
         }
-    }
-
-    return NULL;
-}
-
-/* Get window class (WM_CLASS) */
-char *get_window_class(Window xwindow) {
-    Atom actual_type;
-    int actual_format;
-    unsigned long nitems, bytes_after;
-    unsigned char *prop = NULL;
-    char *wm_class = NULL;
-
-    if (XGetWindowProperty(xdisplay, xwindow, wm_class_atom, 0, 1024, False,
-                           XA_STRING, &actual_type, &actual_format, &nitems, &bytes_after, &prop) == Success) {
-        if (prop && nitems > 0) {
-            /* WM_CLASS contains instance\0class\0 */
-            char *instance = (char *)prop;
-            char *class = instance + strlen(instance) + 1;
-            
-            /* Return the class name (second part) */
-            if (strlen(class) > 0) {
-                wm_class = strdup(class);
-            } else if (strlen(instance) > 0) {
-                /* Fallback to instance if class is empty */
-                wm_class = strdup(instance);
+        
+        const char *wm_class = win_cache_class(entry);
+        WindowGroup *group = g_hash_table_lookup(window_groups, wm_class);
+        if (group == NULL) {
+            group = window_group_new(wm_class, win);
+            layout_changed = TRUE;
+        }
+        
+        GList *windows = g_hash_table_lookup(current, group);
+        g_hash_table_insert(current, group, g_list_prepend(windows, GINT_TO_POINTER(win)));
+    }
+    if (prop) XFree(prop);
+    
+    /* Second pass: drop closed groups, refresh the ones whose windows changed */
+    GHashTableIter hash_iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&hash_iter, window_groups);
+    while (g_hash_table_iter_next(&hash_iter, &key, &value)) {
+        WindowGroup *group = (WindowGroup *)value;
+        GList *windows = g_list_reverse(g_hash_table_lookup(current, group));
+        
+        if (windows == NULL && !group->is_pinned) {
+            g_hash_table_iter_remove(&hash_iter);
+            layout_changed = TRUE;
+            continue;
+        }
+        
+        if (same_windows(group->windows, windows)) {
+            g_list_free(windows);
+        } else {
+            g_list_free(group->windows);
+            group->windows = windows;
+            /* Icon window closed: keep its icon, follow the next window's changes */
+            if (g_list_find(windows, GINT_TO_POINTER(group->icon_window)) == NULL) {
+                group->icon_window = windows ? (Window)GPOINTER_TO_INT(windows->data) : None;
             }
-            
-            XFree(prop);
+            update_group_button(group);
         }
     }
-
-    /* If WM_CLASS failed, use window name as fallback */
-    if (wm_class == NULL) {
-        char *name = get_window_name(xwindow);
-        if (name) {
-            wm_class = name;
-        } else {
-            wm_class = strdup("Unknown");
+    g_hash_table_destroy(current);
+    
+    /* Third pass: Add pinned apps that don't have windows */
+    for (GList *l = pinned_apps; l != NULL; l = l->next) {
+        const gchar *pinned_class = (const gchar *)l->data;
+        if (g_hash_table_lookup(window_groups, pinned_class) == NULL) {
+            WindowGroup *group = window_group_new(pinned_class, None);
+            update_group_button(group);
+            layout_changed = TRUE;
         }
     }
-
-    return wm_class;
+    
+    /* Force main window to recalculate size and shrink if needed */
+    if (layout_changed) {
+        gtk_window_resize(GTK_WINDOW(main_window), 1, 1);
+    }
 }
 
-
 /* Get window icon */
-GdkPixbuf *get_window_icon(Window xwindow) {
-    Atom actual_type;
-    int actual_format;
-    unsigned long nitems, bytes_after;
-    unsigned char *prop = NULL;
-    GdkPixbuf *pixbuf = NULL;
-
-    /* Method 1: Try _NET_WM_ICON (modern EWMH standard) */
-    if (XGetWindowProperty(xdisplay, xwindow, net_wm_icon_atom, 0, 65536, False,
-                           XA_CARDINAL, &actual_type, &actual_format, &nitems, &bytes_after, &prop) == Success) {
-        if (prop && actual_format == 32 && nitems > 2) {
-            unsigned long *data = (unsigned long *)prop;
-            int width = data[0];
-            int height = data[1];
-            int size = width * height;
-
-            if (nitems >= (unsigned long)(size + 2) && width > 0 && height > 0 && width < 512 && height < 512) {
-                /* Create pixbuf */
-                pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, width, height);
-                guchar *pixels = gdk_pixbuf_get_pixels(pixbuf);
-
-                for (int i = 0; i < size; i++) {
-                    unsigned long argb = data[i + 2];
-                    int r = (argb >> 16) & 0xFF;
-                    int g = (argb >> 8) & 0xFF;
-                    int b = argb & 0xFF;
-                    int a = (argb >> 24) & 0xFF;
-
-                    pixels[i * 4 + 0] = r;
-                    pixels[i * 4 + 1] = g;
-                    pixels[i * 4 + 2] = b;
-                    pixels[i * 4 + 3] = a;
-                }
-            }
-            XFree(prop);
-            if (pixbuf != NULL)
-                return pixbuf;
-        } else if (prop) {
-            XFree(prop);
+cairo_surface_t *get_window_icon(Window xwindow) {
+    cairo_surface_t *icon = NULL;
+    int scale = gtk_widget_get_scale_factor(main_window);
+
+    /* Method 1: Try _NET_WM_ICON (modern EWMH standard), decoded once per window */
+    icon = win_cache_get_icon(xwindow, DOCK_ICON_SIZE, scale);
+    if (icon != NULL)
+        return cairo_surface_reference(icon);
+
+    /* Method 2: Icon of the desktop entry WM_CLASS resolves to (one index lookup) */
+    const WinCacheEntry *entry = win_cache_get(xwindow);
+    if (entry->res_name != NULL) {
+        const char *instance = entry->res_name;
+        const char *class = entry->res_class ? entry->res_class : "";
+        
+        gchar *icon_name = NULL;
+        if (app_mgr_find_app_for_class(class, instance, NULL, &icon_name)) {
+            icon = app_mgr_load_icon(icon_name, DOCK_ICON_SIZE, scale);
+            g_free(icon_name);
+            if (icon != NULL) return icon;
         }
-    }
-
-
-    /* Method 2: Try WM_CLASS to lookup icon via GDesktopAppInfo (professional approach) */
-    prop = NULL;
-    if (XGetWindowProperty(xdisplay, xwindow, wm_class_atom, 0, 1024, False,
-                           XA_STRING, &actual_type, &actual_format, &nitems, &bytes_after, &prop) == Success) {
-        if (prop && nitems > 0) {
-            /* WM_CLASS contains instance\0class\0 */
-            char *instance = (char *)prop;
-            char *class = instance + strlen(instance) + 1;
-            
-            GtkIconTheme *icon_theme = gtk_icon_theme_get_default();
-            GError *error = NULL;
-            GDesktopAppInfo *app_info = NULL;
-            gchar *icon_name = NULL;
-            
-            /* Try to find .desktop file using class name */
-            gchar *desktop_id = g_strdup_printf("%s.desktop", class);
-            app_info = g_desktop_app_info_new(desktop_id);
-            g_free(desktop_id);
-            
-            /* If not found, try lowercase */
-            if (app_info == NULL) {
-                gchar *lowercase_class = g_ascii_strdown(class, -1);
-                desktop_id = g_strdup_printf("%s.desktop", lowercase_class);
-                app_info = g_desktop_app_info_new(desktop_id);
-                g_free(desktop_id);
-                g_free(lowercase_class);
-            }
-            
-            /* If still not found, try instance name */
-            if (app_info == NULL && strlen(instance) > 0) {
-                desktop_id = g_strdup_printf("%s.desktop", instance);
-                app_info = g_desktop_app_info_new(desktop_id);
-                g_free(desktop_id);
-            }
-            
-            /* If still not found, search for it */
-            if (app_info == NULL) {
-                gchar ***desktop_ids = g_desktop_app_info_search(class);
-                if (desktop_ids != NULL && desktop_ids[0] != NULL) {
-                    app_info = g_desktop_app_info_new(desktop_ids[0][0]);
-                }
-                
-                if (desktop_ids != NULL) {
-                    for (gchar ***p = desktop_ids; *p != NULL; p++)
-                        g_strfreev(*p);
-                    g_free(desktop_ids);
-                }
-            }
-            
-            /* Extract icon from .desktop file */
-            if (app_info != NULL) {
-                icon_name = g_desktop_app_info_get_string(app_info, "Icon");
-                
-                if (icon_name != NULL) {
-                    /* Check if it's an absolute path */
-                    if (g_path_is_absolute(icon_name)) {
-                        pixbuf = gdk_pixbuf_new_from_file_at_scale(icon_name, 48, 48, TRUE, &error);
-                        if (error) {
-                            g_error_free(error);
-                            error = NULL;
-                        }
-                    } else {
-                        /* Load from icon theme */
-                        pixbuf = gtk_icon_theme_load_icon(icon_theme, icon_name, 48,
-                                                         GTK_ICON_LOOKUP_FORCE_SIZE, &error);
-                        if (error) {
-                            g_error_free(error);
-                            error = NULL;
-                        }
-                    }
-                    
-                    g_free(icon_name);
-                }
-                
-                g_object_unref(app_info);
-                
-                if (pixbuf != NULL) {
-                    XFree(prop);
-                    return pixbuf;
-                }
-            }
-            
-            /* Fallback: try class/instance names directly in icon theme */
-            pixbuf = gtk_icon_theme_load_icon(icon_theme, class, 48,
-                                             GTK_ICON_LOOKUP_FORCE_SIZE, &error);
-            if (error) {
-                g_error_free(error);
-                error = NULL;
-            }
-            
-            if (pixbuf != NULL) {
-                XFree(prop);
-                return pixbuf;
-            }
-            
-            gchar *lowercase_class = g_ascii_strdown(class, -1);
-            pixbuf = gtk_icon_theme_load_icon(icon_theme, lowercase_class, 48,
-                                             GTK_ICON_LOOKUP_FORCE_SIZE, &error);
-            g_free(lowercase_class);
-            if (error) {
-                g_error_free(error);
-                error = NULL;
-            }
-            
-            if (pixbuf != NULL) {
-                XFree(prop);
-                return pixbuf;
-            }
-            
-            if (strlen(instance) > 0) {
-                gchar *lowercase_instance = g_ascii_strdown(instance, -1);
-                pixbuf = gtk_icon_theme_load_icon(icon_theme, lowercase_instance, 48,
-                                                 GTK_ICON_LOOKUP_FORCE_SIZE, &error);
-                g_free(lowercase_instance);
-                if (error) {
-                    g_error_free(error);
-                    error = NULL;
-                }
-                
-                if (pixbuf != NULL) {
-                    XFree(prop);
-                    return pixbuf;
-                }
-            }
-            
-            XFree(prop);
-        } else if (prop) {
-            XFree(prop);
+        
+        /* Fallback: try class/instance names directly in icon theme */
+        icon = app_mgr_load_icon(class, DOCK_ICON_SIZE, scale);
+        if (icon != NULL) return icon;
+        
+        gchar *lowercase_class = g_ascii_strdown(class, -1);
+        icon = app_mgr_load_icon(lowercase_class, DOCK_ICON_SIZE, scale);
+        g_free(lowercase_class);
+        if (icon != NULL) return icon;
+        
+        if (strlen(instance) > 0) {
+            gchar *lowercase_instance = g_ascii_strdown(instance, -1);
+            icon = app_mgr_load_icon(lowercase_instance, DOCK_ICON_SIZE, scale);
+            g_free(lowercase_instance);
+            if (icon != NULL) return icon;
         }
     }
 
     /* Method 3: Use generic fallback icon */
-    GtkIconTheme *icon_theme = gtk_icon_theme_get_default();
-    GError *error = NULL;
-    pixbuf = gtk_icon_theme_load_icon(icon_theme, "application-x-executable", 48,
-                                     GTK_ICON_LOOKUP_FORCE_SIZE, &error);
-    if (error) {
-        g_error_free(error);
-    }
-    
-    return pixbuf;
+    return app_mgr_load_icon("application-x-executable", DOCK_ICON_SIZE, scale);
 }
 
 
@@ -944,12 +675,60 @@ void on_button_clicked(GtkWidget *widget, gpointer data) {
     gdk_x11_display_error_trap_pop_ignored(gdk_display_get_default());
 }
 
+/* A window's title changed: only a single-window group shows it */
+static void update_window_tooltip(Window xwindow) {
+    const WinCacheEntry *entry = win_cache_get(xwindow);
+    WindowGroup *group = g_hash_table_lookup(window_groups, win_cache_class(entry));
+    if (group != NULL && group->windows != NULL && group->windows->next == NULL &&
+        (Window)GPOINTER_TO_INT(group->windows->data) == xwindow) {
+        update_group_button(group);
+    }
+}
+
+/* A window's _NET_WM_ICON changed: only its group's icon window matters */
+static void update_window_icon(Window xwindow) {
+    const WinCacheEntry *entry = win_cache_get(xwindow);
+    WindowGroup *group = g_hash_table_lookup(window_groups, win_cache_class(entry));
+    if (group != NULL && group->icon_window == xwindow) {
+        load_group_icon(group);
+    }
+}
+
+/* Icon theme or scale factor changed: every group icon is stale */
+static void reload_group_icons(void) {
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, window_groups);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        load_group_icon((WindowGroup *)value);
+    }
+}
+
+static void on_icon_theme_changed(GtkIconTheme *theme, gpointer data) {
+    (void)theme; (void)data;
+    reload_group_icons();
+}
+
+static void on_scale_factor_changed(GObject *object, GParamSpec *pspec, gpointer data) {
+    (void)object; (void)pspec; (void)data;
+    reload_group_icons();
+}
+
 /* Filter X events to update list */
 GdkFilterReturn event_filter(GdkXEvent *xevent, GdkEvent *event, gpointer data) {
     (void)event; (void)data; /* Unused */
     XEvent *xev = (XEvent *)xevent;
 
-    if (xev->type == PropertyNotify) {
+    if (xev->type == PropertyNotify && xev->xproperty.window != root_window) {
+        /* A client window's property: refresh just that one in the cache */
+        WinCacheChange change = win_cache_handle_property(&xev->xproperty);
+        if (change & (WIN_CACHE_CLASS | WIN_CACHE_STATE)) {
+            update_window_list(); /* Grouping or visibility changed */
+        } else {
+            if (change & WIN_CACHE_NAME) update_window_tooltip(xev->xproperty.window);
+            if (change & WIN_CACHE_ICON) update_window_icon(xev->xproperty.window);
+        }
+    } else if (xev->type == PropertyNotify) {
         if (xev->xproperty.atom == net_client_list_atom) {
             update_window_list();
             pager_update(); /* Windows changed, update previews potentially */
@@ -1047,18 +826,10 @@ void on_new_window_clicked(GtkWidget *menuitem, gpointer data) {
     WindowGroup *group = (WindowGroup *)data;
     
     if (group->desktop_file_path != NULL) {
-        GDesktopAppInfo *app_info = g_desktop_app_info_new_from_filename(group->desktop_file_path);
-        if (app_info != NULL) {
-            GError *error = NULL;
-            GdkAppLaunchContext *context = gdk_display_get_app_launch_context(gdk_display_get_default());
-            
-            if (!g_app_info_launch(G_APP_INFO(app_info), NULL, G_APP_LAUNCH_CONTEXT(context), &error)) {
-                g_warning("Failed to launch app: %s", error->message);
-                g_error_free(error);
-            }
-            
-            g_object_unref(context);
-            g_object_unref(app_info);
+        GError *error = NULL;
+        if (!app_mgr_launch(group->desktop_file_path, &error)) {
+            g_warning("Failed to launch app: %s", error ? error->message : group->desktop_file_path);
+            g_clear_error(&error);
         }
     }
 }
@@ -1110,7 +881,7 @@ void on_run_with_gpu_clicked(GtkWidget *menuitem, gpointer data) {
                 gchar *gpu_command = g_strdup_printf("env DRI_PRIME=1 __NV_PRIME_RENDER_OFFLOAD=1 __GLX_VENDOR_LIBRARY_NAME=nvidia %s", clean_exec);
                 
                 GError *error = NULL;
-                if (!g_spawn_command_line_async(gpu_command, &error)) {
+                if (!app_mgr_launch_detached(gpu_command, &error)) {
                     g_warning("Failed to launch with GPU: %s", error->message);
                     g_error_free(error);
                 }
@@ -0,0 +1,466 @@
+/*
+ * desktop_bench - Per-file cost of the .desktop parser against GKeyFile.
+ *
+ *   meson compile -C build desktop-bench
+ *   ./build/desktop-bench [-n files] [-s seed] [-o corpus_dir] [dir...]
+ *
+ * Checks desktop_parser against GKeyFile — the way the launcher used to
+ * read entries — on two sets of files, and prints the median time per
+ * file for each parser:
+ *
+ *   generated  a corpus written by this program (default 5000 files,
+ *              seed 1) with translations, escapes (valid and not),
+ *              CRLF line ends, duplicate keys, padded separators,
+ *              invalid UTF-8 and malformed lines, compared under
+ *              several LANGUAGE settings.  It goes to a temporary
+ *              directory, or to corpus_dir (kept) with -o.
+ *   installed  every *.desktop in the given directories (default
+ *              /usr/share/applications).
+ *
+ * The one intended difference — a malformed line after [Desktop Entry],
+ * which desktop_parser never reads but which makes GKeyFile refuse the
+ * whole file — is accepted only if GKeyFile agrees on the file cut off
+ * there.  It is counted separately; any other difference is a mismatch
+ * and makes the exit status 1.
+ */
+
+#include "../src/core/desktop_parser.h"
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROUNDS  20
+#define GROUP   "Desktop Entry"
+
+/* -------------------------------------------------------------------------
+ * Corpus generator
+ * ------------------------------------------------------------------------- */
+
+static const char *langs[] = {
+    "de", "de_DE", "fr", "es", "pt_BR", "ja", "zh_CN", "ru", "C", "en_US", "en",
+};
+
+static const char *words[] = {
+    "Libre", "Office", "Writer", "Text", "Editor", "Web", "Browser", "Files",
+    "Terminal", "Ünïcödé", "日本語",
+};
+
+static const char *localized_keys[] = {
+    "Name", "Comment", "GenericName", "Keywords", "Exec",
+};
+
+static const char *booleans[] = { "true", "false", "1", "0", "yes", "true  " };
+
+static const char *separators[] = { "=", "=", "=", " = ", "= " };
+
+static guint32
+next_rand (guint32 *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+/* TRUE with probability @p */
+static gboolean
+chance (guint32 *state, double p)
+{
+    return (next_rand (state) % 10000) < (guint32) (p * 10000);
+}
+
+#define PICK(state, array)  ((array)[next_rand (state) % G_N_ELEMENTS (array)])
+
+/* A few words, sometimes with escapes, a bad escape or padding */
+static char *
+gen_value (guint32 *state)
+{
+    GString *v = g_string_new (NULL);
+    guint    n = 1 + next_rand (state) % 3;
+    for (guint i = 0; i < n; i++) {
+        if (i) g_string_append_c (v, ' ');
+        g_string_append (v, PICK (state, words));
+    }
+
+    guint r = next_rand (state) % 100;
+    if (r < 5)       g_string_append (v, "\\s\\n\\t\\r\\\\x");
+    else if (r < 7)  g_string_append (v, "\\q");         /* invalid escape */
+    else if (r < 8)  g_string_append_c (v, '\\');        /* trailing backslash */
+    else if (r < 10) { g_string_prepend (v, "  "); g_string_append (v, "  "); }
+    else if (r < 11) g_string_prepend (v, "\\s");        /* escaped leading space */
+    return g_string_free (v, FALSE);
+}
+
+static void
+add_key (GPtrArray *keys, const char *key, char *value)
+{
+    g_ptr_array_add (keys, g_strdup (key));
+    g_ptr_array_add (keys, value);
+}
+
+/* Contents of generated file @index */
+static GString *
+gen_file (guint32 *state, guint index)
+{
+    static const char *types[] = { "Application", "Application", "Link", "Application " };
+    GString   *out  = g_string_new (NULL);
+    GPtrArray *keys = g_ptr_array_new_with_free_func (g_free);   /* key, value, ... */
+
+    if (chance (state, 0.10)) g_string_append (out, "# comment\n");
+    if (chance (state, 0.02)) g_string_append (out, "Orphan=1\n");   /* before any group */
+    if (chance (state, 0.05)) g_string_append (out, "[Other Group]\nFoo=bar\n");
+    g_string_append (out, "[" GROUP "]\n");
+
+    add_key (keys, "Type", g_strdup (PICK (state, types)));
+    add_key (keys, "Name", gen_value (state));
+
+    /* Translations, in random languages, each used once */
+    guint used = 0;
+    guint n_tr = next_rand (state) % 7;
+    for (guint i = 0; i < n_tr; i++) {
+        guint l = next_rand (state) % G_N_ELEMENTS (langs);
+        if (used & (1u << l)) continue;
+        used |= 1u << l;
+        char *key = g_strdup_printf ("%s[%s]", PICK (state, localized_keys), langs[l]);
+        add_key (keys, key, gen_value (state));
+        g_free (key);
+    }
+
+    add_key (keys, "Exec", chance (state, 0.95) ? g_strdup_printf ("app%u %%U", index)
+                                                 : g_strdup ("a\\;b"));
+    if (chance (state, 0.8)) add_key (keys, "Icon", g_strdup_printf ("icon-%u", index));
+    if (chance (state, 0.7)) add_key (keys, "Comment", gen_value (state));
+    if (chance (state, 0.3)) add_key (keys, "GenericName", gen_value (state));
+    if (chance (state, 0.3)) add_key (keys, "Keywords", g_strdup ("a;b;c;"));
+    if (chance (state, 0.6)) add_key (keys, "Categories", g_strdup ("Utility;Office;"));
+    if (chance (state, 0.2)) add_key (keys, "StartupWMClass", g_strdup_printf ("App%u", index));
+    if (chance (state, 0.1)) add_key (keys, "NoDisplay", g_strdup (PICK (state, booleans)));
+    if (chance (state, 0.05)) add_key (keys, "Hidden", g_strdup (PICK (state, booleans)));
+    if (chance (state, 0.05)) add_key (keys, "Name", g_strdup_printf ("Dup %u", index));
+
+    /* Shuffle key/value pairs */
+    guint n_pairs = keys->len / 2;
+    for (guint i = n_pairs; i > 1; i--) {
+        guint j = next_rand (state) % i;
+        gpointer k = keys->pdata[2 * (i - 1)], v = keys->pdata[2 * (i - 1) + 1];
+        keys->pdata[2 * (i - 1)]     = keys->pdata[2 * j];
+        keys->pdata[2 * (i - 1) + 1] = keys->pdata[2 * j + 1];
+        keys->pdata[2 * j]     = k;
+        keys->pdata[2 * j + 1] = v;
+    }
+    for (guint i = 0; i < n_pairs; i++)
+        g_string_append_printf (out, "%s%s%s\n", (char *) keys->pdata[2 * i],
+                                PICK (state, separators), (char *) keys->pdata[2 * i + 1]);
+    g_ptr_array_unref (keys);
+
+    if (chance (state, 0.03)) g_string_append (out, "garbage line\n");
+    if (chance (state, 0.05)) g_string_append (out, "   \n");
+    if (chance (state, 0.30)) g_string_append (out, "\n[Desktop Action new]\nName=New Window\nExec=x\n");
+    if (chance (state, 0.02)) g_string_append (out, "=novalue\n");
+
+    if (chance (state, 0.05)) {
+        GString *crlf = g_string_sized_new (out->len + 64);
+        for (gsize i = 0; i < out->len; i++) {
+            if (out->str[i] == '\n') g_string_append_c (crlf, '\r');
+            g_string_append_c (crlf, out->str[i]);
+        }
+        g_string_free (out, TRUE);
+        out = crlf;
+    }
+
+    /* Invalid UTF-8 in a value */
+    char *libre;
+    if (chance (state, 0.01) && (libre = strstr (out->str, "Libre")))
+        libre[1] = (char) 0xff;
+    return out;
+}
+
+/* Writes @n files into @dir and appends their paths to @paths */
+static gboolean
+gen_corpus (const char *dir, guint n, guint32 seed, GPtrArray *paths)
+{
+    guint32 state = seed;
+
+    for (guint i = 0; i < n; i++) {
+        GString *data = gen_file (&state, i);
+        char    *name = g_strdup_printf ("app%u.desktop", i);
+        char    *path = g_build_filename (dir, name, NULL);
+        GError  *err  = NULL;
+
+        gboolean ok = g_file_set_contents (path, data->str, (gssize) data->len, &err);
+        g_string_free (data, TRUE);
+        g_free (name);
+        if (!ok) {
+            fprintf (stderr, "desktop-bench: %s\n", err->message);
+            g_error_free (err);
+            g_free (path);
+            return FALSE;
+        }
+        g_ptr_array_add (paths, path);
+    }
+    return TRUE;
+}
+
+/* -------------------------------------------------------------------------
+ * Comparison
+ * ------------------------------------------------------------------------- */
+
+static gint
+compare_time (gconstpointer a, gconstpointer b)
+{
+    gint64 x = *(const gint64 *) a, y = *(const gint64 *) b;
+    return (x > y) - (x < y);
+}
+
+static void
+keyfile_fill (GKeyFile *kf, DesktopFields *out)
+{
+    out->type         = g_key_file_get_string (kf, GROUP, "Type", NULL);
+    out->name         = g_key_file_get_locale_string (kf, GROUP, "Name", NULL, NULL);
+    out->exec         = g_key_file_get_string (kf, GROUP, "Exec", NULL);
+    out->icon         = g_key_file_get_string (kf, GROUP, "Icon", NULL);
+    out->comment      = g_key_file_get_locale_string (kf, GROUP, "Comment", NULL, NULL);
+    out->generic_name = g_key_file_get_locale_string (kf, GROUP, "GenericName", NULL, NULL);
+    out->keywords     = g_key_file_get_locale_string (kf, GROUP, "Keywords", NULL, NULL);
+    out->categories   = g_key_file_get_string (kf, GROUP, "Categories", NULL);
+    out->startup_wm_class = g_key_file_get_string (kf, GROUP, "StartupWMClass", NULL);
+    out->no_display   = g_key_file_get_boolean (kf, GROUP, "NoDisplay", NULL);
+    out->hidden       = g_key_file_get_boolean (kf, GROUP, "Hidden", NULL);
+}
+
+static gboolean
+keyfile_parse (const char *path, DesktopFields *out)
+{
+    GKeyFile *kf = g_key_file_new ();
+    memset (out, 0, sizeof *out);
+
+    gboolean ok = g_key_file_load_from_file (kf, path, G_KEY_FILE_NONE, NULL);
+    if (ok) keyfile_fill (kf, out);
+    g_key_file_free (kf);
+    return ok;
+}
+
+/*
+ * GKeyFile on @path cut off at the group after [Desktop Entry] — what
+ * desktop_parser reads.  FALSE if there is no such group or it fails.
+ */
+static gboolean
+keyfile_parse_entry_group (const char *path, DesktopFields *out)
+{
+    char  *data = NULL;
+    gsize  len  = 0;
+    memset (out, 0, sizeof *out);
+    if (!g_file_get_contents (path, &data, &len, NULL)) return FALSE;
+
+    gboolean in_entry = FALSE;
+    gsize    end      = 0;
+    for (gsize line = 0; line < len && !end; ) {
+        const char *nl   = memchr (data + line, '\n', len - line);
+        gsize       next = nl ? (gsize) (nl - data) + 1 : len;
+
+        if (data[line] == '[') {
+            if (in_entry) end = line;
+            in_entry = strncmp (data + line, "[" GROUP "]", strlen (GROUP) + 2) == 0;
+        }
+        line = next;
+    }
+
+    gboolean ok = FALSE;
+    if (end) {
+        GKeyFile *kf = g_key_file_new ();
+        ok = g_key_file_load_from_data (kf, data, end, G_KEY_FILE_NONE, NULL);
+        if (ok) keyfile_fill (kf, out);
+        g_key_file_free (kf);
+    }
+    g_free (data);
+    return ok;
+}
+
+/* Returns the name of the first differing field, or NULL */
+static const char *
+compare_fields (const DesktopFields *a, const DesktopFields *b)
+{
+    if (g_strcmp0 (a->type, b->type))                 return "Type";
+    if (g_strcmp0 (a->name, b->name))                 return "Name";
+    if (g_strcmp0 (a->exec, b->exec))                 return "Exec";
+    if (g_strcmp0 (a->icon, b->icon))                 return "Icon";
+    if (g_strcmp0 (a->comment, b->comment))           return "Comment";
+    if (g_strcmp0 (a->generic_name, b->generic_name)) return "GenericName";
+    if (g_strcmp0 (a->keywords, b->keywords))         return "Keywords";
+    if (g_strcmp0 (a->categories, b->categories))     return "Categories";
+    if (g_strcmp0 (a->startup_wm_class, b->startup_wm_class)) return "StartupWMClass";
+    if (a->no_display != b->no_display)               return "NoDisplay";
+    if (a->hidden != b->hidden)                       return "Hidden";
+    return NULL;
+}
+
+/* Compares both parsers on every file; returns the number of mismatches */
+static guint
+check (GPtrArray *paths, const char *language)
+{
+    guint mismatches = 0, after_group = 0;
+
+    for (guint i = 0; i < paths->len; i++) {
+        const char   *path = g_ptr_array_index (paths, i);
+        DesktopFields a, b;
+        gboolean      ok_a = keyfile_parse (path, &a);
+        gboolean      ok_b = desktop_parser_parse_file (path, &b);
+
+        /* The intended difference: only what follows [Desktop Entry] is bad */
+        if (!ok_a && ok_b) {
+            ok_a = keyfile_parse_entry_group (path, &a);
+            if (ok_a) after_group++;
+        }
+
+        const char *field = ok_a != ok_b ? "load" :
+                            ok_a ? compare_fields (&a, &b) : NULL;
+        if (field) {
+            mismatches++;
+            printf ("mismatch: %s (%s, LANGUAGE=%s)\n", path, field, language);
+        }
+        desktop_fields_clear (&a);
+        desktop_fields_clear (&b);
+    }
+
+    printf ("  LANGUAGE=%-12s %u files, %u mismatches, %u differ only after [%s]\n",
+            language, paths->len, mismatches, after_group, GROUP);
+    return mismatches;
+}
+
+static gint64
+time_pass (GPtrArray *paths,
+           gboolean (*parse) (const char *, DesktopFields *))
+{
+    gint64 t0 = g_get_monotonic_time ();
+    for (guint i = 0; i < paths->len; i++) {
+        DesktopFields f;
+        parse (g_ptr_array_index (paths, i), &f);
+        desktop_fields_clear (&f);
+    }
+    return g_get_monotonic_time () - t0;
+}
+
+/* Agreement under each of @languages (the current one if NULL), then timing */
+static guint
+run (const char *label, GPtrArray *paths, const char * const *languages)
+{
+    guint mismatches = 0;
+
+    printf ("%s:\n", label);
+    if (languages) {
+        char *saved = g_strdup (g_getenv ("LANGUAGE"));
+        for (const char * const *l = languages; *l; l++) {
+            g_setenv ("LANGUAGE", *l, TRUE);
+            mismatches += check (paths, *l);
+        }
+        if (saved) g_setenv ("LANGUAGE", saved, TRUE);
+        else       g_unsetenv ("LANGUAGE");
+        g_free (saved);
+    } else {
+        const char *current = g_getenv ("LANGUAGE");
+        mismatches += check (paths, current ? current : "(unset)");
+    }
+
+    gint64 kf_times[ROUNDS], dp_times[ROUNDS];
+    for (guint r = 0; r < ROUNDS; r++) {
+        kf_times[r] = time_pass (paths, keyfile_parse);
+        dp_times[r] = time_pass (paths, desktop_parser_parse_file);
+    }
+    qsort (kf_times, ROUNDS, sizeof (gint64), compare_time);
+    qsort (dp_times, ROUNDS, sizeof (gint64), compare_time);
+
+    double kf = (double) kf_times[ROUNDS / 2] / paths->len;
+    double dp = (double) dp_times[ROUNDS / 2] / paths->len;
+
+    printf ("  GKeyFile        %8.2f us/file\n", kf);
+    printf ("  desktop_parser  %8.2f us/file  (%.1fx)\n", dp, dp > 0 ? kf / dp : 0.0);
+    return mismatches;
+}
+
+static void
+collect (const char *dir, GPtrArray *paths)
+{
+    GDir *d = g_dir_open (dir, 0, NULL);
+    if (!d) {
+        fprintf (stderr, "desktop-bench: cannot open %s\n", dir);
+        return;
+    }
+
+    const char *name;
+    while ((name = g_dir_read_name (d)))
+        if (g_str_has_suffix (name, ".desktop"))
+            g_ptr_array_add (paths, g_build_filename (dir, name, NULL));
+    g_dir_close (d);
+}
+
+int
+main (int argc, char **argv)
+{
+    /* Exact, prefix-only, region fallback, unknown, several at once */
+    static const char *languages[] = { "C", "de_DE", "pt_BR", "ja:fr", "sv", NULL };
+
+    guint       n_files    = 5000;
+    guint32     seed       = 1;
+    const char *corpus_dir = NULL;
+    int         first_dir  = 1;
+
+    for (; first_dir < argc && argv[first_dir][0] == '-'; first_dir++) {
+        const char *opt = argv[first_dir];
+        if (first_dir + 1 >= argc || strlen (opt) != 2 || !strchr ("nso", opt[1])) {
+            fprintf (stderr, "usage: desktop-bench [-n files] [-s seed] [-o corpus_dir] [dir...]\n");
+            return 2;
+        }
+        const char *val = argv[++first_dir];
+        if (opt[1] == 'n')      n_files    = (guint) atoi (val);
+        else if (opt[1] == 's') seed       = (guint32) strtoul (val, NULL, 10);
+        else                    corpus_dir = val;
+    }
+
+    guint mismatches = 0;
+
+    /* Generated corpus */
+    char *tmp_dir = NULL;
+    if (corpus_dir) {
+        g_mkdir_with_parents (corpus_dir, 0755);
+    } else {
+        GError *err = NULL;
+        tmp_dir = g_dir_make_tmp ("desktop-bench-XXXXXX", &err);
+        if (!tmp_dir) {
+            fprintf (stderr, "desktop-bench: %s\n", err->message);
+            g_error_free (err);
+            return 1;
+        }
+    }
+
+    GPtrArray *generated = g_ptr_array_new_with_free_func (g_free);
+    if (n_files > 0) {
+        if (!gen_corpus (corpus_dir ? corpus_dir : tmp_dir, n_files, seed, generated))
+            return 1;
+        char *label = g_strdup_printf ("generated (%u files, seed %u, %s)", n_files, seed,
+                                       corpus_dir ? corpus_dir : "temporary");
+        mismatches += run (label, generated, languages);
+        g_free (label);
+    }
+    if (tmp_dir) {
+        for (guint i = 0; i < generated->len; i++)
+            g_unlink (g_ptr_array_index (generated, i));
+        g_rmdir (tmp_dir);
+        g_free (tmp_dir);
+    }
+    g_ptr_array_unref (generated);
+
+    /* Installed entries */
+    GPtrArray *installed = g_ptr_array_new_with_free_func (g_free);
+    if (first_dir < argc)
+        for (int i = first_dir; i < argc; i++) collect (argv[i], installed);
+    else
+        collect ("/usr/share/applications", installed);
+
+    if (installed->len > 0)
+        mismatches += run ("installed", installed, NULL);
+    else
+        fprintf (stderr, "desktop-bench: no installed .desktop files\n");
+    g_ptr_array_unref (installed);
+
+    return mismatches ? 1 : 0;
+}
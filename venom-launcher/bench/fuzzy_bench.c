@@ -0,0 +1,98 @@
+/*
+ * fuzzy_bench - Per-keystroke cost of fuzzy_rank() over a synthetic
+ * catalog.
+ *
+ *   meson compile -C build fuzzy-bench && ./build/fuzzy-bench [n_entries]
+ *
+ * Types "lo wr" one key at a time against n_entries names (default
+ * 10000, one of them "LibreOffice Writer") and prints the median and
+ * worst time per keystroke plus the top hit.
+ */
+
+#include "../src/core/fuzzy_match.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ROUNDS  200
+#define TOP_K   140
+
+static const char *words[] = {
+    "Libre", "Office", "Writer", "Calc", "Impress", "Draw", "Gnome", "KDE",
+    "Terminal", "Text", "Editor", "Files", "Manager", "System", "Monitor",
+    "Settings", "Sound", "Video", "Player", "Image", "Viewer", "Web",
+    "Browser", "Mail", "Client", "Disk", "Usage", "Analyzer", "Network",
+    "Tools", "Color", "Picker", "Font", "Archive", "Backup", "Clock",
+    "Weather", "Maps", "Photos", "Music", "Notes", "Tasks", "Calendar",
+    "Contacts", "Password", "Keyring", "Screenshot", "Recorder", "Power",
+    "Statistics", "Printer", "Scanner", "Remote", "Desktop", "Viewer",
+};
+
+static guint32
+next_rand (guint32 *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+static gint
+compare_time (gconstpointer a, gconstpointer b)
+{
+    gint64 x = *(const gint64 *) a, y = *(const gint64 *) b;
+    return (x > y) - (x < y);
+}
+
+int
+main (int argc, char **argv)
+{
+    guint n = argc > 1 ? (guint) atoi (argv[1]) : 10000;
+    if (n < 1) n = 1;
+
+    char     **names = g_new0 (char *, n);
+    FuzzySlot *slots = g_new0 (FuzzySlot, n);
+    guint32    seed  = 42;
+
+    for (guint i = 0; i < n; i++) {
+        GString *s = g_string_new (NULL);
+        guint    k = 1 + next_rand (&seed) % 3;
+        for (guint w = 0; w < k; w++) {
+            if (w) g_string_append_c (s, ' ');
+            g_string_append (s, words[next_rand (&seed) % G_N_ELEMENTS (words)]);
+        }
+        g_string_append_printf (s, " %u", i);
+        names[i] = g_string_free (s, FALSE);
+    }
+    g_free (names[n / 2]);
+    names[n / 2] = g_strdup ("LibreOffice Writer");
+
+    for (guint i = 0; i < n; i++)
+        fuzzy_slot_init (&slots[i], names[i]);
+
+    const char *keys[] = { "l", "lo", "lo ", "lo w", "lo wr" };
+    FuzzyHit    hits[TOP_K];
+    gint64      times[ROUNDS];
+
+    printf ("%u entries, %d rounds\n", n, ROUNDS);
+    for (guint q = 0; q < G_N_ELEMENTS (keys); q++) {
+        guint n_hits = 0;
+        for (guint r = 0; r < ROUNDS; r++) {
+            gint64 t0 = g_get_monotonic_time ();
+            FuzzyQuery *query = fuzzy_query_new (keys[q]);
+            n_hits = fuzzy_rank (query, slots, NULL, n, TOP_K, hits);
+            fuzzy_query_free (query);
+            times[r] = g_get_monotonic_time () - t0;
+        }
+        qsort (times, ROUNDS, sizeof (gint64), compare_time);
+
+        printf ("  %-8s median %5" G_GINT64_FORMAT " us  max %5" G_GINT64_FORMAT
+                " us  hits %3u  top: %s\n",
+                keys[q], times[ROUNDS / 2], times[ROUNDS - 1], n_hits,
+                n_hits ? names[hits[0].index] : "-");
+    }
+
+    for (guint i = 0; i < n; i++)
+        g_free (names[i]);
+    g_free (names);
+    g_free (slots);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * spawn_bench - Click-to-exec latency, local fork against venom-spawnd.
+ *
+ *   meson compile -C build spawn-bench venom-spawnd
+ *   ./build/venom-spawnd & ./build/spawn-bench [MiB...]
+ *
+ * For each ballast size (default 0 256 1024 MiB of touched heap, to
+ * stand in for a grown GTK shell) starts /bin/true repeatedly the way
+ * the shell used to — g_spawn_async() with a child setup function,
+ * which forks the caller — and through the spawn helper, and prints the
+ * median time until the child has exec'd.  The helper column should
+ * stay flat as the ballast grows.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "../src/core/venom-spawn.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROUNDS  50
+
+static gint
+compare_time (gconstpointer a, gconstpointer b)
+{
+    gint64 x = *(const gint64 *) a, y = *(const gint64 *) b;
+    return (x > y) - (x < y);
+}
+
+static double
+median_ms (gint64 *t)
+{
+    qsort (t, ROUNDS, sizeof *t, (int (*) (const void *, const void *)) compare_time);
+    return t[ROUNDS / 2] / 1000.0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const int default_sizes[] = { 0, 256, 1024 };
+    char  *child[] = { "/bin/true", NULL };
+    char **env     = g_get_environ ();
+    char  *cwd     = g_get_current_dir ();
+    gint64 local[ROUNDS], helper[ROUNDS];
+    int    n_sizes = argc > 1 ? argc - 1 : (int) G_N_ELEMENTS (default_sizes);
+    guint8 *ballast = NULL;
+    gsize   ballast_size = 0;
+
+    VenomSpawnReply reply;
+    int err;
+    if (!venom_spawn_request (cwd, child, env, &reply, &err)) {
+        fprintf (stderr, "venom-spawnd is not running (start it first)\n");
+        return 1;
+    }
+
+    printf ("%10s  %14s  %14s\n", "ballast", "fork (ms)", "helper (ms)");
+
+    for (int s = 0; s < n_sizes; s++) {
+        gsize mib = argc > 1 ? (gsize) atoi (argv[s + 1]) : (gsize) default_sizes[s];
+
+        /* Grow (never shrink) the touched heap to the requested size */
+        if (mib << 20 > ballast_size) {
+            ballast = g_realloc (ballast, mib << 20);
+            memset (ballast + ballast_size, 1, (mib << 20) - ballast_size);
+            ballast_size = mib << 20;
+        }
+
+        for (int r = 0; r < ROUNDS; r++) {
+            gint64 start = g_get_monotonic_time ();
+            if (!g_spawn_async (NULL, child, NULL, 0, venom_spawn_child_setup,
+                                NULL, NULL, NULL))
+                return 1;
+            local[r] = g_get_monotonic_time () - start;
+
+            start = g_get_monotonic_time ();
+            if (!venom_spawn_request (cwd, child, env, &reply, &err))
+                return 1;
+            helper[r] = g_get_monotonic_time () - start;
+        }
+
+        printf ("%6zu MiB  %14.3f  %14.3f\n", mib, median_ms (local), median_ms (helper));
+    }
+
+    g_free (ballast);
+    g_free (cwd);
+    g_strfreev (env);
+    return 0;
+}
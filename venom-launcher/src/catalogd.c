@@ -0,0 +1,163 @@
+/*
+ * venom-catalogd - Session application catalog service.
+ *
+ * Scans the application directories once, publishes the result as a
+ * SessionCatalog snapshot and republishes it whenever AppMonitor reports
+ * a change.  The launcher, dock, panel and desktop map the snapshot
+ * instead of scanning on their own.  Started by D-Bus activation.
+ */
+
+#include "core/desktop_reader.h"
+#include "core/app_monitor.h"
+#include "core/session_catalog.h"
+
+#include <gio/gio.h>
+#include <locale.h>
+
+static const char introspection_xml[] =
+    "<node>"
+    "  <interface name='" SESSION_CATALOG_IFACE "'>"
+    "    <method name='GetSnapshot'>"
+    "      <arg type='s' name='path' direction='out'/>"
+    "      <arg type='u' name='version' direction='out'/>"
+    "    </method>"
+    "    <signal name='Changed'>"
+    "      <arg type='u' name='version'/>"
+    "    </signal>"
+    "  </interface>"
+    "</node>";
+
+typedef struct {
+    GMainLoop       *loop;
+    GDBusConnection *bus;
+    AppMonitor      *monitor;
+    guint32          version;
+} CatalogService;
+
+/* -------------------------------------------------------------------------
+ * Publishing
+ * ------------------------------------------------------------------------- */
+
+static void
+publish (CatalogService *svc)
+{
+    gint64     start   = g_get_monotonic_time ();
+    GPtrArray *apps    = desktop_reader_load_apps_full (DESKTOP_READER_PARALLEL);
+    guint32    version = session_catalog_publish (apps);
+    guint      n       = apps->len;
+    g_ptr_array_unref (apps);
+
+    if (version == 0 || version == svc->version) return;
+    svc->version = version;
+
+    g_message ("Catalogd: published v%u, %u apps in %.1f ms", version, n,
+               (g_get_monotonic_time () - start) / 1000.0);
+
+    if (svc->bus)
+        g_dbus_connection_emit_signal (svc->bus, NULL, SESSION_CATALOG_PATH,
+                                       SESSION_CATALOG_IFACE, "Changed",
+                                       g_variant_new ("(u)", version), NULL);
+}
+
+/* The cache makes a rescan a stat per file; no need to patch per id */
+static void
+on_apps_changed (GPtrArray *desktop_ids, gpointer user_data)
+{
+    (void) desktop_ids;
+    publish (user_data);
+}
+
+/* -------------------------------------------------------------------------
+ * D-Bus
+ * ------------------------------------------------------------------------- */
+
+static void
+on_method_call (GDBusConnection *bus, const char *sender, const char *path,
+                const char *iface, const char *method, GVariant *params,
+                GDBusMethodInvocation *invocation, gpointer user_data)
+{
+    (void) bus; (void) sender; (void) path; (void) iface; (void) params;
+    CatalogService *svc = user_data;
+
+    if (g_strcmp0 (method, "GetSnapshot") != 0) {
+        g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
+                                               G_DBUS_ERROR_UNKNOWN_METHOD,
+                                               "No method %s", method);
+        return;
+    }
+
+    char *file = session_catalog_get_path ();
+    g_dbus_method_invocation_return_value (invocation,
+                                           g_variant_new ("(su)", file, svc->version));
+    g_free (file);
+}
+
+static const GDBusInterfaceVTable vtable = { on_method_call, NULL, NULL, { 0 } };
+
+static void
+on_bus_acquired (GDBusConnection *bus, const char *name, gpointer user_data)
+{
+    (void) name;
+    CatalogService *svc = user_data;
+    GError         *err = NULL;
+
+    GDBusNodeInfo *info = g_dbus_node_info_new_for_xml (introspection_xml, NULL);
+    svc->bus = g_object_ref (bus);
+    if (!g_dbus_connection_register_object (bus, SESSION_CATALOG_PATH,
+                                            info->interfaces[0], &vtable,
+                                            svc, NULL, &err)) {
+        g_warning ("Catalogd: register object: %s", err->message);
+        g_error_free (err);
+    }
+    g_dbus_node_info_unref (info);
+}
+
+/* Publish before taking calls, so GetSnapshot never returns version 0 */
+static void
+on_name_acquired (GDBusConnection *bus, const char *name, gpointer user_data)
+{
+    (void) bus; (void) name;
+    CatalogService *svc = user_data;
+
+    publish (svc);
+    svc->monitor = app_monitor_new (on_apps_changed, svc);
+}
+
+static void
+on_name_lost (GDBusConnection *bus, const char *name, gpointer user_data)
+{
+    (void) bus;
+    CatalogService *svc = user_data;
+
+    g_message ("Catalogd: %s is owned elsewhere or the bus went away", name);
+    g_main_loop_quit (svc->loop);
+}
+
+/* -------------------------------------------------------------------------
+ * Entry point
+ * ------------------------------------------------------------------------- */
+
+int
+main (int argc, char *argv[])
+{
+    (void) argc; (void) argv;
+
+    /* Sort keys and localized names must match what GTK clients see */
+    setlocale (LC_ALL, "");
+
+    CatalogService svc = { 0 };
+    svc.loop = g_main_loop_new (NULL, FALSE);
+
+    guint owner = g_bus_own_name (G_BUS_TYPE_SESSION, SESSION_CATALOG_BUS_NAME,
+                                  G_BUS_NAME_OWNER_FLAGS_NONE,
+                                  on_bus_acquired, on_name_acquired, on_name_lost,
+                                  &svc, NULL);
+
+    g_main_loop_run (svc.loop);
+
+    g_bus_unown_name (owner);
+    app_monitor_free (svc.monitor);
+    g_clear_object (&svc.bus);
+    g_main_loop_unref (svc.loop);
+    return 0;
+}
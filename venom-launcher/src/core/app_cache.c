@@ -0,0 +1,341 @@
+#include "app_cache.h"
+
+#include <glib/gstdio.h>
+#include <locale.h>
+#include <string.h>
+
+G_STATIC_ASSERT (sizeof (AppCacheHeader) % 8 == 0);
+G_STATIC_ASSERT (sizeof (AppCacheRecord) % 8 == 0);
+
+/* -------------------------------------------------------------------------
+ * Structs
+ * ------------------------------------------------------------------------- */
+
+struct _AppCache {
+    GMappedFile          *mapped;
+    const char           *data;
+    const AppCacheHeader *header;
+    const AppCacheRecord *records;
+    const char           *strtab;
+    GHashTable           *by_path;  /* path (in mapping) -> AppCacheRecord* */
+};
+
+struct _AppCacheWriter {
+    GArray     *records;    /* AppCacheRecord */
+    GString    *strtab;
+    GHashTable *interned;   /* string -> offset (dedups Categories etc.) */
+    gint64      dir_mtime[APP_CACHE_MAX_DIRS];
+};
+
+/* -------------------------------------------------------------------------
+ * Helpers
+ * ------------------------------------------------------------------------- */
+
+static char *
+cache_file_path (void)
+{
+    return g_build_filename (g_get_user_cache_dir (), "venom",
+                             "launcher-apps.cache", NULL);
+}
+
+/*
+ * Localized Name/Comment depend on the language list and the stored sort
+ * keys on LC_COLLATE — key the cache on both
+ */
+static char *
+locale_key (void)
+{
+    char       *languages = g_strjoinv (":", (char **) g_get_language_names ());
+    const char *collate   = setlocale (LC_COLLATE, NULL);
+    char       *key       = g_strconcat (languages, "|", collate ? collate : "C", NULL);
+    g_free (languages);
+    return key;
+}
+
+static gboolean
+offset_valid (const AppCacheHeader *h, guint32 off)
+{
+    return off < h->strtab_size;
+}
+
+static gboolean
+validate (const char *data, gsize len)
+{
+    if (len < sizeof (AppCacheHeader)) return FALSE;
+
+    const AppCacheHeader *h = (const AppCacheHeader *) data;
+    if (h->magic != APP_CACHE_MAGIC || h->version != APP_CACHE_VERSION)
+        return FALSE;
+    if (h->n_dirs > APP_CACHE_MAX_DIRS) return FALSE;
+
+    guint64 rec_end = (guint64) h->records_offset +
+                      (guint64) h->n_records * sizeof (AppCacheRecord);
+    if (h->records_offset % 8 != 0 || rec_end > len) return FALSE;
+
+    guint64 str_end = (guint64) h->strtab_offset + h->strtab_size;
+    if (h->strtab_size == 0 || str_end > len) return FALSE;
+
+    /* Last byte must terminate the final string */
+    if (data[h->strtab_offset + h->strtab_size - 1] != '\0') return FALSE;
+    if (!offset_valid (h, h->locale)) return FALSE;
+
+    const AppCacheRecord *recs =
+        (const AppCacheRecord *) (data + h->records_offset);
+    for (guint32 i = 0; i < h->n_records; i++) {
+        const AppCacheRecord *r = &recs[i];
+        if (r->dir_index >= h->n_dirs || r->path == 0)       return FALSE;
+        if (!offset_valid (h, r->path)      ||
+            !offset_valid (h, r->name)      ||
+            !offset_valid (h, r->exec)      ||
+            !offset_valid (h, r->icon_name) ||
+            !offset_valid (h, r->categories)||
+            !offset_valid (h, r->comment)   ||
+            !offset_valid (h, r->generic_name) ||
+            !offset_valid (h, r->keywords)  ||
+            !offset_valid (h, r->sort_key)  ||
+            !offset_valid (h, r->startup_wm_class))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* -------------------------------------------------------------------------
+ * Reader
+ * ------------------------------------------------------------------------- */
+
+AppCache *
+app_cache_open (void)
+{
+    char        *path   = cache_file_path ();
+    GMappedFile *mapped = g_mapped_file_new (path, FALSE, NULL);
+    g_free (path);
+    if (!mapped) return NULL;
+
+    const char *data = g_mapped_file_get_contents (mapped);
+    gsize       len  = g_mapped_file_get_length (mapped);
+
+    if (!data || !validate (data, len)) {
+        g_mapped_file_unref (mapped);
+        return NULL;
+    }
+
+    const AppCacheHeader *h = (const AppCacheHeader *) data;
+
+    char    *locale  = locale_key ();
+    gboolean same_lc = g_strcmp0 (locale, data + h->strtab_offset + h->locale) == 0;
+    g_free (locale);
+    if (!same_lc) {
+        g_mapped_file_unref (mapped);
+        return NULL;
+    }
+
+    AppCache *c = g_new0 (AppCache, 1);
+    c->mapped  = mapped;
+    c->data    = data;
+    c->header  = h;
+    c->records = (const AppCacheRecord *) (data + h->records_offset);
+    c->strtab  = data + h->strtab_offset;
+    c->by_path = g_hash_table_new (g_str_hash, g_str_equal);
+
+    for (guint32 i = 0; i < h->n_records; i++) {
+        const AppCacheRecord *r = &c->records[i];
+        g_hash_table_insert (c->by_path, (gpointer) (c->strtab + r->path),
+                             (gpointer) r);
+    }
+
+    return c;
+}
+
+void
+app_cache_free (AppCache *cache)
+{
+    if (!cache) return;
+    g_hash_table_destroy (cache->by_path);
+    /* Entries built from the cache keep their own ref on the mapping */
+    g_mapped_file_unref (cache->mapped);
+    g_free (cache);
+}
+
+gboolean
+app_cache_dir_unchanged (AppCache *cache, guint dir_index, gint64 mtime)
+{
+    if (!cache || dir_index >= cache->header->n_dirs) return FALSE;
+    return cache->header->dir_mtime[dir_index] == mtime;
+}
+
+guint
+app_cache_get_n_records (AppCache *cache)
+{
+    return cache ? cache->header->n_records : 0;
+}
+
+const AppCacheRecord *
+app_cache_get_record (AppCache *cache, guint index)
+{
+    g_return_val_if_fail (cache != NULL, NULL);
+    g_return_val_if_fail (index < cache->header->n_records, NULL);
+    return &cache->records[index];
+}
+
+const AppCacheRecord *
+app_cache_lookup (AppCache *cache, const char *path)
+{
+    if (!cache || !path) return NULL;
+    return g_hash_table_lookup (cache->by_path, path);
+}
+
+const char *
+app_cache_get_string (AppCache *cache, guint32 offset)
+{
+    g_return_val_if_fail (cache != NULL, NULL);
+    if (offset == 0 || offset >= cache->header->strtab_size) return NULL;
+    return cache->strtab + offset;
+}
+
+AppEntry *
+app_cache_make_entry (AppCache *cache, const AppCacheRecord *rec)
+{
+    g_return_val_if_fail (cache != NULL && rec != NULL, NULL);
+
+    AppEntry *e = app_entry_new ();
+    e->backing      = g_mapped_file_ref (cache->mapped);
+    e->name         = (char *) app_cache_get_string (cache, rec->name);
+    e->exec         = (char *) app_cache_get_string (cache, rec->exec);
+    e->icon_name    = (char *) app_cache_get_string (cache, rec->icon_name);
+    e->categories   = (char *) app_cache_get_string (cache, rec->categories);
+    e->comment      = (char *) app_cache_get_string (cache, rec->comment);
+    e->generic_name = (char *) app_cache_get_string (cache, rec->generic_name);
+    e->keywords     = (char *) app_cache_get_string (cache, rec->keywords);
+    e->desktop_path = (char *) app_cache_get_string (cache, rec->path);
+    e->sort_key     = (char *) app_cache_get_string (cache, rec->sort_key);
+    e->startup_wm_class = (char *) app_cache_get_string (cache, rec->startup_wm_class);
+    return e;
+}
+
+/* -------------------------------------------------------------------------
+ * Writer
+ * ------------------------------------------------------------------------- */
+
+static guint32
+writer_intern (AppCacheWriter *w, const char *s)
+{
+    if (!s) return 0;
+
+    gpointer off;
+    if (g_hash_table_lookup_extended (w->interned, s, NULL, &off))
+        return GPOINTER_TO_UINT (off);
+
+    guint32 pos = (guint32) w->strtab->len;
+    g_string_append_len (w->strtab, s, (gssize) strlen (s) + 1);
+    g_hash_table_insert (w->interned, g_strdup (s), GUINT_TO_POINTER (pos));
+    return pos;
+}
+
+AppCacheWriter *
+app_cache_writer_new (void)
+{
+    AppCacheWriter *w = g_new0 (AppCacheWriter, 1);
+    w->records  = g_array_new (FALSE, TRUE, sizeof (AppCacheRecord));
+    w->strtab   = g_string_sized_new (64 * 1024);
+    w->interned = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    /* Offset 0 is reserved for NULL */
+    g_string_append_c (w->strtab, '\0');
+    return w;
+}
+
+void
+app_cache_writer_free (AppCacheWriter *w)
+{
+    if (!w) return;
+    g_array_free (w->records, TRUE);
+    g_string_free (w->strtab, TRUE);
+    g_hash_table_destroy (w->interned);
+    g_free (w);
+}
+
+void
+app_cache_writer_set_dir_mtime (AppCacheWriter *w, guint dir_index, gint64 mtime)
+{
+    g_return_if_fail (w != NULL && dir_index < APP_CACHE_MAX_DIRS);
+    w->dir_mtime[dir_index] = mtime;
+}
+
+void
+app_cache_writer_add (AppCacheWriter *w,
+                      guint           dir_index,
+                      const char     *path,
+                      gint64          mtime,
+                      gint64          size,
+                      const AppEntry *entry)
+{
+    g_return_if_fail (w != NULL && path != NULL);
+    g_return_if_fail (dir_index < APP_CACHE_MAX_DIRS);
+
+    AppCacheRecord r = { 0 };
+    r.mtime     = mtime;
+    r.size      = size;
+    r.dir_index = dir_index;
+    r.path      = writer_intern (w, path);
+
+    if (entry) {
+        r.flags      = APP_CACHE_RECORD_VALID;
+        r.name       = writer_intern (w, entry->name);
+        r.exec       = writer_intern (w, entry->exec);
+        r.icon_name  = writer_intern (w, entry->icon_name);
+        r.categories = writer_intern (w, entry->categories);
+        r.comment    = writer_intern (w, entry->comment);
+        r.generic_name = writer_intern (w, entry->generic_name);
+        r.keywords   = writer_intern (w, entry->keywords);
+        r.sort_key   = writer_intern (w, entry->sort_key);
+        r.startup_wm_class = writer_intern (w, entry->startup_wm_class);
+    }
+
+    g_array_append_val (w->records, r);
+}
+
+gboolean
+app_cache_writer_commit (AppCacheWriter *w)
+{
+    g_return_val_if_fail (w != NULL, FALSE);
+
+    char *locale = locale_key ();
+
+    AppCacheHeader h = { 0 };
+    h.magic          = APP_CACHE_MAGIC;
+    h.version        = APP_CACHE_VERSION;
+    h.n_dirs         = APP_CACHE_MAX_DIRS;
+    h.n_records      = w->records->len;
+    h.records_offset = sizeof (AppCacheHeader);
+    h.locale         = writer_intern (w, locale);
+    h.strtab_offset  = h.records_offset +
+                       w->records->len * (guint32) sizeof (AppCacheRecord);
+    h.strtab_size    = (guint32) w->strtab->len;
+    memcpy (h.dir_mtime, w->dir_mtime, sizeof (h.dir_mtime));
+    g_free (locale);
+
+    GString *buf = g_string_sized_new (h.strtab_offset + h.strtab_size);
+    g_string_append_len (buf, (const char *) &h, sizeof (h));
+    g_string_append_len (buf, w->records->data,
+                         (gssize) (w->records->len * sizeof (AppCacheRecord)));
+    g_string_append_len (buf, w->strtab->str, (gssize) w->strtab->len);
+
+    char *path = cache_file_path ();
+    char *dir  = g_path_get_dirname (path);
+    g_mkdir_with_parents (dir, 0700);
+
+    /* Written to a temp file and renamed; live mappings of the old
+     * file stay valid since they pin the old inode. */
+    GError  *err = NULL;
+    gboolean ok  = g_file_set_contents (path, buf->str, (gssize) buf->len, &err);
+    if (!ok) {
+        g_warning ("AppCache: write %s: %s", path, err->message);
+        g_error_free (err);
+    }
+
+    g_free (dir);
+    g_free (path);
+    g_string_free (buf, TRUE);
+    return ok;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <glib.h>
+#include "app_entry.h"
+
+/**
+ * AppCache - Persistent binary catalog of parsed .desktop files.
+ *
+ * Stored at $XDG_CACHE_HOME/venom/launcher-apps.cache and loaded with
+ * mmap (GMappedFile).  Layout:
+ *
+ *   AppCacheHeader | AppCacheRecord[n_records] | string table
+ *
+ * Every string field of a record is an offset into the string table
+ * (0 = NULL).  Records also exist for files that are not launchable
+ * (Type != Application, NoDisplay, ...) so those are not re-parsed either.
+ * Sort keys are stored too; the cache is per-locale, so they stay valid.
+ *
+ * AppEntry objects built from the cache borrow their strings from the
+ * mapping and hold a reference on it (see AppEntry.backing).
+ */
+
+#define APP_CACHE_MAGIC     0x54414356u   /* "VCAT" */
+#define APP_CACHE_VERSION   5
+#define APP_CACHE_MAX_DIRS  4
+
+#define APP_CACHE_RECORD_VALID  (1u << 0) /* record describes a shown app */
+
+typedef struct {
+    guint32  magic;
+    guint32  version;
+    guint32  n_records;
+    guint32  records_offset;
+    guint32  strtab_offset;
+    guint32  strtab_size;
+    guint32  locale;                        /* strtab offset */
+    guint32  n_dirs;
+    gint64   dir_mtime[APP_CACHE_MAX_DIRS];
+} AppCacheHeader;
+
+typedef struct {
+    gint64   mtime;
+    gint64   size;
+    guint32  dir_index;
+    guint32  flags;
+    guint32  path;                          /* strtab offsets */
+    guint32  name;
+    guint32  exec;
+    guint32  icon_name;
+    guint32  categories;
+    guint32  comment;
+    guint32  generic_name;
+    guint32  keywords;
+    guint32  sort_key;                      /* g_utf8_collate_key (name) */
+    guint32  startup_wm_class;
+} AppCacheRecord;
+
+typedef struct _AppCache       AppCache;
+typedef struct _AppCacheWriter AppCacheWriter;
+
+/* ── Reader ─────────────────────────────────────────────────────────────── */
+
+/**
+ * Maps and validates the on-disk cache.
+ * Returns NULL if missing, corrupt, or written for a different locale.
+ */
+AppCache             *app_cache_open          (void);
+void                  app_cache_free          (AppCache *cache);
+
+gboolean              app_cache_dir_unchanged (AppCache   *cache,
+                                               guint       dir_index,
+                                               gint64      mtime);
+guint                 app_cache_get_n_records (AppCache   *cache);
+const AppCacheRecord *app_cache_get_record    (AppCache   *cache,
+                                               guint       index);
+const AppCacheRecord *app_cache_lookup        (AppCache   *cache,
+                                               const char *path);
+const char           *app_cache_get_string    (AppCache   *cache,
+                                               guint32     offset);
+
+/* Builds an AppEntry whose strings point into the mapping. */
+AppEntry             *app_cache_make_entry    (AppCache             *cache,
+                                               const AppCacheRecord *rec);
+
+/* ── Writer ─────────────────────────────────────────────────────────────── */
+
+AppCacheWriter       *app_cache_writer_new            (void);
+void                  app_cache_writer_free           (AppCacheWriter *w);
+void                  app_cache_writer_set_dir_mtime  (AppCacheWriter *w,
+                                                       guint           dir_index,
+                                                       gint64          mtime);
+
+/* @entry may be NULL for files that did not produce a launchable app. */
+void                  app_cache_writer_add            (AppCacheWriter *w,
+                                                       guint           dir_index,
+                                                       const char     *path,
+                                                       gint64          mtime,
+                                                       gint64          size,
+                                                       const AppEntry *entry);
+
+/* Atomically replaces the on-disk cache. Returns FALSE on I/O error. */
+gboolean              app_cache_writer_commit         (AppCacheWriter *w);
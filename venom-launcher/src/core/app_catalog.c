@@ -0,0 +1,154 @@
+#include "app_catalog.h"
+
+#include <string.h>
+
+/* -------------------------------------------------------------------------
+ * Structs
+ * ------------------------------------------------------------------------- */
+
+struct _AppCatalog {
+    gint         refs;       /* one per packed entry */
+    char        *arena;      /* strings of parsed entries, NUL-terminated; offset 0 = NULL */
+    GMappedFile *backing[2]; /* cache mappings cached entries point into, or NULL */
+    AppEntry     entries[];  /* allocated together with the header */
+};
+
+/* String fields of AppEntry, copied into the arena unless mapped */
+static const gsize string_fields[] = {
+    G_STRUCT_OFFSET (AppEntry, name),
+    G_STRUCT_OFFSET (AppEntry, exec),
+    G_STRUCT_OFFSET (AppEntry, icon_name),
+    G_STRUCT_OFFSET (AppEntry, categories),
+    G_STRUCT_OFFSET (AppEntry, comment),
+    G_STRUCT_OFFSET (AppEntry, generic_name),
+    G_STRUCT_OFFSET (AppEntry, keywords),
+    G_STRUCT_OFFSET (AppEntry, desktop_path),
+    G_STRUCT_OFFSET (AppEntry, sort_key),
+    G_STRUCT_OFFSET (AppEntry, startup_wm_class),
+};
+
+#define FIELD(e, off)  (*(char **) ((guint8 *) (e) + (off)))
+
+/* -------------------------------------------------------------------------
+ * Helpers
+ * ------------------------------------------------------------------------- */
+
+static gsize
+arena_intern (GString *arena, GHashTable *interned, const char *s)
+{
+    if (!s) return 0;
+
+    gpointer off;
+    if (g_hash_table_lookup_extended (interned, s, NULL, &off))
+        return GPOINTER_TO_SIZE (off);
+
+    gsize pos = arena->len;
+    g_string_append_len (arena, s, (gssize) strlen (s) + 1);
+    g_hash_table_insert (interned, (gpointer) s, GSIZE_TO_POINTER (pos));
+    return pos;
+}
+
+static int
+compare_entries (gconstpointer a, gconstpointer b)
+{
+    return app_entry_collate (*(const AppEntry **) a, *(const AppEntry **) b);
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+GPtrArray *
+app_catalog_pack (GPtrArray *loose)
+{
+    g_return_val_if_fail (loose != NULL, NULL);
+
+    guint      n   = loose->len;
+    GPtrArray *out = g_ptr_array_new_full (n, (GDestroyNotify) app_entry_free);
+    if (n == 0) {
+        g_ptr_array_unref (loose);
+        return out;
+    }
+
+    /* Entries built without a key (should not happen) get one now */
+    for (guint i = 0; i < n; i++) {
+        AppEntry *e = g_ptr_array_index (loose, i);
+        if (!e->sort_key && e->name && !e->backing)
+            app_entry_update_sort_key (e);
+    }
+    g_ptr_array_sort (loose, compare_entries);
+
+    AppCatalog *catalog = g_malloc0 (sizeof (AppCatalog) + n * sizeof (AppEntry));
+    catalog->refs = (gint) n;
+
+    /* Entries from the app cache keep pointing into its mapping (no copy);
+     * the catalog holds the mapping instead.  Only parsed entries' strings
+     * go to the arena. */
+    gboolean *mapped = g_new0 (gboolean, n);
+    for (guint i = 0; i < n; i++) {
+        const AppEntry *src = g_ptr_array_index (loose, i);
+        if (!src->backing) continue;
+
+        guint b = 0;
+        while (b < G_N_ELEMENTS (catalog->backing) &&
+               catalog->backing[b] && catalog->backing[b] != src->backing)
+            b++;
+        if (b == G_N_ELEMENTS (catalog->backing)) continue;   /* copied */
+        if (!catalog->backing[b])
+            catalog->backing[b] = g_mapped_file_ref (src->backing);
+        mapped[i] = TRUE;
+    }
+
+    /* Pass 1: copy strings, recording arena offsets in the string fields.
+     * Interning borrows the loose strings, which outlive the table. */
+    GString    *arena    = g_string_sized_new (n * 64);
+    GHashTable *interned = g_hash_table_new (g_str_hash, g_str_equal);
+    g_string_append_c (arena, '\0');
+
+    for (guint i = 0; i < n; i++) {
+        const AppEntry *src = g_ptr_array_index (loose, i);
+        AppEntry       *dst = &catalog->entries[i];
+
+        dst->no_display = src->no_display;
+        dst->catalog    = catalog;
+        if (mapped[i]) {
+            for (guint f = 0; f < G_N_ELEMENTS (string_fields); f++)
+                FIELD (dst, string_fields[f]) = FIELD (src, string_fields[f]);
+            continue;
+        }
+        for (guint f = 0; f < G_N_ELEMENTS (string_fields); f++) {
+            gsize off = arena_intern (arena, interned,
+                                      FIELD (src, string_fields[f]));
+            FIELD (dst, string_fields[f]) = GSIZE_TO_POINTER (off);
+        }
+    }
+
+    g_hash_table_destroy (interned);
+    catalog->arena = g_string_free (arena, FALSE);
+
+    /* Pass 2: the arena no longer moves — turn offsets into pointers */
+    for (guint i = 0; i < n; i++) {
+        AppEntry *e = &catalog->entries[i];
+        for (guint f = 0; f < G_N_ELEMENTS (string_fields) && !mapped[i]; f++) {
+            gsize off = GPOINTER_TO_SIZE (FIELD (e, string_fields[f]));
+            FIELD (e, string_fields[f]) = off ? catalog->arena + off : NULL;
+        }
+        g_ptr_array_add (out, e);
+    }
+
+    g_free (mapped);
+    g_ptr_array_unref (loose);
+    return out;
+}
+
+void
+app_catalog_release (AppCatalog *catalog)
+{
+    g_return_if_fail (catalog != NULL);
+
+    if (!g_atomic_int_dec_and_test (&catalog->refs)) return;
+    for (guint b = 0; b < G_N_ELEMENTS (catalog->backing); b++)
+        if (catalog->backing[b]) g_mapped_file_unref (catalog->backing[b]);
+    g_free (catalog->arena);
+    g_free (catalog);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glib.h>
+#include "app_entry.h"
+
+/**
+ * AppCatalog - Packed storage for a loaded app list.
+ *
+ * All entries of a catalog live in one contiguous AppEntry block.
+ * Entries that came from the app cache keep borrowing their strings
+ * from its mapping, which the catalog holds on to, so an unchanged
+ * start copies no strings at all; the strings of freshly parsed entries
+ * (sort keys included) go to one arena, with repeated values such as
+ * Categories stored once.  Building a catalog is a few allocations plus
+ * the returned array, whatever the number of apps.
+ *
+ * Packed entries are still ordinary AppEntry pointers: app_entry_free()
+ * on one just drops its reference, and the last one releases both blocks.
+ * Entries added later (live updates) stay individually allocated.
+ */
+
+/*
+ * Packs @loose into a new catalog, sorted by app_entry_collate().
+ * @loose is consumed; its free_func must be app_entry_free.
+ * Returns a GPtrArray of the packed entries (free_func app_entry_free).
+ */
+GPtrArray *app_catalog_pack    (GPtrArray  *loose);
+
+/* Called by app_entry_free() for packed entries */
+void       app_catalog_release (AppCatalog *catalog);
@@ -1,4 +1,5 @@
 #include "app_entry.h"
+#include "app_catalog.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -13,16 +14,64 @@ void
 app_entry_free (AppEntry *entry)
 {
     if (!entry) return;
-    g_free (entry->name);
-    g_free (entry->exec);
-    g_free (entry->icon_name);
-    g_free (entry->categories);
-    g_free (entry->comment);
-    g_free (entry->desktop_path);
     if (entry->pixbuf) g_object_unref (entry->pixbuf);
+
+    /* Packed entries are released with their catalog */
+    if (entry->catalog) {
+        app_catalog_release (entry->catalog);
+        return;
+    }
+
+    if (entry->backing) {
+        g_mapped_file_unref (entry->backing);
+    } else {
+        g_free (entry->name);
+        g_free (entry->exec);
+        g_free (entry->icon_name);
+        g_free (entry->categories);
+        g_free (entry->comment);
+        g_free (entry->generic_name);
+        g_free (entry->keywords);
+        g_free (entry->desktop_path);
+        g_free (entry->sort_key);
+        g_free (entry->startup_wm_class);
+    }
     g_free (entry);
 }
 
+const char *
+app_entry_get_id (const AppEntry *entry)
+{
+    if (!entry || !entry->desktop_path) return NULL;
+    const char *slash = strrchr (entry->desktop_path, '/');
+    return slash ? slash + 1 : entry->desktop_path;
+}
+
+void
+app_entry_update_sort_key (AppEntry *entry)
+{
+    g_return_if_fail (entry != NULL);
+    g_return_if_fail (!entry->backing && !entry->catalog);
+
+    g_free (entry->sort_key);
+    entry->sort_key = entry->name ? g_utf8_collate_key (entry->name, -1) : NULL;
+}
+
+int
+app_entry_collate (const AppEntry *a, const AppEntry *b)
+{
+    /* Entries without a name sort last */
+    if (a->sort_key && b->sort_key) {
+        int r = strcmp (a->sort_key, b->sort_key);
+        if (r != 0) return r;
+    } else if (a->sort_key || b->sort_key) {
+        return a->sort_key ? -1 : 1;
+    }
+
+    /* Tie-break on path so the order does not depend on scan order */
+    return g_strcmp0 (a->desktop_path, b->desktop_path);
+}
+
 /**
  * Strip field codes like %f %u %F %U %d %D %n %N %i %c %k from exec string.
  * Returns newly allocated string — caller must g_free().
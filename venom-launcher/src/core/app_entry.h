@@ -1,8 +1,10 @@
 #pragma once
 
-#include <gtk/gtk.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
 #include <stdbool.h>
 
+typedef struct _AppCatalog AppCatalog;
+
 /**
  * AppEntry - Data model for a single application.
  * Pure data struct — no GTK rendering logic.
@@ -13,13 +15,32 @@ typedef struct {
     char       *icon_name;   /* Icon name or absolute path */
     char       *categories;  /* Desktop categories string */
     char       *comment;     /* Short description */
+    char       *generic_name;/* GenericName, e.g. "Web Browser" */
+    char       *keywords;    /* Keywords string (semicolon-separated) */
     char       *desktop_path;/* Absolute path to the original .desktop file */
+    char       *sort_key;    /* g_utf8_collate_key (name), compared with strcmp */
+    char       *startup_wm_class; /* StartupWMClass, for matching windows */
     bool        no_display;  /* Hidden from launcher */
+    guint32     index_id;    /* Slot in the SearchIndex (set on add) */
     GdkPixbuf  *pixbuf;      /* Loaded icon (NULL until loaded) */
+    GMappedFile *backing;    /* Non-NULL: strings point into this app cache
+                              * mapping and are not owned by the entry */
+    AppCatalog *catalog;     /* Non-NULL: the entry and its strings live in
+                              * this catalog's blocks (see app_catalog.h) */
 } AppEntry;
 
 AppEntry *app_entry_new  (void);
 void      app_entry_free (AppEntry *entry);
 
+/* Desktop file id (basename of desktop_path), e.g. "firefox.desktop" */
+const char *app_entry_get_id (const AppEntry *entry);
+
+/* Sets sort_key from name (owned entries only) */
+void      app_entry_update_sort_key (AppEntry *entry);
+
+/* Launcher sort order: collated name, then path as a tie-break.
+ * Compares the precomputed sort keys — no collation per call. */
+int       app_entry_collate (const AppEntry *a, const AppEntry *b);
+
 /* Utility: strip %f, %u, %F, %U, etc. from Exec field */
 char     *app_entry_clean_exec (const char *exec_raw);
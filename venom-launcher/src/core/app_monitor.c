@@ -0,0 +1,144 @@
+#include "app_monitor.h"
+#include "desktop_reader.h"
+
+#include <gio/gio.h>
+
+/* Quiet period before a batch is delivered */
+#define APP_MONITOR_SETTLE_MS  250
+
+struct _AppMonitor {
+    GPtrArray          *monitors;  /* GFileMonitor* */
+    GHashTable         *pending;   /* desktop id (owned) -> NULL */
+    guint               settle_id;
+    AppMonitorCallback  callback;
+    gpointer            user_data;
+};
+
+/* -------------------------------------------------------------------------
+ * Helpers
+ * ------------------------------------------------------------------------- */
+
+static gboolean
+settle_fire (gpointer data)
+{
+    AppMonitor *m = data;
+    m->settle_id = 0;
+
+    GPtrArray *ids = g_ptr_array_new_with_free_func (g_free);
+
+    GHashTableIter iter;
+    gpointer       key;
+    g_hash_table_iter_init (&iter, m->pending);
+    while (g_hash_table_iter_next (&iter, &key, NULL)) {
+        g_ptr_array_add (ids, key);
+        g_hash_table_iter_steal (&iter);
+    }
+
+    if (ids->len > 0)
+        m->callback (ids, m->user_data);
+
+    g_ptr_array_unref (ids);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+queue_file (AppMonitor *m, GFile *file)
+{
+    if (!file) return;
+
+    char *id = g_file_get_basename (file);
+    if (!id || !g_str_has_suffix (id, ".desktop")) {
+        g_free (id);
+        return;
+    }
+
+    g_hash_table_add (m->pending, id);
+
+    /* Restart the quiet period */
+    if (m->settle_id) g_source_remove (m->settle_id);
+    m->settle_id = g_timeout_add (APP_MONITOR_SETTLE_MS, settle_fire, m);
+}
+
+static void
+on_dir_changed (GFileMonitor     *monitor,
+                GFile            *file,
+                GFile            *other_file,
+                GFileMonitorEvent event,
+                gpointer          data)
+{
+    (void) monitor;
+    AppMonitor *m = data;
+
+    switch (event) {
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+    case G_FILE_MONITOR_EVENT_MOVED_IN:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT:
+        queue_file (m, file);
+        break;
+    case G_FILE_MONITOR_EVENT_RENAMED:
+        queue_file (m, file);
+        queue_file (m, other_file);
+        break;
+    default:
+        /* CHANGED is followed by CHANGES_DONE_HINT — wait for that */
+        break;
+    }
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+AppMonitor *
+app_monitor_new (AppMonitorCallback callback, gpointer user_data)
+{
+    g_return_val_if_fail (callback != NULL, NULL);
+
+    AppMonitor *m = g_new0 (AppMonitor, 1);
+    m->monitors  = g_ptr_array_new_with_free_func (g_object_unref);
+    m->pending   = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    m->callback  = callback;
+    m->user_data = user_data;
+
+    const char * const *dirs = desktop_reader_get_dirs ();
+    for (guint i = 0; dirs[i]; i++) {
+        GFile  *dir = g_file_new_for_path (dirs[i]);
+        GError *err = NULL;
+
+        /* Missing directories are watched too (created later by installers) */
+        GFileMonitor *mon = g_file_monitor_directory (
+            dir, G_FILE_MONITOR_WATCH_MOVES, NULL, &err);
+        g_object_unref (dir);
+
+        if (!mon) {
+            g_warning ("AppMonitor: %s: %s", dirs[i], err->message);
+            g_error_free (err);
+            continue;
+        }
+
+        g_signal_connect (mon, "changed", G_CALLBACK (on_dir_changed), m);
+        g_ptr_array_add (m->monitors, mon);
+    }
+
+    return m;
+}
+
+void
+app_monitor_free (AppMonitor *monitor)
+{
+    if (!monitor) return;
+
+    for (guint i = 0; i < monitor->monitors->len; i++) {
+        GFileMonitor *mon = g_ptr_array_index (monitor->monitors, i);
+        g_signal_handlers_disconnect_by_data (mon, monitor);
+        g_file_monitor_cancel (mon);
+    }
+
+    if (monitor->settle_id) g_source_remove (monitor->settle_id);
+    g_ptr_array_unref (monitor->monitors);
+    g_hash_table_destroy (monitor->pending);
+    g_free (monitor);
+}
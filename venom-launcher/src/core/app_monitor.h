@@ -0,0 +1,21 @@
+#pragma once
+
+#include <glib.h>
+
+/**
+ * AppMonitor - Watches the application directories for .desktop changes.
+ *
+ * One GFileMonitor per directory from desktop_reader_get_dirs().
+ * Events are coalesced per desktop id and delivered in one batch after
+ * a short quiet period, so a package upgrade touching many files results
+ * in a single callback with each id listed once.
+ */
+typedef struct _AppMonitor AppMonitor;
+
+/* @desktop_ids: array of const char* (e.g. "firefox.desktop"), valid
+ * for the duration of the callback only. */
+typedef void (*AppMonitorCallback) (GPtrArray *desktop_ids, gpointer user_data);
+
+AppMonitor *app_monitor_new  (AppMonitorCallback callback,
+                              gpointer           user_data);
+void        app_monitor_free (AppMonitor        *monitor);
@@ -0,0 +1,297 @@
+#include "desktop_parser.h"
+
+#include <string.h>
+
+/* Language variants considered per key; g_get_language_names() is short */
+#define MAX_LANGS  15
+#define UNTRANSLATED  MAX_LANGS
+
+/* -------------------------------------------------------------------------
+ * Keys
+ * ------------------------------------------------------------------------- */
+
+typedef enum {
+    KEY_TYPE,
+    KEY_NO_DISPLAY,
+    KEY_HIDDEN,
+    KEY_NAME,
+    KEY_EXEC,
+    KEY_ICON,
+    KEY_COMMENT,
+    KEY_GENERIC_NAME,
+    KEY_KEYWORDS,
+    KEY_CATEGORIES,
+    KEY_STARTUP_WM_CLASS,
+    N_KEYS
+} KeyId;
+
+static const struct {
+    const char *name;
+    gsize       len;
+    gboolean    localized;
+} keys[N_KEYS] = {
+    [KEY_TYPE]         = { "Type",        4,  FALSE },
+    [KEY_NO_DISPLAY]   = { "NoDisplay",   9,  FALSE },
+    [KEY_HIDDEN]       = { "Hidden",      6,  FALSE },
+    [KEY_NAME]         = { "Name",        4,  TRUE  },
+    [KEY_EXEC]         = { "Exec",        4,  FALSE },
+    [KEY_ICON]         = { "Icon",        4,  FALSE },
+    [KEY_COMMENT]      = { "Comment",     7,  TRUE  },
+    [KEY_GENERIC_NAME] = { "GenericName", 11, TRUE  },
+    [KEY_KEYWORDS]     = { "Keywords",    8,  TRUE  },
+    [KEY_CATEGORIES]   = { "Categories",  10, FALSE },
+    [KEY_STARTUP_WM_CLASS] = { "StartupWMClass", 14, FALSE },
+};
+
+#define DESKTOP_GROUP      "Desktop Entry"
+#define DESKTOP_GROUP_LEN  13
+
+typedef struct {
+    const char *start;    /* raw value in the file, NULL if absent */
+    gsize       len;
+} Span;
+
+/* Raw value per key and rank: [0, n_langs) are translations, best first */
+typedef struct {
+    Span                 values[N_KEYS][MAX_LANGS + 1];
+    const char * const  *langs;
+    guint                n_langs;
+} Scan;
+
+static int
+find_key (const char *key, gsize len)
+{
+    for (int k = 0; k < N_KEYS; k++)
+        if (keys[k].len == len && memcmp (keys[k].name, key, len) == 0)
+            return k;
+    return -1;
+}
+
+static int
+find_lang (const Scan *scan, const char *locale, gsize len)
+{
+    for (guint i = 0; i < scan->n_langs; i++)
+        if (strncmp (scan->langs[i], locale, len) == 0 &&
+            scan->langs[i][len] == '\0')
+            return (int) i;
+    return -1;
+}
+
+/* Records "key[locale]=value" if it is one we read */
+static void
+note_pair (Scan *scan, const char *key, gsize key_len,
+           const char *value, gsize value_len)
+{
+    const char *bracket = memchr (key, '[', key_len);
+    gsize       base    = bracket ? (gsize) (bracket - key) : key_len;
+
+    int k = find_key (key, base);
+    if (k < 0) return;
+
+    int rank = UNTRANSLATED;
+    if (bracket) {
+        /* get_string ("Exec") never sees "Exec[de]" */
+        if (!keys[k].localized || key[key_len - 1] != ']') return;
+        rank = find_lang (scan, bracket + 1, key_len - base - 2);
+        if (rank < 0) return;
+    }
+
+    /* Later duplicates win, as in GKeyFile */
+    scan->values[k][rank].start = value;
+    scan->values[k][rank].len   = value_len;
+}
+
+/* -------------------------------------------------------------------------
+ * Values (GKeyFile semantics)
+ * ------------------------------------------------------------------------- */
+
+/*
+ * g_key_file_parse_value_as_string(): NULL on bad UTF-8; unknown escapes
+ * are kept as written and a trailing backslash is dropped.
+ */
+static char *
+decode_string (const Span *v)
+{
+    if (!g_utf8_validate_len (v->start, v->len, NULL)) return NULL;
+
+    char       *out = g_malloc (v->len + 1);
+    char       *q   = out;
+    const char *p   = v->start;
+    const char *end = v->start + v->len;
+
+    while (p < end) {
+        if (*p != '\\') {
+            *q++ = *p++;
+            continue;
+        }
+
+        if (++p == end) break;
+        switch (*p) {
+        case 's':  *q++ = ' ';  break;
+        case 'n':  *q++ = '\n'; break;
+        case 't':  *q++ = '\t'; break;
+        case 'r':  *q++ = '\r'; break;
+        case '\\': *q++ = '\\'; break;
+        default:   *q++ = '\\'; *q++ = *p; break;
+        }
+        p++;
+    }
+
+    *q = '\0';
+    return out;
+}
+
+/* g_key_file_parse_value_as_boolean(); malformed reads as FALSE */
+static gboolean
+decode_boolean (const Span *v)
+{
+    gsize len = v->len;
+    while (len > 0 && g_ascii_isspace (v->start[len - 1])) len--;
+
+    return (len == 4 && memcmp (v->start, "true", 4) == 0) ||
+           (len == 1 && v->start[0] == '1');
+}
+
+/* Best decodable variant: translations in language order, then the plain key */
+static char *
+pick_string (const Scan *scan, KeyId k)
+{
+    for (guint r = 0; keys[k].localized && r < scan->n_langs; r++) {
+        const Span *v = &scan->values[k][r];
+        if (!v->start) continue;
+
+        char *s = decode_string (v);
+        if (s) return s;
+    }
+
+    const Span *v = &scan->values[k][UNTRANSLATED];
+    return v->start ? decode_string (v) : NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Scanner
+ * ------------------------------------------------------------------------- */
+
+/*
+ * Walks lines up to the end of [Desktop Entry].  Returns FALSE where
+ * g_key_file_load_from_data() would fail: a key before any group, a
+ * line that is neither comment, group nor key=value, an empty key or
+ * an unterminated group header.
+ */
+static gboolean
+scan_entry (Scan *scan, const char *data, gsize len)
+{
+    const char *p        = data;
+    const char *end      = data + len;
+    gboolean    in_group = FALSE;
+    gboolean    in_entry = FALSE;
+
+    while (p < end) {
+        const char *nl   = memchr (p, '\n', (gsize) (end - p));
+        const char *line = p;
+        const char *eol  = nl ? nl : end;
+        p = nl ? nl + 1 : end;
+
+        while (line < eol && g_ascii_isspace (*line)) line++;
+        if (eol > line && eol[-1] == '\r') eol--;
+        if (line == eol || *line == '#') continue;
+
+        if (*line == '[') {
+            /* Parsing stops at the group after ours */
+            if (in_entry) return TRUE;
+
+            const char *close = eol - 1;
+            while (close > line && *close != ']') close--;
+            if (close == line) return FALSE;
+
+            in_group = TRUE;
+            in_entry = close - line - 1 == DESKTOP_GROUP_LEN &&
+                       memcmp (line + 1, DESKTOP_GROUP, DESKTOP_GROUP_LEN) == 0;
+            continue;
+        }
+
+        const char *eq = memchr (line, '=', (gsize) (eol - line));
+        if (!eq || !in_group) return FALSE;
+        if (!in_entry) continue;
+
+        const char *key_end = eq;
+        while (key_end > line && g_ascii_isspace (key_end[-1])) key_end--;
+        if (key_end == line) return FALSE;
+
+        const char *value = eq + 1;
+        while (value < eol && g_ascii_isspace (*value)) value++;
+
+        note_pair (scan, line, (gsize) (key_end - line), value, (gsize) (eol - value));
+    }
+
+    return TRUE;
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+gboolean
+desktop_parser_parse_data (const char *data, gsize len, DesktopFields *out)
+{
+    g_return_val_if_fail (out != NULL, FALSE);
+    memset (out, 0, sizeof *out);
+
+    Scan scan;
+    memset (scan.values, 0, sizeof scan.values);
+    scan.langs   = g_get_language_names ();
+    scan.n_langs = 0;
+    while (scan.n_langs < MAX_LANGS && scan.langs[scan.n_langs])
+        scan.n_langs++;
+
+    /* An empty file loads fine; it just has no keys */
+    if (len > 0 && !scan_entry (&scan, data, len)) return FALSE;
+
+    out->type         = pick_string (&scan, KEY_TYPE);
+    out->name         = pick_string (&scan, KEY_NAME);
+    out->exec         = pick_string (&scan, KEY_EXEC);
+    out->icon         = pick_string (&scan, KEY_ICON);
+    out->comment      = pick_string (&scan, KEY_COMMENT);
+    out->generic_name = pick_string (&scan, KEY_GENERIC_NAME);
+    out->keywords     = pick_string (&scan, KEY_KEYWORDS);
+    out->categories   = pick_string (&scan, KEY_CATEGORIES);
+    out->startup_wm_class = pick_string (&scan, KEY_STARTUP_WM_CLASS);
+
+    const Span *nd = &scan.values[KEY_NO_DISPLAY][UNTRANSLATED];
+    out->no_display = nd->start && decode_boolean (nd);
+    const Span *hd = &scan.values[KEY_HIDDEN][UNTRANSLATED];
+    out->hidden     = hd->start && decode_boolean (hd);
+    return TRUE;
+}
+
+gboolean
+desktop_parser_parse_file (const char *path, DesktopFields *out)
+{
+    g_return_val_if_fail (path != NULL && out != NULL, FALSE);
+    memset (out, 0, sizeof *out);
+
+    GMappedFile *mapped = g_mapped_file_new (path, FALSE, NULL);
+    if (!mapped) return FALSE;
+
+    gboolean ok = desktop_parser_parse_data (g_mapped_file_get_contents (mapped),
+                                             g_mapped_file_get_length (mapped),
+                                             out);
+    g_mapped_file_unref (mapped);
+    return ok;
+}
+
+void
+desktop_fields_clear (DesktopFields *fields)
+{
+    if (!fields) return;
+    g_free (fields->type);
+    g_free (fields->name);
+    g_free (fields->exec);
+    g_free (fields->icon);
+    g_free (fields->comment);
+    g_free (fields->generic_name);
+    g_free (fields->keywords);
+    g_free (fields->categories);
+    g_free (fields->startup_wm_class);
+    memset (fields, 0, sizeof *fields);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glib.h>
+
+/**
+ * DesktopParser - Streaming reader for the [Desktop Entry] group.
+ *
+ * Replaces a GKeyFile load for the handful of keys the launcher needs:
+ * the file is mapped, lines are found with memchr (SIMD in glibc), and
+ * only [Desktop Entry] is scanned — parsing stops at the next group.
+ * Localized keys keep the best variant for g_get_language_names() as
+ * they go, so Name/Comment/... cost one pass however many translations
+ * the file carries.
+ *
+ * Values match what g_key_file_get_string(), _get_locale_string() and
+ * _get_boolean() would return: escapes are decoded, non-UTF-8 or badly
+ * escaped values read as missing, and a file GKeyFile would refuse to
+ * load (up to the end of [Desktop Entry]) is rejected.  Lines after
+ * that group are not looked at.
+ *
+ * Thread-safe.
+ */
+typedef struct {
+    char     *type;
+    char     *name;          /* localized */
+    char     *exec;
+    char     *icon;
+    char     *comment;       /* localized */
+    char     *generic_name;  /* localized */
+    char     *keywords;      /* localized, raw (semicolon-separated) */
+    char     *categories;
+    char     *startup_wm_class;
+    gboolean  no_display;
+    gboolean  hidden;        /* Hidden=true: treat as deleted */
+} DesktopFields;
+
+/* Fills @out (all NULL/FALSE first). Returns FALSE if unreadable or malformed. */
+gboolean desktop_parser_parse_file (const char    *path,
+                                    DesktopFields *out);
+gboolean desktop_parser_parse_data (const char    *data,
+                                    gsize          len,
+                                    DesktopFields *out);
+
+void     desktop_fields_clear      (DesktopFields *fields);
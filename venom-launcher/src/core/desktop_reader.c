@@ -1,5 +1,8 @@
 #include "desktop_reader.h"
 #include "app_entry.h"
+#include "app_cache.h"
+#include "app_catalog.h"
+#include "desktop_parser.h"
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -10,99 +13,262 @@
  * Helpers
  * -------------------------------------------------------------------------- */
 
-static void
-parse_desktop_file (const char *path, GPtrArray *out)
+/* Returns a new AppEntry, or NULL if @path is not a launchable app */
+static AppEntry *
+parse_desktop_file (const char *path)
 {
-    GKeyFile *kf = g_key_file_new ();
-    GError   *err = NULL;
-
-    if (!g_key_file_load_from_file (kf, path, G_KEY_FILE_NONE, &err)) {
-        g_error_free (err);
-        g_key_file_free (kf);
-        return;
-    }
+    DesktopFields f;
+    if (!desktop_parser_parse_file (path, &f)) return NULL;
 
-    /* Must be Type=Application */
-    char *type = g_key_file_get_string (kf, "Desktop Entry", "Type", NULL);
-    if (!type || g_strcmp0 (type, "Application") != 0) {
-        g_free (type);
-        g_key_file_free (kf);
-        return;
+    /* Must be Type=Application, shown, and have a name and command */
+    if (g_strcmp0 (f.type, "Application") != 0 || f.no_display || f.hidden ||
+        !f.name || !f.exec) {
+        desktop_fields_clear (&f);
+        return NULL;
     }
-    g_free (type);
 
     AppEntry *e = app_entry_new ();
 
-    e->no_display = g_key_file_get_boolean (kf, "Desktop Entry",
-                                            "NoDisplay", NULL);
-    if (e->no_display) {
-        app_entry_free (e);
-        g_key_file_free (kf);
-        return;
-    }
+    e->name         = g_steal_pointer (&f.name);
+    e->exec         = app_entry_clean_exec (f.exec);
+    e->icon_name    = g_steal_pointer (&f.icon);
+    e->comment      = g_steal_pointer (&f.comment);
+    e->generic_name = g_steal_pointer (&f.generic_name);   /* search only */
+    e->keywords     = g_steal_pointer (&f.keywords);       /* search only */
+    e->categories   = g_steal_pointer (&f.categories);
+    e->startup_wm_class = g_steal_pointer (&f.startup_wm_class);  /* window matching */
 
-    /* Name: prefer localized */
-    e->name = g_key_file_get_locale_string (kf, "Desktop Entry",
-                                            "Name", NULL, NULL);
-    if (!e->name)
-        e->name = g_key_file_get_string (kf, "Desktop Entry", "Name", NULL);
+    /* Store the absolute path for shortcuts/uninstall */
+    e->desktop_path = g_strdup (path);
+    app_entry_update_sort_key (e);
+
+    desktop_fields_clear (&f);
+    return e;
+}
 
-    /* Exec */
-    char *exec_raw = g_key_file_get_string (kf, "Desktop Entry", "Exec", NULL);
-    e->exec = app_entry_clean_exec (exec_raw);
-    g_free (exec_raw);
+/*
+ * An mtime from the current second can still change without the value
+ * changing; such entries are recorded as -1 so the next start re-checks.
+ */
+static gint64
+stable_mtime (gint64 mtime)
+{
+    gint64 now = g_get_real_time () / G_USEC_PER_SEC;
+    return (mtime >= now - 1) ? -1 : mtime;
+}
 
-    /* Icon */
-    e->icon_name = g_key_file_get_string (kf, "Desktop Entry", "Icon", NULL);
+/*
+ * One .desktop file found during enumeration.  @cached is set when the
+ * cache record is still current; otherwise @entry is filled by parsing.
+ */
+typedef struct {
+    char                 *path;
+    guint                 dir_index;
+    gint64                mtime;
+    gint64                size;
+    const AppCacheRecord *cached;
+    AppEntry             *entry;
+} ScanItem;
 
-    /* Comment */
-    e->comment = g_key_file_get_locale_string (kf, "Desktop Entry",
-                                               "Comment", NULL, NULL);
+/* Below this many files to parse, thread start-up costs more than it saves */
+#define PARALLEL_MIN_ITEMS  16
 
-    /* Categories */
-    e->categories = g_key_file_get_string (kf, "Desktop Entry",
-                                           "Categories", NULL);
+static void
+scan_item_clear (gpointer data)
+{
+    ScanItem *item = data;
+    g_free (item->path);
+}
 
-    /* Store the absolute path for shortcuts/uninstall */
-    e->desktop_path = g_strdup (path);
+/*
+ * Stat one file and queue it.  Returns TRUE if it must be (re-)parsed.
+ */
+static gboolean
+enqueue_file (const char *path,
+              guint       dir_index,
+              AppCache   *cache,
+              GArray     *items)
+{
+    GStatBuf st;
+    if (g_stat (path, &st) != 0) return TRUE;
 
-    if (e->name && e->exec) {
-        g_ptr_array_add (out, e);
-    } else {
-        app_entry_free (e);
-    }
+    ScanItem item  = { 0 };
+    item.path      = g_strdup (path);
+    item.dir_index = dir_index;
+    item.mtime     = (gint64) st.st_mtime;
+    item.size      = (gint64) st.st_size;
 
-    g_key_file_free (kf);
+    const AppCacheRecord *rec = app_cache_lookup (cache, path);
+    if (rec && rec->mtime == item.mtime && rec->size == item.size &&
+        rec->dir_index == dir_index)
+        item.cached = rec;
+
+    g_array_append_val (items, item);
+    return item.cached == NULL;
 }
 
-static void
-scan_directory (const char *dir_path, GPtrArray *out)
+/*
+ * Enumerate one application directory.  If its mtime matches the cache,
+ * no file was added, removed or renamed, so only the cached files are
+ * re-stat'ed; otherwise the directory is listed again.
+ * Returns TRUE if the cache needs to be rewritten.
+ */
+static gboolean
+scan_directory (const char     *dir_path,
+                guint           dir_index,
+                AppCache       *cache,
+                AppCacheWriter *writer,
+                GArray         *items)
 {
+    GStatBuf st;
+    gint64   dir_mtime = (g_stat (dir_path, &st) == 0) ? (gint64) st.st_mtime : 0;
+    gboolean dirty     = FALSE;
+
+    app_cache_writer_set_dir_mtime (writer, dir_index, stable_mtime (dir_mtime));
+
+    if (app_cache_dir_unchanged (cache, dir_index, dir_mtime)) {
+        guint n = app_cache_get_n_records (cache);
+        for (guint i = 0; i < n; i++) {
+            const AppCacheRecord *rec = app_cache_get_record (cache, i);
+            if (rec->dir_index != dir_index) continue;
+
+            const char *path = app_cache_get_string (cache, rec->path);
+            dirty |= enqueue_file (path, dir_index, cache, items);
+        }
+        return dirty;
+    }
+
     GDir *dir = g_dir_open (dir_path, 0, NULL);
-    if (!dir) return;
+    if (!dir) return TRUE;
 
     const char *filename;
     while ((filename = g_dir_read_name (dir))) {
         if (!g_str_has_suffix (filename, ".desktop")) continue;
 
         char *full_path = g_build_filename (dir_path, filename, NULL);
-        parse_desktop_file (full_path, out);
+        enqueue_file (full_path, dir_index, cache, items);
         g_free (full_path);
     }
 
     g_dir_close (dir);
+    return TRUE;
+}
+
+/* Thread pool worker — each item is owned by exactly one task */
+static void
+parse_item_func (gpointer task_data, gpointer user_data)
+{
+    (void) user_data;
+    ScanItem *item = task_data;
+    item->entry = parse_desktop_file (item->path);
+}
+
+/*
+ * Parse every item that has no current cache record.  In parallel mode
+ * the work is spread over a pool sized to the core count; results land
+ * in their own ScanItem slot, so completion order does not matter.
+ */
+static void
+parse_items (GArray *items, gboolean parallel)
+{
+    guint n_todo = 0;
+    for (guint i = 0; i < items->len; i++)
+        if (!g_array_index (items, ScanItem, i).cached) n_todo++;
+
+    guint        n_threads = MIN (g_get_num_processors (), n_todo);
+    GThreadPool *pool      = NULL;
+
+    if (parallel && n_todo >= PARALLEL_MIN_ITEMS && n_threads > 1) {
+        GError *err = NULL;
+        pool = g_thread_pool_new (parse_item_func, NULL, (gint) n_threads,
+                                  TRUE, &err);
+        if (err) {
+            g_warning ("DesktopReader: thread pool: %s", err->message);
+            g_error_free (err);
+            pool = NULL;
+        }
+    }
+
+    for (guint i = 0; i < items->len; i++) {
+        ScanItem *item = &g_array_index (items, ScanItem, i);
+        if (item->cached) continue;
+
+        if (!pool || !g_thread_pool_push (pool, item, NULL))
+            parse_item_func (item, NULL);
+    }
+
+    /* Waits for all queued tasks */
+    if (pool)
+        g_thread_pool_free (pool, FALSE, TRUE);
 }
 
-static int
-app_entry_compare (gconstpointer a, gconstpointer b)
+/* Desktop id of a scanned file: its name within its application dir */
+static const char *
+item_desktop_id (const ScanItem *item)
+{
+    const char *slash = strrchr (item->path, '/');
+    return slash ? slash + 1 : item->path;
+}
+
+/*
+ * Merge parsed and cached items into @out.  Items are walked from the
+ * highest-priority directory down, so a desktop id already seen (e.g. a
+ * user override in ~/.local/share/applications) shadows later ones —
+ * including an override that is not shown itself (NoDisplay, Hidden),
+ * which is how a user hides a system app.  Every item is still recorded
+ * in the cache, shadowed or not.
+ */
+static void
+merge_items (GArray         *items,
+             AppCache       *cache,
+             AppCacheWriter *writer,
+             GPtrArray      *out)
 {
-    const AppEntry *ea = *(const AppEntry **) a;
-    const AppEntry *eb = *(const AppEntry **) b;
+    GHashTable *seen = g_hash_table_new (g_str_hash, g_str_equal);
 
-    if (!ea->name) return 1;
-    if (!eb->name) return -1;
+    for (guint i = items->len; i-- > 0; ) {
+        ScanItem *item  = &g_array_index (items, ScanItem, i);
+        AppEntry *e     = item->entry;
+        gint64    mtime = item->mtime;
 
-    return g_utf8_collate (ea->name, eb->name);
+        if (item->cached) {
+            if (item->cached->flags & APP_CACHE_RECORD_VALID)
+                e = app_cache_make_entry (cache, item->cached);
+        } else {
+            mtime = stable_mtime (mtime);
+        }
+
+        app_cache_writer_add (writer, item->dir_index, item->path,
+                              mtime, item->size, e);
+
+        /* item->path outlives @seen */
+        const char *id     = item_desktop_id (item);
+        gboolean    shadow = g_hash_table_contains (seen, id);
+        g_hash_table_add (seen, (gpointer) id);
+
+        if (!e) continue;
+        if (shadow) {
+            app_entry_free (e);
+            continue;
+        }
+        g_ptr_array_add (out, e);
+    }
+
+    g_hash_table_destroy (seen);
+}
+
+/* Lowest priority first: system directories, then the user directory */
+static gpointer
+init_dirs (gpointer arg)
+{
+    (void) arg;
+    G_STATIC_ASSERT (3 <= APP_CACHE_MAX_DIRS);
+    char **dirs = g_new0 (char *, 4);
+    dirs[0] = g_strdup ("/usr/share/applications");
+    dirs[1] = g_strdup ("/usr/local/share/applications");
+    dirs[2] = g_build_filename (g_get_home_dir (),
+                                ".local", "share", "applications", NULL);
+    return dirs;
 }
 
 /* --------------------------------------------------------------------------
@@ -111,24 +277,66 @@ app_entry_compare (gconstpointer a, gconstpointer b)
 
 GPtrArray *
 desktop_reader_load_apps (void)
+{
+    return desktop_reader_load_apps_full (DESKTOP_READER_PARALLEL);
+}
+
+const char * const *
+desktop_reader_get_dirs (void)
+{
+    static GOnce once = G_ONCE_INIT;
+    g_once (&once, init_dirs, NULL);
+    return (const char * const *) once.retval;
+}
+
+AppEntry *
+desktop_reader_resolve_id (const char *desktop_id)
+{
+    g_return_val_if_fail (desktop_id != NULL, NULL);
+
+    const char * const *dirs = desktop_reader_get_dirs ();
+    guint n = g_strv_length ((char **) dirs);
+
+    /* Highest priority first — same rule as merge_items(): the first
+     * file found decides, even if it is not shown */
+    for (guint i = n; i-- > 0; ) {
+        char *path = g_build_filename (dirs[i], desktop_id, NULL);
+        gboolean found = g_file_test (path, G_FILE_TEST_IS_REGULAR);
+        AppEntry *e = found ? parse_desktop_file (path) : NULL;
+        g_free (path);
+        if (found) return e;
+    }
+    return NULL;
+}
+
+GPtrArray *
+desktop_reader_load_apps_full (DesktopReaderFlags flags)
 {
     GPtrArray *apps = g_ptr_array_new_with_free_func (
         (GDestroyNotify) app_entry_free);
 
-    /* System directories */
-    scan_directory ("/usr/share/applications",       apps);
-    scan_directory ("/usr/local/share/applications", apps);
+    const char * const *dirs = desktop_reader_get_dirs ();
+
+    AppCache       *cache  = app_cache_open ();
+    AppCacheWriter *writer = app_cache_writer_new ();
+    gboolean        dirty  = (cache == NULL);
+
+    GArray *items = g_array_sized_new (FALSE, TRUE, sizeof (ScanItem), 512);
+    g_array_set_clear_func (items, scan_item_clear);
+
+    for (guint i = 0; dirs[i]; i++)
+        dirty |= scan_directory (dirs[i], i, cache, writer, items);
+
+    parse_items (items, (flags & DESKTOP_READER_PARALLEL) != 0);
+    merge_items (items, cache, writer, apps);
 
-    /* User directory */
-    const char *home = g_get_home_dir ();
-    char *user_dir = g_build_filename (home,
-                                       ".local", "share", "applications",
-                                       NULL);
-    scan_directory (user_dir, apps);
-    g_free (user_dir);
+    if (dirty)
+        app_cache_writer_commit (writer);
 
-    /* Sort alphabetically */
-    g_ptr_array_sort (apps, app_entry_compare);
+    g_array_unref (items);
+    app_cache_writer_free (writer);
+    app_cache_free (cache);
 
-    return apps;
+    /* Sorted alphabetically, in one block + one string arena */
+    return app_catalog_pack (apps);
 }
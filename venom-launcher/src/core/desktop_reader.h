@@ -10,7 +10,37 @@
  *   2. /usr/local/share/applications
  *   3. ~/.local/share/applications
  *
+ * Results are persisted in the AppCache (see app_cache.h); on later
+ * calls only files whose mtime/size changed are parsed again, and
+ * unchanged entries borrow their strings from the cache mapping.
+ *
  * Returns a GPtrArray* of AppEntry* (caller owns — free with
- * g_ptr_array_unref after setting free_func to app_entry_free).
+ * g_ptr_array_unref; the free_func is already set to app_entry_free).
  */
 GPtrArray *desktop_reader_load_apps (void);
+
+typedef enum {
+    DESKTOP_READER_NONE     = 0,
+    DESKTOP_READER_PARALLEL = 1 << 0,  /* parse on a pool sized to the core count */
+} DesktopReaderFlags;
+
+/**
+ * Like desktop_reader_load_apps() (which uses DESKTOP_READER_PARALLEL).
+ * When the same desktop id exists in several directories, the user
+ * directory wins over /usr/local, which wins over /usr/share.
+ * The result is identical in serial and parallel mode.
+ */
+GPtrArray *desktop_reader_load_apps_full (DesktopReaderFlags flags);
+
+/**
+ * NULL-terminated list of the scanned directories, lowest priority first.
+ * Owned by the reader — do not free.
+ */
+const char * const *desktop_reader_get_dirs (void);
+
+/**
+ * Parses the winning .desktop file for @desktop_id (e.g. "firefox.desktop")
+ * across all directories, using the same priority rule as the full scan.
+ * Returns a new AppEntry, or NULL if no launchable entry exists.
+ */
+AppEntry  *desktop_reader_resolve_id (const char *desktop_id);
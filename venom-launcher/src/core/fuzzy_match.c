@@ -0,0 +1,411 @@
+#include "fuzzy_match.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FUZZY_HAVE_AVX2 1
+#endif
+
+G_STATIC_ASSERT (sizeof (FuzzySlot) % 8 == 0);
+G_STATIC_ASSERT (FUZZY_SLOT_LEN == 64);
+
+/* Scoring weights (fzf-like) */
+#define SCORE_MATCH         16
+#define SCORE_GAP_START     (-3)
+#define SCORE_GAP_EXTEND    (-1)
+#define BONUS_BOUNDARY       8
+#define BONUS_CONSECUTIVE    4
+#define BONUS_FIRST_MULT     2    /* boundary bonus multiplier, first char */
+#define BONUS_PREFIX        12    /* first char matches name start */
+
+typedef struct {
+    guint8   chars[FUZZY_MAX_TERM];
+    guint    len;
+    guint    first;     /* offset of chars[0] in the per-slot mask array */
+} FuzzyTerm;
+
+struct _FuzzyQuery {
+    FuzzyTerm terms[FUZZY_MAX_TERMS];
+    guint     n_terms;
+    guint     n_chars;
+    guint8    chars[FUZZY_MAX_TERMS * FUZZY_MAX_TERM];  /* all terms */
+    guint64   bloom;
+};
+
+/* -------------------------------------------------------------------------
+ * Occurrence masks — bit i set where slot->text[i] == c
+ * ------------------------------------------------------------------------- */
+
+typedef void (*MaskFunc) (const FuzzyQuery *q, const FuzzySlot *slot,
+                          guint64 *masks);
+
+static void
+masks_scalar (const FuzzyQuery *q, const FuzzySlot *slot, guint64 *masks)
+{
+    for (guint c = 0; c < q->n_chars; c++) {
+        guint64 m = 0;
+        for (guint i = 0; i < slot->len; i++)
+            if (slot->text[i] == q->chars[c])
+                m |= (guint64) 1 << i;
+        masks[c] = m;
+    }
+}
+
+#if defined(__SSE2__)
+static void
+masks_sse2 (const FuzzyQuery *q, const FuzzySlot *slot, guint64 *masks)
+{
+    const __m128i t0 = _mm_loadu_si128 ((const __m128i *) (slot->text +  0));
+    const __m128i t1 = _mm_loadu_si128 ((const __m128i *) (slot->text + 16));
+    const __m128i t2 = _mm_loadu_si128 ((const __m128i *) (slot->text + 32));
+    const __m128i t3 = _mm_loadu_si128 ((const __m128i *) (slot->text + 48));
+
+    for (guint c = 0; c < q->n_chars; c++) {
+        const __m128i n = _mm_set1_epi8 ((char) q->chars[c]);
+        guint64 m0 = (guint16) _mm_movemask_epi8 (_mm_cmpeq_epi8 (t0, n));
+        guint64 m1 = (guint16) _mm_movemask_epi8 (_mm_cmpeq_epi8 (t1, n));
+        guint64 m2 = (guint16) _mm_movemask_epi8 (_mm_cmpeq_epi8 (t2, n));
+        guint64 m3 = (guint16) _mm_movemask_epi8 (_mm_cmpeq_epi8 (t3, n));
+        masks[c] = m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+    }
+}
+#endif
+
+#if defined(FUZZY_HAVE_AVX2)
+__attribute__ ((target ("avx2")))
+static void
+masks_avx2 (const FuzzyQuery *q, const FuzzySlot *slot, guint64 *masks)
+{
+    const __m256i lo = _mm256_loadu_si256 ((const __m256i *) (slot->text +  0));
+    const __m256i hi = _mm256_loadu_si256 ((const __m256i *) (slot->text + 32));
+
+    for (guint c = 0; c < q->n_chars; c++) {
+        const __m256i n = _mm256_set1_epi8 ((char) q->chars[c]);
+        guint64 m0 = (guint32) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (lo, n));
+        guint64 m1 = (guint32) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (hi, n));
+        masks[c] = m0 | (m1 << 32);
+    }
+}
+#endif
+
+static MaskFunc
+pick_masks (void)
+{
+    static MaskFunc fn;
+    if (G_LIKELY (fn)) return fn;
+
+    fn = masks_scalar;
+#if defined(__SSE2__)
+    fn = masks_sse2;
+#endif
+#if defined(FUZZY_HAVE_AVX2)
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2"))
+        fn = masks_avx2;
+#endif
+    return fn;
+}
+
+/* -------------------------------------------------------------------------
+ * Scoring
+ * ------------------------------------------------------------------------- */
+
+#define NO_SCORE  G_MININT
+
+static inline guint64
+bits_below (guint p)
+{
+    return p ? ((guint64) 1 << p) - 1 : 0;
+}
+
+static inline guint64
+bits_above (gint p)
+{
+    return p >= 63 ? 0 : ~(guint64) 0 << (p + 1);
+}
+
+/**
+ * Best alignment of one term, given its occurrence masks.
+ * DP over matched positions: best[p] is the best score of the term's
+ * first i characters with character i at position p.
+ */
+static gboolean
+score_term (const guint64 *masks, guint len, guint64 boundary, gint *out)
+{
+    /* Greedy subsequence test rejects most slots before the DP */
+    gint pos = -1;
+    for (guint i = 0; i < len; i++) {
+        guint64 m = masks[i] & bits_above (pos);
+        if (!m) return FALSE;
+        pos = __builtin_ctzll (m);
+    }
+
+    gint     prev[FUZZY_SLOT_LEN], cur[FUZZY_SLOT_LEN];
+    guint64  prev_bits = 0;
+
+    for (guint i = 0; i < len; i++) {
+        guint64 cur_bits = 0;
+
+        for (guint64 bits = masks[i]; bits; bits &= bits - 1) {
+            guint p  = __builtin_ctzll (bits);
+            gint  on_boundary = (boundary >> p) & 1;
+            gint  best;
+
+            if (i == 0) {
+                best = on_boundary * BONUS_BOUNDARY * BONUS_FIRST_MULT +
+                       (p == 0 ? BONUS_PREFIX : 0);
+            } else {
+                best = NO_SCORE;
+                for (guint64 pb = prev_bits & bits_below (p); pb; pb &= pb - 1) {
+                    guint q   = __builtin_ctzll (pb);
+                    gint  gap = (gint) (p - q - 1);
+                    gint  s   = prev[q] + (gap == 0
+                                  ? BONUS_CONSECUTIVE
+                                  : SCORE_GAP_START + SCORE_GAP_EXTEND * (gap - 1));
+                    if (s > best) best = s;
+                }
+                if (best == NO_SCORE) continue;
+                best += on_boundary * BONUS_BOUNDARY;
+            }
+
+            cur[p]    = best + SCORE_MATCH;
+            cur_bits |= (guint64) 1 << p;
+        }
+
+        if (!cur_bits) return FALSE;
+        memcpy (prev, cur, sizeof (prev));
+        prev_bits = cur_bits;
+    }
+
+    gint best = NO_SCORE;
+    for (guint64 bits = prev_bits; bits; bits &= bits - 1) {
+        guint p = __builtin_ctzll (bits);
+        if (prev[p] > best) best = prev[p];
+    }
+    *out = best;
+    return TRUE;
+}
+
+static inline gboolean
+score_slot (const FuzzyQuery *q, const FuzzySlot *slot, MaskFunc masks_fn,
+            gint *score)
+{
+    if (slot->len == 0 || (q->bloom & ~slot->bloom)) return FALSE;
+
+    guint64 masks[FUZZY_MAX_TERMS * FUZZY_MAX_TERM];
+    masks_fn (q, slot, masks);
+
+    gint total = 0;
+    for (guint t = 0; t < q->n_terms; t++) {
+        const FuzzyTerm *term = &q->terms[t];
+        gint s;
+        if (!score_term (masks + term->first, term->len, slot->boundary, &s))
+            return FALSE;
+        total += s;
+    }
+    *score = total;
+    return TRUE;
+}
+
+/* -------------------------------------------------------------------------
+ * Top-K heap — root is the worst kept hit
+ * ------------------------------------------------------------------------- */
+
+static inline gboolean
+hit_worse (const FuzzySlot *slots, const FuzzyHit *a, const FuzzyHit *b)
+{
+    if (a->score != b->score) return a->score < b->score;
+    guint la = slots[a->index].len, lb = slots[b->index].len;
+    if (la != lb) return la > lb;
+    return a->index > b->index;
+}
+
+static void
+heap_sift_down (const FuzzySlot *slots, FuzzyHit *h, guint n, guint i)
+{
+    for (;;) {
+        guint l = 2 * i + 1, r = l + 1, w = i;
+        if (l < n && hit_worse (slots, &h[l], &h[w])) w = l;
+        if (r < n && hit_worse (slots, &h[r], &h[w])) w = r;
+        if (w == i) return;
+        FuzzyHit tmp = h[i]; h[i] = h[w]; h[w] = tmp;
+        i = w;
+    }
+}
+
+static void
+heap_sift_up (const FuzzySlot *slots, FuzzyHit *h, guint i)
+{
+    while (i > 0) {
+        guint parent = (i - 1) / 2;
+        if (!hit_worse (slots, &h[i], &h[parent])) return;
+        FuzzyHit tmp = h[i]; h[i] = h[parent]; h[parent] = tmp;
+        i = parent;
+    }
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+static inline gboolean
+is_separator (guchar c)
+{
+    return c == ' ' || c == '-' || c == '_' || c == '.' || c == '/' ||
+           c == '(' || c == ')' || c == ':' || c == ',';
+}
+
+void
+fuzzy_slot_init (FuzzySlot *slot, const char *name)
+{
+    g_return_if_fail (slot != NULL);
+    memset (slot, 0, sizeof (*slot));
+    if (!name || !*name) return;
+
+    char  *folded = g_utf8_casefold (name, -1);
+    gsize  len    = MIN (strlen (folded), (gsize) FUZZY_SLOT_LEN);
+    memcpy (slot->text, folded, len);
+    slot->len = (guint32) len;
+
+    /* CamelCase boundaries only line up when folding kept the length */
+    gboolean camel = strlen (folded) == strlen (name);
+
+    for (gsize i = 0; i < len; i++) {
+        guchar c = slot->text[i];
+        slot->bloom |= (guint64) 1 << (c & 63);
+
+        gboolean start = i == 0 || is_separator (slot->text[i - 1]);
+        if (!start && camel && g_ascii_isupper (name[i]) &&
+            g_ascii_islower (name[i - 1]))
+            start = TRUE;
+        if (start && !is_separator (c))
+            slot->boundary |= (guint64) 1 << i;
+    }
+
+    g_free (folded);
+}
+
+FuzzyQuery *
+fuzzy_query_new (const char *query)
+{
+    if (!query) return NULL;
+
+    char       *folded = g_utf8_casefold (query, -1);
+    FuzzyQuery *q      = g_new0 (FuzzyQuery, 1);
+
+    for (const guchar *p = (const guchar *) folded; *p; ) {
+        while (*p == ' ') p++;
+        if (!*p) break;
+        if (q->n_terms == FUZZY_MAX_TERMS) break;
+
+        FuzzyTerm *t = &q->terms[q->n_terms++];
+        t->first = q->n_chars;
+        for (; *p && *p != ' '; p++) {
+            if (t->len == FUZZY_MAX_TERM) continue;
+            t->chars[t->len++]      = *p;
+            q->chars[q->n_chars++]  = *p;
+            q->bloom               |= (guint64) 1 << (*p & 63);
+        }
+    }
+
+    g_free (folded);
+
+    if (q->n_terms == 0) {
+        g_free (q);
+        return NULL;
+    }
+    return q;
+}
+
+void
+fuzzy_query_free (FuzzyQuery *query)
+{
+    g_free (query);
+}
+
+guint64
+fuzzy_query_get_bloom (const FuzzyQuery *query)
+{
+    g_return_val_if_fail (query != NULL, 0);
+    return query->bloom;
+}
+
+gboolean
+fuzzy_score (const FuzzyQuery *query, const FuzzySlot *slot, gint *score)
+{
+    g_return_val_if_fail (query != NULL && slot != NULL, FALSE);
+
+    gint s;
+    if (!score_slot (query, slot, pick_masks (), &s)) return FALSE;
+    if (score) *score = s;
+    return TRUE;
+}
+
+/* Top-@k over slots ids[0..n) (or 0..n when @ids is NULL) */
+static guint
+rank_slots (const FuzzyQuery *query,
+            const FuzzySlot  *slots,
+            const gint       *bias,
+            const guint32    *ids,
+            guint             n,
+            guint             k,
+            FuzzyHit         *out)
+{
+    if (k == 0 || n == 0) return 0;
+
+    MaskFunc masks_fn = pick_masks ();
+    guint    n_hits   = 0;
+
+    for (guint j = 0; j < n; j++) {
+        guint    i   = ids ? ids[j] : j;
+        FuzzyHit hit = { i, 0 };
+        if (!score_slot (query, &slots[i], masks_fn, &hit.score)) continue;
+        if (bias) hit.score += bias[i];
+
+        if (n_hits < k) {
+            out[n_hits] = hit;
+            heap_sift_up (slots, out, n_hits++);
+        } else if (hit_worse (slots, &out[0], &hit)) {
+            out[0] = hit;
+            heap_sift_down (slots, out, n_hits, 0);
+        }
+    }
+
+    /* Heap sort: repeatedly move the worst to the back → best first */
+    for (guint end = n_hits; end > 1; end--) {
+        FuzzyHit tmp = out[0]; out[0] = out[end - 1]; out[end - 1] = tmp;
+        heap_sift_down (slots, out, end - 1, 0);
+    }
+
+    return n_hits;
+}
+
+guint
+fuzzy_rank (const FuzzyQuery *query,
+            const FuzzySlot  *slots,
+            const gint       *bias,
+            guint             n_slots,
+            guint             k,
+            FuzzyHit         *out)
+{
+    g_return_val_if_fail (query != NULL, 0);
+    return rank_slots (query, slots, bias, NULL, n_slots, k, out);
+}
+
+guint
+fuzzy_rank_subset (const FuzzyQuery *query,
+                   const FuzzySlot  *slots,
+                   const gint       *bias,
+                   const guint32    *ids,
+                   guint             n_ids,
+                   guint             k,
+                   FuzzyHit         *out)
+{
+    g_return_val_if_fail (query != NULL, 0);
+    g_return_val_if_fail (ids != NULL || n_ids == 0, 0);
+    return rank_slots (query, slots, bias, ids, n_ids, k, out);
+}
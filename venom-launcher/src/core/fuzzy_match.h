@@ -0,0 +1,77 @@
+#pragma once
+
+#include <glib.h>
+
+/**
+ * FuzzyMatch - Ranked subsequence matching for launcher search.
+ *
+ * fzf / Smith-Waterman style: every query character must appear in
+ * order in the name; the score rewards matches on word boundaries,
+ * at the start of the name and in consecutive runs, and penalises
+ * gaps.  Space-separated query terms are matched independently and
+ * must all match ("lo wr" finds "LibreOffice Writer").
+ *
+ * Names are pre-casefolded into fixed-size FuzzySlot records stored in
+ * one contiguous array.  The scoring kernel builds a 64-bit occurrence
+ * mask per query character with SSE2 (or AVX2 when the CPU has it)
+ * compares over the slot, so the matching DP works on bit positions
+ * instead of bytes.
+ */
+
+#define FUZZY_SLOT_LEN    64   /* name bytes scored per entry */
+#define FUZZY_MAX_TERMS    8
+#define FUZZY_MAX_TERM    32   /* bytes per query term */
+
+typedef struct {
+    guint8   text[FUZZY_SLOT_LEN];  /* casefolded, zero padded */
+    guint64  boundary;              /* bit i: text[i] starts a word */
+    guint64  bloom;                 /* bit (c & 63) for every byte c */
+    guint32  len;                   /* 0 = empty / removed */
+    guint32  reserved;
+} FuzzySlot;
+
+typedef struct {
+    guint    index;   /* slot index */
+    gint     score;
+} FuzzyHit;
+
+typedef struct _FuzzyQuery FuzzyQuery;
+
+/* Fills @slot from a display name (NULL clears it). */
+void        fuzzy_slot_init   (FuzzySlot        *slot,
+                               const char       *name);
+
+/* Returns NULL if @query has no searchable characters. */
+FuzzyQuery *fuzzy_query_new   (const char       *query);
+void        fuzzy_query_free  (FuzzyQuery       *query);
+
+/* Bloom bits of the query's characters: only slots whose bloom has all
+ * of them can match. */
+guint64     fuzzy_query_get_bloom (const FuzzyQuery *query);
+
+/* Score of one slot; returns FALSE if it does not match. */
+gboolean    fuzzy_score       (const FuzzyQuery *query,
+                               const FuzzySlot  *slot,
+                               gint             *score);
+
+/**
+ * Scores all @n_slots and writes the best @k matches to @out, best
+ * first (ties: shorter name, then lower index).  @bias (may be NULL)
+ * is added to the score of each matching slot, e.g. for usage.
+ * Returns the number of hits written (<= @k).
+ */
+guint       fuzzy_rank        (const FuzzyQuery *query,
+                               const FuzzySlot  *slots,
+                               const gint       *bias,
+                               guint             n_slots,
+                               guint             k,
+                               FuzzyHit         *out);
+
+/* As fuzzy_rank(), over only the slots listed in @ids (hit.index is the slot). */
+guint       fuzzy_rank_subset (const FuzzyQuery *query,
+                               const FuzzySlot  *slots,
+                               const gint       *bias,
+                               const guint32    *ids,
+                               guint             n_ids,
+                               guint             k,
+                               FuzzyHit         *out);
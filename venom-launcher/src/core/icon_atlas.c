@@ -0,0 +1,357 @@
+#include "icon_atlas.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+G_STATIC_ASSERT (sizeof (IconAtlasHeader) % 8 == 0);
+G_STATIC_ASSERT (sizeof (IconAtlasRecord) % 8 == 0);
+
+#define TILES_ALIGN  64
+
+/* -------------------------------------------------------------------------
+ * Structs
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    char            *path;
+    gint64           mtime;
+    cairo_surface_t *tile;
+} PendingIcon;
+
+struct _IconAtlas {
+    char                  *theme;
+    GMappedFile           *mapped;    /* NULL if no usable file */
+    const IconAtlasHeader *header;
+    const IconAtlasRecord *records;
+    const char            *strtab;
+    const guint8          *tiles;
+    GHashTable            *by_name;   /* name (in mapping) -> IconAtlasRecord* */
+    GHashTable            *pending;   /* name -> PendingIcon* */
+};
+
+static cairo_user_data_key_t mapping_key;
+
+/* -------------------------------------------------------------------------
+ * Helpers
+ * ------------------------------------------------------------------------- */
+
+static char *
+atlas_file_path (void)
+{
+    return g_build_filename (g_get_user_cache_dir (), "venom",
+                             "launcher-icons.atlas", NULL);
+}
+
+static void
+pending_free (gpointer data)
+{
+    PendingIcon *p = data;
+    g_free (p->path);
+    cairo_surface_destroy (p->tile);
+    g_free (p);
+}
+
+static gint64
+file_mtime (const char *path)
+{
+    GStatBuf st;
+    if (!path || g_stat (path, &st) != 0) return -1;
+    return (gint64) st.st_mtime;
+}
+
+static gboolean
+validate (const char *data, gsize len)
+{
+    if (len < sizeof (IconAtlasHeader)) return FALSE;
+
+    const IconAtlasHeader *h = (const IconAtlasHeader *) data;
+    if (h->magic != ICON_ATLAS_MAGIC || h->version != ICON_ATLAS_VERSION ||
+        h->tile != ICON_ATLAS_TILE)
+        return FALSE;
+
+    guint64 rec_end = (guint64) h->records_offset +
+                      (guint64) h->n_records * sizeof (IconAtlasRecord);
+    if (h->records_offset % 8 != 0 || rec_end > len) return FALSE;
+
+    guint64 str_end = (guint64) h->strtab_offset + h->strtab_size;
+    if (h->strtab_size == 0 || str_end > len) return FALSE;
+    if (data[h->strtab_offset + h->strtab_size - 1] != '\0') return FALSE;
+    if (h->theme >= h->strtab_size) return FALSE;
+
+    guint64 tiles_end = h->tiles_offset +
+                        (guint64) h->n_records * ICON_ATLAS_TILE_SIZE;
+    if (h->tiles_offset % TILES_ALIGN != 0 || tiles_end > len) return FALSE;
+
+    const IconAtlasRecord *recs =
+        (const IconAtlasRecord *) (data + h->records_offset);
+    for (guint32 i = 0; i < h->n_records; i++) {
+        const IconAtlasRecord *r = &recs[i];
+        if (r->name == 0 || r->name >= h->strtab_size) return FALSE;
+        if (r->path == 0 || r->path >= h->strtab_size) return FALSE;
+        if (r->tile >= h->n_records)                   return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+map_file (IconAtlas *a)
+{
+    char        *path   = atlas_file_path ();
+    GMappedFile *mapped = g_mapped_file_new (path, FALSE, NULL);
+    g_free (path);
+    if (!mapped) return;
+
+    const char *data = g_mapped_file_get_contents (mapped);
+    gsize       len  = g_mapped_file_get_length (mapped);
+
+    if (!data || !validate (data, len)) {
+        g_mapped_file_unref (mapped);
+        return;
+    }
+
+    const IconAtlasHeader *h = (const IconAtlasHeader *) data;
+    if (g_strcmp0 (a->theme, data + h->strtab_offset + h->theme) != 0) {
+        g_mapped_file_unref (mapped);
+        return;
+    }
+
+    a->mapped  = mapped;
+    a->header  = h;
+    a->records = (const IconAtlasRecord *) (data + h->records_offset);
+    a->strtab  = data + h->strtab_offset;
+    a->tiles   = (const guint8 *) data + h->tiles_offset;
+
+    for (guint32 i = 0; i < h->n_records; i++)
+        g_hash_table_insert (a->by_name,
+                             (gpointer) (a->strtab + a->records[i].name),
+                             (gpointer) &a->records[i]);
+}
+
+static void
+unmap_file (IconAtlas *a)
+{
+    g_hash_table_remove_all (a->by_name);
+    /* Surfaces handed out keep their own ref on the mapping */
+    g_clear_pointer (&a->mapped, g_mapped_file_unref);
+    a->header  = NULL;
+    a->records = NULL;
+    a->strtab  = NULL;
+    a->tiles   = NULL;
+}
+
+/* Zero-copy view of a mapped tile */
+static cairo_surface_t *
+tile_view (IconAtlas *a, const IconAtlasRecord *r)
+{
+    guint8 *pixels = (guint8 *) a->tiles + (gsize) r->tile * ICON_ATLAS_TILE_SIZE;
+
+    /* Read-only mapping: only ever used as a paint source */
+    cairo_surface_t *s = cairo_image_surface_create_for_data (
+        pixels, CAIRO_FORMAT_ARGB32, ICON_ATLAS_TILE, ICON_ATLAS_TILE,
+        ICON_ATLAS_STRIDE);
+    cairo_surface_set_user_data (s, &mapping_key,
+                                 g_mapped_file_ref (a->mapped),
+                                 (cairo_destroy_func_t) g_mapped_file_unref);
+    return s;
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+IconAtlas *
+icon_atlas_new (const char *theme_name)
+{
+    IconAtlas *a = g_new0 (IconAtlas, 1);
+    a->theme   = g_strdup (theme_name ? theme_name : "");
+    a->by_name = g_hash_table_new (g_str_hash, g_str_equal);
+    a->pending = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                        g_free, pending_free);
+    map_file (a);
+    return a;
+}
+
+void
+icon_atlas_free (IconAtlas *atlas)
+{
+    if (!atlas) return;
+    unmap_file (atlas);
+    g_hash_table_destroy (atlas->by_name);
+    g_hash_table_destroy (atlas->pending);
+    g_free (atlas->theme);
+    g_free (atlas);
+}
+
+const char *
+icon_atlas_get_theme (const IconAtlas *atlas)
+{
+    g_return_val_if_fail (atlas != NULL, NULL);
+    return atlas->theme;
+}
+
+cairo_surface_t *
+icon_atlas_lookup (IconAtlas *atlas, const char *icon_name)
+{
+    g_return_val_if_fail (atlas != NULL, NULL);
+    if (!icon_name) return NULL;
+
+    PendingIcon *p = g_hash_table_lookup (atlas->pending, icon_name);
+    if (p) return cairo_surface_reference (p->tile);
+
+    const IconAtlasRecord *r = g_hash_table_lookup (atlas->by_name, icon_name);
+    if (!r) return NULL;
+
+    if (file_mtime (atlas->strtab + r->path) != r->mtime)
+        return NULL;
+
+    return tile_view (atlas, r);
+}
+
+void
+icon_atlas_add (IconAtlas       *atlas,
+                const char      *icon_name,
+                const char      *path,
+                gint64           mtime,
+                cairo_surface_t *tile)
+{
+    g_return_if_fail (atlas != NULL && icon_name != NULL && path != NULL);
+    g_return_if_fail (tile != NULL);
+    g_return_if_fail (cairo_image_surface_get_format (tile) == CAIRO_FORMAT_ARGB32 &&
+                      cairo_image_surface_get_width  (tile) == ICON_ATLAS_TILE &&
+                      cairo_image_surface_get_height (tile) == ICON_ATLAS_TILE);
+
+    PendingIcon *p = g_new0 (PendingIcon, 1);
+    p->path  = g_strdup (path);
+    p->mtime = mtime;
+    p->tile  = cairo_surface_reference (tile);
+    g_hash_table_replace (atlas->pending, g_strdup (icon_name), p);
+}
+
+/* -------------------------------------------------------------------------
+ * Writer
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    GArray     *records;
+    GString    *strtab;
+    GHashTable *interned;
+    GString    *tiles;
+} AtlasWriter;
+
+static guint32
+writer_intern (AtlasWriter *w, const char *s)
+{
+    gpointer off;
+    if (g_hash_table_lookup_extended (w->interned, s, NULL, &off))
+        return GPOINTER_TO_UINT (off);
+
+    guint32 pos = (guint32) w->strtab->len;
+    g_string_append_len (w->strtab, s, (gssize) strlen (s) + 1);
+    g_hash_table_insert (w->interned, g_strdup (s), GUINT_TO_POINTER (pos));
+    return pos;
+}
+
+static void
+writer_add (AtlasWriter *w, const char *name, const char *path, gint64 mtime,
+            const guint8 *pixels, int stride)
+{
+    IconAtlasRecord r = { 0 };
+    r.mtime = mtime;
+    r.name  = writer_intern (w, name);
+    r.path  = writer_intern (w, path);
+    r.tile  = w->records->len;
+    g_array_append_val (w->records, r);
+
+    for (int y = 0; y < ICON_ATLAS_TILE; y++)
+        g_string_append_len (w->tiles, (const char *) pixels + (gsize) y * stride,
+                             ICON_ATLAS_STRIDE);
+}
+
+gboolean
+icon_atlas_flush (IconAtlas *atlas)
+{
+    g_return_val_if_fail (atlas != NULL, FALSE);
+    if (g_hash_table_size (atlas->pending) == 0) return TRUE;
+
+    AtlasWriter w;
+    w.records  = g_array_new (FALSE, TRUE, sizeof (IconAtlasRecord));
+    w.strtab   = g_string_sized_new (16 * 1024);
+    w.interned = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    w.tiles    = g_string_sized_new (64 * ICON_ATLAS_TILE_SIZE);
+
+    /* Offset 0 is reserved for NULL */
+    g_string_append_c (w.strtab, '\0');
+    guint32 theme = writer_intern (&w, atlas->theme);
+
+    /* Fresh decodes first, so they survive the cap */
+    GHashTableIter iter;
+    gpointer       key, value;
+    g_hash_table_iter_init (&iter, atlas->pending);
+    while (g_hash_table_iter_next (&iter, &key, &value) &&
+           w.records->len < ICON_ATLAS_MAX) {
+        PendingIcon *p = value;
+        cairo_surface_flush (p->tile);
+        writer_add (&w, key, p->path, p->mtime,
+                    cairo_image_surface_get_data (p->tile),
+                    cairo_image_surface_get_stride (p->tile));
+    }
+
+    for (guint32 i = 0; atlas->header && i < atlas->header->n_records &&
+                        w.records->len < ICON_ATLAS_MAX; i++) {
+        const IconAtlasRecord *r    = &atlas->records[i];
+        const char            *name = atlas->strtab + r->name;
+        if (g_hash_table_contains (atlas->pending, name)) continue;
+        writer_add (&w, name, atlas->strtab + r->path, r->mtime,
+                    atlas->tiles + (gsize) r->tile * ICON_ATLAS_TILE_SIZE,
+                    ICON_ATLAS_STRIDE);
+    }
+
+    IconAtlasHeader h = { 0 };
+    h.magic          = ICON_ATLAS_MAGIC;
+    h.version        = ICON_ATLAS_VERSION;
+    h.tile           = ICON_ATLAS_TILE;
+    h.n_records      = w.records->len;
+    h.records_offset = sizeof (IconAtlasHeader);
+    h.strtab_offset  = h.records_offset +
+                       w.records->len * (guint32) sizeof (IconAtlasRecord);
+    h.strtab_size    = (guint32) w.strtab->len;
+    h.theme          = theme;
+    h.tiles_offset   = ((guint64) h.strtab_offset + h.strtab_size + TILES_ALIGN - 1) &
+                       ~(guint64) (TILES_ALIGN - 1);
+
+    GString *buf = g_string_sized_new (h.tiles_offset + w.tiles->len);
+    g_string_append_len (buf, (const char *) &h, sizeof (h));
+    g_string_append_len (buf, w.records->data,
+                         (gssize) (w.records->len * sizeof (IconAtlasRecord)));
+    g_string_append_len (buf, w.strtab->str, (gssize) w.strtab->len);
+    while (buf->len < h.tiles_offset)
+        g_string_append_c (buf, '\0');
+    g_string_append_len (buf, w.tiles->str, (gssize) w.tiles->len);
+
+    char *path = atlas_file_path ();
+    char *dir  = g_path_get_dirname (path);
+    g_mkdir_with_parents (dir, 0700);
+
+    /* Renamed into place; live tile views pin the old inode */
+    GError  *err = NULL;
+    gboolean ok  = g_file_set_contents (path, buf->str, (gssize) buf->len, &err);
+    if (!ok) {
+        g_warning ("IconAtlas: write %s: %s", path, err->message);
+        g_error_free (err);
+    } else {
+        /* Serve everything from the new mapping; frees the pending tiles */
+        unmap_file (atlas);
+        g_hash_table_remove_all (atlas->pending);
+        map_file (atlas);
+    }
+
+    g_free (dir);
+    g_free (path);
+    g_string_free (buf, TRUE);
+    g_string_free (w.tiles, TRUE);
+    g_hash_table_destroy (w.interned);
+    g_string_free (w.strtab, TRUE);
+    g_array_free (w.records, TRUE);
+    return ok;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glib.h>
+#include <cairo.h>
+
+/**
+ * IconAtlas - Persistent cache of decoded, pre-scaled icons.
+ *
+ * Stored at $XDG_CACHE_HOME/venom/launcher-icons.atlas and loaded with
+ * mmap (GMappedFile).  Layout:
+ *
+ *   IconAtlasHeader | IconAtlasRecord[n_records] | string table | tiles
+ *
+ * Every tile is ICON_ATLAS_TILE x ICON_ATLAS_TILE premultiplied ARGB32
+ * (cairo's native layout), so a hit is a cairo image surface pointing
+ * straight into the mapping — no decode, no copy.  The surface holds a
+ * reference on the mapping.
+ *
+ * Records are keyed by icon name and validated against the resolved
+ * file path and its mtime; the whole atlas is tied to one icon theme.
+ * Icons decoded during a session are kept in memory and written out
+ * together by icon_atlas_flush() (atomic replace, like AppCache).
+ *
+ * Main thread only.
+ */
+
+#define ICON_ATLAS_MAGIC     0x41494356u   /* "VCIA" */
+#define ICON_ATLAS_VERSION   1
+#define ICON_ATLAS_TILE      96
+#define ICON_ATLAS_STRIDE    (ICON_ATLAS_TILE * 4)
+#define ICON_ATLAS_TILE_SIZE (ICON_ATLAS_STRIDE * ICON_ATLAS_TILE)
+#define ICON_ATLAS_MAX       4096          /* records kept across flushes */
+
+typedef struct {
+    guint32  magic;
+    guint32  version;
+    guint32  tile;                          /* ICON_ATLAS_TILE */
+    guint32  n_records;
+    guint32  records_offset;
+    guint32  strtab_offset;
+    guint32  strtab_size;
+    guint32  theme;                         /* strtab offset */
+    guint64  tiles_offset;                  /* 64-byte aligned */
+} IconAtlasHeader;
+
+typedef struct {
+    gint64   mtime;                         /* of @path when decoded */
+    guint32  name;                          /* strtab offsets */
+    guint32  path;
+    guint32  tile;                          /* tile index */
+    guint32  reserved;
+} IconAtlasRecord;
+
+typedef struct _IconAtlas IconAtlas;
+
+/* Maps the on-disk atlas if it was written for @theme_name. Never NULL. */
+IconAtlas       *icon_atlas_new     (const char      *theme_name);
+void             icon_atlas_free    (IconAtlas       *atlas);
+const char      *icon_atlas_get_theme (const IconAtlas *atlas);
+
+/**
+ * Returns a new surface reference for @icon_name if its file is
+ * unchanged since it was cached, else NULL.
+ */
+cairo_surface_t *icon_atlas_lookup  (IconAtlas       *atlas,
+                                     const char      *icon_name);
+
+/*
+ * Queues a decoded @tile (ICON_ATLAS_TILE square ARGB32 image surface)
+ * for the next flush; later lookups in this session hit it too.
+ */
+void             icon_atlas_add     (IconAtlas       *atlas,
+                                     const char      *icon_name,
+                                     const char      *path,
+                                     gint64           mtime,
+                                     cairo_surface_t *tile);
+
+/* Rewrites the file if anything was added. Returns FALSE on I/O error. */
+gboolean         icon_atlas_flush   (IconAtlas       *atlas);
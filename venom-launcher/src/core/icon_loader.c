@@ -1,16 +1,28 @@
+#define _DEFAULT_SOURCE   /* O_CLOEXEC, ftruncate() in venom-icon-atlas.h */
 #include "icon_loader.h"
+#include "icon_atlas.h"
+#include "icon_theme_index.h"
+#include "venom-icon-atlas.h"
+#include <glib/gstdio.h>
 #include <string.h>
 #include <pthread.h>
 
+/* New decodes are written to the atlas this long after the last one */
+#define ATLAS_FLUSH_DELAY_S  5
+
+/* Cache nodes are carved out of slabs of this many */
+#define NODES_PER_SLAB     128
+
 /* -------------------------------------------------------------------------
  * LRU Cache node
  * ------------------------------------------------------------------------- */
 
 typedef struct _CacheNode {
-    char             *key;
-    GdkPixbuf        *pixbuf;
+    const char       *key;      /* interned in IconLoader.keys */
+    cairo_surface_t  *surface;
+    gsize             bytes;    /* pixel data charged to the budget */
     struct _CacheNode *prev;
-    struct _CacheNode *next;
+    struct _CacheNode *next;    /* free list link while unused */
 } CacheNode;
 
 /* -------------------------------------------------------------------------
@@ -21,25 +33,58 @@ struct _IconLoader {
     GHashTable      *map;    /* key -> CacheNode* (main thread only) */
     CacheNode       *head;   /* MRU end */
     CacheNode       *tail;   /* LRU end */
-    int              count;
-    GtkIconTheme    *theme;  /* GTK objects — main thread only */
-    GThreadPool     *pool;
-    pthread_mutex_t  path_lock;  /* protects async task path-resolve queue */
+    GPtrArray       *slabs;  /* CacheNode[NODES_PER_SLAB] blocks */
+    CacheNode       *free_nodes;
+    GStringChunk    *keys;   /* icon names; bounded by distinct names seen */
+    IconLoaderStats  stats;  /* main thread only */
+    GtkSettings     *settings;  /* GTK objects — main thread only */
+    gulong           theme_handler;
+    GHookList        theme_hooks;
+    IconAtlas       *atlas;  /* persistent decoded tiles, main thread only */
+    guint            flush_id;
+    GThreadPool     *pool;   /* one ticket per queued Flight */
+
+    /* Loads in flight, one per icon name however many callers want it */
+    GHashTable      *flights;  /* icon name -> Flight* (main thread only) */
+    pthread_mutex_t  queue_lock;
+    GQueue           queue[ICON_PRIORITY_LEVELS];  /* Flight*, not yet started */
+
+    /* Theme index, shared with workers and the builder thread */
+    pthread_mutex_t  index_lock;
+    pthread_cond_t   index_ready;
+    IconThemeIndex  *index;         /* NULL until the first build */
+    guint            index_gen;     /* bumped per installed index */
+    char            *wanted_theme;  /* pending rebuild, if any */
+    GThread         *builder;
+    gboolean         building;
 };
 
-/* Async task: pass file path (not GtkIconTheme) to the thread */
 typedef struct {
-    IconLoader        *loader;
-    char              *resolved_path;  /* absolute file path — safe for threads */
     IconReadyCallback  callback;
     gpointer           user_data;
-} AsyncTask;
-
+    GCancellable      *cancellable;    /* owned ref, may be NULL */
+} Waiter;
+
+/*
+ * One load of one icon name. Waiters are appended on the main thread
+ * under queue_lock; the worker reads them there to decide whether
+ * anyone still wants the icon, then resolves and decodes through the
+ * theme index and hands the result back on an idle.
+ */
 typedef struct {
-    IconReadyCallback  callback;
-    GdkPixbuf         *pixbuf;
-    gpointer           user_data;
-} IdleData;
+    char              *icon_name;
+    GArray            *waiters;        /* Waiter */
+    IconPriority       priority;       /* queue_lock */
+    GList             *link;           /* in queue[priority]; NULL once popped */
+    gboolean           skipped;        /* queue_lock; popped unwanted, delivers NULL */
+
+    cairo_surface_t   *surface;
+    char              *path;           /* NULL if it was the fallback icon */
+    gint64             mtime;
+    guint              index_gen;
+    gboolean           decoded;        /* FALSE if skipped as unwanted */
+    gint64             decode_us;
+} Flight;
 
 /* -------------------------------------------------------------------------
  * Global singleton + g_once for thread-safe lazy init
@@ -52,6 +97,41 @@ static GOnce      g_loader_once  = G_ONCE_INIT;
  * LRU internals  (all called under main-thread or with appropriate locking)
  * ------------------------------------------------------------------------- */
 
+static CacheNode *
+node_alloc (IconLoader *l)
+{
+    if (!l->free_nodes) {
+        CacheNode *slab = g_new (CacheNode, NODES_PER_SLAB);
+        g_ptr_array_add (l->slabs, slab);
+        for (int i = 0; i < NODES_PER_SLAB; i++) {
+            slab[i].next  = l->free_nodes;
+            l->free_nodes = &slab[i];
+        }
+    }
+
+    CacheNode *node = l->free_nodes;
+    l->free_nodes   = node->next;
+    memset (node, 0, sizeof *node);
+    return node;
+}
+
+static void
+node_release (IconLoader *l, CacheNode *node)
+{
+    if (node->surface) cairo_surface_destroy (node->surface);
+    node->surface = NULL;
+    node->next    = l->free_nodes;
+    l->free_nodes = node;
+}
+
+static gsize
+surface_bytes (cairo_surface_t *surface)
+{
+    if (!surface) return 0;
+    return (gsize) cairo_image_surface_get_stride (surface) *
+           (gsize) cairo_image_surface_get_height (surface);
+}
+
 static void
 lru_detach (IconLoader *l, CacheNode *node)
 {
@@ -73,121 +153,398 @@ lru_push_front (IconLoader *l, CacheNode *node)
 }
 
 static void
-lru_evict_lru (IconLoader *l)
+lru_drop_tail (IconLoader *l)
 {
     if (!l->tail) return;
     CacheNode *old = l->tail;
     lru_detach (l, old);
     g_hash_table_remove (l->map, old->key);
-    l->count--;
-    g_free (old->key);
-    if (old->pixbuf) g_object_unref (old->pixbuf);
-    g_free (old);
+    l->stats.entries--;
+    l->stats.bytes -= old->bytes;
+    node_release (l, old);
+}
+
+/* Evicts from the LRU end until the budget holds (the MRU entry stays) */
+static void
+lru_trim (IconLoader *l)
+{
+    while (l->stats.bytes > l->stats.budget && l->tail && l->tail != l->head) {
+        lru_drop_tail (l);
+        l->stats.evictions++;
+    }
 }
 
 /* Returns new ref or NULL — must be called on main thread */
-static GdkPixbuf *
+static cairo_surface_t *
 lru_get (IconLoader *l, const char *key)
 {
     CacheNode *node = g_hash_table_lookup (l->map, key);
     if (!node) return NULL;
     lru_detach (l, node);
     lru_push_front (l, node);
-    return node->pixbuf ? g_object_ref (node->pixbuf) : NULL;
+    return node->surface ? cairo_surface_reference (node->surface) : NULL;
 }
 
 /* Stores a ref — must be called on main thread */
 static void
-lru_put (IconLoader *l, const char *key, GdkPixbuf *pixbuf)
-{
-    CacheNode *existing = g_hash_table_lookup (l->map, key);
-    if (existing) {
-        if (existing->pixbuf) g_object_unref (existing->pixbuf);
-        existing->pixbuf = pixbuf ? g_object_ref (pixbuf) : NULL;
-        lru_detach (l, existing);
-        lru_push_front (l, existing);
-        return;
+lru_put (IconLoader *l, const char *key, cairo_surface_t *surface)
+{
+    CacheNode *node = g_hash_table_lookup (l->map, key);
+    if (node) {
+        lru_detach (l, node);
+        if (node->surface) cairo_surface_destroy (node->surface);
+        l->stats.bytes -= node->bytes;
+    } else {
+        node      = node_alloc (l);
+        node->key = g_string_chunk_insert_const (l->keys, key);
+        g_hash_table_insert (l->map, (gpointer) node->key, node);
+        l->stats.entries++;
     }
-    if (l->count >= ICON_CACHE_MAX)
-        lru_evict_lru (l);
 
-    CacheNode *node  = g_new0 (CacheNode, 1);
-    node->key        = g_strdup (key);
-    node->pixbuf     = pixbuf ? g_object_ref (pixbuf) : NULL;
-    g_hash_table_insert (l->map, node->key, node);
+    /* Shared atlas tiles are mapped once for the session: not our memory */
+    node->surface = surface ? cairo_surface_reference (surface) : NULL;
+    node->bytes   = venom_icon_atlas_owns (surface) ? 0 : surface_bytes (surface);
+    l->stats.bytes += node->bytes;
     lru_push_front (l, node);
-    l->count++;
+    lru_trim (l);
+}
+
+static void
+lru_clear (IconLoader *l)
+{
+    while (l->tail)
+        lru_drop_tail (l);
+}
+
+/* -------------------------------------------------------------------------
+ * Theme index (built off the main thread, swapped in under index_lock)
+ * ------------------------------------------------------------------------- */
+
+static gboolean
+index_installed (gpointer data)
+{
+    (void) data;
+    IconLoader *l = g_loader;
+    if (!l) return G_SOURCE_REMOVE;
+
+    pthread_mutex_lock (&l->index_lock);
+    char *theme = g_strdup (icon_theme_index_get_theme (l->index));
+    pthread_mutex_unlock (&l->index_lock);
+
+    /* Tiles decoded for the old theme must not leak into the new one */
+    if (g_strcmp0 (theme, icon_atlas_get_theme (l->atlas)) != 0) {
+        if (l->flush_id) {
+            g_source_remove (l->flush_id);
+            l->flush_id = 0;
+        }
+        icon_atlas_flush (l->atlas);
+        icon_atlas_free (l->atlas);
+        l->atlas = icon_atlas_new (theme);
+    }
+    g_free (theme);
+
+    lru_clear (l);
+    g_hook_list_invoke (&l->theme_hooks, FALSE);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer
+index_builder (gpointer data)
+{
+    IconLoader *l = data;
+
+    pthread_mutex_lock (&l->index_lock);
+    while (l->wanted_theme) {
+        char *theme = l->wanted_theme;
+        l->wanted_theme = NULL;
+        pthread_mutex_unlock (&l->index_lock);
+
+        IconThemeIndex *index = icon_theme_index_new (theme);
+        g_free (theme);
+
+        pthread_mutex_lock (&l->index_lock);
+        if (l->wanted_theme && l->index) {
+            /* Superseded while building; workers can keep the old one */
+            icon_theme_index_unref (index);
+            continue;
+        }
+
+        IconThemeIndex *old = l->index;
+        l->index = index;
+        g_atomic_int_inc (&l->index_gen);
+        pthread_cond_broadcast (&l->index_ready);
+
+        if (old) {
+            icon_theme_index_unref (old);
+            g_idle_add (index_installed, NULL);
+        }
+    }
+    l->building = FALSE;
+    pthread_mutex_unlock (&l->index_lock);
+    return NULL;
+}
+
+/* Main thread: (re)build the index for the current theme in the background */
+static void
+request_index (IconLoader *l)
+{
+    char *theme = NULL;
+    g_object_get (l->settings, "gtk-icon-theme-name", &theme, NULL);
+
+    pthread_mutex_lock (&l->index_lock);
+    g_free (l->wanted_theme);
+    l->wanted_theme = theme;
+
+    gboolean start = !l->building;
+    l->building = TRUE;
+    pthread_mutex_unlock (&l->index_lock);
+
+    if (!start) return;  /* the running builder picks it up */
+
+    if (l->builder) g_thread_join (l->builder);
+    l->builder = g_thread_new ("icon-index", index_builder, l);
+}
+
+static void
+on_theme_changed (GObject *settings, GParamSpec *pspec, gpointer data)
+{
+    (void) settings;
+    (void) pspec;
+    request_index (data);
+}
+
+/* Returns a ref on the current index, waiting for the first build */
+static IconThemeIndex *
+acquire_index (IconLoader *l, guint *gen)
+{
+    pthread_mutex_lock (&l->index_lock);
+    while (!l->index)
+        pthread_cond_wait (&l->index_ready, &l->index_lock);
+    IconThemeIndex *index = icon_theme_index_ref (l->index);
+    if (gen) *gen = l->index_gen;
+    pthread_mutex_unlock (&l->index_lock);
+    return index;
 }
 
 /* -------------------------------------------------------------------------
- * Resolve icon name -> absolute file path (main-thread only, uses GtkIconTheme)
+ * Resolve icon name -> absolute file path (any thread)
  * ------------------------------------------------------------------------- */
 
 static char *
-resolve_icon_path (IconLoader *l, const char *icon_name)
+resolve_icon_path (IconThemeIndex *index, const char *icon_name)
 {
     if (!icon_name || *icon_name == '\0') return NULL;
 
-    if (g_path_is_absolute (icon_name) && g_file_test (icon_name, G_FILE_TEST_EXISTS))
-        return g_strdup (icon_name);
+    if (g_path_is_absolute (icon_name))
+        return g_file_test (icon_name, G_FILE_TEST_EXISTS)
+               ? g_strdup (icon_name) : NULL;
+
+    return icon_theme_index_lookup (index, icon_name, ICON_LOAD_SIZE);
+}
+
+/* @icon_name's file, else the generic fallback (*is_fallback set) */
+static char *
+resolve_or_fallback (IconThemeIndex *index, const char *icon_name,
+                     gboolean *is_fallback)
+{
+    char *path = resolve_icon_path (index, icon_name);
+    *is_fallback = path == NULL;
+    if (!path)
+        path = resolve_icon_path (index, "application-x-executable");
+    return path;
+}
+
+/* -------------------------------------------------------------------------
+ * Decoding — thread safe, no GTK calls
+ * ------------------------------------------------------------------------- */
+
+/*
+ * Centred ICON_LOAD_SIZE square premultiplied ARGB32 tile — the atlas
+ * format, and what cairo paints without conversion.  The tile lives in
+ * the session-wide shared icon atlas, so the dock, panel and desktop
+ * reuse it (and a file they already decoded at this size is not decoded
+ * again here).  Safe to call from the pool threads.
+ */
+static cairo_surface_t *
+decode_tile (const char *path)
+{
+    return venom_icon_atlas_load (path, ICON_LOAD_SIZE);
+}
+
+static gint64
+file_mtime (const char *path)
+{
+    GStatBuf st;
+    if (g_stat (path, &st) != 0) return -1;
+    return (gint64) st.st_mtime;
+}
+
+/* -------------------------------------------------------------------------
+ * Atlas write-back (main thread)
+ * ------------------------------------------------------------------------- */
+
+static gboolean
+atlas_flush_cb (gpointer data)
+{
+    IconLoader *l = data;
+    l->flush_id = 0;
+    icon_atlas_flush (l->atlas);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+remember_decode (IconLoader *l, const char *icon_name, const char *path,
+                 gint64 mtime, cairo_surface_t *tile)
+{
+    lru_put (l, icon_name, tile);
 
-    GtkIconInfo *info = gtk_icon_theme_lookup_icon (
-        l->theme, icon_name, ICON_LOAD_SIZE, GTK_ICON_LOOKUP_FORCE_SIZE);
+    /* A shared atlas tile needs no second copy in our own atlas */
+    if (!path || mtime < 0 || venom_icon_atlas_owns (tile)) return;
+    icon_atlas_add (l->atlas, icon_name, path, mtime, tile);
 
-    if (!info) {
-        /* Fallback */
-        info = gtk_icon_theme_lookup_icon (
-            l->theme, "application-x-executable", ICON_LOAD_SIZE,
-            GTK_ICON_LOOKUP_FORCE_SIZE);
+    if (l->flush_id) g_source_remove (l->flush_id);
+    l->flush_id = g_timeout_add_seconds (ATLAS_FLUSH_DELAY_S, atlas_flush_cb, l);
+}
+
+/* Memory cache, then the atlas (a warm start: no decode) */
+static cairo_surface_t *
+cache_lookup (IconLoader *l, const char *icon_name)
+{
+    cairo_surface_t *cached = lru_get (l, icon_name);
+    if (cached) {
+        l->stats.hits++;
+        return cached;
     }
 
-    if (!info) return NULL;
+    cached = icon_atlas_lookup (l->atlas, icon_name);
+    if (cached) {
+        l->stats.atlas_hits++;
+        lru_put (l, icon_name, cached);
+        return cached;
+    }
 
-    const char *path = gtk_icon_info_get_filename (info);
-    char *result = path ? g_strdup (path) : NULL;
-    g_object_unref (info);
-    return result;
+    l->stats.misses++;
+    return NULL;
 }
 
 /* -------------------------------------------------------------------------
- * Thread pool worker — only does file I/O, no GTK calls
+ * Flights (single-flight loads with priorities and cancellation)
  * ------------------------------------------------------------------------- */
 
+static Flight *
+flight_new (const char *icon_name, IconPriority priority)
+{
+    Flight *f    = g_new0 (Flight, 1);
+    f->icon_name = g_strdup (icon_name);
+    f->waiters   = g_array_new (FALSE, FALSE, sizeof (Waiter));
+    f->priority  = priority;
+    f->mtime     = -1;
+    return f;
+}
+
+/* Calls every waiter once, with the result or NULL, and frees @f */
+static void
+flight_finish (Flight *f)
+{
+    for (guint i = 0; i < f->waiters->len; i++) {
+        Waiter *w = &g_array_index (f->waiters, Waiter, i);
+        w->callback (f->surface, w->user_data);
+        g_clear_object (&w->cancellable);
+    }
+
+    g_array_unref (f->waiters);
+    if (f->surface) cairo_surface_destroy (f->surface);
+    g_free (f->icon_name);
+    g_free (f->path);
+    g_free (f);
+}
+
+/* Under queue_lock. FALSE once every waiter has been cancelled */
+static gboolean
+flight_wanted (const Flight *f)
+{
+    for (guint i = 0; i < f->waiters->len; i++) {
+        const Waiter *w = &g_array_index (f->waiters, Waiter, i);
+        if (!g_cancellable_is_cancelled (w->cancellable)) return TRUE;
+    }
+    return FALSE;
+}
+
 static gboolean
-idle_deliver (gpointer data)
+flight_done (gpointer data)
 {
-    IdleData *id = data;
-    id->callback (id->pixbuf, id->user_data);
-    if (id->pixbuf) g_object_unref (id->pixbuf);
-    g_free (id);
+    Flight     *f = data;
+    IconLoader *l = g_loader;
+
+    if (l) {
+        if (g_hash_table_lookup (l->flights, f->icon_name) == f)
+            g_hash_table_remove (l->flights, f->icon_name);
+
+        if (f->decoded) {
+            l->stats.decodes++;
+            l->stats.decode_us += f->decode_us;
+        } else {
+            l->stats.skipped++;
+        }
+
+        /* Decodes resolved against a replaced theme index are not cached */
+        if (f->surface &&
+            f->index_gen == (guint) g_atomic_int_get (&l->index_gen))
+            remember_decode (l, f->icon_name, f->path, f->mtime, f->surface);
+    }
+
+    flight_finish (f);
     return G_SOURCE_REMOVE;
 }
 
+/* -------------------------------------------------------------------------
+ * Thread pool worker — resolve + decode, no GTK calls
+ * ------------------------------------------------------------------------- */
+
 static void
 thread_pool_func (gpointer task_data, gpointer user_data)
 {
     (void) user_data;
-    AsyncTask *task = task_data;
-    GdkPixbuf *pb   = NULL;
-
-    if (task->resolved_path) {
-        GError *err = NULL;
-        pb = gdk_pixbuf_new_from_file_at_scale (
-            task->resolved_path,
-            ICON_LOAD_SIZE, ICON_LOAD_SIZE,
-            TRUE, &err);
-        if (err) { g_error_free (err); pb = NULL; }
+    IconLoader *l = task_data;
+    Flight     *f = NULL;
+    gboolean    wanted = FALSE;
+
+    /* Whatever is most urgent now, not what was pushed first */
+    pthread_mutex_lock (&l->queue_lock);
+    for (int p = 0; p < ICON_PRIORITY_LEVELS && !f; p++)
+        f = g_queue_pop_head (&l->queue[p]);
+    if (f) {
+        f->link    = NULL;
+        wanted     = flight_wanted (f);
+        f->skipped = !wanted;
+    }
+    pthread_mutex_unlock (&l->queue_lock);
+
+    if (!f) return;
+
+    /* Paged past before we got to it: skip the decode */
+    if (wanted) {
+        gint64          start = g_get_monotonic_time ();
+        gboolean        fallback;
+        IconThemeIndex *index = acquire_index (l, &f->index_gen);
+        char           *path  = resolve_or_fallback (index, f->icon_name, &fallback);
+        icon_theme_index_unref (index);
+
+        if (path) {
+            /* mtime first: a file replaced mid-decode is re-decoded next time */
+            f->mtime   = file_mtime (path);
+            f->surface = decode_tile (path);
+        }
+
+        /* The fallback is cached in memory, never persisted under this name */
+        if (fallback) g_free (path);
+        else          f->path = path;
+
+        f->decoded   = TRUE;
+        f->decode_us = g_get_monotonic_time () - start;
     }
 
-    IdleData *id  = g_new0 (IdleData, 1);
-    id->callback  = task->callback;
-    id->pixbuf    = pb;  /* hand ref to idle */
-    id->user_data = task->user_data;
-
-    g_idle_add (idle_deliver, id);
-
-    g_free (task->resolved_path);
-    g_free (task);
+    g_idle_add (flight_done, f);
 }
 
 /* -------------------------------------------------------------------------
@@ -200,9 +557,29 @@ icon_loader_init_once (gpointer arg)
     (void) arg;
 
     IconLoader *l = g_new0 (IconLoader, 1);
-    l->map   = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, NULL);
-    l->theme = gtk_icon_theme_get_default ();
-    pthread_mutex_init (&l->path_lock, NULL);
+    l->map      = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, NULL);
+    l->flights  = g_hash_table_new (g_str_hash, g_str_equal);
+    l->slabs    = g_ptr_array_new_with_free_func (g_free);
+    l->keys     = g_string_chunk_new (4096);
+    l->stats.budget = ICON_CACHE_BUDGET;
+    l->settings = g_object_ref (gtk_settings_get_default ());
+    pthread_mutex_init (&l->index_lock, NULL);
+    pthread_cond_init (&l->index_ready, NULL);
+    pthread_mutex_init (&l->queue_lock, NULL);
+    for (int p = 0; p < ICON_PRIORITY_LEVELS; p++)
+        g_queue_init (&l->queue[p]);
+    g_hook_list_init (&l->theme_hooks, sizeof (GHook));
+
+    /* Decoded tiles are only valid for the theme they were resolved in */
+    char *theme_name = NULL;
+    g_object_get (l->settings, "gtk-icon-theme-name", &theme_name, NULL);
+    l->atlas = icon_atlas_new (theme_name);
+    g_free (theme_name);
+
+    /* Atlas hits need no index, so a warm start never waits for this */
+    request_index (l);
+    l->theme_handler = g_signal_connect (l->settings, "notify::gtk-icon-theme-name",
+                                         G_CALLBACK (on_theme_changed), l);
 
     GError *err = NULL;
     l->pool = g_thread_pool_new (thread_pool_func, NULL, 4, FALSE, &err);
@@ -233,76 +610,223 @@ icon_loader_destroy (void)
 
     g_thread_pool_free (g_loader->pool, TRUE, TRUE);
 
-    CacheNode *node = g_loader->head;
-    while (node) {
-        CacheNode *next = node->next;
-        g_free (node->key);
-        if (node->pixbuf) g_object_unref (node->pixbuf);
-        g_free (node);
-        node = next;
+    /* Loads that never started still owe their callers a callback */
+    for (int p = 0; p < ICON_PRIORITY_LEVELS; p++) {
+        Flight *f;
+        while ((f = g_queue_pop_head (&g_loader->queue[p])))
+            flight_finish (f);
     }
+    g_hash_table_destroy (g_loader->flights);
 
+    /* Let a running build finish rather than start another */
+    pthread_mutex_lock (&g_loader->index_lock);
+    g_clear_pointer (&g_loader->wanted_theme, g_free);
+    pthread_mutex_unlock (&g_loader->index_lock);
+    if (g_loader->builder) g_thread_join (g_loader->builder);
+    icon_theme_index_unref (g_loader->index);
+
+    g_signal_handler_disconnect (g_loader->settings, g_loader->theme_handler);
+    g_object_unref (g_loader->settings);
+    g_hook_list_clear (&g_loader->theme_hooks);
+
+    if (g_loader->flush_id) g_source_remove (g_loader->flush_id);
+    icon_atlas_flush (g_loader->atlas);
+    icon_atlas_free (g_loader->atlas);
+
+    lru_clear (g_loader);
     g_hash_table_destroy (g_loader->map);
-    pthread_mutex_destroy (&g_loader->path_lock);
+    g_ptr_array_unref (g_loader->slabs);
+    g_string_chunk_free (g_loader->keys);
+    pthread_mutex_destroy (&g_loader->queue_lock);
+    pthread_cond_destroy (&g_loader->index_ready);
+    pthread_mutex_destroy (&g_loader->index_lock);
     g_free (g_loader);
     g_loader = NULL;
 }
 
-GdkPixbuf *
+cairo_surface_t *
 icon_loader_load (IconLoader *loader, const char *icon_name)
 {
     g_return_val_if_fail (loader != NULL, NULL);
 
-    GdkPixbuf *cached = lru_get (loader, icon_name);
+    cairo_surface_t *cached = cache_lookup (loader, icon_name);
     if (cached) return cached;
 
-    char *path = resolve_icon_path (loader, icon_name);
+    gint64          start = g_get_monotonic_time ();
+    gboolean        fallback;
+    IconThemeIndex *index = acquire_index (loader, NULL);
+    char           *path  = resolve_or_fallback (index, icon_name, &fallback);
+    icon_theme_index_unref (index);
     if (!path) return NULL;
 
-    GError    *err = NULL;
-    GdkPixbuf *pb  = gdk_pixbuf_new_from_file_at_scale (
-        path, ICON_LOAD_SIZE, ICON_LOAD_SIZE, TRUE, &err);
-    g_free (path);
-    if (err) { g_error_free (err); return NULL; }
+    gint64           mtime = file_mtime (path);
+    cairo_surface_t *tile  = decode_tile (path);
 
-    lru_put (loader, icon_name, pb);
-    return pb;
+    loader->stats.decodes++;
+    loader->stats.decode_us += g_get_monotonic_time () - start;
+    if (tile)
+        remember_decode (loader, icon_name, fallback ? NULL : path, mtime, tile);
+
+    g_free (path);
+    return tile;
 }
 
 void
 icon_loader_load_async (IconLoader       *loader,
                         const char       *icon_name,
+                        IconPriority      priority,
+                        GCancellable     *cancellable,
                         IconReadyCallback callback,
                         gpointer          user_data)
 {
     g_return_if_fail (loader   != NULL);
     g_return_if_fail (callback != NULL);
+    g_return_if_fail (priority >= 0 && priority < ICON_PRIORITY_LEVELS);
+
+    /* Cache check on main thread — memory first, then the atlas, so
+     * icons cached by an earlier run are delivered synchronously */
+    cairo_surface_t *cached = cache_lookup (loader, icon_name);
 
-    /* Cache check on main thread */
-    GdkPixbuf *cached = lru_get (loader, icon_name);
     if (cached) {
         callback (cached, user_data);
-        g_object_unref (cached);
+        cairo_surface_destroy (cached);
         return;
     }
 
-    /* Resolve icon path on main thread (GtkIconTheme is not thread-safe) */
-    char *path = resolve_icon_path (loader, icon_name);
+    Waiter w = {
+        callback, user_data,
+        cancellable ? g_object_ref (cancellable) : NULL,
+    };
+
+    /* Join a load already queued or running for this name — unless a
+     * worker skipped it because every waiter had been cancelled: it only
+     * delivers NULL, so start over (its flight_done may not have run yet) */
+    Flight  *f = g_hash_table_lookup (loader->flights, icon_name);
+    gboolean fresh;
+
+    pthread_mutex_lock (&loader->queue_lock);
+    fresh = f == NULL || f->skipped;
+    if (fresh) {
+        f = flight_new (icon_name, priority);
+        g_hash_table_replace (loader->flights, f->icon_name, f);
+    }
+    g_array_append_val (f->waiters, w);
+    if (fresh) {
+        g_queue_push_tail (&loader->queue[priority], f);
+        f->link = loader->queue[priority].tail;
+    } else if (f->link && priority < f->priority) {
+        /* A prefetch became visible: move it up */
+        g_queue_unlink (&loader->queue[f->priority], f->link);
+        g_queue_push_tail_link (&loader->queue[priority], f->link);
+        f->priority = priority;
+    }
+    pthread_mutex_unlock (&loader->queue_lock);
 
-    /* Build task — thread only does file I/O */
-    AsyncTask *task        = g_new0 (AsyncTask, 1);
-    task->loader           = loader;
-    task->resolved_path    = path;  /* may be NULL — thread handles gracefully */
-    task->callback         = callback;
-    task->user_data        = user_data;
+    if (!fresh) return;
 
     GError *err = NULL;
-    g_thread_pool_push (loader->pool, task, &err);
+    g_thread_pool_push (loader->pool, loader, &err);
     if (err) {
         g_warning ("IconLoader: push failed: %s", err->message);
         g_error_free (err);
-        callback (NULL, user_data);
-        g_free (task->resolved_path);
-        g_free (task);
+
+        /* Unless another ticket already picked it up */
+        pthread_mutex_lock (&loader->queue_lock);
+        gboolean queued = f->link != NULL;
+        if (queued) g_queue_delete_link (&loader->queue[f->priority], f->link);
+        pthread_mutex_unlock (&loader->queue_lock);
+
+        if (queued) {
+            g_hash_table_remove (loader->flights, f->icon_name);
+            flight_finish (f);
+        }
     }
 }
+
+void
+icon_loader_rescan (IconLoader *loader)
+{
+    g_return_if_fail (loader != NULL);
+    request_index (loader);
+}
+
+guint
+icon_loader_add_theme_watch (IconLoader     *loader,
+                             IconThemeWatch  func,
+                             gpointer        user_data)
+{
+    g_return_val_if_fail (loader != NULL && func != NULL, 0);
+
+    GHook *hook = g_hook_alloc (&loader->theme_hooks);
+    hook->func  = func;
+    hook->data  = user_data;
+    g_hook_append (&loader->theme_hooks, hook);
+    return (guint) hook->hook_id;
+}
+
+void
+icon_loader_remove_theme_watch (IconLoader *loader, guint id)
+{
+    g_return_if_fail (loader != NULL);
+    g_hook_destroy (&loader->theme_hooks, id);
+}
+
+void
+icon_loader_trim (IconLoader *loader)
+{
+    g_return_if_fail (loader != NULL);
+
+    /* Pending tiles go to disk; the atlas then serves them from the mapping */
+    if (loader->flush_id) {
+        g_source_remove (loader->flush_id);
+        loader->flush_id = 0;
+    }
+    icon_atlas_flush (loader->atlas);
+
+    lru_clear (loader);
+
+    /* Every node is back on the free list: give the slabs and keys back too */
+    g_ptr_array_set_size (loader->slabs, 0);
+    loader->free_nodes = NULL;
+    g_string_chunk_clear (loader->keys);
+}
+
+void
+icon_loader_set_cache_budget (IconLoader *loader, gsize bytes)
+{
+    g_return_if_fail (loader != NULL);
+    loader->stats.budget = bytes;
+    lru_trim (loader);
+}
+
+void
+icon_loader_get_stats (IconLoader *loader, IconLoaderStats *stats)
+{
+    g_return_if_fail (loader != NULL && stats != NULL);
+    *stats = loader->stats;
+}
+
+void
+icon_loader_dump_stats (IconLoader *loader)
+{
+    g_return_if_fail (loader != NULL);
+
+    const IconLoaderStats *st = &loader->stats;
+    guint64 lookups = st->hits + st->atlas_hits + st->misses;
+
+    g_message ("IconLoader: %u icons, %.1f of %.1f MiB; "
+               "%" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT " atlas hits, "
+               "%" G_GUINT64_FORMAT " misses (%.1f%% hit rate); "
+               "%" G_GUINT64_FORMAT " evictions; "
+               "%" G_GUINT64_FORMAT " decodes, %.2f ms avg; "
+               "%" G_GUINT64_FORMAT " skipped",
+               st->entries,
+               st->bytes  / (1024.0 * 1024.0),
+               st->budget / (1024.0 * 1024.0),
+               st->hits, st->atlas_hits, st->misses,
+               lookups ? 100.0 * (st->hits + st->atlas_hits) / lookups : 0.0,
+               st->evictions,
+               st->decodes,
+               st->decodes ? st->decode_us / 1000.0 / st->decodes : 0.0,
+               st->skipped);
+}
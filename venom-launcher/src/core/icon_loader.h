@@ -3,34 +3,102 @@
 #include <gtk/gtk.h>
 #include <glib.h>
 
-#define ICON_LOAD_SIZE   96   /* pixels — matches design spec */
-#define ICON_CACHE_MAX  256   /* LRU cache entries            */
+#define ICON_LOAD_SIZE     96                  /* pixels — matches design spec */
+#define ICON_CACHE_BUDGET  (24 * 1024 * 1024)  /* default LRU budget, bytes    */
 
 /**
  * IconLoader - Thread-safe icon resolver with LRU cache.
  * Singleton: call icon_loader_get() to obtain the global instance.
+ *
+ * Icons are delivered as ICON_LOAD_SIZE square premultiplied ARGB32
+ * cairo image surfaces, backed by the on-disk IconAtlas when an earlier
+ * run already decoded them.
+ *
+ * Names are resolved through an IconThemeIndex, so workers resolve and
+ * decode without touching GtkIconTheme. The index is built on a
+ * background thread at startup and again when the icon theme changes.
  */
 typedef struct _IconLoader IconLoader;
 
+/* Cache counters since startup (lookups are per request, not per name) */
+typedef struct {
+    guint64 hits;         /* served from memory */
+    guint64 atlas_hits;   /* served from the on-disk atlas */
+    guint64 misses;       /* had to be loaded (or joined a load) */
+    guint64 evictions;    /* dropped to stay within budget */
+    guint64 decodes;
+    guint64 skipped;      /* loads cancelled before decoding */
+    gint64  decode_us;    /* resolve + decode time, all decodes */
+    gsize   bytes;        /* private pixel data currently cached */
+    gsize   budget;
+    guint   entries;
+} IconLoaderStats;
+
 IconLoader  *icon_loader_get          (void);
 void         icon_loader_destroy      (void);
 
 /**
- * Returns a referenced GdkPixbuf* (96×96) for the given icon name.
- * Looks up LRU cache first, then resolves via GtkIconTheme.
- * Returns NULL if not found.
- * Thread-safe.
+ * Returns a referenced surface (96×96) for the given icon name.
+ * Looks up LRU cache and icon atlas first, then resolves via the
+ * theme index (waiting for its first build) and decodes.
+ * Returns NULL if not found. Main thread only.
  */
-GdkPixbuf   *icon_loader_load         (IconLoader  *loader,
+cairo_surface_t *icon_loader_load     (IconLoader  *loader,
                                        const char  *icon_name);
 
+/* Order in which queued loads are picked up by the workers */
+typedef enum {
+    ICON_PRIORITY_VISIBLE,   /* on screen now */
+    ICON_PRIORITY_PREFETCH,  /* probably on screen next */
+    ICON_PRIORITY_LEVELS
+} IconPriority;
+
 /**
- * Async variant — calls @callback on the GLib main thread
- * with the resolved GdkPixbuf* (may be NULL).
+ * Async variant — calls @callback on the GLib main thread with the
+ * surface (may be NULL; borrowed, reference it to keep it).  Memory
+ * and atlas hits call back before this returns.
+ *
+ * Requests for a name already loading join that load.  A load whose
+ * callers have all cancelled their @cancellable before a worker gets
+ * to it is not decoded, and calls back with NULL.  Every callback is
+ * called exactly once.
  */
-typedef void (*IconReadyCallback) (GdkPixbuf *pixbuf, gpointer user_data);
+typedef void (*IconReadyCallback) (cairo_surface_t *surface, gpointer user_data);
 
 void         icon_loader_load_async   (IconLoader       *loader,
                                        const char       *icon_name,
+                                       IconPriority      priority,
+                                       GCancellable     *cancellable,
                                        IconReadyCallback callback,
                                        gpointer          user_data);
+
+/* Rebuilds the theme index in the background, e.g. after icons were installed */
+void         icon_loader_rescan       (IconLoader  *loader);
+
+/**
+ * Called on the main thread once a rebuilt index (new theme, or a
+ * rescan) is in place and the memory cache was dropped; surfaces held
+ * by the caller may be stale. Returns an id for removal.
+ */
+typedef void (*IconThemeWatch) (gpointer user_data);
+
+guint        icon_loader_add_theme_watch    (IconLoader     *loader,
+                                             IconThemeWatch  func,
+                                             gpointer        user_data);
+void         icon_loader_remove_theme_watch (IconLoader     *loader,
+                                             guint           id);
+
+/*
+ * Empties the memory cache, freeing all of its storage, after writing
+ * pending decodes to the atlas.  Later loads are served from the atlas.
+ */
+void         icon_loader_trim         (IconLoader  *loader);
+
+/* Bounds the memory cache by privately decoded bytes (ICON_CACHE_BUDGET by
+ * default); tiles in the shared session atlas are not counted */
+void         icon_loader_set_cache_budget (IconLoader      *loader,
+                                           gsize            bytes);
+void         icon_loader_get_stats        (IconLoader      *loader,
+                                           IconLoaderStats *stats);
+/* Logs the counters with g_message() */
+void         icon_loader_dump_stats       (IconLoader      *loader);
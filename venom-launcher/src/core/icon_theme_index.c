@@ -0,0 +1,506 @@
+#include "icon_theme_index.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+/* Same bits as icon-theme.cache image flags */
+#define HAS_XPM  (1 << 0)
+#define HAS_SVG  (1 << 1)
+#define HAS_PNG  (1 << 2)
+#define HAS_ANY  (HAS_XPM | HAS_SVG | HAS_PNG)
+
+#define CACHE_NONE  0xffffffffu
+
+/* -------------------------------------------------------------------------
+ * Structs
+ * ------------------------------------------------------------------------- */
+
+typedef enum {
+    DIR_FIXED,
+    DIR_SCALABLE,
+    DIR_THRESHOLD,
+    DIR_UNTHEMED,
+} DirType;
+
+typedef struct {
+    char    *path;        /* absolute, no trailing slash */
+    guint    rank;        /* position of its theme in the chain */
+    DirType  type;
+    int      size;
+    int      min_size;
+    int      max_size;
+    int      threshold;
+} IconDir;
+
+typedef struct {
+    guint32  dir;
+    guint32  flags;
+} IconHit;
+
+struct _IconThemeIndex {
+    char         *theme;
+    GPtrArray    *dirs;      /* IconDir*, in lookup order */
+    GStringChunk *names;
+    GHashTable   *icons;     /* name (in names) -> GArray<IconHit> */
+};
+
+/* -------------------------------------------------------------------------
+ * Helpers
+ * ------------------------------------------------------------------------- */
+
+static void
+icon_dir_free (gpointer data)
+{
+    IconDir *d = data;
+    g_free (d->path);
+    g_free (d);
+}
+
+static void
+add_hit (IconThemeIndex *idx, const char *name, guint32 dir, guint32 flags)
+{
+    GArray *hits = g_hash_table_lookup (idx->icons, name);
+    if (!hits) {
+        hits = g_array_new (FALSE, FALSE, sizeof (IconHit));
+        g_hash_table_insert (idx->icons,
+                             g_string_chunk_insert_const (idx->names, name),
+                             hits);
+    }
+
+    /* foo.png and foo.svg in one directory */
+    if (hits->len > 0) {
+        IconHit *last = &g_array_index (hits, IconHit, hits->len - 1);
+        if (last->dir == dir) { last->flags |= flags; return; }
+    }
+
+    IconHit h = { dir, flags };
+    g_array_append_val (hits, h);
+}
+
+static GPtrArray *
+icon_base_dirs (const char *leaf)
+{
+    GPtrArray *dirs = g_ptr_array_new_with_free_func (g_free);
+
+    if (g_strcmp0 (leaf, "icons") == 0) {
+        g_ptr_array_add (dirs, g_build_filename (g_get_user_data_dir (), "icons", NULL));
+        g_ptr_array_add (dirs, g_build_filename (g_get_home_dir (), ".icons", NULL));
+    }
+
+    const char * const *sys = g_get_system_data_dirs ();
+    for (int i = 0; sys[i]; i++)
+        g_ptr_array_add (dirs, g_build_filename (sys[i], leaf, NULL));
+
+    return dirs;
+}
+
+static gint64
+path_mtime (const char *path)
+{
+    GStatBuf st;
+    if (g_stat (path, &st) != 0) return -1;
+    return (gint64) st.st_mtime;
+}
+
+/* -------------------------------------------------------------------------
+ * Directory listing (no cache, or a stale one)
+ * ------------------------------------------------------------------------- */
+
+static void
+scan_dir (IconThemeIndex *idx, guint32 dir_id)
+{
+    const IconDir *d   = g_ptr_array_index (idx->dirs, dir_id);
+    GDir          *dir = g_dir_open (d->path, 0, NULL);
+    if (!dir) return;
+
+    const char *file;
+    while ((file = g_dir_read_name (dir))) {
+        const char *dot = strrchr (file, '.');
+        if (!dot || dot == file) continue;
+
+        guint32 flags;
+        if      (strcmp (dot, ".png") == 0) flags = HAS_PNG;
+        else if (strcmp (dot, ".svg") == 0) flags = HAS_SVG;
+        else if (strcmp (dot, ".xpm") == 0) flags = HAS_XPM;
+        else continue;
+
+        char *name = g_strndup (file, (gsize) (dot - file));
+        add_hit (idx, name, dir_id, flags);
+        g_free (name);
+    }
+
+    g_dir_close (dir);
+}
+
+/* -------------------------------------------------------------------------
+ * icon-theme.cache (GTK format, big endian)
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    const guint8 *data;
+    gsize         len;
+} CacheView;
+
+static gboolean
+cache_u16 (const CacheView *c, guint32 off, guint32 *out)
+{
+    if ((gsize) off + 2 > c->len) return FALSE;
+    *out = ((guint32) c->data[off] << 8) | c->data[off + 1];
+    return TRUE;
+}
+
+static gboolean
+cache_u32 (const CacheView *c, guint32 off, guint32 *out)
+{
+    if ((gsize) off + 4 > c->len) return FALSE;
+    *out = ((guint32) c->data[off]     << 24) | ((guint32) c->data[off + 1] << 16) |
+           ((guint32) c->data[off + 2] <<  8) |  (guint32) c->data[off + 3];
+    return TRUE;
+}
+
+static const char *
+cache_str (const CacheView *c, guint32 off)
+{
+    if (off >= c->len) return NULL;
+    if (!memchr (c->data + off, '\0', c->len - off)) return NULL;
+    return (const char *) c->data + off;
+}
+
+/*
+ * Adds every icon listed in @cache_path. @subdirs maps a subdir name
+ * (as in index.theme) to its dir id + 1. Returns FALSE if the file is
+ * unusable, in which case the caller lists the directories instead.
+ */
+static gboolean
+load_cache (IconThemeIndex *idx, const char *cache_path, GHashTable *subdirs)
+{
+    GMappedFile *mapped = g_mapped_file_new (cache_path, FALSE, NULL);
+    if (!mapped) return FALSE;
+
+    CacheView c = {
+        (const guint8 *) g_mapped_file_get_contents (mapped),
+        g_mapped_file_get_length (mapped),
+    };
+
+    guint32 major, minor, hash_off, dirs_off, n_dirs, n_buckets;
+    gboolean ok = c.data &&
+                  cache_u16 (&c, 0, &major) && cache_u16 (&c, 2, &minor) &&
+                  major == 1 && minor == 0 &&
+                  cache_u32 (&c, 4, &hash_off) && cache_u32 (&c, 8, &dirs_off) &&
+                  cache_u32 (&c, dirs_off, &n_dirs) &&
+                  cache_u32 (&c, hash_off, &n_buckets) &&
+                  n_dirs <= c.len / 4 && n_buckets <= c.len / 4;
+    if (!ok) {
+        g_mapped_file_unref (mapped);
+        return FALSE;
+    }
+
+    /* Cache directory index -> our dir id (CACHE_NONE if not listed) */
+    guint32 *dir_map = g_new (guint32, n_dirs ? n_dirs : 1);
+    for (guint32 i = 0; i < n_dirs; i++) {
+        guint32     off;
+        const char *name = cache_u32 (&c, dirs_off + 4 + 4 * i, &off)
+                           ? cache_str (&c, off) : NULL;
+        gpointer    id   = name ? g_hash_table_lookup (subdirs, name) : NULL;
+        dir_map[i] = id ? GPOINTER_TO_UINT (id) - 1 : CACHE_NONE;
+    }
+
+    for (guint32 b = 0; ok && b < n_buckets; b++) {
+        guint32 icon;
+        if (!cache_u32 (&c, hash_off + 4 + 4 * b, &icon)) { ok = FALSE; break; }
+
+        /* Chains are acyclic in a well-formed cache; bound them anyway */
+        for (guint32 steps = 0; icon != CACHE_NONE && steps < c.len / 12; steps++) {
+            guint32 next, name_off, list_off, n_images;
+            if (!cache_u32 (&c, icon,     &next)     ||
+                !cache_u32 (&c, icon + 4, &name_off) ||
+                !cache_u32 (&c, icon + 8, &list_off) ||
+                !cache_u32 (&c, list_off, &n_images)) { ok = FALSE; break; }
+
+            const char *name = cache_str (&c, name_off);
+            for (guint32 i = 0; name && i < n_images; i++) {
+                guint32 dir, flags;
+                if (!cache_u16 (&c, list_off + 4 + 8 * i,     &dir) ||
+                    !cache_u16 (&c, list_off + 4 + 8 * i + 2, &flags)) {
+                    ok = FALSE;
+                    break;
+                }
+                if (dir < n_dirs && dir_map[dir] != CACHE_NONE && (flags & HAS_ANY))
+                    add_hit (idx, name, dir_map[dir], flags & HAS_ANY);
+            }
+            icon = next;
+        }
+    }
+
+    g_free (dir_map);
+    g_mapped_file_unref (mapped);
+    return ok;
+}
+
+/* -------------------------------------------------------------------------
+ * Theme chain
+ * ------------------------------------------------------------------------- */
+
+/* index.theme of the first base dir that has @theme */
+static GKeyFile *
+load_theme_index (GPtrArray *bases, const char *theme)
+{
+    for (guint i = 0; i < bases->len; i++) {
+        char     *path = g_build_filename (g_ptr_array_index (bases, i),
+                                           theme, "index.theme", NULL);
+        GKeyFile *kf   = g_key_file_new ();
+        g_key_file_set_list_separator (kf, ',');  /* Directories=a,b */
+        gboolean  ok   = g_key_file_load_from_file (kf, path, G_KEY_FILE_NONE, NULL);
+        g_free (path);
+        if (ok && g_key_file_has_group (kf, "Icon Theme")) return kf;
+        g_key_file_free (kf);
+    }
+    return NULL;
+}
+
+/* Theme, its Inherits depth first, then hicolor */
+static void
+collect_chain (GPtrArray *bases, const char *theme, GPtrArray *chain,
+               GPtrArray *indexes)
+{
+    for (guint i = 0; i < chain->len; i++)
+        if (strcmp (g_ptr_array_index (chain, i), theme) == 0) return;
+
+    GKeyFile *kf = load_theme_index (bases, theme);
+    if (!kf) return;
+
+    g_ptr_array_add (chain, g_strdup (theme));
+    g_ptr_array_add (indexes, kf);
+
+    char **inherits = g_key_file_get_string_list (kf, "Icon Theme", "Inherits",
+                                                  NULL, NULL);
+    for (int i = 0; inherits && inherits[i]; i++)
+        collect_chain (bases, g_strstrip (inherits[i]), chain, indexes);
+    g_strfreev (inherits);
+}
+
+static int
+key_int (GKeyFile *kf, const char *group, const char *key, int fallback)
+{
+    GError *err = NULL;
+    int     v   = g_key_file_get_integer (kf, group, key, &err);
+    if (err) { g_error_free (err); return fallback; }
+    return v;
+}
+
+static void
+add_theme (IconThemeIndex *idx, GPtrArray *bases, const char *theme,
+           GKeyFile *kf, guint rank)
+{
+    char **subdirs = g_key_file_get_string_list (kf, "Icon Theme", "Directories",
+                                                 NULL, NULL);
+    if (!subdirs) return;
+
+    for (guint b = 0; b < bases->len; b++) {
+        char *root = g_build_filename (g_ptr_array_index (bases, b), theme, NULL);
+        if (!g_file_test (root, G_FILE_TEST_IS_DIR)) { g_free (root); continue; }
+
+        GHashTable *by_name = g_hash_table_new (g_str_hash, g_str_equal);
+        guint       first   = idx->dirs->len;
+
+        for (int i = 0; subdirs[i]; i++) {
+            const char *sub = subdirs[i];
+            int size = key_int (kf, sub, "Size", 0);
+
+            /* HiDPI variants are for other scales */
+            if (size <= 0 || key_int (kf, sub, "Scale", 1) != 1) continue;
+
+            char *path = g_build_filename (root, sub, NULL);
+            if (!g_file_test (path, G_FILE_TEST_IS_DIR)) { g_free (path); continue; }
+
+            IconDir *d   = g_new0 (IconDir, 1);
+            d->path      = path;
+            d->rank      = rank;
+            d->size      = size;
+            d->min_size  = key_int (kf, sub, "MinSize", size);
+            d->max_size  = key_int (kf, sub, "MaxSize", size);
+            d->threshold = key_int (kf, sub, "Threshold", 2);
+
+            char *type = g_key_file_get_string (kf, sub, "Type", NULL);
+            if      (g_strcmp0 (type, "Fixed")    == 0) d->type = DIR_FIXED;
+            else if (g_strcmp0 (type, "Scalable") == 0) d->type = DIR_SCALABLE;
+            else                                        d->type = DIR_THRESHOLD;
+            g_free (type);
+
+            g_hash_table_insert (by_name, (gpointer) sub,
+                                 GUINT_TO_POINTER (idx->dirs->len + 1));
+            g_ptr_array_add (idx->dirs, d);
+        }
+
+        /* Like GTK: the cache is trusted only if it is not older than the theme dir */
+        char    *cache_path = g_build_filename (root, "icon-theme.cache", NULL);
+        gint64   cache_time = path_mtime (cache_path);
+        gboolean cached     = cache_time >= 0 && cache_time >= path_mtime (root) &&
+                              load_cache (idx, cache_path, by_name);
+        if (!cached)
+            for (guint d = first; d < idx->dirs->len; d++)
+                scan_dir (idx, d);
+
+        g_free (cache_path);
+        g_hash_table_destroy (by_name);
+        g_free (root);
+    }
+
+    g_strfreev (subdirs);
+}
+
+static void
+add_unthemed (IconThemeIndex *idx, guint rank)
+{
+    GPtrArray *bases = icon_base_dirs ("pixmaps");
+
+    for (guint b = 0; b < bases->len; b++) {
+        const char *path = g_ptr_array_index (bases, b);
+        if (!g_file_test (path, G_FILE_TEST_IS_DIR)) continue;
+
+        IconDir *d = g_new0 (IconDir, 1);
+        d->path    = g_strdup (path);
+        d->rank    = rank;
+        d->type    = DIR_UNTHEMED;
+        g_ptr_array_add (idx->dirs, d);
+        scan_dir (idx, idx->dirs->len - 1);
+    }
+
+    g_ptr_array_unref (bases);
+}
+
+/* -------------------------------------------------------------------------
+ * Size matching (icon theme spec)
+ * ------------------------------------------------------------------------- */
+
+static int
+dir_distance (const IconDir *d, int size)
+{
+    int lo, hi;
+
+    switch (d->type) {
+    case DIR_FIXED:     lo = hi = d->size;                                     break;
+    case DIR_SCALABLE:  lo = d->min_size; hi = d->max_size;                    break;
+    case DIR_THRESHOLD: lo = d->size - d->threshold; hi = d->size + d->threshold; break;
+    default:            return G_MAXINT / 2;   /* any size, but last resort */
+    }
+
+    if (size < lo) return lo - size;
+    if (size > hi) return size - hi;
+    return 0;
+}
+
+static char *
+hit_path (const IconThemeIndex *idx, const char *name, const IconHit *hit)
+{
+    const IconDir *d = g_ptr_array_index (idx->dirs, hit->dir);
+
+    /* Bitmaps at their own size beat scaled SVGs, as in GTK */
+    const char *ext = (hit->flags & HAS_PNG) ? ".png" :
+                      (hit->flags & HAS_SVG) ? ".svg" : ".xpm";
+    char *file = g_strconcat (name, ext, NULL);
+    char *path = g_build_filename (d->path, file, NULL);
+    g_free (file);
+    return path;
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+IconThemeIndex *
+icon_theme_index_new (const char *theme_name)
+{
+    IconThemeIndex *idx = g_atomic_rc_box_new0 (IconThemeIndex);
+    idx->theme = g_strdup (theme_name && *theme_name ? theme_name : "hicolor");
+    idx->dirs  = g_ptr_array_new_with_free_func (icon_dir_free);
+    idx->names = g_string_chunk_new (64 * 1024);
+    idx->icons = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                        (GDestroyNotify) g_array_unref);
+
+    GPtrArray *bases   = icon_base_dirs ("icons");
+    GPtrArray *chain   = g_ptr_array_new_with_free_func (g_free);
+    GPtrArray *indexes = g_ptr_array_new_with_free_func (
+        (GDestroyNotify) g_key_file_free);
+
+    collect_chain (bases, idx->theme, chain, indexes);
+    collect_chain (bases, "hicolor", chain, indexes);
+
+    for (guint i = 0; i < chain->len; i++)
+        add_theme (idx, bases, g_ptr_array_index (chain, i),
+                   g_ptr_array_index (indexes, i), i);
+    add_unthemed (idx, chain->len);
+
+    g_ptr_array_unref (indexes);
+    g_ptr_array_unref (chain);
+    g_ptr_array_unref (bases);
+    return idx;
+}
+
+IconThemeIndex *
+icon_theme_index_ref (IconThemeIndex *index)
+{
+    g_return_val_if_fail (index != NULL, NULL);
+    return g_atomic_rc_box_acquire (index);
+}
+
+static void
+index_clear (gpointer data)
+{
+    IconThemeIndex *idx = data;
+    g_hash_table_destroy (idx->icons);
+    g_string_chunk_free (idx->names);
+    g_ptr_array_unref (idx->dirs);
+    g_free (idx->theme);
+}
+
+void
+icon_theme_index_unref (IconThemeIndex *index)
+{
+    if (!index) return;
+    g_atomic_rc_box_release_full (index, index_clear);
+}
+
+const char *
+icon_theme_index_get_theme (const IconThemeIndex *index)
+{
+    g_return_val_if_fail (index != NULL, NULL);
+    return index->theme;
+}
+
+char *
+icon_theme_index_lookup (const IconThemeIndex *index,
+                         const char           *icon_name,
+                         int                   size)
+{
+    g_return_val_if_fail (index != NULL, NULL);
+    if (!icon_name || *icon_name == '\0') return NULL;
+
+    GArray *hits = g_hash_table_lookup (index->icons, icon_name);
+    if (!hits) return NULL;
+
+    /*
+     * Hits are grouped by theme in chain order (a cache lists dirs in
+     * any order within one theme): the closest directory of the first
+     * theme that has the icon wins, earlier directories on ties.
+     */
+    const IconHit *best      = NULL;
+    int            best_dist = G_MAXINT;
+    guint          best_rank = 0;
+
+    for (guint i = 0; i < hits->len; i++) {
+        const IconHit *h = &g_array_index (hits, IconHit, i);
+        const IconDir *d = g_ptr_array_index (index->dirs, h->dir);
+
+        if (best && d->rank != best_rank) break;
+
+        int dist = dir_distance (d, size);
+        if (dist < best_dist || (dist == best_dist && h->dir < best->dir)) {
+            best      = h;
+            best_dist = dist;
+            best_rank = d->rank;
+        }
+    }
+
+    return best ? hit_path (index, icon_name, best) : NULL;
+}
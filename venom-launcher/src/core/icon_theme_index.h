@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glib.h>
+
+/**
+ * IconThemeIndex - Immutable name → file index of an icon theme chain.
+ *
+ * Built from the theme's index.theme (following Inherits, then hicolor)
+ * across the XDG icon directories, plus the unthemed pixmaps dirs.
+ * Each theme directory is enumerated from its icon-theme.cache when
+ * that is up to date, else by listing the directory.
+ *
+ * Lookup follows the icon theme spec (exact size match, else closest
+ * directory in the first theme that has the icon), for scale 1 only.
+ *
+ * Once built the index never changes, so it can be shared between
+ * threads; it is reference counted (atomically).
+ */
+
+typedef struct _IconThemeIndex IconThemeIndex;
+
+/* Blocking build — call from a worker thread. Never NULL. */
+IconThemeIndex *icon_theme_index_new       (const char           *theme_name);
+IconThemeIndex *icon_theme_index_ref       (IconThemeIndex       *index);
+void            icon_theme_index_unref     (IconThemeIndex       *index);
+
+const char     *icon_theme_index_get_theme (const IconThemeIndex *index);
+
+/* Returns the file for @icon_name at @size pixels (newly allocated), or NULL */
+char           *icon_theme_index_lookup    (const IconThemeIndex *index,
+                                            const char           *icon_name,
+                                            int                   size);
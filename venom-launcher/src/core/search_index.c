@@ -0,0 +1,851 @@
+#include "search_index.h"
+#include "fuzzy_match.h"
+#include "usage_store.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Separates fields in SearchDoc.text; never part of a trigram */
+#define FIELD_SEP  '\x1f'
+
+/* Usage bias: USAGE_WEIGHT * log2 (1 + frecency), added to fuzzy scores */
+#define USAGE_WEIGHT     8.0
+/* Minimum bias to be listed first with no query (~1 launch last week) */
+#define FREQUENT_MIN     4
+/* Result sets of shorter queries kept for backspace */
+#define HISTORY_DEPTH    16
+
+typedef struct {
+    AppEntry *entry;   /* NULL once removed */
+    char     *text;    /* casefolded fields joined by FIELD_SEP */
+} SearchDoc;
+
+/* An earlier query and its results, restored on backspace */
+typedef struct {
+    char   *query;
+    GArray *cands;
+    GArray *hits;
+} QueryState;
+
+struct _SearchIndex {
+    GArray     *docs;       /* SearchDoc, indexed by AppEntry.index_id */
+    GHashTable *postings;   /* trigram key -> GArray<guint32> (sorted) */
+    char       *query;      /* casefolded active query, NULL = all */
+    GArray     *hits;       /* guint64 bitset over doc slots */
+
+    /*
+     * Slots matching the active query by substring or fuzzy name match,
+     * ascending.  A query that extends the active one only re-tests
+     * these; @history holds the states of its shorter prefixes.
+     */
+    GArray     *cands;      /* guint32 */
+    GPtrArray  *history;    /* QueryState*, oldest first */
+
+    /* Categories, interned to ids, each with a bitset over doc slots */
+    GHashTable *category_ids;    /* name -> GUINT_TO_POINTER (id + 1) */
+    GPtrArray  *category_names;  /* char*, by id */
+    GPtrArray  *category_sets;   /* GArray<guint64>, by id */
+    gint        category;        /* active filter, -1 = none */
+    GArray     *visible;         /* guint64: hits AND the active category */
+
+    /* Fuzzy name ranking */
+    GArray     *names;      /* FuzzySlot, parallel to docs */
+    GArray     *bloom_sets[64];  /* guint64 bitset of slots per FuzzySlot.bloom bit */
+    FuzzyQuery *fuzzy;      /* compiled active query, NULL = none */
+    GArray     *ranked;     /* FuzzyHit scratch */
+    GArray     *seen;       /* guint64 bitset: slots already collected */
+
+    /* Frecency */
+    GArray     *bias;       /* gint, parallel to docs */
+    guint       bias_gen;   /* UsageStore generation of @bias */
+
+    /* Per-query scratch, reused to keep queries allocation-free */
+    GPtrArray  *lists;
+    GArray     *cand_a;
+    GArray     *cand_b;
+};
+
+/* -------------------------------------------------------------------------
+ * Helpers
+ * ------------------------------------------------------------------------- */
+
+static inline guint32
+trigram_key (const char *p)
+{
+    return ((guint32) (guchar) p[0] << 16) |
+           ((guint32) (guchar) p[1] <<  8) |
+            (guint32) (guchar) p[2];
+}
+
+static inline gboolean
+trigram_valid (const char *p)
+{
+    return p[0] != FIELD_SEP && p[1] != FIELD_SEP && p[2] != FIELD_SEP;
+}
+
+static char *
+build_text (const AppEntry *e)
+{
+    const char *fields[] = {
+        e->name, e->generic_name, e->comment, e->keywords, e->categories,
+    };
+
+    GString *s = g_string_new (NULL);
+    for (guint i = 0; i < G_N_ELEMENTS (fields); i++) {
+        if (!fields[i]) continue;
+        char *folded = g_utf8_casefold (fields[i], -1);
+        if (s->len) g_string_append_c (s, FIELD_SEP);
+        g_string_append (s, folded);
+        g_free (folded);
+    }
+    return g_string_free (s, FALSE);
+}
+
+static void
+hits_set (SearchIndex *idx, guint32 id)
+{
+    g_array_index (idx->hits, guint64, id / 64) |= (guint64) 1 << (id % 64);
+}
+
+static void
+hits_clear (SearchIndex *idx, guint32 id)
+{
+    if (id / 64 < idx->hits->len)
+        g_array_index (idx->hits, guint64, id / 64) &= ~((guint64) 1 << (id % 64));
+}
+
+static inline gboolean
+bit_get (GArray *set, guint32 id)
+{
+    return id / 64 < set->len &&
+           ((g_array_index (set, guint64, id / 64) >> (id % 64)) & 1);
+}
+
+static void
+bit_set (GArray *set, guint32 id)
+{
+    if (id / 64 >= set->len) g_array_set_size (set, id / 64 + 1);
+    g_array_index (set, guint64, id / 64) |= (guint64) 1 << (id % 64);
+}
+
+static void
+bit_clear (GArray *set, guint32 id)
+{
+    if (id / 64 < set->len)
+        g_array_index (set, guint64, id / 64) &= ~((guint64) 1 << (id % 64));
+}
+
+static GArray *
+active_category (SearchIndex *idx)
+{
+    return idx->category >= 0
+         ? g_ptr_array_index (idx->category_sets, idx->category)
+         : NULL;
+}
+
+/* visible = hits & category, a word at a time */
+static void
+update_visible (SearchIndex *idx)
+{
+    GArray *cat   = active_category (idx);
+    guint   words = idx->hits->len;
+
+    g_array_set_size (idx->visible, words);
+    for (guint w = 0; w < words; w++) {
+        guint64 mask = !cat ? ~(guint64) 0
+                     : w < cat->len ? g_array_index (cat, guint64, w) : 0;
+        g_array_index (idx->visible, guint64, w) =
+            g_array_index (idx->hits, guint64, w) & mask;
+    }
+}
+
+/* Same for one slot whose hit bit just changed */
+static void
+update_visible_bit (SearchIndex *idx, guint32 id)
+{
+    GArray *cat = active_category (idx);
+    if (bit_get (idx->hits, id) && (!cat || bit_get (cat, id)))
+        bit_set (idx->visible, id);
+    else
+        bit_clear (idx->visible, id);
+}
+
+static guint
+intern_category (SearchIndex *idx, const char *name)
+{
+    gpointer v = g_hash_table_lookup (idx->category_ids, name);
+    if (v) return GPOINTER_TO_UINT (v) - 1;
+
+    guint id   = idx->category_names->len;
+    char *copy = g_strdup (name);
+    g_ptr_array_add (idx->category_names, copy);
+    g_ptr_array_add (idx->category_sets, g_array_new (FALSE, TRUE, sizeof (guint64)));
+    g_hash_table_insert (idx->category_ids, copy, GUINT_TO_POINTER (id + 1));
+    return id;
+}
+
+static void
+add_categories (SearchIndex *idx, const AppEntry *e, guint32 id)
+{
+    if (!e->categories) return;
+
+    char **names = g_strsplit (e->categories, ";", -1);
+    for (char **n = names; *n; n++) {
+        if (!**n) continue;
+        /* Intern first: it may grow category_sets */
+        guint c = intern_category (idx, *n);
+        bit_set (g_ptr_array_index (idx->category_sets, c), id);
+    }
+    g_strfreev (names);
+}
+
+static void
+hits_reset (SearchIndex *idx)
+{
+    guint words = (idx->docs->len + 63) / 64;
+    g_array_set_size (idx->hits, words);
+    if (words)
+        memset (idx->hits->data, 0, words * sizeof (guint64));
+}
+
+static gboolean
+doc_matches (SearchIndex *idx, const SearchDoc *doc)
+{
+    if (!doc->entry) return FALSE;
+    return !idx->query || strstr (doc->text, idx->query) != NULL;
+}
+
+/* First position in @list whose value is >= @id, searching from @from */
+static guint
+lower_bound (GArray *list, guint from, guint32 id)
+{
+    guint lo = from, hi = list->len;
+    while (lo < hi) {
+        guint mid = (lo + hi) / 2;
+        if (g_array_index (list, guint32, mid) < id) lo = mid + 1;
+        else                                         hi = mid;
+    }
+    return lo;
+}
+
+static gint
+compare_list_len (gconstpointer a, gconstpointer b)
+{
+    const GArray *la = *(GArray * const *) a;
+    const GArray *lb = *(GArray * const *) b;
+    return (la->len > lb->len) - (la->len < lb->len);
+}
+
+/* Intersect sorted @a with sorted @b into @out */
+static void
+intersect (GArray *a, GArray *b, GArray *out)
+{
+    g_array_set_size (out, 0);
+
+    guint pos = 0;
+    for (guint i = 0; i < a->len && pos < b->len; i++) {
+        guint32 id = g_array_index (a, guint32, i);
+        pos = lower_bound (b, pos, id);
+        if (pos < b->len && g_array_index (b, guint32, pos) == id)
+            g_array_append_val (out, id);
+    }
+}
+
+static void
+compute_hits (SearchIndex *idx)
+{
+    hits_reset (idx);
+
+    const char *q   = idx->query;
+    gsize       len = q ? strlen (q) : 0;
+
+    /* Empty or too short for a trigram: scan the folded text */
+    if (len < 3) {
+        for (guint i = 0; i < idx->docs->len; i++)
+            if (doc_matches (idx, &g_array_index (idx->docs, SearchDoc, i)))
+                hits_set (idx, i);
+        return;
+    }
+
+    /* Gather posting lists; any missing trigram means no result */
+    g_ptr_array_set_size (idx->lists, 0);
+    for (gsize i = 0; i + 3 <= len; i++) {
+        GArray *list = g_hash_table_lookup (
+            idx->postings, GUINT_TO_POINTER (trigram_key (q + i)));
+        if (!list || list->len == 0) return;
+        if (!g_ptr_array_find (idx->lists, list, NULL))
+            g_ptr_array_add (idx->lists, list);
+    }
+
+    /* Shortest list first keeps the candidate set minimal */
+    g_ptr_array_sort (idx->lists, compare_list_len);
+
+    GArray *first = g_ptr_array_index (idx->lists, 0);
+    g_array_set_size (idx->cand_a, 0);
+    g_array_append_vals (idx->cand_a, first->data, first->len);
+
+    for (guint i = 1; i < idx->lists->len && idx->cand_a->len > 0; i++) {
+        intersect (idx->cand_a, g_ptr_array_index (idx->lists, i), idx->cand_b);
+        GArray *tmp = idx->cand_a;
+        idx->cand_a = idx->cand_b;
+        idx->cand_b = tmp;
+    }
+
+    /* Trigram hits are necessary but not sufficient — verify */
+    for (guint i = 0; i < idx->cand_a->len; i++) {
+        guint32 id = g_array_index (idx->cand_a, guint32, i);
+        if (doc_matches (idx, &g_array_index (idx->docs, SearchDoc, id)))
+            hits_set (idx, id);
+    }
+}
+
+static gboolean
+fuzzy_matches (SearchIndex *idx, guint32 id)
+{
+    return idx->fuzzy &&
+           fuzzy_score (idx->fuzzy, &g_array_index (idx->names, FuzzySlot, id), NULL);
+}
+
+/* Names that may fuzzy-match in word @w of the slot bitsets: all of them
+ * for a query shorter than a trigram, else those whose bloom covers it */
+static guint64
+fuzzy_maybe (SearchIndex *idx, guint64 bloom, gboolean scan_all, guint w)
+{
+    if (!idx->fuzzy) return 0;
+    if (scan_all)    return ~(guint64) 0;
+
+    guint64 maybe = ~(guint64) 0;
+    for (guint64 bits = bloom; bits && maybe; bits &= bits - 1) {
+        GArray *set = idx->bloom_sets[__builtin_ctzll (bits)];
+        maybe &= w < set->len ? g_array_index (set, guint64, w) : 0;
+    }
+    return maybe;
+}
+
+/*
+ * Fresh query: candidates are all substring hits plus fuzzy name matches.
+ * Only the hits and the names passing the bloom test are scored.
+ */
+static void
+compute_cands (SearchIndex *idx)
+{
+    g_array_set_size (idx->cands, 0);
+    if (!idx->query) return;
+
+    guint64  bloom    = idx->fuzzy ? fuzzy_query_get_bloom (idx->fuzzy) : 0;
+    gboolean scan_all = strlen (idx->query) < 3;
+
+    for (guint w = 0; w < idx->hits->len; w++) {
+        guint64 hits  = g_array_index (idx->hits, guint64, w);
+        guint64 maybe = fuzzy_maybe (idx, bloom, scan_all, w) & ~hits;
+
+        for (guint64 bits = hits | maybe; bits; bits &= bits - 1) {
+            guint32 id = w * 64 + (guint32) __builtin_ctzll (bits);
+            if (id >= idx->docs->len) break;
+            if (((hits >> (id % 64)) & 1) || fuzzy_matches (idx, id))
+                g_array_append_val (idx->cands, id);
+        }
+    }
+}
+
+/*
+ * The query grew at the end: anything matching it matched the shorter
+ * query too (substring and subsequence both), so only @prev is tested.
+ */
+static void
+refine (SearchIndex *idx, GArray *prev)
+{
+    hits_reset (idx);
+    g_array_set_size (idx->cands, 0);
+
+    for (guint i = 0; i < prev->len; i++) {
+        guint32          id  = g_array_index (prev, guint32, i);
+        const SearchDoc *doc = &g_array_index (idx->docs, SearchDoc, id);
+        if (!doc->entry) continue;
+
+        gboolean hit = strstr (doc->text, idx->query) != NULL;
+        if (hit) hits_set (idx, id);
+        if (hit || fuzzy_matches (idx, id))
+            g_array_append_val (idx->cands, id);
+    }
+}
+
+static void
+query_state_free (gpointer data)
+{
+    QueryState *st = data;
+    g_free (st->query);
+    g_array_unref (st->cands);
+    g_array_unref (st->hits);
+    g_free (st);
+}
+
+/* Moves the active query's results onto the history stack */
+static void
+history_push (SearchIndex *idx)
+{
+    if (idx->history->len == HISTORY_DEPTH)
+        g_ptr_array_remove_index (idx->history, 0);
+
+    QueryState *st = g_new (QueryState, 1);
+    st->query = idx->query;
+    st->cands = idx->cands;
+    st->hits  = idx->hits;
+    g_ptr_array_add (idx->history, st);
+
+    idx->query = NULL;
+    idx->cands = g_array_new (FALSE, FALSE, sizeof (guint32));
+    idx->hits  = g_array_new (FALSE, TRUE, sizeof (guint64));
+}
+
+/* Position of @query in the history, or -1 */
+static gint
+history_find (SearchIndex *idx, const char *query)
+{
+    for (guint i = idx->history->len; i-- > 0; )
+        if (strcmp (((QueryState *) g_ptr_array_index (idx->history, i))->query,
+                    query) == 0)
+            return (gint) i;
+    return -1;
+}
+
+/* Makes history entry @pos the active state, dropping everything newer */
+static void
+history_restore (SearchIndex *idx, guint pos)
+{
+    QueryState *st = g_ptr_array_steal_index (idx->history, pos);
+    g_ptr_array_set_size (idx->history, pos);
+
+    g_free (idx->query);
+    g_array_unref (idx->cands);
+    g_array_unref (idx->hits);
+    idx->query = st->query;
+    idx->cands = st->cands;
+    idx->hits  = st->hits;
+    g_free (st);
+}
+
+/* Covers slots added since @hits was sized */
+static void
+hits_fit (SearchIndex *idx)
+{
+    if (idx->hits->len * 64 < idx->docs->len)
+        g_array_set_size (idx->hits, (idx->docs->len + 63) / 64);
+}
+
+static gint
+usage_bias (const AppEntry *e)
+{
+    gdouble score = usage_store_get_score (usage_store_get (), e->desktop_path);
+    return (gint) lround (USAGE_WEIGHT * log2 (1.0 + score));
+}
+
+static inline gint
+doc_bias (SearchIndex *idx, const AppEntry *e)
+{
+    return g_array_index (idx->bias, gint, e->index_id);
+}
+
+static void
+refresh_bias (SearchIndex *idx)
+{
+    guint gen = usage_store_get_generation (usage_store_get ());
+    if (gen == idx->bias_gen) return;
+    idx->bias_gen = gen;
+
+    for (guint i = 0; i < idx->docs->len; i++) {
+        const SearchDoc *doc = &g_array_index (idx->docs, SearchDoc, i);
+        if (doc->entry)
+            g_array_index (idx->bias, gint, i) = usage_bias (doc->entry);
+    }
+}
+
+static gint
+compare_bias (gconstpointer a, gconstpointer b, gpointer data)
+{
+    SearchIndex *idx = data;
+    gint ba = doc_bias (idx, *(AppEntry * const *) a);
+    gint bb = doc_bias (idx, *(AppEntry * const *) b);
+    return (bb > ba) - (bb < ba);
+}
+
+static inline void
+seen_set (SearchIndex *idx, guint32 id)
+{
+    g_array_index (idx->seen, guint64, id / 64) |= (guint64) 1 << (id % 64);
+}
+
+static inline gboolean
+seen_get (SearchIndex *idx, guint32 id)
+{
+    return (g_array_index (idx->seen, guint64, id / 64) >> (id % 64)) & 1;
+}
+
+static void
+free_posting (gpointer list)
+{
+    g_array_unref (list);
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+SearchIndex *
+search_index_new (GPtrArray *apps)
+{
+    SearchIndex *idx = g_new0 (SearchIndex, 1);
+    idx->docs     = g_array_sized_new (FALSE, TRUE, sizeof (SearchDoc),
+                                       apps ? apps->len : 0);
+    idx->postings = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                           NULL, free_posting);
+    idx->hits     = g_array_new (FALSE, TRUE, sizeof (guint64));
+    idx->names    = g_array_sized_new (FALSE, TRUE, sizeof (FuzzySlot),
+                                       apps ? apps->len : 0);
+    idx->ranked   = g_array_new (FALSE, FALSE, sizeof (FuzzyHit));
+    idx->seen     = g_array_new (FALSE, TRUE, sizeof (guint64));
+    idx->bias     = g_array_new (FALSE, TRUE, sizeof (gint));
+    idx->bias_gen = usage_store_get_generation (usage_store_get ());
+    idx->lists    = g_ptr_array_new ();
+    idx->cand_a   = g_array_new (FALSE, FALSE, sizeof (guint32));
+    idx->cand_b   = g_array_new (FALSE, FALSE, sizeof (guint32));
+    idx->cands    = g_array_new (FALSE, FALSE, sizeof (guint32));
+    idx->history  = g_ptr_array_new_with_free_func (query_state_free);
+    idx->category_ids   = g_hash_table_new (g_str_hash, g_str_equal);
+    idx->category_names = g_ptr_array_new_with_free_func (g_free);
+    idx->category_sets  = g_ptr_array_new_with_free_func (free_posting);
+    idx->category       = -1;
+    idx->visible        = g_array_new (FALSE, TRUE, sizeof (guint64));
+    for (guint b = 0; b < G_N_ELEMENTS (idx->bloom_sets); b++)
+        idx->bloom_sets[b] = g_array_new (FALSE, TRUE, sizeof (guint64));
+
+    if (apps)
+        for (guint i = 0; i < apps->len; i++)
+            search_index_add (idx, g_ptr_array_index (apps, i));
+
+    return idx;
+}
+
+void
+search_index_free (SearchIndex *index)
+{
+    if (!index) return;
+
+    for (guint i = 0; i < index->docs->len; i++)
+        g_free (g_array_index (index->docs, SearchDoc, i).text);
+
+    g_array_unref (index->docs);
+    g_hash_table_destroy (index->postings);
+    g_array_unref (index->hits);
+    g_array_unref (index->names);
+    for (guint b = 0; b < G_N_ELEMENTS (index->bloom_sets); b++)
+        g_array_unref (index->bloom_sets[b]);
+    g_array_unref (index->ranked);
+    g_array_unref (index->seen);
+    g_array_unref (index->bias);
+    fuzzy_query_free (index->fuzzy);
+    g_ptr_array_unref (index->lists);
+    g_array_unref (index->cand_a);
+    g_array_unref (index->cand_b);
+    g_array_unref (index->cands);
+    g_ptr_array_unref (index->history);
+    g_hash_table_destroy (index->category_ids);
+    g_ptr_array_unref (index->category_names);
+    g_ptr_array_unref (index->category_sets);
+    g_array_unref (index->visible);
+    g_free (index->query);
+    g_free (index);
+}
+
+void
+search_index_add (SearchIndex *index, AppEntry *entry)
+{
+    g_return_if_fail (index != NULL && entry != NULL);
+
+    /* Slots are never reused, so posting lists stay sorted by append */
+    guint32   id  = index->docs->len;
+    SearchDoc doc = { entry, build_text (entry) };
+    g_array_append_val (index->docs, doc);
+    entry->index_id = id;
+
+    g_array_set_size (index->names, id + 1);
+    FuzzySlot *slot = &g_array_index (index->names, FuzzySlot, id);
+    fuzzy_slot_init (slot, entry->name);
+    for (guint64 bits = slot->bloom; bits; bits &= bits - 1)
+        bit_set (index->bloom_sets[__builtin_ctzll (bits)], id);
+
+    g_array_set_size (index->bias, id + 1);
+    g_array_index (index->bias, gint, id) = usage_bias (entry);
+
+    add_categories (index, entry, id);
+
+    gsize len = strlen (doc.text);
+    for (gsize i = 0; i + 3 <= len; i++) {
+        if (!trigram_valid (doc.text + i)) continue;
+
+        gpointer key  = GUINT_TO_POINTER (trigram_key (doc.text + i));
+        GArray  *list = g_hash_table_lookup (index->postings, key);
+        if (!list) {
+            list = g_array_sized_new (FALSE, FALSE, sizeof (guint32), 4);
+            g_hash_table_insert (index->postings, key, list);
+        }
+
+        /* Same trigram twice in one doc */
+        if (list->len && g_array_index (list, guint32, list->len - 1) == id)
+            continue;
+        g_array_append_val (list, id);
+    }
+
+    /* Keep the active result set current; older ones would miss it */
+    g_ptr_array_set_size (index->history, 0);
+    hits_fit (index);
+    gboolean hit = doc_matches (index, &doc);
+    if (hit) hits_set (index, id);
+    if (index->query && (hit || fuzzy_matches (index, id)))
+        g_array_append_val (index->cands, id);   /* @id is the largest */
+    update_visible_bit (index, id);
+}
+
+void
+search_index_remove (SearchIndex *index, AppEntry *entry)
+{
+    g_return_if_fail (index != NULL && entry != NULL);
+
+    guint32 id = entry->index_id;
+    if (id >= index->docs->len) return;
+
+    SearchDoc *doc = &g_array_index (index->docs, SearchDoc, id);
+    if (doc->entry != entry) return;
+
+    gsize len = strlen (doc->text);
+    for (gsize i = 0; i + 3 <= len; i++) {
+        if (!trigram_valid (doc->text + i)) continue;
+
+        gpointer key  = GUINT_TO_POINTER (trigram_key (doc->text + i));
+        GArray  *list = g_hash_table_lookup (index->postings, key);
+        if (!list) continue;
+
+        guint pos = lower_bound (list, 0, id);
+        if (pos < list->len && g_array_index (list, guint32, pos) == id)
+            g_array_remove_index (list, pos);
+        if (list->len == 0)
+            g_hash_table_remove (index->postings, key);
+    }
+
+    /* Saved states may still list @id; its cleared text skips it */
+    hits_clear (index, id);
+    bit_clear (index->visible, id);
+    for (guint c = 0; c < index->category_sets->len; c++)
+        bit_clear (g_ptr_array_index (index->category_sets, c), id);
+    FuzzySlot *slot = &g_array_index (index->names, FuzzySlot, id);
+    for (guint64 bits = slot->bloom; bits; bits &= bits - 1)
+        bit_clear (index->bloom_sets[__builtin_ctzll (bits)], id);
+    fuzzy_slot_init (slot, NULL);
+    g_array_index (index->bias, gint, id) = 0;
+    g_free (doc->text);
+    doc->text  = NULL;
+    doc->entry = NULL;
+}
+
+void
+search_index_set_query (SearchIndex *index, const char *query)
+{
+    g_return_if_fail (index != NULL);
+
+    char *folded = NULL;
+    if (query && *query) {
+        folded = g_utf8_casefold (query, -1);
+        if (*folded == '\0') g_clear_pointer (&folded, g_free);
+    }
+
+    if (g_strcmp0 (folded, index->query) == 0) {
+        g_free (folded);
+        return;
+    }
+
+    fuzzy_query_free (index->fuzzy);
+    index->fuzzy = folded ? fuzzy_query_new (folded) : NULL;
+
+    /* Backspace to a query we had: its results are still valid */
+    gint pos = folded ? history_find (index, folded) : -1;
+    if (pos >= 0) {
+        history_restore (index, (guint) pos);
+        hits_fit (index);
+        g_free (folded);
+    } else if (folded && index->query && g_str_has_prefix (folded, index->query)) {
+        /* One more character: filter the current results only */
+        history_push (index);
+        index->query = folded;
+        GArray *prev = ((QueryState *) g_ptr_array_index (
+            index->history, index->history->len - 1))->cands;
+        refine (index, prev);
+    } else {
+        g_ptr_array_set_size (index->history, 0);
+        g_free (index->query);
+        index->query = folded;
+        compute_hits (index);
+        compute_cands (index);
+    }
+
+    update_visible (index);
+}
+
+gint
+search_index_lookup_category (SearchIndex *index, const char *name)
+{
+    g_return_val_if_fail (index != NULL && name != NULL, -1);
+    return (gint) GPOINTER_TO_UINT (g_hash_table_lookup (index->category_ids, name)) - 1;
+}
+
+guint
+search_index_category_size (SearchIndex *index, gint category)
+{
+    g_return_val_if_fail (index != NULL, 0);
+    if (category < 0 || (guint) category >= index->category_sets->len) return 0;
+
+    GArray *set = g_ptr_array_index (index->category_sets, category);
+    guint   n   = 0;
+    for (guint w = 0; w < set->len; w++)
+        n += (guint) __builtin_popcountll (g_array_index (set, guint64, w));
+    return n;
+}
+
+void
+search_index_set_category (SearchIndex *index, gint category)
+{
+    g_return_if_fail (index != NULL);
+    if (category >= (gint) index->category_sets->len) category = -1;
+    if (category < 0) category = -1;
+    if (category == index->category) return;
+
+    index->category = category;
+    update_visible (index);
+}
+
+gint
+search_index_get_category (SearchIndex *index)
+{
+    g_return_val_if_fail (index != NULL, -1);
+    return index->category;
+}
+
+guint
+search_index_estimate (SearchIndex *index, const char *query)
+{
+    g_return_val_if_fail (index != NULL, 0);
+
+    if (!query || !*query) return index->query ? index->docs->len : 0;
+
+    char *folded = g_utf8_casefold (query, -1);
+    guint cost;
+
+    if (g_strcmp0 (folded, index->query) == 0 || history_find (index, folded) >= 0)
+        cost = 0;
+    else if (index->query && g_str_has_prefix (folded, index->query))
+        cost = index->cands->len;
+    else
+        cost = index->docs->len;
+
+    g_free (folded);
+    return cost;
+}
+
+bool
+search_index_has_query (SearchIndex *index)
+{
+    g_return_val_if_fail (index != NULL, false);
+    return index->query != NULL;
+}
+
+bool
+search_index_matches (SearchIndex *index, const AppEntry *entry)
+{
+    g_return_val_if_fail (index != NULL && entry != NULL, false);
+
+    guint32 id = entry->index_id;
+    if (id >= index->docs->len ||
+        g_array_index (index->docs, SearchDoc, id).entry != entry)
+        return false;
+
+    return bit_get (index->visible, id);
+}
+
+guint
+search_index_collect (SearchIndex *index,
+                      GPtrArray   *catalog,
+                      guint        limit,
+                      GPtrArray   *out)
+{
+    g_return_val_if_fail (index != NULL && catalog != NULL && out != NULL, 0);
+
+    refresh_bias (index);
+
+    guint words = (index->docs->len + 63) / 64;
+    g_array_set_size (index->seen, words);
+    if (words)
+        memset (index->seen->data, 0, words * sizeof (guint64));
+
+    guint head = out->len;
+
+    if (index->fuzzy) {
+        /* Ranked fuzzy name matches first, usage as a tie-breaker boost */
+        if (limit > 0) {
+            /* Every fuzzy name match is among the candidates */
+            GArray *ids = index->cands;
+            GArray *cat = active_category (index);
+            if (cat) {
+                ids = index->cand_b;   /* scratch once the query is computed */
+                g_array_set_size (ids, 0);
+                for (guint i = 0; i < index->cands->len; i++) {
+                    guint32 id = g_array_index (index->cands, guint32, i);
+                    if (bit_get (cat, id)) g_array_append_val (ids, id);
+                }
+            }
+
+            g_array_set_size (index->ranked, limit);
+            guint n = fuzzy_rank_subset (index->fuzzy,
+                                         (const FuzzySlot *) index->names->data,
+                                         (const gint *) index->bias->data,
+                                         (const guint32 *) ids->data,
+                                         ids->len, limit,
+                                         (FuzzyHit *) index->ranked->data);
+
+            for (guint i = 0; i < n; i++) {
+                guint32 id = g_array_index (index->ranked, FuzzyHit, i).index;
+                g_ptr_array_add (out, g_array_index (index->docs, SearchDoc, id).entry);
+                seen_set (index, id);
+            }
+        }
+    } else {
+        /* No query: most used apps first */
+        for (guint i = 0; i < catalog->len; i++) {
+            AppEntry *e = g_ptr_array_index (catalog, i);
+            if (doc_bias (index, e) >= FREQUENT_MIN && search_index_matches (index, e))
+                g_ptr_array_add (out, e);
+        }
+
+        /* Stable, so equal scores keep catalog order */
+        g_qsort_with_data (out->pdata + head, (gint) (out->len - head),
+                           sizeof (gpointer), compare_bias, index);
+        if (out->len - head > limit)
+            g_ptr_array_set_size (out, (gint) (head + limit));
+
+        for (guint i = head; i < out->len; i++)
+            seen_set (index, ((AppEntry *) g_ptr_array_index (out, i))->index_id);
+    }
+
+    /* Then the remaining matches, most used first, else catalog order */
+    guint tail = out->len;
+    for (guint i = 0; i < catalog->len; i++) {
+        AppEntry *e = g_ptr_array_index (catalog, i);
+        if (!search_index_matches (index, e) || seen_get (index, e->index_id))
+            continue;
+        g_ptr_array_add (out, e);
+    }
+
+    if (index->fuzzy)
+        g_qsort_with_data (out->pdata + tail, (gint) (out->len - tail),
+                           sizeof (gpointer), compare_bias, index);
+
+    return tail - head;
+}
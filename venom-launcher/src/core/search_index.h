@@ -0,0 +1,90 @@
+#pragma once
+
+#include <glib.h>
+#include <stdbool.h>
+#include "app_entry.h"
+
+/**
+ * SearchIndex - Casefolded trigram inverted index over the app catalog.
+ *
+ * Indexed fields: Name, GenericName, Comment, Keywords, Categories.
+ * Each entry gets a document slot (AppEntry.index_id); every byte
+ * trigram of its casefolded text maps to a sorted posting list of slots.
+ *
+ * A query intersects the posting lists of its trigrams and verifies the
+ * surviving candidates with a substring test on the pre-casefolded text,
+ * so results match the old per-field str_contains_icase() semantics.
+ * Queries shorter than a trigram fall back to scanning the casefolded
+ * text, which needs no allocation either.
+ *
+ * Categories are interned to small ids with one bitset over the slots
+ * each; the active category is ANDed into the result set a word at a
+ * time, so switching categories never looks at strings.
+ *
+ * search_index_collect() puts the best fuzzy matches on the Name first
+ * (see FuzzyMatch), so "lo wr" finds "LibreOffice Writer" even though
+ * it is not a substring of anything.
+ *
+ * Main thread only.
+ */
+typedef struct _SearchIndex SearchIndex;
+
+SearchIndex *search_index_new    (GPtrArray   *apps);
+void         search_index_free   (SearchIndex *index);
+
+/* Incremental updates (see AppMonitor) */
+void         search_index_add    (SearchIndex *index,
+                                  AppEntry    *entry);
+void         search_index_remove (SearchIndex *index,
+                                  AppEntry    *entry);
+
+/**
+ * Sets the active query (NULL or "" = match all) and computes its
+ * result set. Cheap to call with the same query again.
+ *
+ * Typing is incremental: a query that extends the active one only
+ * re-tests the active results, and the results of its shorter prefixes
+ * are kept, so backspace restores them without searching.
+ */
+void         search_index_set_query     (SearchIndex    *index,
+                                         const char     *query);
+
+/*
+ * Number of documents search_index_set_query (@query) would have to
+ * test: 0 if its results are at hand, the active result count if it
+ * extends the active query, else the whole catalog.
+ */
+guint        search_index_estimate      (SearchIndex    *index,
+                                         const char     *query);
+
+/* Id of a desktop category such as "Development", or -1 if no app has it */
+gint         search_index_lookup_category (SearchIndex  *index,
+                                           const char   *name);
+/* Number of apps in @category */
+guint        search_index_category_size   (SearchIndex  *index,
+                                           gint          category);
+/* Restricts results to @category (-1 = all); combines with the query */
+void         search_index_set_category    (SearchIndex  *index,
+                                           gint          category);
+gint         search_index_get_category    (SearchIndex  *index);
+
+/* TRUE if @entry is in the result set of the active query and category. */
+bool         search_index_matches       (SearchIndex    *index,
+                                         const AppEntry *entry);
+
+/* TRUE if a non-empty query is active. */
+bool         search_index_has_query     (SearchIndex    *index);
+
+/**
+ * Appends the results of the active query to @out: up to @limit fuzzy
+ * Name matches, best first, then remaining substring matches.  Usage
+ * frecency (see UsageStore) boosts the ranked part and orders the rest;
+ * equal entries keep the order of @catalog.
+ * With no query, appends up to @limit frequently used apps by frecency,
+ * then the rest of @catalog.
+ * Returns the length of that leading ranked / frequent part.
+ */
+guint        search_index_collect       (SearchIndex    *index,
+                                         GPtrArray      *catalog,
+                                         guint           limit,
+                                         GPtrArray      *out);
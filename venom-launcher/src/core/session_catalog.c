@@ -0,0 +1,470 @@
+#include "session_catalog.h"
+#include "app_catalog.h"
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <locale.h>
+#include <string.h>
+
+G_STATIC_ASSERT (sizeof (SessionCatalogHeader) % 8 == 0);
+G_STATIC_ASSERT (sizeof (SessionCatalogRecord) % 8 == 0);
+
+/* -------------------------------------------------------------------------
+ * Structs
+ * ------------------------------------------------------------------------- */
+
+struct _SessionCatalog {
+    GMappedFile                *mapped;
+    const char                 *data;
+    gsize                       len;
+    const SessionCatalogHeader *header;
+    const SessionCatalogRecord *records;
+    const guint32              *by_id;
+    const char                 *strtab;
+};
+
+typedef struct {
+    GDBusConnection        *bus;
+    guint                   subscription;
+    GCancellable           *cancel;
+    SessionCatalogCallback  callback;
+    gpointer                user_data;
+} CatalogWatch;
+
+static GHashTable *watches;       /* watch id -> CatalogWatch* */
+static guint       next_watch_id;
+
+/* -------------------------------------------------------------------------
+ * Helpers
+ * ------------------------------------------------------------------------- */
+
+/* Same key as venom_catalog_locale_key() in venom-session-catalog.h */
+static char *
+locale_key (void)
+{
+    char       *languages = g_strjoinv (":", (char **) g_get_language_names ());
+    const char *collate   = setlocale (LC_COLLATE, NULL);
+    char       *key       = g_strconcat (languages, "|", collate ? collate : "C", NULL);
+    g_free (languages);
+    return key;
+}
+
+static gboolean
+offset_valid (const SessionCatalogHeader *h, guint32 off)
+{
+    return off < h->strtab_size;
+}
+
+static gboolean
+validate (const char *data, gsize len)
+{
+    if (len < sizeof (SessionCatalogHeader)) return FALSE;
+
+    const SessionCatalogHeader *h = (const SessionCatalogHeader *) data;
+    if (h->magic != SESSION_CATALOG_MAGIC || h->format != SESSION_CATALOG_FORMAT)
+        return FALSE;
+
+    guint64 rec_end = (guint64) h->records_offset +
+                      (guint64) h->n_apps * sizeof (SessionCatalogRecord);
+    guint64 ids_end = (guint64) h->by_id_offset +
+                      (guint64) h->n_apps * sizeof (guint32);
+    guint64 str_end = (guint64) h->strtab_offset + h->strtab_size;
+    if (h->records_offset % 8 != 0 || rec_end > len) return FALSE;
+    if (h->by_id_offset % 4 != 0 || ids_end > len)   return FALSE;
+    if (h->strtab_size == 0 || str_end > len)         return FALSE;
+    if (data[h->strtab_offset + h->strtab_size - 1] != '\0') return FALSE;
+    if (h->locale == 0 || !offset_valid (h, h->locale))       return FALSE;
+
+    const SessionCatalogRecord *recs =
+        (const SessionCatalogRecord *) (data + h->records_offset);
+    const guint32 *by_id = (const guint32 *) (data + h->by_id_offset);
+
+    for (guint32 i = 0; i < h->n_apps; i++) {
+        const SessionCatalogRecord *r = &recs[i];
+        if (by_id[i] >= h->n_apps)           return FALSE;
+        if (r->id == 0 || r->path == 0)      return FALSE;
+        if (!offset_valid (h, r->id)         ||
+            !offset_valid (h, r->path)       ||
+            !offset_valid (h, r->name)       ||
+            !offset_valid (h, r->exec)       ||
+            !offset_valid (h, r->icon_name)  ||
+            !offset_valid (h, r->categories) ||
+            !offset_valid (h, r->comment)    ||
+            !offset_valid (h, r->generic_name) ||
+            !offset_valid (h, r->keywords)   ||
+            !offset_valid (h, r->sort_key)   ||
+            !offset_valid (h, r->startup_wm_class))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static const char *
+get_string (SessionCatalog *c, guint32 offset)
+{
+    return offset ? c->strtab + offset : NULL;
+}
+
+static AppEntry *
+make_entry (SessionCatalog *c, const SessionCatalogRecord *rec)
+{
+    AppEntry *e = app_entry_new ();
+    e->backing      = g_mapped_file_ref (c->mapped);
+    e->name         = (char *) get_string (c, rec->name);
+    e->exec         = (char *) get_string (c, rec->exec);
+    e->icon_name    = (char *) get_string (c, rec->icon_name);
+    e->categories   = (char *) get_string (c, rec->categories);
+    e->comment      = (char *) get_string (c, rec->comment);
+    e->generic_name = (char *) get_string (c, rec->generic_name);
+    e->keywords     = (char *) get_string (c, rec->keywords);
+    e->desktop_path = (char *) get_string (c, rec->path);
+    e->sort_key     = (char *) get_string (c, rec->sort_key);
+    e->startup_wm_class = (char *) get_string (c, rec->startup_wm_class);
+    return e;
+}
+
+/* -------------------------------------------------------------------------
+ * Reader
+ * ------------------------------------------------------------------------- */
+
+char *
+session_catalog_get_path (void)
+{
+    return g_build_filename (g_get_user_runtime_dir (), "venom",
+                             "apps.catalog", NULL);
+}
+
+/* Any locale when @any_locale, e.g. to continue the version sequence */
+static SessionCatalog *
+map_snapshot (gboolean any_locale)
+{
+    char        *path   = session_catalog_get_path ();
+    GMappedFile *mapped = g_mapped_file_new (path, FALSE, NULL);
+    g_free (path);
+    if (!mapped) return NULL;
+
+    const char *data = g_mapped_file_get_contents (mapped);
+    gsize       len  = g_mapped_file_get_length (mapped);
+
+    if (!data || !validate (data, len)) {
+        g_mapped_file_unref (mapped);
+        return NULL;
+    }
+
+    const SessionCatalogHeader *h = (const SessionCatalogHeader *) data;
+
+    if (!any_locale) {
+        char    *locale  = locale_key ();
+        gboolean same_lc = strcmp (locale, data + h->strtab_offset + h->locale) == 0;
+        g_free (locale);
+        if (!same_lc) {
+            g_mapped_file_unref (mapped);
+            return NULL;
+        }
+    }
+
+    SessionCatalog *c = g_new0 (SessionCatalog, 1);
+    c->mapped  = mapped;
+    c->data    = data;
+    c->len     = len;
+    c->header  = h;
+    c->records = (const SessionCatalogRecord *) (data + h->records_offset);
+    c->by_id   = (const guint32 *) (data + h->by_id_offset);
+    c->strtab  = data + h->strtab_offset;
+    return c;
+}
+
+SessionCatalog *
+session_catalog_open (void)
+{
+    return map_snapshot (FALSE);
+}
+
+void
+session_catalog_free (SessionCatalog *catalog)
+{
+    if (!catalog) return;
+    /* Entries built from the snapshot keep their own ref on the mapping */
+    g_mapped_file_unref (catalog->mapped);
+    g_free (catalog);
+}
+
+guint32
+session_catalog_get_version (SessionCatalog *catalog)
+{
+    g_return_val_if_fail (catalog != NULL, 0);
+    return catalog->header->version;
+}
+
+guint
+session_catalog_get_n_apps (SessionCatalog *catalog)
+{
+    g_return_val_if_fail (catalog != NULL, 0);
+    return catalog->header->n_apps;
+}
+
+const char *
+session_catalog_get_id (SessionCatalog *catalog, guint index)
+{
+    g_return_val_if_fail (catalog != NULL, NULL);
+    g_return_val_if_fail (index < catalog->header->n_apps, NULL);
+    return get_string (catalog, catalog->records[index].id);
+}
+
+GPtrArray *
+session_catalog_load_apps (SessionCatalog *catalog)
+{
+    g_return_val_if_fail (catalog != NULL, NULL);
+
+    guint      n     = catalog->header->n_apps;
+    GPtrArray *loose = g_ptr_array_new_full (n, (GDestroyNotify) app_entry_free);
+    for (guint i = 0; i < n; i++)
+        g_ptr_array_add (loose, make_entry (catalog, &catalog->records[i]));
+
+    return app_catalog_pack (loose);
+}
+
+AppEntry *
+session_catalog_lookup (SessionCatalog *catalog, const char *desktop_id)
+{
+    g_return_val_if_fail (catalog != NULL, NULL);
+    g_return_val_if_fail (desktop_id != NULL, NULL);
+
+    guint lo = 0, hi = catalog->header->n_apps;
+    while (lo < hi) {
+        guint mid = (lo + hi) / 2;
+        const SessionCatalogRecord *rec = &catalog->records[catalog->by_id[mid]];
+        int r = strcmp (get_string (catalog, rec->id), desktop_id);
+        if (r == 0) return make_entry (catalog, rec);
+        if (r < 0) lo = mid + 1;
+        else       hi = mid;
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Publisher
+ * ------------------------------------------------------------------------- */
+
+static guint32
+strtab_intern (GString *strtab, GHashTable *interned, const char *s)
+{
+    if (!s) return 0;
+
+    gpointer off;
+    if (g_hash_table_lookup_extended (interned, s, NULL, &off))
+        return GPOINTER_TO_UINT (off);
+
+    guint32 pos = (guint32) strtab->len;
+    g_string_append_len (strtab, s, (gssize) strlen (s) + 1);
+    g_hash_table_insert (interned, (gpointer) s, GUINT_TO_POINTER (pos));
+    return pos;
+}
+
+static gint
+compare_by_id (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    GPtrArray *apps = user_data;
+    return strcmp (app_entry_get_id (g_ptr_array_index (apps, *(const guint32 *) a)),
+                   app_entry_get_id (g_ptr_array_index (apps, *(const guint32 *) b)));
+}
+
+/* @buf (version still 0) holds the same catalog as @current */
+static gboolean
+same_catalog (SessionCatalog *current, const GString *buf)
+{
+    if (!current || current->len != buf->len) return FALSE;
+
+    SessionCatalogHeader h = *current->header;
+    h.version = 0;
+    return memcmp (&h, buf->str, sizeof (h)) == 0 &&
+           memcmp (current->data + sizeof (h), buf->str + sizeof (h),
+                   buf->len - sizeof (h)) == 0;
+}
+
+guint32
+session_catalog_publish (GPtrArray *apps)
+{
+    g_return_val_if_fail (apps != NULL, 0);
+
+    guint       n        = apps->len;
+    GArray     *records  = g_array_sized_new (FALSE, TRUE,
+                                              sizeof (SessionCatalogRecord), n);
+    GString    *strtab   = g_string_sized_new (64 * 1024);
+    GHashTable *interned = g_hash_table_new (g_str_hash, g_str_equal);
+    char       *locale   = locale_key ();
+    g_string_append_c (strtab, '\0');   /* offset 0 = NULL */
+
+    for (guint i = 0; i < n; i++) {
+        const AppEntry *e = g_ptr_array_index (apps, i);
+        SessionCatalogRecord r = { 0 };
+        r.id           = strtab_intern (strtab, interned, app_entry_get_id (e));
+        r.path         = strtab_intern (strtab, interned, e->desktop_path);
+        r.name         = strtab_intern (strtab, interned, e->name);
+        r.exec         = strtab_intern (strtab, interned, e->exec);
+        r.icon_name    = strtab_intern (strtab, interned, e->icon_name);
+        r.categories   = strtab_intern (strtab, interned, e->categories);
+        r.comment      = strtab_intern (strtab, interned, e->comment);
+        r.generic_name = strtab_intern (strtab, interned, e->generic_name);
+        r.keywords     = strtab_intern (strtab, interned, e->keywords);
+        r.sort_key     = strtab_intern (strtab, interned, e->sort_key);
+        r.startup_wm_class = strtab_intern (strtab, interned, e->startup_wm_class);
+        g_array_append_val (records, r);
+    }
+    guint32 locale_off = strtab_intern (strtab, interned, locale);
+    g_hash_table_destroy (interned);
+    g_free (locale);
+
+    guint32 *by_id = g_new (guint32, MAX (n, 1));
+    for (guint i = 0; i < n; i++) by_id[i] = i;
+    g_qsort_with_data (by_id, (gint) n, sizeof (guint32), compare_by_id, apps);
+
+    SessionCatalogHeader h = { 0 };
+    h.magic          = SESSION_CATALOG_MAGIC;
+    h.format         = SESSION_CATALOG_FORMAT;
+    h.n_apps         = n;
+    h.records_offset = sizeof (SessionCatalogHeader);
+    h.by_id_offset   = h.records_offset + n * (guint32) sizeof (SessionCatalogRecord);
+    h.strtab_offset  = h.by_id_offset + n * (guint32) sizeof (guint32);
+    h.strtab_size    = (guint32) strtab->len;
+    h.locale         = locale_off;
+
+    GString *buf = g_string_sized_new (h.strtab_offset + h.strtab_size);
+    g_string_append_len (buf, (const char *) &h, sizeof (h));
+    g_string_append_len (buf, records->data,
+                         (gssize) (n * sizeof (SessionCatalogRecord)));
+    g_string_append_len (buf, (const char *) by_id, (gssize) (n * sizeof (guint32)));
+    g_string_append_len (buf, strtab->str, (gssize) strtab->len);
+
+    g_array_unref (records);
+    g_string_free (strtab, TRUE);
+    g_free (by_id);
+
+    /* Unchanged (e.g. a touched file): keep the current version */
+    SessionCatalog *current = map_snapshot (TRUE);
+    guint32         version = current ? current->header->version + 1 : 1;
+    if (same_catalog (current, buf)) {
+        version = current->header->version;
+        session_catalog_free (current);
+        g_string_free (buf, TRUE);
+        return version;
+    }
+    session_catalog_free (current);
+
+    ((SessionCatalogHeader *) buf->str)->version = version;
+
+    char *path = session_catalog_get_path ();
+    char *dir  = g_path_get_dirname (path);
+    g_mkdir_with_parents (dir, 0700);
+
+    /* Temp file + rename: live client mappings pin the old inode */
+    GError *err = NULL;
+    if (!g_file_set_contents (path, buf->str, (gssize) buf->len, &err)) {
+        g_warning ("SessionCatalog: write %s: %s", path, err->message);
+        g_error_free (err);
+        version = 0;
+    }
+
+    g_free (dir);
+    g_free (path);
+    g_string_free (buf, TRUE);
+    return version;
+}
+
+/* -------------------------------------------------------------------------
+ * Change notification
+ * ------------------------------------------------------------------------- */
+
+static void
+on_changed_signal (GDBusConnection *bus, const char *sender, const char *path,
+                   const char *iface, const char *signal, GVariant *params,
+                   gpointer user_data)
+{
+    (void) bus; (void) sender; (void) path; (void) iface; (void) signal;
+    CatalogWatch *w = user_data;
+
+    if (!g_variant_is_of_type (params, G_VARIANT_TYPE ("(u)"))) return;
+
+    guint32 version;
+    g_variant_get (params, "(u)", &version);
+    w->callback (version, w->user_data);
+}
+
+static void
+on_get_snapshot (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    GError   *err   = NULL;
+    GVariant *reply = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source),
+                                                     res, &err);
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_error_free (err);
+        return;     /* unwatched; @user_data is gone */
+    }
+
+    CatalogWatch *w       = user_data;
+    guint32       version = 0;
+    if (reply) {
+        g_variant_get (reply, "(&su)", NULL, &version);
+        g_variant_unref (reply);
+    } else {
+        g_debug ("SessionCatalog: service unavailable: %s", err->message);
+        g_error_free (err);
+    }
+    w->callback (version, w->user_data);
+}
+
+static void
+watch_free (gpointer data)
+{
+    CatalogWatch *w = data;
+    g_cancellable_cancel (w->cancel);
+    g_object_unref (w->cancel);
+    g_dbus_connection_signal_unsubscribe (w->bus, w->subscription);
+    g_object_unref (w->bus);
+    g_free (w);
+}
+
+guint
+session_catalog_watch (SessionCatalogCallback callback, gpointer user_data)
+{
+    g_return_val_if_fail (callback != NULL, 0);
+
+    GError          *err = NULL;
+    GDBusConnection *bus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &err);
+    if (!bus) {
+        g_debug ("SessionCatalog: no session bus: %s", err->message);
+        g_error_free (err);
+        return 0;
+    }
+
+    if (!watches)
+        watches = g_hash_table_new_full (NULL, NULL, NULL, watch_free);
+
+    CatalogWatch *w = g_new0 (CatalogWatch, 1);
+    w->bus       = bus;
+    w->cancel    = g_cancellable_new ();
+    w->callback  = callback;
+    w->user_data = user_data;
+    w->subscription = g_dbus_connection_signal_subscribe (
+        bus, SESSION_CATALOG_BUS_NAME, SESSION_CATALOG_IFACE, "Changed",
+        SESSION_CATALOG_PATH, NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+        on_changed_signal, w, NULL);
+
+    /* Also starts the service if it is not running yet */
+    g_dbus_connection_call (bus, SESSION_CATALOG_BUS_NAME, SESSION_CATALOG_PATH,
+                            SESSION_CATALOG_IFACE, "GetSnapshot", NULL,
+                            G_VARIANT_TYPE ("(su)"), G_DBUS_CALL_FLAGS_NONE,
+                            -1, w->cancel, on_get_snapshot, w);
+
+    guint id = ++next_watch_id;
+    g_hash_table_insert (watches, GUINT_TO_POINTER (id), w);
+    return id;
+}
+
+void
+session_catalog_unwatch (guint watch_id)
+{
+    if (watch_id && watches)
+        g_hash_table_remove (watches, GUINT_TO_POINTER (watch_id));
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <glib.h>
+#include "app_entry.h"
+
+/**
+ * SessionCatalog - The session-wide application catalog snapshot.
+ *
+ * venom-catalogd scans and watches the application directories once per
+ * session and publishes the result as an immutable file in the user
+ * runtime directory (tmpfs), $XDG_RUNTIME_DIR/venom/apps.catalog:
+ *
+ *   SessionCatalogHeader | SessionCatalogRecord[n_apps] |
+ *   guint32 by_id[n_apps] | string table
+ *
+ * Records are in launcher order (collated name); by_id lists record
+ * indices sorted by desktop id for binary search.  Every string field is
+ * an offset into the string table (0 = NULL).  A new version is written
+ * to a temp file and renamed over the old one, so a client's mapping
+ * never changes under it; clients re-open on the Changed signal.
+ *
+ * Names and sort keys are localized, so the header names the locale the
+ * snapshot was built for (languages and collation).  A client running
+ * under a different one treats the snapshot as absent and scans itself.
+ *
+ * D-Bus (session bus, activatable):
+ *   name/interface  org.venom.AppCatalog
+ *   object          /org/venom/AppCatalog
+ *   GetSnapshot ()  -> (s path, u version)
+ *   Changed         (u version)
+ *
+ * The dock, panel and desktop read the same layout through their copy of
+ * venom-session-catalog.h — keep the two in sync.
+ */
+
+#define SESSION_CATALOG_MAGIC    0x43415356u   /* "VSAC" */
+#define SESSION_CATALOG_FORMAT   3
+
+#define SESSION_CATALOG_BUS_NAME "org.venom.AppCatalog"
+#define SESSION_CATALOG_PATH     "/org/venom/AppCatalog"
+#define SESSION_CATALOG_IFACE    "org.venom.AppCatalog"
+
+typedef struct {
+    guint32  magic;
+    guint32  format;
+    guint32  version;                       /* bumped on every publish */
+    guint32  n_apps;
+    guint32  records_offset;
+    guint32  by_id_offset;
+    guint32  strtab_offset;
+    guint32  strtab_size;
+    guint32  locale;                        /* strtab offset */
+    guint32  reserved;
+} SessionCatalogHeader;
+
+typedef struct {
+    guint32  id;                            /* strtab offsets */
+    guint32  path;
+    guint32  name;
+    guint32  exec;
+    guint32  icon_name;
+    guint32  categories;
+    guint32  comment;
+    guint32  generic_name;
+    guint32  keywords;
+    guint32  sort_key;
+    guint32  startup_wm_class;
+    guint32  reserved;
+} SessionCatalogRecord;
+
+typedef struct _SessionCatalog SessionCatalog;
+
+/* ── Reader ─────────────────────────────────────────────────────────────── */
+
+/* Absolute path of the snapshot file (g_free) */
+char           *session_catalog_get_path    (void);
+
+/*
+ * Maps and validates the current snapshot.  NULL if none is published
+ * or it was built for another locale.
+ */
+SessionCatalog *session_catalog_open        (void);
+void            session_catalog_free        (SessionCatalog *catalog);
+
+guint32         session_catalog_get_version (SessionCatalog *catalog);
+guint           session_catalog_get_n_apps  (SessionCatalog *catalog);
+
+/* Desktop id of the @index-th app; valid while @catalog is open */
+const char     *session_catalog_get_id      (SessionCatalog *catalog,
+                                             guint           index);
+
+/*
+ * All apps as a packed catalog (see app_catalog.h), in snapshot order.
+ * Same ownership as desktop_reader_load_apps().
+ */
+GPtrArray      *session_catalog_load_apps   (SessionCatalog *catalog);
+
+/* New AppEntry for @desktop_id borrowing the mapping, or NULL */
+AppEntry       *session_catalog_lookup      (SessionCatalog *catalog,
+                                             const char     *desktop_id);
+
+/* ── Publisher (venom-catalogd) ─────────────────────────────────────────── */
+
+/*
+ * Writes @apps (sorted) as the next snapshot unless it matches the
+ * current one.  Returns the version now published, or 0 on I/O error.
+ */
+guint32         session_catalog_publish     (GPtrArray *apps);
+
+/* ── Change notification ────────────────────────────────────────────────── */
+
+/*
+ * @version is the newly published version, or 0 if the service cannot
+ * be reached (no session bus, not installed) — scan locally then.
+ */
+typedef void (*SessionCatalogCallback) (guint32  version,
+                                        gpointer user_data);
+
+/*
+ * Subscribes to Changed and asks the service for its current version
+ * (starting it by D-Bus activation if needed); @callback gets that
+ * answer first.  Returns a watch id for session_catalog_unwatch(), or 0
+ * (and never calls back) if there is no session bus.
+ */
+guint           session_catalog_watch       (SessionCatalogCallback callback,
+                                             gpointer               user_data);
+void            session_catalog_unwatch     (guint                  watch_id);
@@ -0,0 +1,223 @@
+#define _DEFAULT_SOURCE
+#include "usage_store.h"
+
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define PROBE_LIMIT  16
+
+G_STATIC_ASSERT (sizeof (UsageStoreHeader) % 8 == 0);
+G_STATIC_ASSERT (sizeof (UsageRecord) == 32);
+G_STATIC_ASSERT ((USAGE_STORE_SLOTS & (USAGE_STORE_SLOTS - 1)) == 0);
+
+#define STORE_SIZE  (sizeof (UsageStoreHeader) + \
+                     USAGE_STORE_SLOTS * sizeof (UsageRecord))
+
+struct _UsageStore {
+    guint8           *data;
+    gboolean          mapped;    /* FALSE: private heap fallback */
+    UsageStoreHeader *header;
+    UsageRecord      *records;
+    guint             generation;
+};
+
+static UsageStore *g_store = NULL;
+
+/* -------------------------------------------------------------------------
+ * Helpers
+ * ------------------------------------------------------------------------- */
+
+static char *
+store_file_path (void)
+{
+    return g_build_filename (g_get_user_data_dir (), "venom",
+                             "launcher-usage.db", NULL);
+}
+
+/* FNV-1a; 0 is reserved for empty slots */
+static guint64
+path_key (const char *path)
+{
+    guint64 h = 0xcbf29ce484222325ull;
+    for (const guchar *p = (const guchar *) path; *p; p++) {
+        h ^= *p;
+        h *= 0x100000001b3ull;
+    }
+    return h ? h : 1;
+}
+
+static gint64
+now_seconds (void)
+{
+    return g_get_real_time () / G_USEC_PER_SEC;
+}
+
+static gdouble
+decayed (const UsageRecord *r, gint64 now)
+{
+    if (r->key == 0) return 0.0;
+    gdouble age = (gdouble) MAX (now - r->stamp, 0);
+    return r->score * exp2 (-age / (USAGE_HALF_LIFE_DAYS * 86400.0));
+}
+
+static gboolean
+header_valid (const UsageStoreHeader *h)
+{
+    return h->magic == USAGE_STORE_MAGIC &&
+           h->version == USAGE_STORE_VERSION &&
+           h->n_slots == USAGE_STORE_SLOTS;
+}
+
+static void
+header_init (UsageStoreHeader *h)
+{
+    memset (h, 0, STORE_SIZE);
+    h->magic   = USAGE_STORE_MAGIC;
+    h->version = USAGE_STORE_VERSION;
+    h->n_slots = USAGE_STORE_SLOTS;
+}
+
+static guint8 *
+map_file (void)
+{
+    char *path = store_file_path ();
+    char *dir  = g_path_get_dirname (path);
+    g_mkdir_with_parents (dir, 0700);
+    g_free (dir);
+
+    int fd = g_open (path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        g_warning ("UsageStore: open %s: %s", path, g_strerror (errno));
+        g_free (path);
+        return NULL;
+    }
+
+    /* Grows a new file (zero filled); leaves a right-sized one alone */
+    guint8 *data = NULL;
+    if (ftruncate (fd, STORE_SIZE) == 0) {
+        data = mmap (NULL, STORE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) data = NULL;
+    }
+    if (!data)
+        g_warning ("UsageStore: map %s: %s", path, g_strerror (errno));
+
+    close (fd);
+    g_free (path);
+    return data;
+}
+
+/* Slot holding @key, or NULL */
+static UsageRecord *
+find (UsageStore *s, guint64 key)
+{
+    for (guint i = 0; i < PROBE_LIMIT; i++) {
+        UsageRecord *r = &s->records[(key + i) & (USAGE_STORE_SLOTS - 1)];
+        if (r->key == key) return r;
+        if (r->key == 0)   return NULL;
+    }
+    return NULL;
+}
+
+/* Slot for inserting @key: first empty one, else the weakest */
+static UsageRecord *
+find_free (UsageStore *s, guint64 key, gint64 now)
+{
+    UsageRecord *weakest = NULL;
+    gdouble      lowest  = 0.0;
+
+    for (guint i = 0; i < PROBE_LIMIT; i++) {
+        UsageRecord *r = &s->records[(key + i) & (USAGE_STORE_SLOTS - 1)];
+        if (r->key == 0) return r;
+
+        gdouble d = decayed (r, now);
+        if (!weakest || d < lowest) {
+            weakest = r;
+            lowest  = d;
+        }
+    }
+    return weakest;
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+UsageStore *
+usage_store_get (void)
+{
+    if (g_store) return g_store;
+
+    g_store = g_new0 (UsageStore, 1);
+    g_store->data   = map_file ();
+    g_store->mapped = g_store->data != NULL;
+
+    /* Ranking still works for this session without the file */
+    if (!g_store->mapped)
+        g_store->data = g_malloc0 (STORE_SIZE);
+
+    g_store->header  = (UsageStoreHeader *) g_store->data;
+    g_store->records = (UsageRecord *) (g_store->data + sizeof (UsageStoreHeader));
+
+    if (!header_valid (g_store->header))
+        header_init (g_store->header);
+
+    return g_store;
+}
+
+void
+usage_store_destroy (void)
+{
+    if (!g_store) return;
+
+    if (g_store->mapped) munmap (g_store->data, STORE_SIZE);
+    else                 g_free (g_store->data);
+
+    g_free (g_store);
+    g_store = NULL;
+}
+
+void
+usage_store_record (UsageStore *store, const char *desktop_path)
+{
+    g_return_if_fail (store != NULL);
+    if (!desktop_path) return;
+
+    guint64      key = path_key (desktop_path);
+    gint64       now = now_seconds ();
+    UsageRecord *r   = find (store, key);
+
+    if (r) {
+        r->score = decayed (r, now) + 1.0;
+        r->launches++;
+    } else {
+        r = find_free (store, key, now);
+        r->key      = key;
+        r->score    = 1.0;
+        r->launches = 1;
+    }
+    r->stamp = now;
+
+    store->generation++;
+}
+
+gdouble
+usage_store_get_score (UsageStore *store, const char *desktop_path)
+{
+    g_return_val_if_fail (store != NULL, 0.0);
+    if (!desktop_path) return 0.0;
+
+    const UsageRecord *r = find (store, path_key (desktop_path));
+    return r ? decayed (r, now_seconds ()) : 0.0;
+}
+
+guint
+usage_store_get_generation (UsageStore *store)
+{
+    g_return_val_if_fail (store != NULL, 0);
+    return store->generation;
+}
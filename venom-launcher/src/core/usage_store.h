@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glib.h>
+
+/**
+ * UsageStore - Decayed launch counts ("frecency") per desktop file.
+ *
+ * Stored at $XDG_DATA_HOME/venom/launcher-usage.db: a small header and
+ * a fixed open-addressed table of USAGE_STORE_SLOTS records, keyed by
+ * a 64-bit hash of the desktop file path.  The file is mmap'd shared
+ * and updated in place, so recording a launch is a single record write
+ * with no allocation and no file rewrite.
+ *
+ * A record keeps the score as of its last update; reads decay it by
+ * USAGE_HALF_LIFE_DAYS.  When the probe window is full the weakest
+ * record in it is replaced.
+ *
+ * Singleton, main thread only.
+ */
+
+#define USAGE_STORE_MAGIC     0x53554356u   /* "VCUS" */
+#define USAGE_STORE_VERSION   1
+#define USAGE_STORE_SLOTS     1024          /* power of two */
+#define USAGE_HALF_LIFE_DAYS  7
+
+typedef struct {
+    guint32  magic;
+    guint32  version;
+    guint32  n_slots;
+    guint32  reserved;
+} UsageStoreHeader;
+
+typedef struct {
+    guint64  key;        /* path hash, 0 = empty */
+    gint64   stamp;      /* last update, seconds since epoch */
+    gdouble  score;      /* launch count decayed to @stamp */
+    guint32  launches;   /* raw total, informational */
+    guint32  reserved;
+} UsageRecord;
+
+typedef struct _UsageStore UsageStore;
+
+UsageStore *usage_store_get            (void);
+void        usage_store_destroy        (void);
+
+/* Adds one launch of @desktop_path. */
+void        usage_store_record         (UsageStore *store,
+                                        const char *desktop_path);
+
+/* Current decayed score of @desktop_path, 0 if never launched. */
+gdouble     usage_store_get_score      (UsageStore *store,
+                                        const char *desktop_path);
+
+/* Bumped by every usage_store_record() — lets callers cache scores. */
+guint       usage_store_get_generation (UsageStore *store);
@@ -1,5 +1,38 @@
 #include "ui/launcher_window.h"
+#include "core/icon_loader.h"
 #include <gtk/gtk.h>
+#include <glib-unix.h>
+#include <signal.h>
+
+static gint     icon_cache_mb = 0;      /* 0 = ICON_CACHE_BUDGET */
+static gboolean daemon_mode   = FALSE;  /* start hidden, stay resident */
+static gint     trim_after_s  = LAUNCHER_TRIM_DELAY_S;
+
+/* kill -USR2 dumps the icon cache counters to the log */
+static gboolean
+on_dump_stats (gpointer user_data)
+{
+    (void) user_data;
+    icon_loader_dump_stats (icon_loader_get ());
+    return G_SOURCE_CONTINUE;
+}
+
+static gint
+on_handle_local_options (GApplication *app, GVariantDict *options,
+                         gpointer user_data)
+{
+    (void) user_data;
+    g_variant_dict_lookup (options, "icon-cache-mb", "i", &icon_cache_mb);
+    g_variant_dict_lookup (options, "daemon", "b", &daemon_mode);
+    g_variant_dict_lookup (options, "trim-after", "i", &trim_after_s);
+
+    /* A second --daemon (e.g. session autostart twice) must not toggle */
+    if (daemon_mode) {
+        if (!g_application_register (app, NULL, NULL)) return 1;
+        if (g_application_get_is_remote (app)) return 0;
+    }
+    return -1;  /* continue startup */
+}
 
 /* -------------------------------------------------------------------------
  * GtkApplication activate callback
@@ -20,8 +53,24 @@ on_activate (GtkApplication *app, gpointer user_data)
             venom_launcher_window_show_launcher (VENOM_LAUNCHER_WINDOW (win));
         }
     } else {
+        if (icon_cache_mb > 0)
+            icon_loader_set_cache_budget (icon_loader_get (),
+                                          (gsize) icon_cache_mb * 1024 * 1024);
+        g_unix_signal_add (SIGUSR2, on_dump_stats, NULL);
+
         GtkWidget *win = venom_launcher_window_new (app);
-        venom_launcher_window_show_launcher (VENOM_LAUNCHER_WINDOW (win));
+        venom_launcher_window_set_trim_delay (VENOM_LAUNCHER_WINDOW (win),
+                                              (guint) MAX (trim_after_s, 0));
+
+        if (daemon_mode) {
+            /* Resident: hidden between shows, never torn down */
+            g_application_hold (G_APPLICATION (app));
+            g_signal_connect (win, "delete-event",
+                              G_CALLBACK (gtk_widget_hide_on_delete), NULL);
+            venom_launcher_window_prepare (VENOM_LAUNCHER_WINDOW (win));
+        } else {
+            venom_launcher_window_show_launcher (VENOM_LAUNCHER_WINDOW (win));
+        }
     }
 }
 
@@ -36,6 +85,20 @@ main (int argc, char *argv[])
         "org.venom.Launcher",
         G_APPLICATION_DEFAULT_FLAGS);
 
+    g_application_add_main_option (G_APPLICATION (app), "icon-cache-mb", 0,
+                                   G_OPTION_FLAG_NONE, G_OPTION_ARG_INT,
+                                   "Icon cache budget in MiB", "MIB");
+    g_application_add_main_option (G_APPLICATION (app), "daemon", 0,
+                                   G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE,
+                                   "Start hidden and stay resident; later runs show the launcher",
+                                   NULL);
+    g_application_add_main_option (G_APPLICATION (app), "trim-after", 0,
+                                   G_OPTION_FLAG_NONE, G_OPTION_ARG_INT,
+                                   "Free icon and page caches after this long hidden (0 = never)",
+                                   "SECONDS");
+
+    g_signal_connect (app, "handle-local-options",
+                      G_CALLBACK (on_handle_local_options), NULL);
     g_signal_connect (app, "activate", G_CALLBACK (on_activate), NULL);
 
     int status = g_application_run (G_APPLICATION (app), argc, argv);
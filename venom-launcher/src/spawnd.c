@@ -0,0 +1,257 @@
+/*
+ * venom-spawnd - Session spawn helper.
+ *
+ * Started with the session (autostart) or by the first client that
+ * finds it missing.  Receives argv, environment and working directory
+ * from the launcher, dock and panel over a Unix socket and starts the
+ * app with posix_spawn() in a new session, so launching does not fork
+ * those large GTK processes.  Protocol: core/venom-spawn.h.
+ *
+ * Deliberately libc only and single-threaded: it stays a few hundred
+ * KiB resident, and posix_spawn() from it costs the same whatever the
+ * shell's size.
+ */
+
+#define _GNU_SOURCE   /* accept4(), SO_PEERCRED */
+
+#define VENOM_SPAWN_PROTOCOL_ONLY
+#include "core/venom-spawn.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_PATH "/usr/local/bin:/usr/bin:/bin"
+
+/* -------------------------------------------------------------------------
+ * Request parsing
+ * ------------------------------------------------------------------------- */
+
+/*
+ * Splits the string area after the header into @out (count strings).
+ * Returns 0, or EINVAL if the message is truncated or malformed.
+ */
+static int
+split_strings (char *p, char *end, char **out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        char *nul = memchr (p, '\0', (size_t) (end - p));
+        if (!nul) return EINVAL;
+        out[i] = p;
+        p = nul + 1;
+    }
+    return 0;
+}
+
+static const char *
+env_lookup (char **envp, const char *name)
+{
+    size_t len = strlen (name);
+    for (char **e = envp; *e; e++)
+        if (strncmp (*e, name, len) == 0 && (*e)[len] == '=')
+            return *e + len + 1;
+    return NULL;
+}
+
+/*
+ * Resolves @prog in the client's PATH (not ours) into @buf.  Called
+ * after chdir() to the client's cwd, so relative entries work too.
+ */
+static const char *
+resolve_program (const char *prog, char **envp, char *buf, size_t size)
+{
+    if (strchr (prog, '/')) return prog;
+
+    const char *path = env_lookup (envp, "PATH");
+    if (!path || !*path) path = DEFAULT_PATH;
+
+    for (const char *dir = path; ; ) {
+        const char *colon = strchr (dir, ':');
+        size_t      dlen  = colon ? (size_t) (colon - dir) : strlen (dir);
+        int         n     = snprintf (buf, size, "%.*s%s%s", (int) dlen, dir,
+                                      dlen ? "/" : "", prog);
+
+        if (n > 0 && (size_t) n < size && access (buf, X_OK) == 0)
+            return buf;
+        if (!colon) break;
+        dir = colon + 1;
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Spawning
+ * ------------------------------------------------------------------------- */
+
+static int64_t
+now_us (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void
+spawn (char *cwd, char **argv, char **envp, int home_fd, VenomSpawnReply *reply)
+{
+    char        exe[PATH_MAX];
+    const char *path;
+
+    if (chdir (cwd) != 0) {
+        reply->error = errno;
+        return;
+    }
+
+    path = resolve_program (argv[0], envp, exe, sizeof exe);
+    if (!path) {
+        reply->error = ENOENT;
+    } else {
+        /* Our SIGCHLD/SIGPIPE dispositions must not leak into the app */
+        posix_spawnattr_t attr;
+        sigset_t          none, defaults;
+        short             flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+
+        sigemptyset (&none);
+        sigemptyset (&defaults);
+        sigaddset (&defaults, SIGCHLD);
+        sigaddset (&defaults, SIGPIPE);
+#ifdef POSIX_SPAWN_SETSID
+        flags |= POSIX_SPAWN_SETSID;
+#endif
+        posix_spawnattr_init (&attr);
+        posix_spawnattr_setflags (&attr, flags);
+        posix_spawnattr_setsigmask (&attr, &none);
+        posix_spawnattr_setsigdefault (&attr, &defaults);
+
+        pid_t   pid;
+        int64_t start = now_us ();
+        int     err   = posix_spawn (&pid, path, NULL, &attr, argv, envp);
+        reply->spawn_us = now_us () - start;
+
+        if (err == 0) reply->pid   = pid;
+        else          reply->error = err;
+        posix_spawnattr_destroy (&attr);
+    }
+
+    /* Back to our own directory for the next request */
+    if (fchdir (home_fd) != 0)
+        perror ("venom-spawnd: fchdir");
+}
+
+static void
+serve (int client, int home_fd, char *buf)
+{
+    VenomSpawnReply reply = { 0, EINVAL, 0 };
+    struct ucred    cred;
+    socklen_t       len = sizeof cred;
+
+    /* The socket directory is private, but check the peer anyway */
+    if (getsockopt (client, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 ||
+        cred.uid != getuid ()) {
+        reply.error = EPERM;
+        send (client, &reply, sizeof reply, MSG_NOSIGNAL);
+        return;
+    }
+
+    ssize_t n = recv (client, buf, VENOM_SPAWN_MAX_REQUEST, 0);
+    VenomSpawnRequest *req = (VenomSpawnRequest *) buf;
+
+    if (n >= (ssize_t) sizeof *req && req->magic == VENOM_SPAWN_MAGIC &&
+        req->argc > 0 && req->argc < 65536 && req->envc < 65536) {
+        char **strs = calloc ((size_t) req->argc + req->envc + 3, sizeof (char *));
+
+        if (strs &&
+            split_strings (buf + sizeof *req, buf + n, strs, 1 + req->argc + req->envc) == 0) {
+            /* strs: cwd | argv... NULL | envp... NULL */
+            char  *cwd  = strs[0];
+            char **argv = strs + 1;
+            char **envp = argv + req->argc + 1;
+            memmove (envp, argv + req->argc, req->envc * sizeof (char *));
+            argv[req->argc] = NULL;
+            envp[req->envc] = NULL;
+
+            reply.error = 0;
+            spawn (cwd, argv, envp, home_fd, &reply);
+        }
+        free (strs);
+    }
+
+    send (client, &reply, sizeof reply, MSG_NOSIGNAL);
+}
+
+/* -------------------------------------------------------------------------
+ * Entry point
+ * ------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    const char *runtime = getenv ("XDG_RUNTIME_DIR");
+    if (!runtime || !*runtime) {
+        fprintf (stderr, "venom-spawnd: XDG_RUNTIME_DIR is not set\n");
+        return 1;
+    }
+
+    char dir[PATH_MAX], lock_path[PATH_MAX];
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    snprintf (dir, sizeof dir, "%s/venom", runtime);
+    snprintf (lock_path, sizeof lock_path, "%s/venom/spawn.lock", runtime);
+    if (snprintf (addr.sun_path, sizeof addr.sun_path, "%s/%s", runtime,
+                  VENOM_SPAWN_SOCKET) >= (int) sizeof addr.sun_path) {
+        fprintf (stderr, "venom-spawnd: socket path too long\n");
+        return 1;
+    }
+    mkdir (dir, 0700);
+
+    /* One helper per session: a second start (autostart + a client) just exits */
+    int lock = open (lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lock < 0 || flock (lock, LOCK_EX | LOCK_NB) != 0)
+        return 0;
+
+    /* Apps are never waited for; the kernel reaps them */
+    signal (SIGCHLD, SIG_IGN);
+    signal (SIGPIPE, SIG_IGN);
+
+    int listener = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    unlink (addr.sun_path);
+    if (listener < 0 ||
+        bind (listener, (struct sockaddr *) &addr, sizeof addr) != 0 ||
+        listen (listener, 16) != 0) {
+        perror ("venom-spawnd");
+        return 1;
+    }
+
+    int   home_fd = open (".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    char *buf     = malloc (VENOM_SPAWN_MAX_REQUEST);
+    if (home_fd < 0 || !buf) {
+        perror ("venom-spawnd");
+        return 1;
+    }
+
+    for (;;) {
+        int client = accept4 (listener, NULL, NULL, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror ("venom-spawnd: accept");
+            return 1;
+        }
+        /* A client that connects and never sends must not block the others */
+        struct timeval timeout = { 1, 0 };
+        setsockopt (client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+
+        serve (client, home_fd, buf);
+        close (client);
+    }
+}
@@ -0,0 +1,168 @@
+#define _DEFAULT_SOURCE   /* struct timeval, SOCK_CLOEXEC in venom-spawn.h */
+
+#include "app_actions.h"
+#include "../core/usage_store.h"
+#include "../core/venom-spawn.h"
+#include <string.h>
+
+/* Copy of the entry fields a menu action needs */
+typedef struct {
+    GtkWidget *from;
+    char      *name;
+    char      *exec;
+    char      *desktop_path;
+} MenuCtx;
+
+static void
+menu_ctx_free (gpointer data)
+{
+    MenuCtx *ctx = data;
+    g_free (ctx->name);
+    g_free (ctx->exec);
+    g_free (ctx->desktop_path);
+    g_free (ctx);
+}
+
+static void
+hide_toplevel (GtkWidget *from)
+{
+    GtkWidget *toplevel = gtk_widget_get_toplevel (from);
+    if (GTK_IS_WINDOW (toplevel))
+        gtk_widget_hide (toplevel);
+}
+
+/* Wrapper to avoid -Wcast-function-type with gtk_widget_destroy */
+static void
+destroy_menu (GtkMenuShell *menu, gpointer user_data)
+{
+    (void) user_data;
+    gtk_widget_destroy (GTK_WIDGET (menu));
+}
+
+/* -------------------------------------------------------------------------
+ * Launch the application
+ * ------------------------------------------------------------------------- */
+
+static void
+launch (const char *name, const char *exec, const char *desktop_path,
+        GtkWidget *from)
+{
+    if (!exec) return;
+
+    GError *err = NULL;
+    if (!venom_spawn_command_line (exec, &err)) {
+        g_warning ("Failed to launch '%s': %s", name, err->message);
+        g_error_free (err);
+        return;
+    }
+
+    /* One in-place record write in the mmap'd store */
+    usage_store_record (usage_store_get (), desktop_path);
+
+    /* Close the launcher window */
+    hide_toplevel (from);
+}
+
+/* -------------------------------------------------------------------------
+ * Context Menu Actions
+ * ------------------------------------------------------------------------- */
+
+static void
+on_menu_run (GtkMenuItem *item, gpointer data)
+{
+    (void) item;
+    MenuCtx *ctx = data;
+    launch (ctx->name, ctx->exec, ctx->desktop_path, ctx->from);
+}
+
+static void
+on_menu_shortcut (GtkMenuItem *item, gpointer data)
+{
+    (void) item;
+    MenuCtx *ctx = data;
+
+    if (!ctx->desktop_path) return;
+
+    /* Copy .desktop to ~/Desktop and make executable */
+    const char *home    = g_get_home_dir ();
+    char *desktop_dir   = g_build_filename (home, "Desktop", NULL);
+    char *filename      = g_path_get_basename (ctx->desktop_path);
+    char *dest_path     = g_build_filename (desktop_dir, filename, NULL);
+
+    /* Hide window so user sees the change */
+    hide_toplevel (ctx->from);
+
+    /* Use sh -c to execute a compound shell command */
+    char *cmd = g_strdup_printf ("sh -c \"cp '%s' '%s' && chmod +x '%s'\"",
+                                 ctx->desktop_path, dest_path, dest_path);
+
+    venom_spawn_command_line (cmd, NULL);
+
+    g_free (cmd);
+    g_free (dest_path);
+    g_free (filename);
+    g_free (desktop_dir);
+}
+
+static void
+on_menu_uninstall (GtkMenuItem *item, gpointer data)
+{
+    (void) item;
+    MenuCtx *ctx = data;
+
+    if (!ctx->desktop_path) return;
+
+    hide_toplevel (ctx->from);
+
+    /* Use pkexec to prompt password and delete the .desktop file */
+    char *cmd = g_strdup_printf ("pkexec sh -c \"rm -f '%s'\"", ctx->desktop_path);
+    venom_spawn_command_line (cmd, NULL);
+    g_free (cmd);
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+void
+app_actions_launch (const AppEntry *entry, GtkWidget *from)
+{
+    g_return_if_fail (entry != NULL && GTK_IS_WIDGET (from));
+    launch (entry->name, entry->exec, entry->desktop_path, from);
+}
+
+void
+app_actions_popup_menu (const AppEntry *entry,
+                        GtkWidget      *from,
+                        const GdkEvent *event)
+{
+    g_return_if_fail (entry != NULL && GTK_IS_WIDGET (from));
+
+    MenuCtx *ctx = g_new0 (MenuCtx, 1);
+    ctx->from         = from;
+    ctx->name         = g_strdup (entry->name);
+    ctx->exec         = g_strdup (entry->exec);
+    ctx->desktop_path = g_strdup (entry->desktop_path);
+
+    GtkWidget *menu = gtk_menu_new ();
+    g_object_set_data_full (G_OBJECT (menu), "venom-menu-ctx", ctx, menu_ctx_free);
+    gtk_menu_attach_to_widget (GTK_MENU (menu), from, NULL);
+
+    GtkWidget *item_run = gtk_menu_item_new_with_label ("Run");
+    g_signal_connect (item_run, "activate", G_CALLBACK (on_menu_run), ctx);
+    gtk_menu_shell_append (GTK_MENU_SHELL (menu), item_run);
+
+    GtkWidget *item_shortcut = gtk_menu_item_new_with_label ("Create Shortcut");
+    g_signal_connect (item_shortcut, "activate", G_CALLBACK (on_menu_shortcut), ctx);
+    gtk_menu_shell_append (GTK_MENU_SHELL (menu), item_shortcut);
+
+    GtkWidget *item_uninstall = gtk_menu_item_new_with_label ("Uninstall");
+    g_signal_connect (item_uninstall, "activate", G_CALLBACK (on_menu_uninstall), ctx);
+    gtk_menu_shell_append (GTK_MENU_SHELL (menu), item_uninstall);
+
+    /* Emitted after the chosen item's "activate", or on dismissal */
+    g_signal_connect (menu, "selection-done", G_CALLBACK (destroy_menu), NULL);
+
+    gtk_widget_show_all (menu);
+    gtk_menu_popup_at_pointer (GTK_MENU (menu), event);
+}
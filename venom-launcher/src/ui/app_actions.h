@@ -0,0 +1,27 @@
+#pragma once
+
+#include <gtk/gtk.h>
+#include "../core/app_entry.h"
+
+G_BEGIN_DECLS
+
+/**
+ * AppActions - What clicking an app in the grid does.
+ * @from is the widget the action came from; its toplevel (the launcher
+ * window) is hidden once the action starts.
+ */
+
+/* Spawns @entry's Exec line and records the launch in the UsageStore. */
+void app_actions_launch     (const AppEntry *entry,
+                             GtkWidget      *from);
+
+/*
+ * Pops up the Run / Create Shortcut / Uninstall menu at the pointer.
+ * The menu keeps its own copy of what it needs, so @entry may go away
+ * while it is open.
+ */
+void app_actions_popup_menu (const AppEntry *entry,
+                             GtkWidget      *from,
+                             const GdkEvent *event);
+
+G_END_DECLS
@@ -1,253 +1,859 @@
 #include "app_grid.h"
-#include "app_icon.h"
+#include "app_actions.h"
 #include "../core/app_entry.h"
-#include "../utils/string_utils.h"
+#include "../core/icon_loader.h"
+#include "../core/search_index.h"
+#include "../core/usage_store.h"
 
 #include <string.h>
 #include <math.h>
 
-/* Wrapper to avoid -Wcast-function-type with gtk_widget_destroy */
-static void
-destroy_widget (gpointer widget, gpointer user_data)
-{
-    (void) user_data;
-    gtk_widget_destroy (GTK_WIDGET (widget));
-}
+/* Ranked fuzzy hits kept per query; weaker ones are noise anyway */
+#define FUZZY_RESULTS  (APPS_PER_PAGE * 4)
+
+/* Tile geometry (logical px) — matches the old button + label layout */
+#define TILE_PAD          5
+#define LABEL_GAP        10
+#define LABEL_WIDTH     120
+#define LABEL_LINES       2
+#define ROW_SPACING      10
+#define TILE_RADIUS      22
+#define DOTS_AREA        60    /* bottom strip holding the page dots */
+#define DOT_PITCH        14
+
+#define SLIDE_DURATION_US  (350 * 1000)
+
+/* Cached surfaces/layouts are dropped wholesale past this many entries */
+#define RENDER_CACHE_MAX  1024
 
 /* -------------------------------------------------------------------------
  * Widget struct
  * ------------------------------------------------------------------------- */
 
+typedef struct {
+    cairo_surface_t *surface;   /* NULL while the load is in flight */
+    guint            serial;    /* matches the IconLoadCtx that fills it */
+    guint            page_gen;  /* generation it was requested under */
+    gboolean         done;      /* answered (possibly without an icon) */
+} IconSlot;
+
 struct _VenomAppGrid {
-    GtkBox      parent_instance;
+    GtkDrawingArea parent_instance;
 
     GPtrArray  *all_apps;       /* full list, not owned */
     GPtrArray  *filtered_apps;  /* subset after filter  */
+    SearchIndex *index;         /* not owned; holds the active query */
+    char       *query;          /* active query, NULL when empty */
+    guint       usage_gen;      /* UsageStore generation of the results */
+    gboolean    page_dirty;     /* visible page changed by catalog updates */
+    gboolean    needs_collect;  /* ranked results must be recomputed */
+    guint       n_ranked;       /* leading ranked / most-used entries */
 
     int         current_page;
     int         total_pages;
 
-    /* Child widgets */
-    GtkWidget  *stack;          /* container for page animation */
-    GtkWidget  *flow_box_1;     /* alternates with flow_box_2 */
-    GtkWidget  *flow_box_2;
-    int         active_box;     /* 1 or 2 */
+    /* Per-entry render caches, keyed by AppEntry* */
+    GHashTable *icons;          /* -> IconSlot* */
+    GHashTable *layouts;        /* -> PangoLayout* */
+    guint       icon_serial;
+    guint       theme_watch;
 
-    GtkWidget  *dots_box;
+    /*
+     * Icon loads are requested under the current page generation; moving
+     * to another page or result set cancels whatever has not started.
+     */
+    guint         page_gen;
+    GCancellable *page_cancel;
+    cairo_surface_t *fallback_icon; /* NULL = blank until it arrives */
+    guint       fallback_serial;    /* bumped when it is dropped */
+    gboolean    fallback_requested;
+    int         label_height;   /* LABEL_LINES lines of the current font */
+
+    /* Offscreen pages */
+    cairo_surface_t *page_surface;  /* current page, NULL = render on draw */
+    cairo_surface_t *prev_surface;  /* outgoing page while sliding */
+    gboolean    rendering;
+    guint       prerender_id;       /* idle re-render while hidden */
+    int         slide_dir;          /* +1 next, -1 prev, 0 idle */
+    gint64      slide_start;        /* frame clock time, 0 = first frame */
+    guint       tick_id;
+
+    /* Pointer state, as slots on the current page (-1 = none) */
+    int         hover;
+    int         pressed;
 };
 
-G_DEFINE_TYPE (VenomAppGrid, venom_app_grid, GTK_TYPE_BOX)
+G_DEFINE_TYPE (VenomAppGrid, venom_app_grid, GTK_TYPE_DRAWING_AREA)
+
+typedef struct {
+    VenomAppGrid *grid;         /* weak */
+    AppEntry     *entry;        /* NULL: the fallback icon */
+    guint         serial;
+    GCancellable *cancel;       /* page generation it was requested for */
+} IconLoadCtx;
 
 /* -------------------------------------------------------------------------
- * Helpers
+ * Geometry
  * ------------------------------------------------------------------------- */
 
+static int
+tile_width (void)
+{
+    return MAX (ICON_LOAD_SIZE, LABEL_WIDTH) + 2 * TILE_PAD;
+}
+
+static int
+tile_height (VenomAppGrid *self)
+{
+    return TILE_PAD + ICON_LOAD_SIZE + LABEL_GAP + self->label_height + TILE_PAD;
+}
+
+static int
+page_height (VenomAppGrid *self)
+{
+    return MAX (1, gtk_widget_get_allocated_height (GTK_WIDGET (self)) - DOTS_AREA);
+}
+
+/* Tile rectangle of page slot @slot */
 static void
-update_dots (VenomAppGrid *self)
-{
-    /* Remove all existing dot children */
-    GList *children = gtk_container_get_children (GTK_CONTAINER (self->dots_box));
-    g_list_foreach (children, destroy_widget, NULL);
-    g_list_free (children);
-
-    for (int i = 0; i < self->total_pages; i++) {
-        GtkWidget *dot = gtk_label_new ("●");
-        GtkStyleContext *ctx = gtk_widget_get_style_context (dot);
-        gtk_style_context_add_class (ctx, "page-dot");
-
-        if (i == self->current_page) {
-            gtk_style_context_add_class (ctx, "active");
-            /* Force style with an inline provider to work around GTK3 refresh issues */
-            GtkCssProvider *prov = gtk_css_provider_new ();
-            gtk_css_provider_load_from_data (prov,
-                "label { color: rgba(255,255,255,0.90); font-size: 11px; }", -1, NULL);
-            gtk_style_context_add_provider (ctx,
-                GTK_STYLE_PROVIDER (prov),
-                GTK_STYLE_PROVIDER_PRIORITY_APPLICATION + 1);
-            g_object_unref (prov);
-        } else {
-            GtkCssProvider *prov = gtk_css_provider_new ();
-            gtk_css_provider_load_from_data (prov,
-                "label { color: rgba(255,255,255,0.30); font-size: 9px; }", -1, NULL);
-            gtk_style_context_add_provider (ctx,
-                GTK_STYLE_PROVIDER (prov),
-                GTK_STYLE_PROVIDER_PRIORITY_APPLICATION + 1);
-            g_object_unref (prov);
-        }
+slot_rect (VenomAppGrid *self, int slot, GdkRectangle *r)
+{
+    int col_pitch = gtk_widget_get_allocated_width (GTK_WIDGET (self)) / GRID_COLUMNS;
+    int col = slot % GRID_COLUMNS;
+    int row = slot / GRID_COLUMNS;
+
+    r->width  = tile_width ();
+    r->height = tile_height (self);
+    r->x      = col * col_pitch + (col_pitch - r->width) / 2;
+    r->y      = row * (r->height + ROW_SPACING);
+}
+
+static int
+page_count (VenomAppGrid *self)
+{
+    int start = self->current_page * APPS_PER_PAGE;
+    return CLAMP ((int) self->filtered_apps->len - start, 0, APPS_PER_PAGE);
+}
 
-        gtk_box_pack_start (GTK_BOX (self->dots_box), dot, FALSE, FALSE, 0);
+/* Page slot under (@x, @y), or -1 */
+static int
+hit_test (VenomAppGrid *self, double x, double y)
+{
+    int col_pitch = gtk_widget_get_allocated_width (GTK_WIDGET (self)) / GRID_COLUMNS;
+    int row_pitch = tile_height (self) + ROW_SPACING;
+    if (col_pitch <= 0 || x < 0 || y < 0) return -1;
+
+    int col = (int) x / col_pitch;
+    int row = (int) y / row_pitch;
+    if (col >= GRID_COLUMNS || row >= GRID_ROWS) return -1;
+
+    int slot = row * GRID_COLUMNS + col;
+    if (slot >= page_count (self)) return -1;
+
+    GdkRectangle r;
+    slot_rect (self, slot, &r);
+    if (x < r.x || x >= r.x + r.width || y < r.y || y >= r.y + r.height)
+        return -1;
+    return slot;
+}
+
+static AppEntry *
+slot_entry (VenomAppGrid *self, int slot)
+{
+    if (slot < 0 || slot >= page_count (self)) return NULL;
+    return g_ptr_array_index (self->filtered_apps,
+                              self->current_page * APPS_PER_PAGE + slot);
+}
+
+/* -------------------------------------------------------------------------
+ * Render caches
+ * ------------------------------------------------------------------------- */
+
+static void
+icon_slot_free (gpointer data)
+{
+    IconSlot *slot = data;
+    if (slot->surface) cairo_surface_destroy (slot->surface);
+    g_free (slot);
+}
+
+static void render_page (VenomAppGrid *self);
+
+/* Renders the current page now if it can be, ahead of being drawn */
+static void
+prerender (VenomAppGrid *self)
+{
+    GtkWidget *widget = GTK_WIDGET (self);
+
+    if (self->page_surface || !gtk_widget_get_realized (widget)) return;
+    if (gtk_widget_get_allocated_width (widget) <= 1) return;
+    render_page (self);
+}
+
+static gboolean
+prerender_idle (gpointer data)
+{
+    VenomAppGrid *self = data;
+    self->prerender_id = 0;
+    if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
+        prerender (self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+invalidate_page (VenomAppGrid *self)
+{
+    g_clear_pointer (&self->page_surface, cairo_surface_destroy);
+    gtk_widget_queue_draw (GTK_WIDGET (self));
+
+    /* Hidden but realized (a resident launcher): have the page ready */
+    if (!self->prerender_id && gtk_widget_get_realized (GTK_WIDGET (self)) &&
+        !gtk_widget_get_mapped (GTK_WIDGET (self)))
+        self->prerender_id = g_idle_add_full (G_PRIORITY_LOW, prerender_idle,
+                                              self, NULL);
+}
+
+/* The visible page changed: loads queued for the old one are moot */
+static void
+new_page_generation (VenomAppGrid *self)
+{
+    if (self->page_cancel) {
+        g_cancellable_cancel (self->page_cancel);
+        g_object_unref (self->page_cancel);
     }
+    self->page_cancel = g_cancellable_new ();
+    self->page_gen++;
+}
 
-    gtk_widget_show_all (self->dots_box);
+static gboolean
+entry_on_page (VenomAppGrid *self, AppEntry *entry)
+{
+    for (int i = 0; i < page_count (self); i++)
+        if (slot_entry (self, i) == entry) return TRUE;
+    return FALSE;
 }
 
 static void
-populate_page (VenomAppGrid *self, GtkStackTransitionType transition)
+on_icon_ready (cairo_surface_t *surface, gpointer user_data)
 {
-    /* Toggle active box */
-    self->active_box = (self->active_box == 1) ? 2 : 1;
-    GtkWidget *target_box = (self->active_box == 1) ? self->flow_box_1 : self->flow_box_2;
-    const char *target_name = (self->active_box == 1) ? "page1" : "page2";
+    IconLoadCtx  *ctx  = user_data;
+    VenomAppGrid *self = ctx->grid;
 
-    /* Clear target box */
-    GList *children = gtk_container_get_children (GTK_CONTAINER (target_box));
-    g_list_foreach (children, destroy_widget, NULL);
-    g_list_free (children);
+    if (self) {
+        g_object_remove_weak_pointer (G_OBJECT (self), (gpointer *) &ctx->grid);
 
-    int start = self->current_page * APPS_PER_PAGE;
-    int end   = MIN (start + APPS_PER_PAGE, (int) self->filtered_apps->len);
+        /* Entry may have been removed, or the cache dropped, meanwhile */
+        IconSlot *slot = g_hash_table_lookup (self->icons, ctx->entry);
+        if (slot && slot->serial == ctx->serial) {
+            /* Skipped after a page flip: request again if shown again */
+            slot->done = surface || !g_cancellable_is_cancelled (ctx->cancel);
+
+            if (surface) {
+                slot->surface = cairo_surface_reference (surface);
 
-    for (int i = start; i < end; i++) {
-        AppEntry  *entry = g_ptr_array_index (self->filtered_apps, i);
-        GtkWidget *icon  = venom_app_icon_new (entry);
-        gtk_container_add (GTK_CONTAINER (target_box), icon);
+                /* Cache hits are delivered synchronously, mid-render */
+                if (!self->rendering && entry_on_page (self, ctx->entry))
+                    invalidate_page (self);
+            }
+        }
     }
 
-    gtk_widget_show_all (target_box);
+    g_object_unref (ctx->cancel);
+    g_free (ctx);
+}
 
-    if (transition != GTK_STACK_TRANSITION_TYPE_NONE) {
-        gtk_stack_set_transition_type (GTK_STACK (self->stack), transition);
+static cairo_surface_t *
+lookup_icon (VenomAppGrid *self, AppEntry *entry, IconPriority priority)
+{
+    IconSlot *slot = g_hash_table_lookup (self->icons, entry);
+    if (slot && (slot->done || slot->page_gen == self->page_gen))
+        return slot->surface;
+    if (!entry->icon_name) return NULL;
+
+    /* New, or requested for a page we have since left */
+    if (!slot) {
+        slot = g_new0 (IconSlot, 1);
+        g_hash_table_insert (self->icons, entry, slot);
     }
-    gtk_stack_set_visible_child_name (GTK_STACK (self->stack), target_name);
+    slot->serial   = ++self->icon_serial;
+    slot->page_gen = self->page_gen;
+
+    IconLoadCtx *ctx = g_new0 (IconLoadCtx, 1);
+    ctx->grid   = self;
+    ctx->entry  = entry;
+    ctx->serial = slot->serial;
+    ctx->cancel = g_object_ref (self->page_cancel);
+    g_object_add_weak_pointer (G_OBJECT (self), (gpointer *) &ctx->grid);
 
-    update_dots (self);
+    icon_loader_load_async (icon_loader_get (), entry->icon_name, priority,
+                            self->page_cancel, on_icon_ready, ctx);
+
+    /* May already be filled by a synchronous cache hit */
+    return slot->surface;
 }
 
 static void
-rebuild_filter (VenomAppGrid *self, const char *query)
+on_fallback_ready (cairo_surface_t *surface, gpointer user_data)
 {
-    g_ptr_array_set_size (self->filtered_apps, 0);
-
-    bool empty = (!query || *query == '\0');
+    IconLoadCtx  *ctx  = user_data;
+    VenomAppGrid *self = ctx->grid;
 
-    for (guint i = 0; i < self->all_apps->len; i++) {
-        AppEntry *e = g_ptr_array_index (self->all_apps, i);
+    if (self) {
+        g_object_remove_weak_pointer (G_OBJECT (self), (gpointer *) &ctx->grid);
 
-        if (empty ||
-            str_contains_icase (e->name,       query) ||
-            str_contains_icase (e->comment,    query) ||
-            str_contains_icase (e->categories, query))
-        {
-            g_ptr_array_add (self->filtered_apps, e);
+        /* Dropped meanwhile (theme change, trim): a new one is requested */
+        if (surface && ctx->serial == self->fallback_serial) {
+            self->fallback_icon = cairo_surface_reference (surface);
+            if (!self->rendering) invalidate_page (self);
         }
     }
 
-    self->current_page = 0;
-    self->total_pages  = MAX (1,
-        (int) ceil ((double) self->filtered_apps->len / APPS_PER_PAGE));
+    g_free (ctx);
+}
+
+/*
+ * The icon for apps without one, through the loader's flights like any
+ * other: never resolved on the main thread, and not tied to a page, so
+ * a flip does not cancel it.  Tiles stay blank until it arrives.
+ */
+static void
+request_fallback_icon (VenomAppGrid *self)
+{
+    if (self->fallback_icon || self->fallback_requested) return;
+    self->fallback_requested = TRUE;
+
+    IconLoadCtx *ctx = g_new0 (IconLoadCtx, 1);
+    ctx->grid   = self;
+    ctx->serial = self->fallback_serial;
+    g_object_add_weak_pointer (G_OBJECT (self), (gpointer *) &ctx->grid);
+
+    icon_loader_load_async (icon_loader_get (), "application-x-executable",
+                            ICON_PRIORITY_VISIBLE, NULL, on_fallback_ready, ctx);
+}
+
+static void
+drop_fallback_icon (VenomAppGrid *self)
+{
+    g_clear_pointer (&self->fallback_icon, cairo_surface_destroy);
+    self->fallback_serial++;
+    self->fallback_requested = FALSE;
+}
+
+static PangoLayout *
+lookup_layout (VenomAppGrid *self, AppEntry *entry)
+{
+    PangoLayout *layout = g_hash_table_lookup (self->layouts, entry);
+    if (layout) return layout;
+
+    layout = gtk_widget_create_pango_layout (GTK_WIDGET (self),
+                                             entry->name ? entry->name : "");
+    pango_layout_set_width     (layout, LABEL_WIDTH * PANGO_SCALE);
+    pango_layout_set_height    (layout, -LABEL_LINES);
+    pango_layout_set_wrap      (layout, PANGO_WRAP_WORD_CHAR);
+    pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
+    pango_layout_set_alignment (layout, PANGO_ALIGN_CENTER);
+
+    g_hash_table_insert (self->layouts, entry, layout);
+    return layout;
+}
+
+static void
+drop_caches (VenomAppGrid *self)
+{
+    g_hash_table_remove_all (self->icons);
+    g_hash_table_remove_all (self->layouts);
+}
+
+/* Icon theme replaced: every cached surface may be the wrong icon */
+static void
+on_icon_theme_changed (gpointer data)
+{
+    VenomAppGrid *self = data;
+    g_hash_table_remove_all (self->icons);
+    drop_fallback_icon (self);
+    invalidate_page (self);
+}
+
+/* Font changes: new layouts and label height */
+static void
+update_font_metrics (VenomAppGrid *self)
+{
+    PangoContext     *pctx    = gtk_widget_get_pango_context (GTK_WIDGET (self));
+    PangoFontMetrics *metrics = pango_context_get_metrics (
+        pctx, pango_context_get_font_description (pctx), NULL);
+
+    int line = pango_font_metrics_get_ascent (metrics) +
+               pango_font_metrics_get_descent (metrics);
+    self->label_height = LABEL_LINES * PANGO_PIXELS_CEIL (line);
+    pango_font_metrics_unref (metrics);
 
-    /* Disable animation on absolute filter change */
-    populate_page (self, GTK_STACK_TRANSITION_TYPE_NONE);
+    g_hash_table_remove_all (self->layouts);
 }
 
 /* -------------------------------------------------------------------------
- * Signal handlers
+ * Page rendering
  * ------------------------------------------------------------------------- */
 
 static void
-on_prev_clicked (GtkButton *btn, gpointer data)
+draw_tile (VenomAppGrid *self, cairo_t *cr, int slot, AppEntry *entry,
+           const GdkRGBA *fg)
+{
+    GdkRectangle r;
+    slot_rect (self, slot, &r);
+
+    cairo_surface_t *icon = lookup_icon (self, entry, ICON_PRIORITY_VISIBLE);
+    if (!icon) icon = self->fallback_icon;
+    if (icon) {
+        cairo_set_source_surface (cr, icon,
+                                  r.x + (r.width - ICON_LOAD_SIZE) / 2,
+                                  r.y + TILE_PAD);
+        cairo_paint (cr);
+    }
+
+    PangoLayout *layout = lookup_layout (self, entry);
+    double lx = r.x + (r.width - LABEL_WIDTH) / 2;
+    double ly = r.y + TILE_PAD + ICON_LOAD_SIZE + LABEL_GAP;
+
+    /* text-shadow: 0 1px 4px rgba(0,0,0,0.75), without the blur */
+    cairo_set_source_rgba (cr, 0, 0, 0, 0.75);
+    cairo_move_to (cr, lx, ly + 1);
+    pango_cairo_show_layout (cr, layout);
+
+    gdk_cairo_set_source_rgba (cr, fg);
+    cairo_move_to (cr, lx, ly);
+    pango_cairo_show_layout (cr, layout);
+}
+
+static void
+prefetch_page (VenomAppGrid *self, int page)
 {
-    (void) btn;
-    VenomAppGrid *self = VENOM_APP_GRID (data);
-    if (self->current_page > 0) {
-        self->current_page--;
-        populate_page (self, GTK_STACK_TRANSITION_TYPE_SLIDE_RIGHT);
+    if (page < 0 || page >= self->total_pages) return;
+
+    guint start = (guint) page * APPS_PER_PAGE;
+    guint end   = MIN (start + APPS_PER_PAGE, self->filtered_apps->len);
+    for (guint i = start; i < end; i++)
+        lookup_icon (self, g_ptr_array_index (self->filtered_apps, i),
+                     ICON_PRIORITY_PREFETCH);
+}
+
+static void
+render_page (VenomAppGrid *self)
+{
+    GtkWidget *widget = GTK_WIDGET (self);
+    GdkWindow *window = gtk_widget_get_window (widget);
+    int        w      = gtk_widget_get_allocated_width (widget);
+    int        h      = page_height (self);
+
+    self->page_surface = gdk_window_create_similar_surface (
+        window, CAIRO_CONTENT_COLOR_ALPHA, w, h);
+
+    request_fallback_icon (self);
+
+    GdkRGBA fg;
+    gtk_style_context_get_color (gtk_widget_get_style_context (widget),
+                                 gtk_widget_get_state_flags (widget), &fg);
+
+    cairo_t *cr = cairo_create (self->page_surface);
+    self->rendering = TRUE;
+
+    for (int i = 0; i < page_count (self); i++)
+        draw_tile (self, cr, i, slot_entry (self, i), &fg);
+
+    /* Queued behind the visible icons; cancelled with them on a flip */
+    prefetch_page (self, self->current_page + 1);
+    prefetch_page (self, self->current_page - 1);
+
+    self->rendering = FALSE;
+    cairo_destroy (cr);
+}
+
+static void
+rounded_rect (cairo_t *cr, double x, double y, double w, double h, double r)
+{
+    cairo_new_sub_path (cr);
+    cairo_arc (cr, x + w - r, y + r,     r, -G_PI / 2, 0);
+    cairo_arc (cr, x + w - r, y + h - r, r, 0,          G_PI / 2);
+    cairo_arc (cr, x + r,     y + h - r, r, G_PI / 2,   G_PI);
+    cairo_arc (cr, x + r,     y + r,     r, G_PI,       3 * G_PI / 2);
+    cairo_close_path (cr);
+}
+
+static void
+draw_dots (VenomAppGrid *self, cairo_t *cr, int w, int h)
+{
+    double cy = h - DOTS_AREA / 2.0;
+    double x  = (w - (self->total_pages - 1) * DOT_PITCH) / 2.0;
+
+    for (int i = 0; i < self->total_pages; i++, x += DOT_PITCH) {
+        gboolean active = i == self->current_page;
+        cairo_set_source_rgba (cr, 1, 1, 1, active ? 0.90 : 0.30);
+        cairo_arc (cr, x, cy, active ? 3.5 : 2.5, 0, 2 * G_PI);
+        cairo_fill (cr);
     }
 }
 
+static double
+ease_out_cubic (double t)
+{
+    double u = 1.0 - t;
+    return 1.0 - u * u * u;
+}
+
+static gboolean
+on_slide_tick (GtkWidget *widget, GdkFrameClock *clock, gpointer data)
+{
+    (void) data;
+    VenomAppGrid *self = VENOM_APP_GRID (widget);
+    gint64        now  = gdk_frame_clock_get_frame_time (clock);
+
+    if (self->slide_start == 0) self->slide_start = now;
+
+    if (now - self->slide_start >= SLIDE_DURATION_US) {
+        self->slide_dir = 0;
+        self->tick_id   = 0;
+        g_clear_pointer (&self->prev_surface, cairo_surface_destroy);
+        gtk_widget_queue_draw (widget);
+        return G_SOURCE_REMOVE;
+    }
+
+    gtk_widget_queue_draw (widget);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+stop_slide (VenomAppGrid *self)
+{
+    if (self->tick_id)
+        gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->tick_id);
+    self->tick_id   = 0;
+    self->slide_dir = 0;
+    g_clear_pointer (&self->prev_surface, cairo_surface_destroy);
+}
+
+/* Moves to @page, sliding the old page out in direction @dir */
 static void
-on_next_clicked (GtkButton *btn, gpointer data)
+flip_page (VenomAppGrid *self, int page, int dir)
 {
-    (void) btn;
-    VenomAppGrid *self = VENOM_APP_GRID (data);
-    if (self->current_page < self->total_pages - 1) {
-        self->current_page++;
-        populate_page (self, GTK_STACK_TRANSITION_TYPE_SLIDE_LEFT);
+    stop_slide (self);
+
+    /* The rendered old page is all the animation needs */
+    self->prev_surface = self->page_surface;
+    self->page_surface = NULL;
+    self->current_page = page;
+    self->hover        = -1;
+    self->pressed      = -1;
+    new_page_generation (self);
+
+    if (self->prev_surface && gtk_widget_get_mapped (GTK_WIDGET (self))) {
+        self->slide_dir   = dir;
+        self->slide_start = 0;
+        self->tick_id     = gtk_widget_add_tick_callback (
+            GTK_WIDGET (self), on_slide_tick, NULL, NULL);
+    } else {
+        g_clear_pointer (&self->prev_surface, cairo_surface_destroy);
     }
+
+    gtk_widget_queue_draw (GTK_WIDGET (self));
 }
 
 /* -------------------------------------------------------------------------
- * GObject class init
+ * Helpers
  * ------------------------------------------------------------------------- */
 
+static int
+count_pages (VenomAppGrid *self)
+{
+    return MAX (1,
+        (int) ceil ((double) self->filtered_apps->len / APPS_PER_PAGE));
+}
+
 static void
-venom_app_grid_finalize (GObject *obj)
+collect (VenomAppGrid *self)
 {
-    VenomAppGrid *self = VENOM_APP_GRID (obj);
-    g_ptr_array_unref (self->filtered_apps);
-    G_OBJECT_CLASS (venom_app_grid_parent_class)->finalize (obj);
+    /* Without a query only the first page is reserved for most-used apps */
+    guint limit = search_index_has_query (self->index) ? FUZZY_RESULTS
+                                                      : APPS_PER_PAGE;
+
+    g_ptr_array_set_size (self->filtered_apps, 0);
+    self->n_ranked = search_index_collect (self->index, self->all_apps, limit,
+                                           self->filtered_apps);
+    self->needs_collect = FALSE;
+    self->usage_gen     = usage_store_get_generation (usage_store_get ());
+
+    if (g_hash_table_size (self->layouts) > RENDER_CACHE_MAX)
+        drop_caches (self);
 }
 
 static void
-venom_app_grid_class_init (VenomAppGridClass *klass)
+rebuild_filter (VenomAppGrid *self, const char *query)
 {
-    GObjectClass *obj_class = G_OBJECT_CLASS (klass);
-    obj_class->finalize = venom_app_grid_finalize;
+    if (query && !*query) query = NULL;
+
+    /* Same query over the same catalog and usage: only return to page 0 */
+    if (g_strcmp0 (query, self->query) == 0 && !self->needs_collect &&
+        self->usage_gen == usage_store_get_generation (usage_store_get ())) {
+        if (self->current_page != 0) {
+            self->current_page = 0;
+            self->hover        = -1;
+            self->pressed      = -1;
+            new_page_generation (self);
+            stop_slide (self);
+            invalidate_page (self);
+        }
+        return;
+    }
+
+    char *copy = g_strdup (query);   /* may be self->query */
+    g_free (self->query);
+    self->query = copy;
+
+    /* Posting-list intersection + fuzzy ranking of names */
+    search_index_set_query (self->index, query);
+    collect (self);
+
+    self->current_page = 0;
+    self->total_pages  = count_pages (self);
+    self->page_dirty   = FALSE;
+    self->hover        = -1;
+    self->pressed      = -1;
+    new_page_generation (self);
+
+    /* No animation on absolute filter change */
+    stop_slide (self);
+    invalidate_page (self);
 }
 
-static GtkWidget *
-create_flow_box (void)
+/*
+ * A filtered-list change at @index only disturbs the visible icons if it
+ * lands on or before the current page (everything after it shifts).
+ */
+static void
+mark_change (VenomAppGrid *self, guint index)
 {
-    GtkWidget *fb = gtk_flow_box_new ();
-    gtk_flow_box_set_max_children_per_line (GTK_FLOW_BOX (fb), GRID_COLUMNS);
-    gtk_flow_box_set_min_children_per_line (GTK_FLOW_BOX (fb), GRID_COLUMNS);
-    gtk_flow_box_set_selection_mode (GTK_FLOW_BOX (fb), GTK_SELECTION_NONE);
-    gtk_flow_box_set_homogeneous (GTK_FLOW_BOX (fb), TRUE);
-    gtk_widget_set_vexpand (fb, TRUE);
-    gtk_widget_set_hexpand (fb, TRUE);
+    guint page_end = (guint) (self->current_page + 1) * APPS_PER_PAGE;
+    if (index < page_end || count_pages (self) != self->total_pages)
+        self->page_dirty = TRUE;
+}
 
-    gtk_flow_box_set_column_spacing (GTK_FLOW_BOX (fb), 10);
-    gtk_flow_box_set_row_spacing (GTK_FLOW_BOX (fb), 10);
-    gtk_widget_set_valign (fb, GTK_ALIGN_START); /* Prevent jumpiness during transitions */
+/* -------------------------------------------------------------------------
+ * GtkWidget vfuncs
+ * ------------------------------------------------------------------------- */
+
+static gboolean
+venom_app_grid_draw (GtkWidget *widget, cairo_t *cr)
+{
+    VenomAppGrid *self = VENOM_APP_GRID (widget);
+    int w = gtk_widget_get_allocated_width (widget);
+    int h = gtk_widget_get_allocated_height (widget);
+
+    if (!self->page_surface)
+        render_page (self);
+
+    if (self->slide_dir != 0) {
+        GdkFrameClock *clock = gtk_widget_get_frame_clock (widget);
+        gint64 now = clock ? gdk_frame_clock_get_frame_time (clock) : 0;
+        double t   = self->slide_start
+                   ? CLAMP ((double) (now - self->slide_start) / SLIDE_DURATION_US, 0.0, 1.0)
+                   : 0.0;
+        double x   = self->slide_dir * w * (1.0 - ease_out_cubic (t));
+
+        cairo_set_source_surface (cr, self->prev_surface, x - self->slide_dir * w, 0);
+        cairo_paint (cr);
+        cairo_set_source_surface (cr, self->page_surface, x, 0);
+        cairo_paint (cr);
+    } else {
+        /* Hover / press background goes under the tile */
+        int slot = self->pressed >= 0 ? self->pressed : self->hover;
+        if (slot >= 0) {
+            GdkRectangle r;
+            slot_rect (self, slot, &r);
+            cairo_set_source_rgba (cr, 1, 1, 1, self->pressed >= 0 ? 0.20 : 0.11);
+            rounded_rect (cr, r.x, r.y, r.width, r.height, TILE_RADIUS);
+            cairo_fill (cr);
+        }
 
-    gtk_style_context_add_class (gtk_widget_get_style_context (fb), "app-grid");
-    return fb;
+        cairo_set_source_surface (cr, self->page_surface, 0, 0);
+        cairo_paint (cr);
+    }
+
+    draw_dots (self, cr, w, h);
+    return FALSE;
 }
 
 static void
-venom_app_grid_init (VenomAppGrid *self)
+set_hover (VenomAppGrid *self, int slot)
 {
-    gtk_orientable_set_orientation (GTK_ORIENTABLE (self),
-                                    GTK_ORIENTATION_VERTICAL);
-    gtk_box_set_spacing (GTK_BOX (self), 20);
+    if (self->hover == slot) return;
+    self->hover = slot;
+    gtk_widget_queue_draw (GTK_WIDGET (self));
+}
 
-    /* ── Main Layout ─────────────────────────────────────────────────── */
-    /*
-     * Top struct: VBox
-     *  - Middle: HBox (Left Arrow, FlowBox, Right Arrow)
-     *  - Bottom: Dots box (centered)
-     */
+static gboolean
+venom_app_grid_motion_notify (GtkWidget *widget, GdkEventMotion *event)
+{
+    VenomAppGrid *self = VENOM_APP_GRID (widget);
+    set_hover (self, self->slide_dir ? -1 : hit_test (self, event->x, event->y));
+    return FALSE;
+}
 
-    /* Middle HBox */
-    GtkWidget *middle_hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 20);
-    gtk_box_pack_start (GTK_BOX (self), middle_hbox, TRUE, TRUE, 0);
+static gboolean
+venom_app_grid_leave_notify (GtkWidget *widget, GdkEventCrossing *event)
+{
+    (void) event;
+    set_hover (VENOM_APP_GRID (widget), -1);
+    return FALSE;
+}
+
+static gboolean
+venom_app_grid_button_press (GtkWidget *widget, GdkEventButton *event)
+{
+    VenomAppGrid *self = VENOM_APP_GRID (widget);
+    if (event->type != GDK_BUTTON_PRESS || self->slide_dir) return FALSE;
+
+    int       slot  = hit_test (self, event->x, event->y);
+    AppEntry *entry = slot_entry (self, slot);
+    if (!entry) return FALSE;
+
+    /* Right click (button 3) reveals context menu */
+    if (event->button == GDK_BUTTON_SECONDARY) {
+        app_actions_popup_menu (entry, widget, (GdkEvent *) event);
+        return TRUE;
+    }
+
+    if (event->button == GDK_BUTTON_PRIMARY) {
+        self->pressed = slot;
+        gtk_widget_queue_draw (widget);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static gboolean
+venom_app_grid_button_release (GtkWidget *widget, GdkEventButton *event)
+{
+    VenomAppGrid *self = VENOM_APP_GRID (widget);
+    if (event->button != GDK_BUTTON_PRIMARY || self->pressed < 0) return FALSE;
+
+    int pressed = self->pressed;
+    self->pressed = -1;
+    gtk_widget_queue_draw (widget);
+
+    /* Like a button: only fires if released over the same tile */
+    if (hit_test (self, event->x, event->y) == pressed) {
+        AppEntry *entry = slot_entry (self, pressed);
+        if (entry) app_actions_launch (entry, widget);
+    }
+    return TRUE;
+}
 
-    /* ── Stack (replaces Single FlowBox) ────────────────────────────── */
-    self->stack = gtk_stack_new ();
-    gtk_stack_set_transition_duration (GTK_STACK (self->stack), 350);
-    gtk_widget_set_vexpand (self->stack, TRUE);
-    gtk_widget_set_hexpand (self->stack, TRUE);
+static void
+venom_app_grid_size_allocate (GtkWidget *widget, GtkAllocation *alloc)
+{
+    VenomAppGrid *self = VENOM_APP_GRID (widget);
+    GtkAllocation old;
+    gtk_widget_get_allocation (widget, &old);
 
-    self->flow_box_1 = create_flow_box ();
-    self->flow_box_2 = create_flow_box ();
-    self->active_box = 1;
+    GTK_WIDGET_CLASS (venom_app_grid_parent_class)->size_allocate (widget, alloc);
 
-    gtk_stack_add_named (GTK_STACK (self->stack), self->flow_box_1, "page1");
-    gtk_stack_add_named (GTK_STACK (self->stack), self->flow_box_2, "page2");
+    if (old.width != alloc->width || old.height != alloc->height) {
+        stop_slide (self);
+        g_clear_pointer (&self->page_surface, cairo_surface_destroy);
+    }
+}
 
-    gtk_box_pack_start (GTK_BOX (middle_hbox), self->stack, TRUE, TRUE, 0);
+static void
+venom_app_grid_style_updated (GtkWidget *widget)
+{
+    VenomAppGrid *self = VENOM_APP_GRID (widget);
+    GTK_WIDGET_CLASS (venom_app_grid_parent_class)->style_updated (widget);
 
-    /* ── Bottom Pagination Dots ──────────────────────────────────────── */
-    GtkWidget *dots_container = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
-    gtk_widget_set_halign (dots_container, GTK_ALIGN_CENTER);
-    gtk_widget_set_margin_bottom (dots_container, 40);
-    gtk_box_pack_end (GTK_BOX (self), dots_container, FALSE, FALSE, 0);
+    update_font_metrics (self);
+    invalidate_page (self);
+}
 
-    self->dots_box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
-    gtk_widget_set_valign (self->dots_box, GTK_ALIGN_CENTER);
-    gtk_box_pack_start (GTK_BOX (dots_container), self->dots_box, FALSE, FALSE, 0);
+static void
+venom_app_grid_unrealize (GtkWidget *widget)
+{
+    VenomAppGrid *self = VENOM_APP_GRID (widget);
+
+    /* Page surfaces are similar to the GdkWindow */
+    stop_slide (self);
+    if (self->prerender_id) {
+        g_source_remove (self->prerender_id);
+        self->prerender_id = 0;
+    }
+    g_clear_pointer (&self->page_surface, cairo_surface_destroy);
+
+    GTK_WIDGET_CLASS (venom_app_grid_parent_class)->unrealize (widget);
+}
+
+/* -------------------------------------------------------------------------
+ * GObject class init
+ * ------------------------------------------------------------------------- */
+
+static void
+venom_app_grid_finalize (GObject *obj)
+{
+    VenomAppGrid *self   = VENOM_APP_GRID (obj);
+    IconLoader   *loader = icon_loader_get ();
+    if (loader) icon_loader_remove_theme_watch (loader, self->theme_watch);
+    if (self->prerender_id) g_source_remove (self->prerender_id);
+    g_cancellable_cancel (self->page_cancel);
+    g_object_unref (self->page_cancel);
+    g_ptr_array_unref (self->filtered_apps);
+    g_free (self->query);
+    g_hash_table_destroy (self->icons);
+    g_hash_table_destroy (self->layouts);
+    g_clear_pointer (&self->fallback_icon, cairo_surface_destroy);
+    g_clear_pointer (&self->page_surface, cairo_surface_destroy);
+    g_clear_pointer (&self->prev_surface, cairo_surface_destroy);
+    G_OBJECT_CLASS (venom_app_grid_parent_class)->finalize (obj);
+}
+
+static void
+venom_app_grid_class_init (VenomAppGridClass *klass)
+{
+    GObjectClass   *obj_class    = G_OBJECT_CLASS (klass);
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+    obj_class->finalize = venom_app_grid_finalize;
+
+    widget_class->draw                 = venom_app_grid_draw;
+    widget_class->motion_notify_event  = venom_app_grid_motion_notify;
+    widget_class->leave_notify_event   = venom_app_grid_leave_notify;
+    widget_class->button_press_event   = venom_app_grid_button_press;
+    widget_class->button_release_event = venom_app_grid_button_release;
+    widget_class->size_allocate        = venom_app_grid_size_allocate;
+    widget_class->style_updated        = venom_app_grid_style_updated;
+    widget_class->unrealize            = venom_app_grid_unrealize;
+}
+
+static void
+venom_app_grid_init (VenomAppGrid *self)
+{
+    GtkWidget *widget = GTK_WIDGET (self);
+
+    gtk_widget_set_vexpand (widget, TRUE);
+    gtk_widget_set_hexpand (widget, TRUE);
+    gtk_widget_add_events (widget, GDK_BUTTON_PRESS_MASK |
+                                   GDK_BUTTON_RELEASE_MASK |
+                                   GDK_POINTER_MOTION_MASK |
+                                   GDK_LEAVE_NOTIFY_MASK);
+    gtk_style_context_add_class (gtk_widget_get_style_context (widget), "app-grid");
 
     self->filtered_apps = g_ptr_array_new ();
+    self->icons   = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                           NULL, icon_slot_free);
+    self->layouts = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                           NULL, g_object_unref);
+    self->hover   = -1;
+    self->pressed = -1;
+    self->page_cancel = g_cancellable_new ();
+    self->theme_watch = icon_loader_add_theme_watch (icon_loader_get (),
+                                                     on_icon_theme_changed, self);
+
+    update_font_metrics (self);
 }
 
 /* -------------------------------------------------------------------------
@@ -255,10 +861,12 @@ venom_app_grid_init (VenomAppGrid *self)
  * ------------------------------------------------------------------------- */
 
 GtkWidget *
-venom_app_grid_new (GPtrArray *apps)
+venom_app_grid_new (GPtrArray *apps, SearchIndex *index)
 {
     VenomAppGrid *self = g_object_new (VENOM_TYPE_APP_GRID, NULL);
-    self->all_apps = apps;
+    self->all_apps      = apps;
+    self->index         = index;
+    self->needs_collect = TRUE;
     rebuild_filter (self, NULL);
     return GTK_WIDGET (self);
 }
@@ -270,16 +878,123 @@ venom_app_grid_set_filter (VenomAppGrid *grid, const char *query)
     rebuild_filter (grid, query);
 }
 
+void
+venom_app_grid_set_category (VenomAppGrid *grid, gint category)
+{
+    g_return_if_fail (VENOM_IS_APP_GRID (grid));
+    if (category == search_index_get_category (grid->index)) return;
+
+    /* A bitset AND in the index; only the ranking is redone */
+    search_index_set_category (grid->index, category);
+    grid->needs_collect = TRUE;
+    rebuild_filter (grid, grid->query);
+}
+
+void
+venom_app_grid_prerender (VenomAppGrid *grid)
+{
+    g_return_if_fail (VENOM_IS_APP_GRID (grid));
+    prerender (grid);
+}
+
+void
+venom_app_grid_trim (VenomAppGrid *grid)
+{
+    g_return_if_fail (VENOM_IS_APP_GRID (grid));
+
+    /* In-flight loads find no slot and are dropped */
+    new_page_generation (grid);
+    drop_caches (grid);
+    drop_fallback_icon (grid);
+
+    /* Not re-rendered until drawn again */
+    stop_slide (grid);
+    if (grid->prerender_id) {
+        g_source_remove (grid->prerender_id);
+        grid->prerender_id = 0;
+    }
+    g_clear_pointer (&grid->page_surface, cairo_surface_destroy);
+}
+
+void
+venom_app_grid_app_added (VenomAppGrid *grid, AppEntry *entry)
+{
+    g_return_if_fail (VENOM_IS_APP_GRID (grid));
+    g_return_if_fail (entry != NULL);
+
+    /* Ranked results have no insertion point — recompute on flush */
+    if (search_index_has_query (grid->index)) {
+        grid->needs_collect = TRUE;
+        return;
+    }
+
+    if (!search_index_matches (grid->index, entry)) return;
+
+    /* Unfiltered, the part after the most-used apps keeps the catalog
+     * order — binary search the slot */
+    guint lo = grid->n_ranked, hi = grid->filtered_apps->len;
+    while (lo < hi) {
+        guint mid = (lo + hi) / 2;
+        AppEntry *m = g_ptr_array_index (grid->filtered_apps, mid);
+        if (app_entry_collate (m, entry) < 0) lo = mid + 1;
+        else                                  hi = mid;
+    }
+
+    g_ptr_array_insert (grid->filtered_apps, (gint) lo, entry);
+    mark_change (grid, lo);
+}
+
+void
+venom_app_grid_app_removed (VenomAppGrid *grid, AppEntry *entry)
+{
+    g_return_if_fail (VENOM_IS_APP_GRID (grid));
+
+    /* Keys must not outlive the entry (an in-flight load is ignored) */
+    g_hash_table_remove (grid->icons, entry);
+    g_hash_table_remove (grid->layouts, entry);
+
+    guint index;
+    if (!g_ptr_array_find (grid->filtered_apps, entry, &index)) return;
+
+    g_ptr_array_remove_index (grid->filtered_apps, index);
+    if (index < grid->n_ranked) grid->n_ranked--;
+    mark_change (grid, index);
+}
+
+void
+venom_app_grid_flush_changes (VenomAppGrid *grid)
+{
+    g_return_if_fail (VENOM_IS_APP_GRID (grid));
+
+    if (grid->needs_collect) {
+        collect (grid);
+        grid->page_dirty = TRUE;
+    }
+
+    if (!grid->page_dirty) return;
+    grid->page_dirty = FALSE;
+
+    grid->total_pages  = count_pages (grid);
+    grid->current_page = MIN (grid->current_page, grid->total_pages - 1);
+    grid->hover        = -1;
+    grid->pressed      = -1;
+    new_page_generation (grid);
+
+    invalidate_page (grid);
+}
+
 void
 venom_app_grid_go_next_page (VenomAppGrid *grid)
 {
     g_return_if_fail (VENOM_IS_APP_GRID (grid));
-    on_next_clicked (NULL, grid);
+    if (grid->current_page < grid->total_pages - 1)
+        flip_page (grid, grid->current_page + 1, +1);
 }
 
 void
 venom_app_grid_go_prev_page (VenomAppGrid *grid)
 {
     g_return_if_fail (VENOM_IS_APP_GRID (grid));
-    on_prev_clicked (NULL, grid);
+    if (grid->current_page > 0)
+        flip_page (grid, grid->current_page - 1, -1);
 }
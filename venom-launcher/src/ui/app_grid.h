@@ -2,23 +2,56 @@
 
 #include <gtk/gtk.h>
 #include <glib.h>
+#include "../core/app_entry.h"
+#include "../core/search_index.h"
 
 G_BEGIN_DECLS
 
 #define VENOM_TYPE_APP_GRID (venom_app_grid_get_type ())
-G_DECLARE_FINAL_TYPE (VenomAppGrid, venom_app_grid, VENOM, APP_GRID, GtkBox)
+G_DECLARE_FINAL_TYPE (VenomAppGrid, venom_app_grid, VENOM, APP_GRID,
+                      GtkDrawingArea)
 
 /**
  * VenomAppGrid - Paginated icon grid + pagination dots.
  * Lays out AppEntry list in pages of APPS_PER_PAGE items.
+ *
+ * One widget draws the whole page with cairo and Pango: icon surfaces
+ * and label layouts are cached per entry, the page is rendered once to
+ * an offscreen surface, and page flips slide between two such surfaces.
+ * Clicks and right-clicks are hit-tested against the tile geometry, so
+ * changing the filter or page never creates widgets.
  */
 #define APPS_PER_PAGE   35
 #define GRID_COLUMNS     7
+#define GRID_ROWS       (APPS_PER_PAGE / GRID_COLUMNS)
 
-GtkWidget *venom_app_grid_new          (GPtrArray  *apps);
+GtkWidget *venom_app_grid_new          (GPtrArray    *apps,
+                                        SearchIndex  *index);
+/* A repeated query only returns to the first page; nothing is recomputed */
 void       venom_app_grid_set_filter   (VenomAppGrid *grid,
                                         const char   *query);
+/* Shows only apps in @category (see SearchIndex; -1 = all), with the query */
+void       venom_app_grid_set_category (VenomAppGrid *grid,
+                                        gint          category);
+/* Renders the current page offscreen now (realized and allocated only) */
+void       venom_app_grid_prerender    (VenomAppGrid *grid);
+/* Drops icons, label layouts and page surfaces; rebuilt when next drawn */
+void       venom_app_grid_trim         (VenomAppGrid *grid);
 void       venom_app_grid_go_next_page (VenomAppGrid *grid);
+
+/*
+ * Incremental catalog updates. The caller inserts @entry into the apps
+ * array and the SearchIndex first (added), or removes it from both
+ * afterwards (removed), then calls
+ * venom_app_grid_flush_changes() once per batch. The visible page is
+ * only rebuilt if the batch changed what it shows; removed entries must
+ * stay alive until the flush (removed drops their cached surfaces).
+ */
+void       venom_app_grid_app_added     (VenomAppGrid *grid,
+                                         AppEntry     *entry);
+void       venom_app_grid_app_removed   (VenomAppGrid *grid,
+                                         AppEntry     *entry);
+void       venom_app_grid_flush_changes (VenomAppGrid *grid);
 void       venom_app_grid_go_prev_page (VenomAppGrid *grid);
 
 G_END_DECLS
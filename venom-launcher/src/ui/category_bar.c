@@ -0,0 +1,167 @@
+#include "category_bar.h"
+
+/* Freedesktop main categories, in bar order */
+static const struct {
+    const char *category;
+    const char *label;
+} main_categories[] = {
+    { "AudioVideo",  "Multimedia"  },
+    { "Development", "Development" },
+    { "Education",   "Education"   },
+    { "Game",        "Games"       },
+    { "Graphics",    "Graphics"    },
+    { "Network",     "Internet"    },
+    { "Office",      "Office"      },
+    { "Science",     "Science"     },
+    { "Settings",    "Settings"    },
+    { "System",      "System"      },
+    { "Utility",     "Utilities"   },
+};
+
+#define N_MAIN  G_N_ELEMENTS (main_categories)
+
+/* -------------------------------------------------------------------------
+ * Widget struct
+ * ------------------------------------------------------------------------- */
+
+struct _VenomCategoryBar {
+    GtkBox      parent_instance;
+    GtkWidget  *all_button;
+    GtkWidget  *buttons[N_MAIN];
+    gint        ids[N_MAIN];     /* SearchIndex category id, -1 = no apps */
+    gint        category;        /* current selection, -1 = all */
+};
+
+G_DEFINE_TYPE (VenomCategoryBar, venom_category_bar, GTK_TYPE_BOX)
+
+/* Signals */
+enum { SIGNAL_CATEGORY_CHANGED, N_SIGNALS };
+static guint signals[N_SIGNALS];
+
+/* -------------------------------------------------------------------------
+ * Selection
+ * ------------------------------------------------------------------------- */
+
+static void
+select_category (VenomCategoryBar *self, gint category)
+{
+    if (self->category == category) return;
+    self->category = category;
+    g_signal_emit (self, signals[SIGNAL_CATEGORY_CHANGED], 0);
+}
+
+static void
+on_toggled (GtkToggleButton *button, gpointer user_data)
+{
+    VenomCategoryBar *self = VENOM_CATEGORY_BAR (user_data);
+
+    /* Radio group: only the newly active button matters */
+    if (!gtk_toggle_button_get_active (button)) return;
+
+    if (GTK_WIDGET (button) == self->all_button) {
+        select_category (self, -1);
+        return;
+    }
+
+    for (guint i = 0; i < N_MAIN; i++)
+        if (GTK_WIDGET (button) == self->buttons[i])
+            select_category (self, self->ids[i]);
+}
+
+static GtkWidget *
+add_button (VenomCategoryBar *self, GtkWidget *group, const char *label)
+{
+    GtkWidget *button = group
+        ? gtk_radio_button_new_with_label_from_widget (GTK_RADIO_BUTTON (group), label)
+        : gtk_radio_button_new_with_label (NULL, label);
+
+    gtk_toggle_button_set_mode (GTK_TOGGLE_BUTTON (button), FALSE);
+    gtk_widget_set_can_focus (button, FALSE);
+    gtk_style_context_add_class (gtk_widget_get_style_context (button),
+                                 "category-button");
+    g_signal_connect (button, "toggled", G_CALLBACK (on_toggled), self);
+
+    gtk_box_pack_start (GTK_BOX (self), button, FALSE, FALSE, 0);
+    return button;
+}
+
+/* -------------------------------------------------------------------------
+ * GObject class init
+ * ------------------------------------------------------------------------- */
+
+static void
+venom_category_bar_class_init (VenomCategoryBarClass *klass)
+{
+    signals[SIGNAL_CATEGORY_CHANGED] =
+        g_signal_new ("category-changed",
+                      G_TYPE_FROM_CLASS (klass),
+                      G_SIGNAL_RUN_LAST,
+                      0, NULL, NULL,
+                      g_cclosure_marshal_VOID__VOID,
+                      G_TYPE_NONE, 0);
+}
+
+static void
+venom_category_bar_init (VenomCategoryBar *self)
+{
+    gtk_orientable_set_orientation (GTK_ORIENTABLE (self),
+                                    GTK_ORIENTATION_HORIZONTAL);
+    gtk_box_set_spacing (GTK_BOX (self), 8);
+    gtk_widget_set_halign (GTK_WIDGET (self), GTK_ALIGN_CENTER);
+    gtk_style_context_add_class (
+        gtk_widget_get_style_context (GTK_WIDGET (self)), "category-bar");
+
+    self->category   = -1;
+    self->all_button = add_button (self, NULL, "All");
+
+    for (guint i = 0; i < N_MAIN; i++) {
+        self->buttons[i] = add_button (self, self->all_button,
+                                       main_categories[i].label);
+        self->ids[i]     = -1;
+        gtk_widget_set_no_show_all (self->buttons[i], TRUE);
+    }
+}
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+GtkWidget *
+venom_category_bar_new (void)
+{
+    return g_object_new (VENOM_TYPE_CATEGORY_BAR, NULL);
+}
+
+void
+venom_category_bar_update (VenomCategoryBar *bar, SearchIndex *index)
+{
+    g_return_if_fail (VENOM_IS_CATEGORY_BAR (bar));
+    g_return_if_fail (index != NULL);
+
+    for (guint i = 0; i < N_MAIN; i++) {
+        gint id = search_index_lookup_category (index, main_categories[i].category);
+        if (id >= 0 && search_index_category_size (index, id) == 0) id = -1;
+
+        bar->ids[i] = id;
+        gtk_widget_set_visible (bar->buttons[i], id >= 0);
+
+        /* The selected category lost its last app: back to all */
+        if (id < 0 &&
+            gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (bar->buttons[i])))
+            venom_category_bar_reset (bar);
+    }
+}
+
+gint
+venom_category_bar_get_category (VenomCategoryBar *bar)
+{
+    g_return_val_if_fail (VENOM_IS_CATEGORY_BAR (bar), -1);
+    return bar->category;
+}
+
+void
+venom_category_bar_reset (VenomCategoryBar *bar)
+{
+    g_return_if_fail (VENOM_IS_CATEGORY_BAR (bar));
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (bar->all_button), TRUE);
+}
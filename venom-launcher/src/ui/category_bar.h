@@ -0,0 +1,30 @@
+#pragma once
+
+#include <gtk/gtk.h>
+#include "../core/search_index.h"
+
+G_BEGIN_DECLS
+
+#define VENOM_TYPE_CATEGORY_BAR (venom_category_bar_get_type ())
+G_DECLARE_FINAL_TYPE (VenomCategoryBar, venom_category_bar,
+                      VENOM, CATEGORY_BAR, GtkBox)
+
+/**
+ * VenomCategoryBar - Row of toggle buttons: "All" plus the freedesktop
+ * main categories that have apps in the catalog.
+ * Emits "category-changed" when the selection changes; the selection is
+ * a SearchIndex category id (-1 = all).  Buttons never take focus, so
+ * typing keeps going to the search bar.
+ */
+GtkWidget *venom_category_bar_new          (void);
+
+/* Re-resolves category ids and hides empty categories (after catalog changes) */
+void       venom_category_bar_update       (VenomCategoryBar *bar,
+                                            SearchIndex      *index);
+
+gint       venom_category_bar_get_category (VenomCategoryBar *bar);
+
+/* Selects "All" */
+void       venom_category_bar_reset        (VenomCategoryBar *bar);
+
+G_END_DECLS
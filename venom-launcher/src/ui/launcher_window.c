@@ -1,11 +1,26 @@
+#define _DEFAULT_SOURCE   /* sysconf(), malloc_trim() */
+
 #include "launcher_window.h"
 #include "search_bar.h"
+#include "category_bar.h"
 #include "app_grid.h"
 #include "../core/desktop_reader.h"
+#include "../core/app_monitor.h"
+#include "../core/session_catalog.h"
+#include "../core/search_index.h"
 #include "../core/icon_loader.h"
+#include "../core/usage_store.h"
 
 #include <gdk/gdk.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/* One frame at 60 Hz; slower shows are logged as a regression */
+#define SHOW_BUDGET_US  16000
 
 /* -------------------------------------------------------------------------
  * Private struct
@@ -15,9 +30,27 @@ struct _VenomLauncherWindow {
     GtkApplicationWindow  parent_instance;
 
     GPtrArray    *apps;
+    GHashTable   *apps_by_id;   /* desktop id -> AppEntry* (in apps) */
+    SearchIndex  *index;
+
+    /* Catalog source: the session snapshot, or our own AppMonitor when
+     * venom-catalogd cannot be reached */
+    SessionCatalog *snapshot;
+    guint32       snapshot_version;
+    guint         catalog_watch;
+    AppMonitor   *monitor;
     GtkWidget    *search_bar;
+    GtkWidget    *category_bar;
     GtkWidget    *app_grid;
     GtkWidget    *root_overlay;
+
+    /* Show latency: from the show request to the first painted frame */
+    gint64        show_start;
+    gulong        paint_handler;
+
+    /* Render caches are released after this long hidden (0 = never) */
+    guint         trim_delay_s;
+    guint         trim_id;
 };
 
 G_DEFINE_TYPE (VenomLauncherWindow, venom_launcher_window,
@@ -194,6 +227,21 @@ on_scroll (GtkWidget *widget, GdkEventScroll *event, gpointer user_data)
  * Search changed handler
  * ------------------------------------------------------------------------- */
 
+static guint
+search_cost (const char *text, gpointer data)
+{
+    VenomLauncherWindow *self = VENOM_LAUNCHER_WINDOW (data);
+    return search_index_estimate (self->index, text);
+}
+
+static void
+on_category_changed (GtkWidget *bar, gpointer data)
+{
+    VenomLauncherWindow *self = VENOM_LAUNCHER_WINDOW (data);
+    gint category = venom_category_bar_get_category (VENOM_CATEGORY_BAR (bar));
+    venom_app_grid_set_category (VENOM_APP_GRID (self->app_grid), category);
+}
+
 static void
 on_search_changed (GtkWidget *search, gpointer data)
 {
@@ -204,6 +252,248 @@ on_search_changed (GtkWidget *search, gpointer data)
 
 
 
+/* -------------------------------------------------------------------------
+ * Live catalog updates
+ * ------------------------------------------------------------------------- */
+
+static guint
+sorted_insert_index (GPtrArray *apps, AppEntry *entry)
+{
+    guint lo = 0, hi = apps->len;
+    while (lo < hi) {
+        guint mid = (lo + hi) / 2;
+        if (app_entry_collate (g_ptr_array_index (apps, mid), entry) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static gboolean
+entries_equal (const AppEntry *a, const AppEntry *b)
+{
+    return g_strcmp0 (a->name,         b->name)         == 0 &&
+           g_strcmp0 (a->exec,         b->exec)         == 0 &&
+           g_strcmp0 (a->icon_name,    b->icon_name)    == 0 &&
+           g_strcmp0 (a->categories,   b->categories)   == 0 &&
+           g_strcmp0 (a->comment,      b->comment)      == 0 &&
+           g_strcmp0 (a->generic_name, b->generic_name) == 0 &&
+           g_strcmp0 (a->keywords,     b->keywords)     == 0 &&
+           g_strcmp0 (a->desktop_path, b->desktop_path) == 0;
+}
+
+/* Current entry for @id from the snapshot, or by parsing its file */
+static AppEntry *
+resolve_entry (VenomLauncherWindow *self, const char *id)
+{
+    if (self->snapshot)
+        return session_catalog_lookup (self->snapshot, id);
+    return desktop_reader_resolve_id (id);
+}
+
+/*
+ * Re-resolve each changed desktop id and patch the catalog and grid in
+ * place. Replaced/removed entries are kept alive until the grid has
+ * dropped its widgets for them.
+ */
+static void
+on_apps_changed (GPtrArray *desktop_ids, gpointer data)
+{
+    VenomLauncherWindow *self  = VENOM_LAUNCHER_WINDOW (data);
+    VenomAppGrid        *grid  = VENOM_APP_GRID (self->app_grid);
+    GPtrArray           *stale = g_ptr_array_new_with_free_func (
+        (GDestroyNotify) app_entry_free);
+    gboolean             added = FALSE;
+
+    for (guint i = 0; i < desktop_ids->len; i++) {
+        const char *id  = g_ptr_array_index (desktop_ids, i);
+        AppEntry   *old = g_hash_table_lookup (self->apps_by_id, id);
+        AppEntry   *cur = resolve_entry (self, id);
+
+        if (!old && !cur) continue;
+
+        /* Touched but nothing we display changed (e.g. a reinstall) */
+        if (old && cur && entries_equal (old, cur)) {
+            app_entry_free (cur);
+            continue;
+        }
+
+        if (old) {
+            venom_app_grid_app_removed (grid, old);
+            search_index_remove (self->index, old);
+            g_hash_table_remove (self->apps_by_id, id);
+
+            guint index;
+            if (g_ptr_array_find (self->apps, old, &index))
+                g_ptr_array_add (stale,
+                                 g_ptr_array_steal_index (self->apps, index));
+        }
+
+        if (cur) {
+            g_ptr_array_insert (self->apps,
+                                (gint) sorted_insert_index (self->apps, cur),
+                                cur);
+            g_hash_table_insert (self->apps_by_id,
+                                 (gpointer) app_entry_get_id (cur), cur);
+            search_index_add (self->index, cur);
+            venom_app_grid_app_added (grid, cur);
+            added = TRUE;
+        }
+    }
+
+    venom_app_grid_flush_changes (grid);
+    venom_category_bar_update (VENOM_CATEGORY_BAR (self->category_bar),
+                               self->index);
+
+    /* Packages install their icons alongside the .desktop file */
+    if (added)
+        icon_loader_rescan (icon_loader_get ());
+    g_ptr_array_unref (stale);
+}
+
+/*
+ * A new snapshot was published: switch to it and patch every id that
+ * was or now is in the catalog (unchanged ones are skipped cheaply).
+ */
+static void
+on_catalog_changed (guint32 version, gpointer data)
+{
+    VenomLauncherWindow *self = VENOM_LAUNCHER_WINDOW (data);
+
+    if (version != 0 && version == self->snapshot_version) return;
+
+    /* No service, or a snapshot for another locale: watch the directories ourselves */
+    SessionCatalog *snapshot = version ? session_catalog_open () : NULL;
+    if (!snapshot) {
+        g_clear_pointer (&self->snapshot, session_catalog_free);
+        self->snapshot_version = 0;
+        if (!self->monitor)
+            self->monitor = app_monitor_new (on_apps_changed, self);
+        return;
+    }
+
+    app_monitor_free (self->monitor);
+    self->monitor = NULL;
+    session_catalog_free (self->snapshot);
+    self->snapshot         = snapshot;
+    self->snapshot_version = session_catalog_get_version (snapshot);
+
+    GHashTable *set = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    GHashTableIter iter;
+    gpointer       key;
+    g_hash_table_iter_init (&iter, self->apps_by_id);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        g_hash_table_add (set, g_strdup (key));
+    for (guint i = 0; i < session_catalog_get_n_apps (snapshot); i++)
+        g_hash_table_add (set, g_strdup (session_catalog_get_id (snapshot, i)));
+
+    GPtrArray *ids = g_ptr_array_new_with_free_func (g_free);
+    g_hash_table_iter_init (&iter, set);
+    while (g_hash_table_iter_next (&iter, &key, NULL)) {
+        g_ptr_array_add (ids, key);
+        g_hash_table_iter_steal (&iter);
+    }
+
+    on_apps_changed (ids, self);
+
+    g_ptr_array_unref (ids);
+    g_hash_table_destroy (set);
+}
+
+/* -------------------------------------------------------------------------
+ * Show / hide
+ * ------------------------------------------------------------------------- */
+
+/* Back to all apps, empty query, page 0; a no-op if already there */
+static void
+reset_view (VenomLauncherWindow *self)
+{
+    venom_category_bar_reset (VENOM_CATEGORY_BAR (self->category_bar));
+
+    const char *text = venom_search_bar_get_text (VENOM_SEARCH_BAR (self->search_bar));
+
+    /* Clearing a non-empty entry resets the grid via on_search_changed */
+    if (text && *text)
+        venom_search_bar_clear (VENOM_SEARCH_BAR (self->search_bar));
+    else
+        venom_app_grid_set_filter (VENOM_APP_GRID (self->app_grid), NULL);
+}
+
+/* Resident set size in KiB, 0 if unknown */
+static gulong
+rss_kib (void)
+{
+    unsigned long pages = 0;
+    FILE *f = fopen ("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf (f, "%*s %lu", &pages) != 1) pages = 0;
+    fclose (f);
+    return pages * (gulong) sysconf (_SC_PAGESIZE) / 1024;
+}
+
+/*
+ * Hidden for a while: keep the catalog and search index, drop what the
+ * next show can rebuild from the icon atlas in a few milliseconds.
+ */
+static gboolean
+trim_idle (gpointer data)
+{
+    VenomLauncherWindow *self   = VENOM_LAUNCHER_WINDOW (data);
+    gulong               before = rss_kib ();
+    self->trim_id = 0;
+
+    venom_app_grid_trim (VENOM_APP_GRID (self->app_grid));
+    icon_loader_trim (icon_loader_get ());
+#ifdef __GLIBC__
+    malloc_trim (0);
+#endif
+
+    gulong after = rss_kib ();
+    g_message ("Launcher: hidden %u s, trimmed caches; RSS %lu -> %lu KiB",
+               self->trim_delay_s, before, after);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+cancel_trim (VenomLauncherWindow *self)
+{
+    if (self->trim_id) {
+        g_source_remove (self->trim_id);
+        self->trim_id = 0;
+    }
+}
+
+/* Reset while hidden, so the next show only has to map the window */
+static void
+on_hide (GtkWidget *widget, gpointer user_data)
+{
+    (void) user_data;
+    VenomLauncherWindow *self = VENOM_LAUNCHER_WINDOW (widget);
+
+    reset_view (self);
+
+    cancel_trim (self);
+    if (self->trim_delay_s > 0)
+        self->trim_id = g_timeout_add_seconds (self->trim_delay_s, trim_idle, self);
+}
+
+static void
+on_after_paint (GdkFrameClock *clock, gpointer data)
+{
+    VenomLauncherWindow *self = VENOM_LAUNCHER_WINDOW (data);
+    gint64               us   = g_get_monotonic_time () - self->show_start;
+
+    g_signal_handler_disconnect (clock, self->paint_handler);
+    self->paint_handler = 0;
+
+    if (us > SHOW_BUDGET_US)
+        g_message ("Launcher: first frame %.1f ms after show (budget %.1f ms)",
+                   us / 1000.0, SHOW_BUDGET_US / 1000.0);
+    else
+        g_debug ("Launcher: first frame %.1f ms after show", us / 1000.0);
+}
+
 /* -------------------------------------------------------------------------
  * GObject class init
  * ------------------------------------------------------------------------- */
@@ -212,9 +502,17 @@ static void
 venom_launcher_window_finalize (GObject *obj)
 {
     VenomLauncherWindow *self = VENOM_LAUNCHER_WINDOW (obj);
+    cancel_trim (self);
+    session_catalog_unwatch (self->catalog_watch);
+    session_catalog_free (self->snapshot);
+    app_monitor_free (self->monitor);
+    search_index_free (self->index);
+    if (self->apps_by_id)
+        g_hash_table_destroy (self->apps_by_id);
     if (self->apps)
         g_ptr_array_unref (self->apps);
     icon_loader_destroy ();
+    usage_store_destroy ();
     G_OBJECT_CLASS (venom_launcher_window_parent_class)->finalize (obj);
 }
 
@@ -230,6 +528,8 @@ venom_launcher_window_init (VenomLauncherWindow *self)
 {
     GtkWindow *win = GTK_WINDOW (self);
 
+    self->trim_delay_s = LAUNCHER_TRIM_DELAY_S;
+
     gtk_window_set_decorated         (win, FALSE);
     gtk_window_set_skip_taskbar_hint (win, TRUE);
     gtk_window_set_skip_pager_hint   (win, TRUE);
@@ -266,16 +566,50 @@ venom_launcher_window_init (VenomLauncherWindow *self)
     gtk_box_pack_start (GTK_BOX (vbox), self->search_bar, FALSE, FALSE, 0);
 
     /* ── Load apps ─────────────────────────────────────────────────── */
-    self->apps = desktop_reader_load_apps ();
+    /* The session snapshot when venom-catalogd has published one */
+    self->snapshot = session_catalog_open ();
+    if (self->snapshot) {
+        self->apps             = session_catalog_load_apps (self->snapshot);
+        self->snapshot_version = session_catalog_get_version (self->snapshot);
+    } else {
+        self->apps = desktop_reader_load_apps ();
+    }
+
+    self->apps_by_id = g_hash_table_new (g_str_hash, g_str_equal);
+    for (guint i = 0; i < self->apps->len; i++) {
+        AppEntry *e = g_ptr_array_index (self->apps, i);
+        g_hash_table_insert (self->apps_by_id,
+                             (gpointer) app_entry_get_id (e), e);
+    }
+
+    self->index = search_index_new (self->apps);
+
+    /* Refinements and backspaces are filtered on the keystroke */
+    venom_search_bar_set_cost_func (VENOM_SEARCH_BAR (self->search_bar),
+                                    search_cost, self);
+
+    /* ── Category Bar ──────────────────────────────────────────────── */
+    self->category_bar = venom_category_bar_new ();
+    venom_category_bar_update (VENOM_CATEGORY_BAR (self->category_bar),
+                               self->index);
+    gtk_box_pack_start (GTK_BOX (vbox), self->category_bar, FALSE, FALSE, 0);
 
     /* ── App Grid ──────────────────────────────────────────────────── */
-    self->app_grid = venom_app_grid_new (self->apps);
+    self->app_grid = venom_app_grid_new (self->apps, self->index);
     gtk_box_pack_start (GTK_BOX (vbox), self->app_grid, TRUE, TRUE, 0);
 
     /* Connect signals */
+    /* Keep the catalog live while the launcher is running */
+    self->catalog_watch = session_catalog_watch (on_catalog_changed, self);
+    if (!self->catalog_watch)
+        on_catalog_changed (0, self);
+
     g_signal_connect (self->search_bar, "search-changed-debounced",
                       G_CALLBACK (on_search_changed), self);
 
+    g_signal_connect (self->category_bar, "category-changed",
+                      G_CALLBACK (on_category_changed), self);
+
     g_signal_connect (GTK_WIDGET (self), "key-press-event",
                       G_CALLBACK (on_key_press), NULL);
 
@@ -284,6 +618,9 @@ venom_launcher_window_init (VenomLauncherWindow *self)
 
     g_signal_connect (GTK_WIDGET (self), "draw",
                       G_CALLBACK (on_draw), NULL);
+
+    g_signal_connect (GTK_WIDGET (self), "hide",
+                      G_CALLBACK (on_hide), NULL);
 }
 
 /* -------------------------------------------------------------------------
@@ -309,11 +646,58 @@ venom_launcher_window_show_launcher (VenomLauncherWindow *win)
 {
     g_return_if_fail (VENOM_IS_LAUNCHER_WINDOW (win));
 
-    venom_search_bar_clear (VENOM_SEARCH_BAR (win->search_bar));
-    venom_app_grid_set_filter (VENOM_APP_GRID (win->app_grid), NULL);
+    win->show_start = g_get_monotonic_time ();
+    cancel_trim (win);
+
+    /* Normally done on hide already; then nothing is rebuilt here */
+    reset_view (win);
 
     gtk_widget_show_all (GTK_WIDGET (win));
     gtk_window_present  (GTK_WINDOW (win));
 
     venom_search_bar_grab_focus (VENOM_SEARCH_BAR (win->search_bar));
+
+    GdkFrameClock *clock = gtk_widget_get_frame_clock (GTK_WIDGET (win));
+    if (clock && !win->paint_handler)
+        win->paint_handler = g_signal_connect_object (clock, "after-paint",
+                                                      G_CALLBACK (on_after_paint),
+                                                      win, 0);
+}
+
+void
+venom_launcher_window_set_trim_delay (VenomLauncherWindow *win, guint seconds)
+{
+    g_return_if_fail (VENOM_IS_LAUNCHER_WINDOW (win));
+    win->trim_delay_s = seconds;
+}
+
+void
+venom_launcher_window_prepare (VenomLauncherWindow *win)
+{
+    g_return_if_fail (VENOM_IS_LAUNCHER_WINDOW (win));
+
+    GtkWidget  *widget  = GTK_WIDGET (win);
+    GdkDisplay *display = gtk_widget_get_display (widget);
+    GdkMonitor *monitor = gdk_display_get_primary_monitor (display);
+    if (!monitor) monitor = gdk_display_get_monitor (display, 0);
+    if (!monitor) return;
+
+    /* Lay out at the size fullscreen will give us, without mapping */
+    GdkRectangle geometry;
+    gdk_monitor_get_geometry (monitor, &geometry);
+    gtk_window_set_default_size (GTK_WINDOW (win), geometry.width, geometry.height);
+
+    gtk_widget_show_all (gtk_bin_get_child (GTK_BIN (win)));
+    gtk_widget_realize (widget);
+
+    GtkRequisition min;
+    gtk_widget_get_preferred_size (widget, &min, NULL);
+    GtkAllocation alloc = {
+        0, 0, MAX (min.width, geometry.width), MAX (min.height, geometry.height)
+    };
+    gtk_widget_size_allocate (widget, &alloc);
+
+    /* The grid draws into offscreen surfaces similar to its GdkWindow */
+    gtk_widget_realize (win->app_grid);
+    venom_app_grid_prerender (VENOM_APP_GRID (win->app_grid));
 }
@@ -9,6 +9,8 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (VenomLauncherWindow, venom_launcher_window,
                       VENOM, LAUNCHER_WINDOW, GtkApplicationWindow)
 
+#define LAUNCHER_TRIM_DELAY_S  300   /* default hidden time before trimming */
+
 /**
  * VenomLauncherWindow - Fullscreen, translucent launcher window.
  * Owns the app list, search bar, and icon grid.
@@ -16,4 +18,18 @@ G_DECLARE_FINAL_TYPE (VenomLauncherWindow, venom_launcher_window,
 GtkWidget *venom_launcher_window_new (GtkApplication *app);
 void       venom_launcher_window_show_launcher (VenomLauncherWindow *win);
 
+/*
+ * Realizes and lays out the hidden window at the primary monitor's
+ * size and renders the first page, so a later show only maps it.
+ */
+void       venom_launcher_window_prepare       (VenomLauncherWindow *win);
+
+/*
+ * After @seconds hidden, drops decoded icons and page render caches
+ * (keeping the catalog and search index), returns freed heap to the
+ * system and logs RSS before and after. 0 disables.
+ */
+void       venom_launcher_window_set_trim_delay (VenomLauncherWindow *win,
+                                                 guint                seconds);
+
 G_END_DECLS
@@ -7,6 +7,13 @@
 struct _VenomSearchBar {
     GtkSearchEntry  parent_instance;
     guint           debounce_id;   /* g_timeout source id */
+    guint           debounce_ms;   /* 0 = emit on every change */
+
+    /* Adaptive debounce: handler time per unit of estimated cost */
+    VenomSearchCostFunc cost_func;
+    gpointer            cost_data;
+    gdouble             us_per_unit;   /* running average, 0 = unmeasured */
+    guint               pending_cost;  /* estimate for the text being emitted */
 };
 
 G_DEFINE_TYPE (VenomSearchBar, venom_search_bar, GTK_TYPE_SEARCH_ENTRY)
@@ -19,15 +26,48 @@ static guint signals[N_SIGNALS];
  * Debounce logic
  * ------------------------------------------------------------------------- */
 
+/* Emits and times the handlers, to learn what a unit of cost takes */
+static void
+emit_changed (VenomSearchBar *self)
+{
+    gint64 t0 = g_get_monotonic_time ();
+    g_signal_emit (self, signals[SIGNAL_SEARCH_CHANGED], 0);
+    gint64 us = g_get_monotonic_time () - t0;
+
+    if (self->cost_func && self->pending_cost > 0) {
+        gdouble rate = (gdouble) us / self->pending_cost;
+        self->us_per_unit = self->us_per_unit > 0
+                          ? 0.75 * self->us_per_unit + 0.25 * rate
+                          : rate;
+    }
+}
+
 static gboolean
 debounce_fire (gpointer user_data)
 {
     VenomSearchBar *self = VENOM_SEARCH_BAR (user_data);
     self->debounce_id = 0;
-    g_signal_emit (self, signals[SIGNAL_SEARCH_CHANGED], 0);
+    emit_changed (self);
     return G_SOURCE_REMOVE;
 }
 
+/*
+ * TRUE if the change can be emitted right away: the handlers are
+ * predicted to take under VENOM_SEARCH_BAR_INSTANT_US.  Until the first
+ * measurement the prediction is optimistic.
+ */
+static gboolean
+is_cheap (VenomSearchBar *self)
+{
+    if (!self->cost_func) return FALSE;
+
+    const char *text = gtk_entry_get_text (GTK_ENTRY (self));
+    self->pending_cost = self->cost_func (text, self->cost_data);
+
+    return self->pending_cost == 0 ||
+           self->pending_cost * self->us_per_unit <= VENOM_SEARCH_BAR_INSTANT_US;
+}
+
 static void
 on_text_changed (GtkEditable *editable, gpointer user_data)
 {
@@ -40,8 +80,13 @@ on_text_changed (GtkEditable *editable, gpointer user_data)
         self->debounce_id = 0;
     }
 
-    /* Schedule new debounce: 150 ms */
-    self->debounce_id = g_timeout_add (150, debounce_fire, self);
+    if (self->debounce_ms == 0 || is_cheap (self)) {
+        emit_changed (self);
+        return;
+    }
+
+    /* Schedule new debounce */
+    self->debounce_id = g_timeout_add (self->debounce_ms, debounce_fire, self);
 }
 
 /* -------------------------------------------------------------------------
@@ -64,6 +109,7 @@ static void
 venom_search_bar_init (VenomSearchBar *self)
 {
     self->debounce_id = 0;
+    self->debounce_ms = VENOM_SEARCH_BAR_DEBOUNCE_MS;
 
     gtk_widget_set_name (GTK_WIDGET (self), "venom-search-entry");
     gtk_style_context_add_class (
@@ -101,6 +147,24 @@ venom_search_bar_clear (VenomSearchBar *bar)
     gtk_entry_set_text (GTK_ENTRY (bar), "");
 }
 
+void
+venom_search_bar_set_debounce (VenomSearchBar *bar, guint ms)
+{
+    g_return_if_fail (VENOM_IS_SEARCH_BAR (bar));
+    bar->debounce_ms = ms;
+}
+
+void
+venom_search_bar_set_cost_func (VenomSearchBar      *bar,
+                                VenomSearchCostFunc  func,
+                                gpointer             user_data)
+{
+    g_return_if_fail (VENOM_IS_SEARCH_BAR (bar));
+    bar->cost_func   = func;
+    bar->cost_data   = user_data;
+    bar->us_per_unit = 0;
+}
+
 void
 venom_search_bar_grab_focus (VenomSearchBar *bar)
 {
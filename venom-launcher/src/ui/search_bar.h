@@ -9,12 +9,30 @@ G_DECLARE_FINAL_TYPE (VenomSearchBar, venom_search_bar,
                       VENOM, SEARCH_BAR, GtkSearchEntry)
 
 /**
- * VenomSearchBar - Styled search entry with debounce.
- * Emits "search-changed" signal after 150ms debounce.
+ * VenomSearchBar - Styled search entry with optional debounce.
+ * Emits "search-changed-debounced" after the debounce interval
+ * (VENOM_SEARCH_BAR_DEBOUNCE_MS by default), or immediately if the
+ * interval is set to 0.
+ *
+ * With a cost function the debounce is adaptive: the bar times its
+ * handlers against the estimated cost of each text it emitted, and
+ * emits immediately whenever the next one is predicted to take less
+ * than VENOM_SEARCH_BAR_INSTANT_US.
  */
+#define VENOM_SEARCH_BAR_DEBOUNCE_MS  150
+#define VENOM_SEARCH_BAR_INSTANT_US   2000
+
+/* Estimated work for handling @text, in any unit proportional to time */
+typedef guint (*VenomSearchCostFunc) (const char *text, gpointer user_data);
+
 GtkWidget  *venom_search_bar_new         (void);
 const char *venom_search_bar_get_text    (VenomSearchBar *bar);
 void        venom_search_bar_clear       (VenomSearchBar *bar);
 void        venom_search_bar_grab_focus  (VenomSearchBar *bar);
+void        venom_search_bar_set_debounce (VenomSearchBar *bar,
+                                           guint           ms);
+void        venom_search_bar_set_cost_func (VenomSearchBar      *bar,
+                                            VenomSearchCostFunc  func,
+                                            gpointer             user_data);
 
 G_END_DECLS
@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include "venom-panel-plugin-api.h"
+#include "venom-session-catalog.h"
+#include "venom-spawn.h"
 
 /* The main popup menu */
 static GtkWidget *main_menu = NULL;
@@ -33,23 +35,36 @@ static AppCategory categories[] = {
 
 static const int NUM_CATEGORIES = sizeof(categories) / sizeof(categories[0]);
 
-/* Helper to launch apps */
+/* Helper to launch apps (through the session spawn helper) */
 static void launch_app(GtkMenuItem *item, gpointer data) {
     (void)item;
     GDesktopAppInfo *app_info = G_DESKTOP_APP_INFO(data);
     GError *error = NULL;
     
-    if (!g_app_info_launch(G_APP_INFO(app_info), NULL, NULL, &error)) {
+    if (!venom_spawn_desktop_app(app_info, NULL, &error)) {
         g_warning("[AppMenu] Failed to launch: %s", error->message);
         g_error_free(error);
     }
 }
 
+/* Helper to launch a catalog entry by its .desktop path */
+static void launch_desktop_file(GtkMenuItem *item, gpointer data) {
+    (void)item;
+    const char *path = (const char *)data;
+    GDesktopAppInfo *app_info = g_desktop_app_info_new_from_filename(path);
+    if (!app_info) {
+        g_warning("[AppMenu] No longer installed: %s", path);
+        return;
+    }
+    launch_app(NULL, app_info);
+    g_object_unref(app_info);
+}
+
 /* Helper to launch simple commands */
 static void launch_cmd(GtkMenuItem *item, gpointer data) {
     (void)item;
     const char *cmd = (const char *)data;
-    g_spawn_command_line_async(cmd, NULL);
+    venom_spawn_command_line(cmd, NULL);
 }
 
 /* Helper to create a menu item with an icon and label */
@@ -78,34 +93,47 @@ static GtkWidget* create_icon_menu_item(GIcon *icon, const char *icon_name, cons
     return item;
 }
 
-/* Build the app menu structure */
-static void build_app_menu(void) {
-    if (menu_populated) return;
-    
-    /* 1. Static Top Items */
-    GtkWidget *term_item = create_icon_menu_item(NULL, "utilities-terminal", "Terminal Emulator");
-    g_signal_connect(term_item, "activate", G_CALLBACK(launch_cmd), "x-terminal-emulator");
-    gtk_menu_shell_append(GTK_MENU_SHELL(main_menu), term_item);
+/* Category for a Categories= value; Other if none matches */
+static AppCategory* find_category(const char *cats) {
+    if (cats) {
+        for (int i = 0; i < NUM_CATEGORIES - 1; i++) {
+            if (strstr(cats, categories[i].id)) return &categories[i];
+        }
+    }
+    return &categories[NUM_CATEGORIES - 1];
+}
 
-    GtkWidget *fm_item = create_icon_menu_item(NULL, "system-file-manager", "File Manager");
-    g_signal_connect(fm_item, "activate", G_CALLBACK(launch_cmd), "xdg-open /home/x"); /* or Thunar */
-    gtk_menu_shell_append(GTK_MENU_SHELL(main_menu), fm_item);
+/* Populate categories from the session catalog; FALSE if none is published */
+static gboolean populate_from_catalog(void) {
+    VenomCatalog *catalog = venom_catalog_open();
+    if (!catalog) return FALSE;
 
-    GtkWidget *web_item = create_icon_menu_item(NULL, "web-browser", "Web Browser");
-    g_signal_connect(web_item, "activate", G_CALLBACK(launch_cmd), "xdg-open http://");
-    gtk_menu_shell_append(GTK_MENU_SHELL(main_menu), web_item);
+    for (guint i = 0; i < venom_catalog_n_apps(catalog); i++) {
+        const VenomCatalogRecord *rec = venom_catalog_record(catalog, i);
+        const char *name = venom_catalog_str(catalog, rec->name);
+        if (!name) continue;
 
-    gtk_menu_shell_append(GTK_MENU_SHELL(main_menu), gtk_separator_menu_item_new());
+        AppCategory *target_cat = find_category(venom_catalog_str(catalog, rec->categories));
 
-    /* Initialize Category Submenus */
-    for (int i = 0; i < NUM_CATEGORIES; i++) {
-        categories[i].submenu = gtk_menu_new();
-        categories[i].menu_item = create_icon_menu_item(NULL, categories[i].icon_name, categories[i].label);
-        gtk_menu_item_set_submenu(GTK_MENU_ITEM(categories[i].menu_item), categories[i].submenu);
-        categories[i].count = 0;
+        const char *icon_name = venom_catalog_str(catalog, rec->icon_name);
+        GIcon *icon = icon_name ? g_icon_new_for_string(icon_name, NULL) : NULL;
+        GtkWidget *app_item = create_icon_menu_item(icon, NULL, name);
+        if (icon) g_object_unref(icon);
+
+        char *path = g_strdup(venom_catalog_str(catalog, rec->path));
+        g_signal_connect(app_item, "activate", G_CALLBACK(launch_desktop_file), path);
+        g_object_set_data_full(G_OBJECT(app_item), "desktop-path", path, g_free);
+
+        gtk_menu_shell_append(GTK_MENU_SHELL(target_cat->submenu), app_item);
+        target_cat->count++;
     }
 
-    /* 2. Populate Categories from .desktop files */
+    venom_catalog_free(catalog);
+    return TRUE;
+}
+
+/* Populate categories by enumerating the installed apps ourselves */
+static void populate_from_app_info(void) {
     GList *apps = g_app_info_get_all();
     for (GList *l = apps; l; l = l->next) {
         GAppInfo *app = G_APP_INFO(l->data);
@@ -117,15 +145,7 @@ static void build_app_menu(void) {
         /* Find Category */
         AppCategory *target_cat = &categories[NUM_CATEGORIES - 1]; /* Default: Other */
         if (G_IS_DESKTOP_APP_INFO(app)) {
-            const char *cats = g_desktop_app_info_get_categories(G_DESKTOP_APP_INFO(app));
-            if (cats) {
-                for (int i = 0; i < NUM_CATEGORIES - 1; i++) {
-                    if (strstr(cats, categories[i].id)) {
-                        target_cat = &categories[i];
-                        break;
-                    }
-                }
-            }
+            target_cat = find_category(g_desktop_app_info_get_categories(G_DESKTOP_APP_INFO(app)));
         }
 
         /* Create App Item */
@@ -140,6 +160,39 @@ static void build_app_menu(void) {
         target_cat->count++;
     }
     g_list_free_full(apps, g_object_unref);
+}
+
+/* Build the app menu structure */
+static void build_app_menu(void) {
+    if (menu_populated) return;
+    
+    /* 1. Static Top Items */
+    GtkWidget *term_item = create_icon_menu_item(NULL, "utilities-terminal", "Terminal Emulator");
+    g_signal_connect(term_item, "activate", G_CALLBACK(launch_cmd), "x-terminal-emulator");
+    gtk_menu_shell_append(GTK_MENU_SHELL(main_menu), term_item);
+
+    GtkWidget *fm_item = create_icon_menu_item(NULL, "system-file-manager", "File Manager");
+    g_signal_connect(fm_item, "activate", G_CALLBACK(launch_cmd), "xdg-open /home/x"); /* or Thunar */
+    gtk_menu_shell_append(GTK_MENU_SHELL(main_menu), fm_item);
+
+    GtkWidget *web_item = create_icon_menu_item(NULL, "web-browser", "Web Browser");
+    g_signal_connect(web_item, "activate", G_CALLBACK(launch_cmd), "xdg-open http://");
+    gtk_menu_shell_append(GTK_MENU_SHELL(main_menu), web_item);
+
+    gtk_menu_shell_append(GTK_MENU_SHELL(main_menu), gtk_separator_menu_item_new());
+
+    /* Initialize Category Submenus */
+    for (int i = 0; i < NUM_CATEGORIES; i++) {
+        categories[i].submenu = gtk_menu_new();
+        categories[i].menu_item = create_icon_menu_item(NULL, categories[i].icon_name, categories[i].label);
+        gtk_menu_item_set_submenu(GTK_MENU_ITEM(categories[i].menu_item), categories[i].submenu);
+        categories[i].count = 0;
+    }
+
+    /* 2. Populate Categories: session catalog, or .desktop files */
+    if (!populate_from_catalog()) {
+        populate_from_app_info();
+    }
 
     /* Attach populated category submenus to main menu */
     for (int i = 0; i < NUM_CATEGORIES; i++) {
@@ -163,6 +216,27 @@ static void build_app_menu(void) {
     menu_populated = TRUE;
 }
 
+/* Drop the built menu; the next popup rebuilds it from the new snapshot */
+static void on_catalog_changed(guint32 version, gpointer data) {
+    (void)version; (void)data;
+    if (!menu_populated) return;
+
+    /* Empty categories were never attached, so main_menu does not own them */
+    for (int i = 0; i < NUM_CATEGORIES; i++) {
+        if (categories[i].count == 0) gtk_widget_destroy(categories[i].menu_item);
+        categories[i].menu_item = NULL;
+        categories[i].submenu = NULL;
+    }
+
+    GList *children = gtk_container_get_children(GTK_CONTAINER(main_menu));
+    for (GList *l = children; l; l = l->next) {
+        gtk_widget_destroy(GTK_WIDGET(l->data));
+    }
+    g_list_free(children);
+
+    menu_populated = FALSE;
+}
+
 static void on_menu_button_toggled(GtkToggleButton *btn, gpointer data) {
     (void)data;
     if (gtk_toggle_button_get_active(btn)) {
@@ -197,6 +271,9 @@ static GtkWidget* create_app_menu_widget(void) {
     /* When the button is toggled, show the menu */
     g_signal_connect(menu_btn, "toggled", G_CALLBACK(on_menu_button_toggled), NULL);
 
+    /* Rebuild lazily when apps are installed or removed */
+    venom_catalog_subscribe(on_catalog_changed, NULL);
+
     gtk_widget_show_all(menu_btn);
     return menu_btn;
 }
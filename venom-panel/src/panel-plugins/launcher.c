@@ -1,6 +1,7 @@
 #include <gtk/gtk.h>
 #include <stdlib.h>
 #include "../../include/venom-panel-plugin-api.h"
+#include "../../include/venom-spawn.h"
 
 /* Launcher entries */
 typedef struct {
@@ -18,7 +19,7 @@ static const LauncherEntry LAUNCHERS[] = {
 
 static void on_launch_clicked(GtkButton *btn, gpointer data) {
     const char *cmd = (const char *)data;
-    if (cmd) g_spawn_command_line_async(cmd, NULL);
+    if (cmd) venom_spawn_command_line(cmd, NULL);
 }
 
 static GtkWidget* create_launcher_widget(void) {
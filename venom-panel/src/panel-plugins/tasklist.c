@@ -6,6 +6,9 @@
 #include <X11/Xutil.h>
 #include <string.h>
 #include "venom-panel-plugin-api.h"
+#include "venom-icon-atlas.h"
+
+#define TASK_ICON_SIZE 24
 
 typedef struct {
     GtkWidget *box;
@@ -224,12 +227,14 @@ static char* get_wm_class(Display *dpy, Window win) {
     return NULL;
 }
 
-static GdkPixbuf* get_window_icon(Display *dpy, Window xwindow, const char *class_name) {
+/* Window icon, TASK_ICON_SIZE at @scale; themed icons come from the shared icon atlas */
+static cairo_surface_t* get_window_icon(Display *dpy, Window xwindow, const char *class_name, int scale) {
     Atom actual_type;
     int actual_format;
     unsigned long nitems, bytes_after;
     unsigned char *prop = NULL;
     GdkPixbuf *pixbuf = NULL;
+    cairo_surface_t *icon = NULL;
 
     /* Method 1: Try _NET_WM_ICON (modern EWMH standard, raw pixels) */
     Atom net_wm_icon = XInternAtom(dpy, "_NET_WM_ICON", False);
@@ -255,9 +260,12 @@ static GdkPixbuf* get_window_icon(Display *dpy, Window xwindow, const char *clas
             }
             XFree(prop);
             if (pixbuf != NULL) {
-                GdkPixbuf *scaled = gdk_pixbuf_scale_simple(pixbuf, 24, 24, GDK_INTERP_BILINEAR);
+                GdkPixbuf *scaled = gdk_pixbuf_scale_simple(pixbuf, TASK_ICON_SIZE * scale,
+                                                            TASK_ICON_SIZE * scale, GDK_INTERP_BILINEAR);
                 g_object_unref(pixbuf);
-                return scaled;
+                icon = gdk_cairo_surface_create_from_pixbuf(scaled, scale, NULL);
+                g_object_unref(scaled);
+                return icon;
             }
         } else if (prop) {
             XFree(prop);
@@ -266,7 +274,6 @@ static GdkPixbuf* get_window_icon(Display *dpy, Window xwindow, const char *clas
 
     /* Method 2: Try GDesktopAppInfo to locate the exact themed icon via WM_CLASS */
     GtkIconTheme *icon_theme = gtk_icon_theme_get_default();
-    GError *error = NULL;
     
     if (class_name) {
         GDesktopAppInfo *app_info = NULL;
@@ -287,30 +294,21 @@ static GdkPixbuf* get_window_icon(Display *dpy, Window xwindow, const char *clas
         }
         
         if (app_info) {
+            /* Theme name or absolute path */
             gchar *icon_name = g_desktop_app_info_get_string(app_info, "Icon");
-            if (icon_name) {
-                if (g_path_is_absolute(icon_name)) {
-                    pixbuf = gdk_pixbuf_new_from_file_at_scale(icon_name, 24, 24, TRUE, &error);
-                } else {
-                    pixbuf = gtk_icon_theme_load_icon(icon_theme, icon_name, 24, GTK_ICON_LOOKUP_FORCE_SIZE, &error);
-                }
-                g_free(icon_name);
-                if (error) { g_error_free(error); error = NULL; }
-            }
+            icon = venom_icon_atlas_load_icon(icon_theme, icon_name, TASK_ICON_SIZE, scale);
+            g_free(icon_name);
             g_object_unref(app_info);
-            if (pixbuf) return pixbuf;
+            if (icon) return icon;
         }
         
         /* Direct class name lookup fallback */
-        pixbuf = gtk_icon_theme_load_icon(icon_theme, class_name, 24, GTK_ICON_LOOKUP_FORCE_SIZE, &error);
-        if (error) { g_error_free(error); error = NULL; }
-        if (pixbuf) return pixbuf;
+        icon = venom_icon_atlas_load_icon(icon_theme, class_name, TASK_ICON_SIZE, scale);
+        if (icon) return icon;
     }
     
     /* Method 3: Generic fallback */
-    pixbuf = gtk_icon_theme_load_icon(icon_theme, "application-x-executable", 24, GTK_ICON_LOOKUP_FORCE_SIZE, &error);
-    if (error) { g_error_free(error); error = NULL; }
-    return pixbuf;
+    return venom_icon_atlas_load_icon(icon_theme, "application-x-executable", TASK_ICON_SIZE, scale);
 }
 
 
@@ -425,12 +423,13 @@ static void rebuild_tasklist(TasklistData *data) {
         gtk_widget_set_size_request(btn, 36, 36); /* Square icon button */
         
         char *wm_class = get_wm_class(data->dpy, win);
-        GdkPixbuf *pixbuf = get_window_icon(data->dpy, win, wm_class);
+        cairo_surface_t *surface = get_window_icon(data->dpy, win, wm_class,
+                                                   gtk_widget_get_scale_factor(data->box));
         
         GtkWidget *icon;
-        if (pixbuf) {
-            icon = gtk_image_new_from_pixbuf(pixbuf);
-            g_object_unref(pixbuf);
+        if (surface) {
+            icon = gtk_image_new_from_surface(surface);
+            cairo_surface_destroy(surface);
         } else {
             icon = gtk_image_new_from_icon_name("application-x-executable", GTK_ICON_SIZE_LARGE_TOOLBAR);
         }